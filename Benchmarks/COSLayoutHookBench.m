@@ -0,0 +1,122 @@
+// COSLayoutHookBench.m
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Cost of the layoutSubviews hook for views without constrained subviews.
+//
+// Makes 10k table view cells and constrains the content views of a few of
+// them. Times layoutSubviews of the content views before any cell is
+// constrained, then of the unconstrained and constrained ones after. Once
+// a cell is constrained, layoutSubviews of its class is hooked, and the
+// unconstrained content views pay one load of their driving count, which
+// should stay within noise of before. Classes printed must not change, views are
+// never moved to another class. Needs UIKit, run it in a booted
+// simulator:
+//
+//   xcrun -sdk iphonesimulator clang -fobjc-arc -O2 -framework UIKit
+//      -I../COSLayout COSLayoutHookBench.m ../COSLayout/COSLayout.m
+//      ../COSLayout/COSLayoutCore.c ../COSLayout/COSLayoutParser.c
+//      ../COSLayout/COSLayoutLex.c ../COSLayout/COSLayoutPool.c
+//      ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      ../COSLayout/COSLayoutDump.c
+//      ../COSLayout/COSLayoutCache.c
+//      ../COSLayout/COSLayoutProgram.c ../COSLayout/COSLayoutRegistry.c
+//      ../COSLayout/COSLayoutSession.c ../COSLayout/COSLayoutTree.c
+//      -o hook-bench
+//   xcrun simctl spawn booted ./hook-bench [cells] [constrained]
+
+#import "COSLayout.h"
+
+#import <objc/runtime.h>
+#import <time.h>
+
+#define ROUNDS 20
+
+static double cos_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Nanoseconds per layoutSubviews of the content views of cells selected by
+ * the stride, starting at offset. */
+static double cos_time_layout(NSArray *cells, NSUInteger offset, NSUInteger stride, BOOL skip) {
+    NSUInteger calls = 0;
+    double start = cos_now();
+
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (NSUInteger i = 0; i < cells.count; ++i) {
+            if ((i % stride == offset) == skip) continue;
+
+            [[cells[i] contentView] layoutSubviews];
+
+            calls += 1;
+        }
+    }
+
+    return (cos_now() - start) * 1e9 / MAX(calls, 1);
+}
+
+int main(int argc, char **argv) {
+    @autoreleasepool {
+        NSUInteger count = argc > 1 ? (NSUInteger)atol(argv[1]) : 10000;
+        NSUInteger constrained = argc > 2 ? (NSUInteger)atol(argv[2]) : 10;
+        NSUInteger stride = count / MAX(constrained, 1);
+
+        NSMutableArray *cells = [[NSMutableArray alloc] initWithCapacity:count];
+
+        for (NSUInteger i = 0; i < count; ++i) {
+            UITableViewCell *cell = [[UITableViewCell alloc] initWithStyle:UITableViewCellStyleDefault reuseIdentifier:nil];
+
+            cell.frame = CGRectMake(0, 0, 375, 44);
+
+            [cells addObject:cell];
+        }
+
+        double before = cos_time_layout(cells, 0, 1, YES);
+
+        for (NSUInteger i = 0; i < count; i += stride) {
+            UILabel *label = [[UILabel alloc] init];
+
+            [[cells[i] contentView] addSubview:label];
+            [label.coslayout addRule:@"ll = 15, rr = 15, tt = 0, bb = 0"];
+        }
+
+        double unconstrained = cos_time_layout(cells, 0, stride, YES);
+        double constrained = cos_time_layout(cells, 0, stride, NO);
+
+        UIView *plainView = [cells[1] contentView];
+        UIView *drivenView = [cells[0] contentView];
+
+        printf("cells %lu, constrained %lu\n", (unsigned long)count, (unsigned long)(count + stride - 1) / stride);
+        printf("%-28s %10.1f ns\n", "content view, before", before);
+        printf("%-28s %10.1f ns   %s\n", "unconstrained, after", unconstrained, class_getName(object_getClass(plainView)));
+        printf("%-28s %10.1f ns   %s\n", "constrained, after", constrained, class_getName(object_getClass(drivenView)));
+    }
+
+    return 0;
+}
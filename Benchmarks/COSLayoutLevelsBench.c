@@ -0,0 +1,163 @@
+// COSLayoutLevelsBench.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Scaling of level-parallel solving by thread count.
+//
+// Builds a wide container: every level holds the same number of views,
+// each view placed below one view of the previous level. Runs on any
+// POSIX system:
+//
+//   cc -O2 -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutLevelsBench.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      -lpthread -lm -o levels-bench
+//   ./levels-bench [width] [depth] [rounds]
+
+#include "COSLayoutCore.h"
+#include "COSLayoutPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void set_rule(COSLAYOUT_RULESET *set, int attr, COSLAYOUT_EXPR *expr) {
+    coslayout_ruleset_set(set, attr, expr);
+    coslayout_expr_release(expr);
+}
+
+int main(int argc, char **argv) {
+    size_t width = argc > 1 ? (size_t)atol(argv[1]) : 4096;
+    size_t depth = argc > 2 ? (size_t)atol(argv[2]) : 8;
+    int rounds = argc > 3 ? atoi(argv[3]) : 50;
+
+    size_t count = width * depth;
+
+    char container = 0;
+    char *views = (char *)calloc(count, 1);
+
+    COSLAYOUT_RULESET *sets = (COSLAYOUT_RULESET *)calloc(count, sizeof(COSLAYOUT_RULESET));
+    COSLAYOUT_NODE *nodes = (COSLAYOUT_NODE *)calloc(count, sizeof(COSLAYOUT_NODE));
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t level = i / width;
+        size_t column = i % width;
+
+        COSLAYOUT_RULESET *set = &sets[i];
+
+        coslayout_ruleset_init(set);
+
+        set_rule(set, COSLAYOUT_ATTR_LL, coslayout_expr_create_binary(COSLAYOUT_EXPR_MUL,
+            coslayout_expr_create_percentage(100.0 / width, COSLAYOUT_DIR_NONE),
+            coslayout_expr_create_const((double)column)));
+        set_rule(set, COSLAYOUT_ATTR_W, coslayout_expr_create_percentage(100.0 / width, COSLAYOUT_DIR_NONE));
+        set_rule(set, COSLAYOUT_ATTR_H, coslayout_expr_create_const(20));
+
+        if (level == 0) {
+            set_rule(set, COSLAYOUT_ATTR_TT, coslayout_expr_create_const(0));
+        } else {
+            void *above = &views[(level - 1) * width + (column * 7 + 3) % width];
+
+            set_rule(set, COSLAYOUT_ATTR_TT, coslayout_expr_create_binary(COSLAYOUT_EXPR_ADD,
+                coslayout_expr_create_attr(COSLAYOUT_ATTR_BT, above),
+                coslayout_expr_create_const(4)));
+        }
+
+        nodes[i].set = set;
+        nodes[i].view = &views[i];
+        nodes[i].superview = &container;
+        nodes[i].level = (int)level;
+    }
+
+    int threads[] = { 1, 2, 4, 8 };
+    double base = 0;
+    double checksum = 0;
+
+    printf("views %zu, levels %zu, rounds %d, processors %ld\n", count, depth, rounds, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%8s %12s %10s\n", "threads", "ms/solve", "speedup");
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+        COSLAYOUT_POOL *pool = coslayout_pool_create(threads[t]);
+        COSLAYOUT_SNAPSHOT snapshot;
+
+        coslayout_snapshot_init(&snapshot);
+
+        COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_insert(&snapshot, &container);
+
+        entry->rect = (COSLAYOUT_RECT){ 0, 0, 1024, 768 };
+
+        for (size_t i = 0; i < count; ++i) {
+            coslayout_snapshot_insert(&snapshot, &views[i]);
+        }
+
+        double start = now();
+
+        for (int r = 0; r < rounds; ++r) {
+            entry = coslayout_snapshot_find(&snapshot, &container);
+            entry->rect.w = 1024 + r % 2;
+
+            coslayout_nodes_solve(nodes, count, &snapshot, &container, -1, pool);
+        }
+
+        double elapsed = (now() - start) * 1000 / rounds;
+
+        double sum = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            sum += nodes[i].frame.y;
+        }
+
+        if (t == 0) {
+            base = elapsed;
+            checksum = sum;
+        }
+
+        printf("%8d %12.3f %10.2f%s\n", threads[t], elapsed, base / elapsed,
+               sum == checksum ? "" : "  (frames differ)");
+
+        coslayout_snapshot_destroy(&snapshot);
+        coslayout_pool_destroy(pool);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        coslayout_ruleset_destroy(&sets[i]);
+    }
+
+    free(nodes);
+    free(sets);
+    free(views);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+// COSLayoutMemoryBench.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Bytes per constrained view, for tracking memory regressions.
+//
+// Builds cells of headless views with typical rule sets and reports the
+// heap used per constrained view: the view record, its bindings and its
+// share of rule programs. Heap usage is read from mallinfo2, so numbers
+// need glibc 2.33 or later:
+//
+//   cc -O2 -std=c99 -D_GNU_SOURCE -I../COSLayout
+//      COSLayoutMemoryBench.c ../COSLayout/COSLayoutTree.c
+//      ../COSLayout/COSLayoutProgram.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      ../COSLayout/COSLayoutDump.c
+//      -lpthread -lm -o memory-bench
+//   ./memory-bench [cells]
+
+#include "COSLayoutTree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HEAP_BYTES() ((long)mallinfo2().uordblks)
+#else
+#define HEAP_BYTES() (-1L)
+#endif
+
+#define VIEWS_PER_CELL 6
+
+static const COSLAYOUT_RECT zero = { 0, 0, 0, 0 };
+
+/* Constant edges only. */
+static void build_pinned(COSLAYOUT_VIEW **views) {
+    for (int i = 0; i < VIEWS_PER_CELL; ++i) {
+        coslayout_view_add_rule(views[i], "ll = %f, tt = %f, w = 40, h = 20", 10.0 * i, 4.0 * i);
+    }
+}
+
+/* A vertical stack, each view below the previous one. */
+static void build_stacked(COSLAYOUT_VIEW **views) {
+    coslayout_view_add_rule(views[0], "ll = 12, rr = 12, tt = 12, h = 20");
+
+    for (int i = 1; i < VIEWS_PER_CELL; ++i) {
+        coslayout_view_add_rule(views[i], "ll = %ll, rr = 12, tt = %bt + 8, h = 20", views[i - 1], views[i - 1]);
+    }
+}
+
+/* Centered in the container with relative sizes. */
+static void build_centered(COSLAYOUT_VIEW **views) {
+    for (int i = 0; i < VIEWS_PER_CELL; ++i) {
+        coslayout_view_add_rule(views[i], "ct = 50%, cl = 50%, w = 80%, h = 10%");
+    }
+}
+
+/* A feed cell: avatar, name beside it, body and footer below. */
+static void build_feed(COSLAYOUT_VIEW **views) {
+    coslayout_view_add_rule(views[0], "ll = 12, tt = 12, w = 40, h = 40");
+    coslayout_view_add_rule(views[1], "ll = %rl + 8, rr = 12, tt = %tt, h = 20", views[0], views[0]);
+    coslayout_view_add_rule(views[2], "ll = %ll, rr = 12, tt = %bt + 4, h = 60", views[1], views[1]);
+    coslayout_view_add_rule(views[3], "ll = %ll, w = 50%, tt = %bt + 8, h = 20", views[1], views[2]);
+    coslayout_view_add_rule(views[4], "rr = 12, w = %w, tt = %tt, h = 20", views[3], views[3]);
+    coslayout_view_add_rule(views[5], "ll = 0, rr = 0, bb = 0, h = 1");
+}
+
+typedef struct PRESET {
+    const char *name;
+    void (*build)(COSLAYOUT_VIEW **views);
+} PRESET;
+
+static double measure(size_t cells, const PRESET *preset) {
+    COSLAYOUT_VIEW **containers = (COSLAYOUT_VIEW **)malloc(cells * sizeof(COSLAYOUT_VIEW *));
+
+    long before = HEAP_BYTES();
+
+    for (size_t c = 0; c < cells; ++c) {
+        COSLAYOUT_VIEW *views[VIEWS_PER_CELL];
+
+        containers[c] = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 375, 120 });
+
+        for (int i = 0; i < VIEWS_PER_CELL; ++i) {
+            views[i] = coslayout_view_create(zero);
+            coslayout_view_add_subview(containers[c], views[i]);
+        }
+
+        preset->build(views);
+    }
+
+    long bytes = HEAP_BYTES() - before;
+
+    for (size_t c = 0; c < cells; ++c) {
+        coslayout_view_destroy(containers[c]);
+    }
+
+    free(containers);
+
+    return (double)bytes / (cells * VIEWS_PER_CELL);
+}
+
+int main(int argc, char **argv) {
+    size_t cells = argc > 1 ? (size_t)atol(argv[1]) : 1000;
+
+    PRESET presets[] = {
+        { "pinned", build_pinned },
+        { "stacked", build_stacked },
+        { "centered", build_centered },
+        { "feed", build_feed }
+    };
+
+    /* Warm up the parser, whose first use allocates buffers. */
+    measure(1, &presets[0]);
+
+    if (HEAP_BYTES() < 0) {
+        printf("heap usage is not available on this system\n");
+        return 0;
+    }
+
+    printf("cells %zu, constrained views per cell %d\n", cells, VIEWS_PER_CELL);
+    printf("%10s %14s\n", "rules", "bytes/view");
+
+    for (size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); ++i) {
+        printf("%10s %14.1f\n", presets[i].name, measure(cells, &presets[i]));
+    }
+
+    return 0;
+}
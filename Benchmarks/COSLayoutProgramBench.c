@@ -0,0 +1,192 @@
+// COSLayoutProgramBench.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Memory of rules per view, private rule sets against shared programs.
+//
+// Builds the rules of many identical feed cells twice: once with a rule
+// set per view, the way views held rules before programs, and once with
+// programs and bindings. Heap usage is read from mallinfo2, so byte
+// counts need glibc 2.33 or later:
+//
+//   cc -O2 -std=c99 -D_GNU_SOURCE -I../COSLayout
+//      COSLayoutProgramBench.c ../COSLayout/COSLayoutProgram.c
+//      ../COSLayout/COSLayoutCore.c ../COSLayout/COSLayoutParser.c
+//      ../COSLayout/COSLayoutLex.c ../COSLayout/COSLayoutPool.c
+//      ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      -lpthread -lm -o program-bench
+//   ./program-bench [cells]
+
+#include "COSLayoutProgram.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HEAP_BYTES() ((long)mallinfo2().uordblks)
+#else
+#define HEAP_BYTES() (-1L)
+#endif
+
+#define VIEWS_PER_CELL 5
+
+typedef struct ARGS {
+    va_list args;
+} ARGS;
+
+static COSLAYOUT_EXPR *arg(void *info, const char *spec, int percentage, int dir) {
+    ARGS *a = (ARGS *)info;
+
+    if (percentage) return coslayout_expr_create_percentage(va_arg(a->args, double), dir);
+    if (spec[0] == 'f') return coslayout_expr_create_const(va_arg(a->args, double));
+
+    return coslayout_expr_create_attr(coslayout_attr_named(spec), va_arg(a->args, void *));
+}
+
+/* Rules of a view, either private or shared. Only the fields of one kind
+ * are allocated, so that measurements are not inflated by the other. */
+typedef struct SHARED_RULES {
+    COSLAYOUT_PROGRAM *program;
+    COSLAYOUT_BINDINGS bindings;
+} SHARED_RULES;
+
+typedef struct VIEW_RULES {
+    COSLAYOUT_RULESET *set;
+    SHARED_RULES *shared;
+} VIEW_RULES;
+
+static void add_rule(VIEW_RULES view, const char *rule, ...) {
+    ARGS a;
+
+    va_start(a.args, rule);
+
+    if (view.shared) {
+        coslayout_program_add_rule(&view.shared->program, &view.shared->bindings, rule, arg, &a);
+    } else {
+        coslayout_ruleset_add_rule(view.set, rule, arg, &a);
+    }
+
+    va_end(a.args);
+}
+
+static VIEW_RULES view_at(COSLAYOUT_RULESET *sets, SHARED_RULES *shared, size_t index) {
+    VIEW_RULES view = { sets ? &sets[index] : NULL, shared ? &shared[index] : NULL };
+
+    return view;
+}
+
+/* Avatar, name, body, footer and a divider, referencing each other. The
+ * views themselves are only addresses of rules. */
+static void build_cell(COSLAYOUT_RULESET *sets, SHARED_RULES *shared, size_t first) {
+    VIEW_RULES avatar = view_at(sets, shared, first);
+    VIEW_RULES name = view_at(sets, shared, first + 1);
+    VIEW_RULES body = view_at(sets, shared, first + 2);
+    VIEW_RULES footer = view_at(sets, shared, first + 3);
+    VIEW_RULES divider = view_at(sets, shared, first + 4);
+
+    void *avatar_ref = sets ? (void *)avatar.set : (void *)avatar.shared;
+    void *name_ref = sets ? (void *)name.set : (void *)name.shared;
+    void *body_ref = sets ? (void *)body.set : (void *)body.shared;
+
+    add_rule(avatar, "ll = 12, tt = 12, w = 40, h = 40");
+    add_rule(name, "ll = %rl + %f, rr = 12, tt = %tt", avatar_ref, 8.0, avatar_ref);
+    add_rule(name, "h = 20");
+    add_rule(body, "ll = %ll, rr = 12, tt = %bt + 4, h = 50%", name_ref, name_ref);
+    add_rule(footer, "ll = %ll, w = 50%, tt = %bt + 8, h = 20", name_ref, body_ref);
+    add_rule(divider, "ll = 0, rr = 0, bb = 0, h = 1");
+}
+
+static long measure(size_t cells, int shared, size_t *programs) {
+    size_t count = cells * VIEWS_PER_CELL;
+
+    long before = HEAP_BYTES();
+
+    COSLAYOUT_RULESET *sets = NULL;
+    SHARED_RULES *rules = NULL;
+
+    if (shared) {
+        rules = (SHARED_RULES *)malloc(count * sizeof(SHARED_RULES));
+
+        for (size_t i = 0; i < count; ++i) {
+            rules[i].program = coslayout_program_create();
+            coslayout_bindings_init(&rules[i].bindings);
+        }
+    } else {
+        sets = (COSLAYOUT_RULESET *)malloc(count * sizeof(COSLAYOUT_RULESET));
+
+        for (size_t i = 0; i < count; ++i) {
+            coslayout_ruleset_init(&sets[i]);
+        }
+    }
+
+    for (size_t c = 0; c < cells; ++c) {
+        build_cell(sets, rules, c * VIEWS_PER_CELL);
+    }
+
+    long bytes = HEAP_BYTES() - before;
+
+    *programs = coslayout_program_count();
+
+    for (size_t i = 0; i < count; ++i) {
+        if (shared) {
+            coslayout_program_release(rules[i].program);
+            coslayout_bindings_destroy(&rules[i].bindings);
+        } else {
+            coslayout_ruleset_destroy(&sets[i]);
+        }
+    }
+
+    free(rules);
+    free(sets);
+
+    return bytes;
+}
+
+int main(int argc, char **argv) {
+    size_t cells = argc > 1 ? (size_t)atol(argv[1]) : 1000;
+    size_t views = cells * VIEWS_PER_CELL;
+    size_t programs = 0;
+
+    /* Warm up the parser, whose first use allocates buffers. */
+    measure(1, 0, &programs);
+
+    long private_bytes = measure(cells, 0, &programs);
+    long shared_bytes = measure(cells, 1, &programs);
+
+    printf("cells %zu, views %zu\n", cells, views);
+
+    if (private_bytes < 0) {
+        printf("heap usage is not available on this system\n");
+        return 0;
+    }
+
+    printf("%10s %14s %14s %10s\n", "rules", "bytes", "bytes/view", "programs");
+    printf("%10s %14ld %14.1f %10s\n", "private", private_bytes, (double)private_bytes / views, "-");
+    printf("%10s %14ld %14.1f %10zu\n", "shared", shared_bytes, (double)shared_bytes / views, programs);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+// COSLayoutReplay.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Replays a recorded layout session on headless views.
+//
+// Sessions are recorded on devices with +[COSLayout startRecordingToFile:].
+// Runs the solves of the session a number of times and reports their
+// total and per solve times, so that layouts seen in production become
+// regression benchmarks. With -f, prints the final frame of every view
+// instead, for comparing layouts across versions. Runs on any POSIX system:
+//
+//   cc -O2 -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutReplay.c ../COSLayout/COSLayoutSession.c
+//      ../COSLayout/COSLayoutTree.c ../COSLayout/COSLayoutRegistry.c
+//      ../COSLayout/COSLayoutProgram.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      ../COSLayout/COSLayoutDump.c
+//      -lpthread -lm -o replay
+//   ./replay session [-n iterations] [-f]
+
+#include "COSLayoutSession.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void print_frame(long view, COSLAYOUT_RECT frame, void *info) {
+    (void)info;
+
+    printf("%ld %g %g %g %g\n", view, frame.x, frame.y, frame.w, frame.h);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int iterations = 100;
+    int frames = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0) {
+            frames = 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    if (path == NULL || iterations < 1) {
+        fprintf(stderr, "usage: %s session [-n iterations] [-f]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    size_t line;
+    COSLAYOUT_REPLAY *replay = coslayout_replay_load(file, &line);
+
+    fclose(file);
+
+    if (replay == NULL) {
+        fprintf(stderr, "%s:%zu: malformed session\n", path, line);
+        return 1;
+    }
+
+    if (frames) {
+        size_t failures = coslayout_replay_run(replay, NULL, NULL, print_frame, NULL);
+
+        coslayout_replay_destroy(replay);
+
+        return failures ? 1 : 0;
+    }
+
+    size_t solves = coslayout_replay_solves(replay);
+    size_t samples = solves * (size_t)iterations;
+
+    double *seconds = (double *)calloc(samples + 1, sizeof(double));
+    size_t failures = 0;
+    double total = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+        failures += coslayout_replay_run(replay, NULL, seconds + solves * (size_t)i, NULL, NULL);
+    }
+
+    for (size_t i = 0; i < samples; ++i) {
+        total += seconds[i];
+    }
+
+    qsort(seconds, samples, sizeof(double), compare_doubles);
+
+    printf("views      %zu\n", coslayout_replay_views(replay));
+    printf("solves     %zu x %d\n", solves, iterations);
+    printf("cycles     %zu\n", failures);
+
+    if (samples > 0) {
+        printf("total      %.3f ms per run\n", total * 1e3 / iterations);
+        printf("median     %.2f us per solve\n", seconds[samples / 2] * 1e6);
+        printf("p95        %.2f us per solve\n", seconds[samples * 95 / 100] * 1e6);
+        printf("max        %.2f us per solve\n", seconds[samples - 1] * 1e6);
+    }
+
+    free(seconds);
+    coslayout_replay_destroy(replay);
+
+    return 0;
+}
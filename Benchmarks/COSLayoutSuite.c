@@ -0,0 +1,787 @@
+// COSLayoutSuite.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Reproducible benchmark suite of the layout engine.
+//
+// Covers lexing and parsing rules, adding rules end to end, binding rules
+// to programs, solving synthetic hierarchies of headless views, relayout
+// of a solved plan and whole passes capturing, solving and committing
+// frames the way the UIKit solver repeats them. Results are written as JSON and can
+// be compared against a stored baseline. Runs on any POSIX system:
+//
+//   cc -O2 -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutSuite.c ../COSLayout/COSLayoutTree.c
+//      ../COSLayout/COSLayoutProgram.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      ../COSLayout/COSLayoutDump.c
+//      -lpthread -lm -o suite
+//   ./suite [-o results.json] [-c baseline.json] [-t percent] [-f filter] [-q]
+//
+// With -c, changes against the baseline are printed to stderr and the
+// exit status is 1 if any case got slower by more than -t percent,
+// 10 by default. -q takes fewer and shorter samples.
+
+#include "COSLayoutParser.h"
+#include "COSLayoutLex.h"
+#include "COSLayoutProgram.h"
+#include "COSLayoutTree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* The scanner, which only the parser declares. */
+YY_DECL;
+
+#define MAX_CASES 64
+
+static const char *rules[] = {
+    "ll = 12",
+    "tt = %bt + 8",
+    "w = 50% - 24",
+    "h = %h * 2",
+    "rr = %ll - 8",
+    "ct = 50%",
+    "minw = 40",
+    "bb = 12"
+};
+
+#define RULE_COUNT (sizeof(rules) / sizeof(rules[0]))
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* A case runs operations on a state made by setup and returns how many it
+ * ran, so that results are time per operation. */
+typedef struct CASE {
+    const char *name;
+    size_t size;
+    void *(*setup)(size_t size);
+    size_t (*run)(void *state);
+    void (*teardown)(void *state);
+} CASE;
+
+typedef struct RESULT {
+    char name[64];
+    double ns_per_op;
+    double min_ns_per_op;
+} RESULT;
+
+/* Lexing and parsing */
+
+typedef struct RULES {
+    char buffers[RULE_COUNT][64];
+} RULES;
+
+static void *rules_setup(size_t size) {
+    RULES *state = (RULES *)malloc(sizeof(RULES));
+
+    (void)size;
+
+    for (size_t i = 0; i < RULE_COUNT; ++i) {
+        snprintf(state->buffers[i], sizeof(state->buffers[i]), "%s", rules[i]);
+    }
+
+    return state;
+}
+
+static size_t lex_run(void *info) {
+    RULES *state = (RULES *)info;
+
+    for (size_t i = 0; i < RULE_COUNT; ++i) {
+        yyscan_t scanner;
+        COSLAYOUTSTYPE value = NULL;
+
+        coslayoutlex_init(&scanner);
+
+        YY_BUFFER_STATE buffer = coslayout_scan_string(state->buffers[i], scanner);
+
+        while (coslayoutlex(&value, scanner, NULL) > 0) {
+            coslayout_destroy_ast(value);
+            value = NULL;
+        }
+
+        coslayout_delete_buffer(buffer, scanner);
+        coslayoutlex_destroy(scanner);
+    }
+
+    return RULE_COUNT;
+}
+
+static size_t parse_run(void *info) {
+    RULES *state = (RULES *)info;
+
+    for (size_t i = 0; i < RULE_COUNT; ++i) {
+        COSLAYOUT_AST *ast = NULL;
+
+        if (coslayout_parse_rule(state->buffers[i], &ast) == 0) {
+            coslayout_destroy_ast(ast);
+        }
+    }
+
+    return RULE_COUNT;
+}
+
+/* Adding rules end to end, a feed cell per operation */
+
+static void *add_rule_setup(size_t size) {
+    (void)size;
+
+    return coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 375, 120 });
+}
+
+static size_t add_rule_run(void *info) {
+    COSLAYOUT_VIEW *container = (COSLAYOUT_VIEW *)info;
+    COSLAYOUT_VIEW *views[4];
+
+    for (int i = 0; i < 4; ++i) {
+        views[i] = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 0, 0 });
+        coslayout_view_add_subview(container, views[i]);
+    }
+
+    coslayout_view_add_rule(views[0], "ll = 12, tt = 12, w = 40, h = 40");
+    coslayout_view_add_rule(views[1], "ll = %rl + 8, rr = 12, tt = %tt, h = 20", views[0], views[0]);
+    coslayout_view_add_rule(views[2], "ll = %ll, rr = 12, tt = %bt + 4, h = 60", views[1], views[1]);
+    coslayout_view_add_rule(views[3], "ll = %ll, w = 50%, tt = %bt + 8, h = 20", views[1], views[2]);
+
+    for (int i = 0; i < 4; ++i) {
+        coslayout_view_destroy(views[i]);
+    }
+
+    return 4;
+}
+
+static void view_teardown(void *state) {
+    coslayout_view_destroy((COSLAYOUT_VIEW *)state);
+}
+
+/* Binding rules to programs, a view per operation. Views add equal rules
+ * referencing different views, so that all but the first share a program
+ * kept alive by the state and the cost is binding and interning. */
+
+typedef struct BIND {
+    COSLAYOUT_PROGRAM *shared;
+    COSLAYOUT_BINDINGS shared_bindings;
+    COSLAYOUT_PROGRAM **programs;
+    COSLAYOUT_BINDINGS *bindings;
+    size_t count;
+    char refs[];
+} BIND;
+
+typedef struct BIND_ARGS {
+    BIND *state;
+    size_t index;
+} BIND_ARGS;
+
+static const char *bind_rule = "ll = %rl + 8, tt = %tt, w = %w, h = 20";
+
+static COSLAYOUT_EXPR *bind_arg(void *info, const char *spec, int percentage, int dir) {
+    BIND_ARGS *args = (BIND_ARGS *)info;
+
+    (void)percentage;
+    (void)dir;
+
+    return coslayout_expr_create_attr(coslayout_attr_named(spec), &args->state->refs[args->index]);
+}
+
+static void *bind_setup(size_t size) {
+    BIND *state = (BIND *)calloc(1, sizeof(BIND) + size + 1);
+    BIND_ARGS args = { state, size };
+
+    state->programs = (COSLAYOUT_PROGRAM **)calloc(size, sizeof(COSLAYOUT_PROGRAM *));
+    state->bindings = (COSLAYOUT_BINDINGS *)calloc(size, sizeof(COSLAYOUT_BINDINGS));
+    state->count = size;
+    state->shared = coslayout_program_create();
+
+    coslayout_bindings_init(&state->shared_bindings);
+    coslayout_program_add_rule(&state->shared, &state->shared_bindings, bind_rule, bind_arg, &args);
+
+    return state;
+}
+
+static size_t bind_run(void *info) {
+    BIND *state = (BIND *)info;
+
+    for (size_t i = 0; i < state->count; ++i) {
+        BIND_ARGS args = { state, i };
+
+        state->programs[i] = coslayout_program_create();
+        coslayout_bindings_init(&state->bindings[i]);
+
+        coslayout_program_add_rule(&state->programs[i], &state->bindings[i], bind_rule, bind_arg, &args);
+    }
+
+    for (size_t i = 0; i < state->count; ++i) {
+        coslayout_program_release(state->programs[i]);
+        coslayout_bindings_destroy(&state->bindings[i]);
+    }
+
+    return state->count;
+}
+
+static void bind_teardown(void *info) {
+    BIND *state = (BIND *)info;
+
+    coslayout_program_release(state->shared);
+    coslayout_bindings_destroy(&state->shared_bindings);
+
+    free(state->bindings);
+    free(state->programs);
+    free(state);
+}
+
+/* Solving synthetic hierarchies, a layout of the container per operation */
+
+typedef struct HIERARCHY {
+    COSLAYOUT_VIEW *root;
+    COSLAYOUT_VIEW *container;
+} HIERARCHY;
+
+static HIERARCHY *hierarchy_create(void) {
+    HIERARCHY *state = (HIERARCHY *)malloc(sizeof(HIERARCHY));
+
+    state->root = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 375, 10000 });
+    state->container = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 375, 10000 });
+
+    coslayout_view_add_subview(state->root, state->container);
+
+    return state;
+}
+
+static COSLAYOUT_VIEW *hierarchy_add(COSLAYOUT_VIEW *container) {
+    COSLAYOUT_VIEW *view = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 0, 0 });
+
+    coslayout_view_add_subview(container, view);
+
+    return view;
+}
+
+/* Siblings depending on the container only. */
+static void *siblings_setup(size_t size) {
+    HIERARCHY *state = hierarchy_create();
+
+    for (size_t i = 0; i < size; ++i) {
+        coslayout_view_add_rule(hierarchy_add(state->container), "ll = %f, tt = %f, w = 50%, h = 20", (double)(i % 8), (double)i);
+    }
+
+    return state;
+}
+
+/* Each view below the previous one. */
+static void *chain_setup(size_t size) {
+    HIERARCHY *state = hierarchy_create();
+    COSLAYOUT_VIEW *previous = hierarchy_add(state->container);
+
+    coslayout_view_add_rule(previous, "ll = 12, rr = 12, tt = 0, h = 10");
+
+    for (size_t i = 1; i < size; ++i) {
+        COSLAYOUT_VIEW *view = hierarchy_add(state->container);
+
+        coslayout_view_add_rule(view, "ll = %ll, w = %w, tt = %bt + 4, h = 10", previous, previous, previous);
+        previous = view;
+    }
+
+    return state;
+}
+
+/* Every view aligned to one anchor. */
+static void *fanin_setup(size_t size) {
+    HIERARCHY *state = hierarchy_create();
+    COSLAYOUT_VIEW *anchor = hierarchy_add(state->container);
+
+    coslayout_view_add_rule(anchor, "ll = 12, tt = 12, w = 40, h = 40");
+
+    for (size_t i = 1; i < size; ++i) {
+        coslayout_view_add_rule(hierarchy_add(state->container), "ll = %rl + %f, ct = %ct, w = 20, h = %h", anchor, (double)i, anchor, anchor);
+    }
+
+    return state;
+}
+
+/* Views referencing views of another container. */
+static void *foreign_setup(size_t size) {
+    HIERARCHY *state = hierarchy_create();
+    COSLAYOUT_VIEW *other = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 375, 10000 });
+
+    coslayout_view_add_subview(state->root, other);
+
+    for (size_t i = 0; i < size; ++i) {
+        COSLAYOUT_VIEW *target = coslayout_view_create((COSLAYOUT_RECT){ 0, (double)i * 20, 100, 16 });
+
+        coslayout_view_add_subview(other, target);
+        coslayout_view_add_rule(hierarchy_add(state->container), "ll = 120, tt = %tt, w = %w, h = %h", target, target, target);
+    }
+
+    return state;
+}
+
+static size_t hierarchy_run(void *info) {
+    HIERARCHY *state = (HIERARCHY *)info;
+
+    coslayout_view_layout(state->container, NULL);
+
+    return 1;
+}
+
+static void hierarchy_teardown(void *info) {
+    HIERARCHY *state = (HIERARCHY *)info;
+
+    coslayout_view_destroy(state->root);
+    free(state);
+}
+
+/* Relayout of a solved plan: geometry is captured again and nodes are
+ * solved for the inputs that changed, nothing for a steady state and the
+ * horizontal axis for a width change. */
+
+typedef struct PLAN {
+    COSLAYOUT_RULESET *sets;
+    COSLAYOUT_NODE *nodes;
+    COSLAYOUT_SNAPSHOT snapshot;
+    size_t count;
+    double width;
+    int resize;
+    int solved;
+    char refs[];
+} PLAN;
+
+typedef struct PLAN_ARGS {
+    PLAN *plan;
+    size_t index;
+} PLAN_ARGS;
+
+static COSLAYOUT_EXPR *plan_arg(void *info, const char *spec, int percentage, int dir) {
+    PLAN_ARGS *args = (PLAN_ARGS *)info;
+
+    (void)percentage;
+    (void)dir;
+
+    /* Every view specifier references the previous view. */
+    return coslayout_expr_create_attr(coslayout_attr_named(spec), &args->plan->refs[args->index]);
+}
+
+static void *plan_setup(size_t size, int resize) {
+    PLAN *plan = (PLAN *)calloc(1, sizeof(PLAN) + size + 1);
+
+    plan->sets = (COSLAYOUT_RULESET *)calloc(size, sizeof(COSLAYOUT_RULESET));
+    plan->nodes = (COSLAYOUT_NODE *)calloc(size, sizeof(COSLAYOUT_NODE));
+    plan->count = size;
+    plan->width = 375;
+    plan->resize = resize;
+
+    COSLAYOUT_NODE *unsorted = (COSLAYOUT_NODE *)calloc(size, sizeof(COSLAYOUT_NODE));
+    size_t *order = (size_t *)malloc(size * sizeof(size_t));
+
+    /* Ref 0 is the container, ref i + 1 view i. Every fourth view starts a
+     * column, the others stack below the previous view. */
+    for (size_t i = 0; i < size; ++i) {
+        PLAN_ARGS args = { plan, i };
+
+        coslayout_ruleset_init(&plan->sets[i]);
+
+        if (i % 4 == 0) {
+            coslayout_ruleset_add_rule(&plan->sets[i], "ll = 12, w = 50% - 24, tt = 12, h = 20", NULL, NULL);
+        } else {
+            coslayout_ruleset_add_rule(&plan->sets[i], "ll = %ll, w = %w, tt = %bt + 4, h = 20", plan_arg, &args);
+        }
+
+        unsorted[i].set = &plan->sets[i];
+        unsorted[i].view = &plan->refs[i + 1];
+        unsorted[i].superview = &plan->refs[0];
+    }
+
+    coslayout_nodes_order(unsorted, size, order);
+
+    for (size_t i = 0; i < size; ++i) {
+        plan->nodes[i] = unsorted[order[i]];
+    }
+
+    free(order);
+    free(unsorted);
+
+    coslayout_snapshot_init(&plan->snapshot);
+
+    return plan;
+}
+
+static void *steady_setup(size_t size) {
+    return plan_setup(size, 0);
+}
+
+static void *resize_setup(size_t size) {
+    return plan_setup(size, 1);
+}
+
+static size_t plan_run(void *info) {
+    PLAN *plan = (PLAN *)info;
+
+    int inputs = 0;
+
+    if (plan->resize) {
+        plan->width = plan->width == 375 ? 414 : 375;
+        inputs = COSLAYOUT_READ_WIDTH | COSLAYOUT_READ_VIEW_H;
+    }
+
+    COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_insert(&plan->snapshot, &plan->refs[0]);
+
+    entry->rect = (COSLAYOUT_RECT){ 0, 0, plan->width, 10000 };
+
+    for (size_t i = 0; i < plan->count; ++i) {
+        COSLAYOUT_NODE *node = &plan->nodes[i];
+
+        node->start = node->frame;
+
+        entry = coslayout_snapshot_insert(&plan->snapshot, node->view);
+        entry->rect = node->frame;
+        entry->width = plan->width;
+        entry->height = 10000;
+    }
+
+    /* The first pass solves everything. */
+    coslayout_nodes_solve(plan->nodes, plan->count, &plan->snapshot, &plan->refs[0], plan->solved ? inputs : -1, NULL);
+
+    plan->solved = 1;
+
+    return 1;
+}
+
+static void plan_teardown(void *info) {
+    PLAN *plan = (PLAN *)info;
+
+    for (size_t i = 0; i < plan->count; ++i) {
+        coslayout_ruleset_destroy(&plan->sets[i]);
+    }
+
+    coslayout_snapshot_destroy(&plan->snapshot);
+
+    free(plan->nodes);
+    free(plan->sets);
+    free(plan);
+}
+
+/* Whole passes over a plan, the way the UIKit solver runs them: geometry
+ * of the views is captured into a new snapshot, views moved since the last
+ * commit add to the inputs, nodes are solved and changed frames are
+ * committed back to the views, keeping the snapshot as the geometry of the
+ * next pass. Frames stand for the views. */
+
+typedef struct PASS {
+    PLAN *plan;
+    COSLAYOUT_RECT *frames;
+    COSLAYOUT_SNAPSHOT geometry;
+    double width;
+    int sized;
+    size_t changed;
+} PASS;
+
+static void *pass_setup(size_t size, int resize) {
+    PASS *pass = (PASS *)calloc(1, sizeof(PASS));
+
+    pass->plan = (PLAN *)plan_setup(size, resize);
+    pass->frames = (COSLAYOUT_RECT *)calloc(size, sizeof(COSLAYOUT_RECT));
+
+    coslayout_snapshot_init(&pass->geometry);
+
+    return pass;
+}
+
+static void *pass_steady_setup(size_t size) {
+    return pass_setup(size, 0);
+}
+
+static void *pass_resize_setup(size_t size) {
+    return pass_setup(size, 1);
+}
+
+static size_t pass_run(void *info) {
+    PASS *pass = (PASS *)info;
+    PLAN *plan = pass->plan;
+    COSLAYOUT_SNAPSHOT snapshot;
+
+    if (plan->resize) {
+        plan->width = plan->width == 375 ? 414 : 375;
+    }
+
+    int inputs = -1;
+
+    if (pass->sized) {
+        inputs = plan->width != pass->width ? COSLAYOUT_READ_WIDTH | COSLAYOUT_READ_VIEW_H : 0;
+    }
+
+    /* Capture */
+    coslayout_snapshot_init(&snapshot);
+
+    COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_insert(&snapshot, &plan->refs[0]);
+
+    entry->rect = (COSLAYOUT_RECT){ 0, 0, plan->width, 10000 };
+
+    for (size_t i = 0; i < plan->count; ++i) {
+        COSLAYOUT_NODE *node = &plan->nodes[i];
+        COSLAYOUT_RECT frame = pass->frames[(char *)node->view - plan->refs - 1];
+
+        node->start = frame;
+        node->frame = frame;
+
+        entry = coslayout_snapshot_insert(&snapshot, node->view);
+        entry->rect = frame;
+        entry->width = plan->width;
+        entry->height = 10000;
+    }
+
+    if (inputs >= 0) {
+        int moved = coslayout_snapshot_changed_inputs(&pass->geometry, &snapshot);
+
+        inputs = moved < 0 ? -1 : inputs | moved;
+    }
+
+    coslayout_nodes_solve(plan->nodes, plan->count, &snapshot, &plan->refs[0], inputs, NULL);
+
+    /* Commit */
+    for (size_t i = 0; i < plan->count; ++i) {
+        COSLAYOUT_NODE *node = &plan->nodes[i];
+        COSLAYOUT_RECT *frame = &pass->frames[(char *)node->view - plan->refs - 1];
+
+        if (coslayout_rect_changed_axes(*frame, node->frame)) {
+            *frame = node->frame;
+            pass->changed += 1;
+        }
+    }
+
+    pass->width = plan->width;
+    pass->sized = 1;
+
+    coslayout_snapshot_copy(&pass->geometry, &snapshot);
+    coslayout_snapshot_destroy(&snapshot);
+
+    return 1;
+}
+
+static void pass_teardown(void *info) {
+    PASS *pass = (PASS *)info;
+
+    plan_teardown(pass->plan);
+    coslayout_snapshot_destroy(&pass->geometry);
+
+    free(pass->frames);
+    free(pass);
+}
+
+static const CASE cases[] = {
+    { "lex/rule", 1, rules_setup, lex_run, free },
+    { "parse/rule", 1, rules_setup, parse_run, free },
+    { "add_rule/feed", 4, add_rule_setup, add_rule_run, view_teardown },
+    { "program/bind", 100, bind_setup, bind_run, bind_teardown },
+    { "solve/siblings", 1000, siblings_setup, hierarchy_run, hierarchy_teardown },
+    { "solve/chain", 200, chain_setup, hierarchy_run, hierarchy_teardown },
+    { "solve/fanin", 500, fanin_setup, hierarchy_run, hierarchy_teardown },
+    { "solve/foreign", 200, foreign_setup, hierarchy_run, hierarchy_teardown },
+    { "relayout/steady", 1000, steady_setup, plan_run, plan_teardown },
+    { "relayout/resize", 1000, resize_setup, plan_run, plan_teardown },
+    { "pass/steady", 1000, pass_steady_setup, pass_run, pass_teardown },
+    { "pass/resize", 1000, pass_resize_setup, pass_run, pass_teardown }
+};
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+/* Median and minimum of samples, each running batches of operations for
+ * at least min_time seconds after one warm up run. */
+static void run_case(const CASE *c, int samples, double min_time, RESULT *result) {
+    void *state = c->setup(c->size);
+    double times[16];
+
+    c->run(state);
+
+    for (int s = 0; s < samples; ++s) {
+        size_t ops = 0;
+        double start = now();
+        double elapsed;
+
+        do {
+            ops += c->run(state);
+            elapsed = now() - start;
+        } while (elapsed < min_time);
+
+        times[s] = elapsed * 1e9 / ops;
+    }
+
+    c->teardown(state);
+
+    qsort(times, (size_t)samples, sizeof(double), compare_doubles);
+
+    snprintf(result->name, sizeof(result->name), "%s", c->name);
+
+    result->ns_per_op = times[samples / 2];
+    result->min_ns_per_op = times[0];
+}
+
+static void write_json(FILE *file, const RESULT *results, size_t count, int samples) {
+    fprintf(file, "{\n  \"suite\": \"coslayout\",\n  \"samples\": %d,\n  \"results\": [\n", samples);
+
+    for (size_t i = 0; i < count; ++i) {
+        const CASE *c = NULL;
+
+        for (size_t j = 0; j < sizeof(cases) / sizeof(cases[0]); ++j) {
+            if (strcmp(cases[j].name, results[i].name) == 0) c = &cases[j];
+        }
+
+        fprintf(file, "    {\"name\": \"%s\", \"size\": %zu, \"ns_per_op\": %.1f, \"min_ns_per_op\": %.1f}%s\n",
+                results[i].name, c->size, results[i].ns_per_op, results[i].min_ns_per_op, i + 1 < count ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+}
+
+/* Reads results written by write_json, one per line. */
+static size_t read_json(const char *path, RESULT *results, size_t capacity) {
+    FILE *file = fopen(path, "r");
+    char line[512];
+    size_t count = 0;
+
+    if (file == NULL) return 0;
+
+    while (count < capacity && fgets(line, sizeof(line), file) != NULL) {
+        const char *name = strstr(line, "\"name\": \"");
+        const char *ns = strstr(line, "\"ns_per_op\": ");
+
+        if (name == NULL || ns == NULL) continue;
+
+        name += strlen("\"name\": \"");
+
+        size_t length = strcspn(name, "\"");
+
+        if (length >= sizeof(results[count].name)) continue;
+
+        memcpy(results[count].name, name, length);
+        results[count].name[length] = '\0';
+        results[count].ns_per_op = atof(ns + strlen("\"ns_per_op\": "));
+
+        count += 1;
+    }
+
+    fclose(file);
+
+    return count;
+}
+
+/* Returns the number of cases slower than the baseline by more than
+ * threshold percent. */
+static int compare(const RESULT *results, size_t count, const RESULT *baseline, size_t baseline_count, double threshold) {
+    int regressions = 0;
+
+    fprintf(stderr, "%-20s %14s %14s %9s\n", "case", "baseline ns", "current ns", "change");
+
+    for (size_t i = 0; i < count; ++i) {
+        const RESULT *base = NULL;
+
+        for (size_t j = 0; j < baseline_count; ++j) {
+            if (strcmp(baseline[j].name, results[i].name) == 0) base = &baseline[j];
+        }
+
+        if (base == NULL || base->ns_per_op <= 0) {
+            fprintf(stderr, "%-20s %14s %14.1f %9s\n", results[i].name, "-", results[i].ns_per_op, "new");
+            continue;
+        }
+
+        double change = (results[i].ns_per_op / base->ns_per_op - 1) * 100;
+        int regressed = change > threshold;
+
+        fprintf(stderr, "%-20s %14.1f %14.1f %+8.1f%%%s\n", results[i].name, base->ns_per_op, results[i].ns_per_op, change, regressed ? "  slower" : "");
+
+        regressions += regressed;
+    }
+
+    return regressions;
+}
+
+int main(int argc, char **argv) {
+    const char *output = NULL;
+    const char *baseline_path = NULL;
+    const char *filter = NULL;
+    double threshold = 10;
+    int samples = 7;
+    double min_time = 0.2;
+    int option;
+
+    while ((option = getopt(argc, argv, "o:c:t:f:q")) != -1) {
+        switch (option) {
+        case 'o': output = optarg; break;
+        case 'c': baseline_path = optarg; break;
+        case 't': threshold = atof(optarg); break;
+        case 'f': filter = optarg; break;
+        case 'q': samples = 3; min_time = 0.05; break;
+        default:
+            fprintf(stderr, "usage: %s [-o results.json] [-c baseline.json] [-t percent] [-f filter] [-q]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    RESULT results[MAX_CASES];
+    size_t count = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        if (filter != NULL && strstr(cases[i].name, filter) == NULL) continue;
+
+        run_case(&cases[i], samples, min_time, &results[count++]);
+    }
+
+    FILE *file = output ? fopen(output, "w") : stdout;
+
+    if (file == NULL) {
+        perror(output);
+        return 2;
+    }
+
+    write_json(file, results, count, samples);
+
+    if (file != stdout) fclose(file);
+
+    if (baseline_path != NULL) {
+        RESULT baseline[MAX_CASES];
+        size_t baseline_count = read_json(baseline_path, baseline, MAX_CASES);
+
+        if (baseline_count == 0) {
+            fprintf(stderr, "%s: no results to compare with\n", baseline_path);
+            return 2;
+        }
+
+        if (compare(results, count, baseline, baseline_count, threshold) > 0) return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+// COSLayoutTemplateBench.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Throughput of precomputing cell heights from a template.
+//
+// Solves a feed cell, an avatar beside a name with a body and a footer
+// below, for rows of varying content sizes, the way a table view would
+// before its cells exist, first one row at a time and then in batches
+// over 1, 2, 4 and 8 threads. Runs on any POSIX system:
+//
+//   cc -O2 -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutTemplateBench.c ../COSLayout/COSLayoutTemplate.c
+//      ../COSLayout/COSLayoutCore.c ../COSLayout/COSLayoutParser.c
+//      ../COSLayout/COSLayoutLex.c ../COSLayout/COSLayoutPool.c
+//      ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      -lpthread -lm -o template-bench
+//   ./template-bench [rows] [width]
+
+#include "COSLayoutTemplate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    size_t rows = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+    double width = argc > 2 ? atof(argv[2]) : 375;
+
+    COSLAYOUT_TEMPLATE *tmpl = coslayout_template_create();
+
+    int avatar = coslayout_template_add_slot(tmpl, "avatar");
+    int name = coslayout_template_add_slot(tmpl, "name");
+    int body = coslayout_template_add_slot(tmpl, "body");
+    int footer = coslayout_template_add_slot(tmpl, "footer");
+    int bottom = coslayout_template_add_slot(tmpl, "bottom");
+
+    coslayout_template_add_rule(tmpl, avatar, "ll = 12, tt = 12, w = 40, h = 40");
+    coslayout_template_add_rule(tmpl, name, "ll = %rl + 8, rr = 12, tt = 12, h = %h",
+                                avatar, COSLAYOUT_CONTENT(name));
+    coslayout_template_add_rule(tmpl, body, "ll = %ll, rr = 12, tt = %bt + 4, h = %h",
+                                name, name, COSLAYOUT_CONTENT(body));
+    coslayout_template_add_rule(tmpl, footer, "ll = %ll, w = 50%, tt = %bt + 8, h = 20",
+                                name, body);
+    coslayout_template_add_rule(tmpl, bottom, "ll = 0, w = 0, tt = %bt + 12, h = 0", footer);
+
+    if (coslayout_template_compile(tmpl) != 0) {
+        fprintf(stderr, "template has a cycle\n");
+        return 1;
+    }
+
+    size_t count = coslayout_template_slot_count(tmpl);
+
+    COSLAYOUT_SIZE *contents = (COSLAYOUT_SIZE *)calloc(rows * count, sizeof(COSLAYOUT_SIZE));
+    COSLAYOUT_RECT *frames = (COSLAYOUT_RECT *)calloc(count, sizeof(COSLAYOUT_RECT));
+
+    srand(1);
+
+    for (size_t r = 0; r < rows; ++r) {
+        contents[r * count + name].h = 16 + rand() % 2 * 18;
+        contents[r * count + body].h = 18 * (1 + rand() % 12);
+    }
+
+    COSLAYOUT_SCRATCH scratch;
+
+    coslayout_scratch_init(&scratch);
+
+    double total = 0;
+    double start = now();
+
+    for (size_t r = 0; r < rows; ++r) {
+        total += coslayout_template_solve(tmpl, &scratch, width, &contents[r * count], frames);
+    }
+
+    double elapsed = now() - start;
+
+    printf("rows %zu, width %.0f, processors %ld\n", rows, width, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%8s %12s %12s %10s\n", "threads", "rows/sec", "us/row", "speedup");
+    printf("%8s %12.0f %12.3f %10s  (mean height %.2f)\n", "single", rows / elapsed, elapsed * 1e6 / rows, "", total / rows);
+
+    COSLAYOUT_RECT *batch = (COSLAYOUT_RECT *)calloc(rows * count, sizeof(COSLAYOUT_RECT));
+    double *heights = (double *)calloc(rows, sizeof(double));
+
+    int threads[] = { 1, 2, 4, 8 };
+    double base = 0;
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+        COSLAYOUT_POOL *pool = coslayout_pool_create(threads[t]);
+
+        start = now();
+        coslayout_template_solve_batch(tmpl, pool, width, rows, contents, batch, heights);
+        elapsed = now() - start;
+
+        double sum = 0;
+
+        for (size_t r = 0; r < rows; ++r) {
+            sum += heights[r];
+        }
+
+        if (t == 0) base = elapsed;
+
+        printf("%8d %12.0f %12.3f %10.2f%s\n", threads[t], rows / elapsed, elapsed * 1e6 / rows, base / elapsed,
+               sum == total ? "" : "  (heights differ)");
+
+        coslayout_pool_destroy(pool);
+    }
+
+    coslayout_scratch_destroy(&scratch);
+    coslayout_template_destroy(tmpl);
+
+    free(heights);
+    free(batch);
+    free(frames);
+    free(contents);
+
+    return 0;
+}
@@ -27,14 +27,222 @@
 #import <UIKit/UIKit.h>
 
 
+typedef struct COSLayoutCacheStatistics {
+    NSUInteger hits;
+    NSUInteger misses;
+    NSUInteger evictions;
+    NSUInteger count;
+    NSUInteger bytes;
+} COSLayoutCacheStatistics;
+
+
+// Totals since statistics were enabled or reset. Views are views solved,
+// evaluations are rules evaluated and changed frames are frames that
+// changed when applied. Elapsed is the time counted, so that passes over
+// elapsed is solves per second.
+typedef struct COSLayoutStatistics {
+    NSUInteger passes;
+    NSUInteger views;
+    NSUInteger evaluations;
+    NSUInteger changedFrames;
+    NSTimeInterval solveTime;
+    NSUInteger parses;
+    NSTimeInterval parseTime;
+    NSTimeInterval elapsed;
+} COSLayoutStatistics;
+
+typedef struct COSLayoutPassStatistics {
+    NSUInteger views;
+    NSUInteger evaluations;
+    NSUInteger changedFrames;
+    NSTimeInterval solveTime;
+} COSLayoutPassStatistics;
+
+typedef void (^COSLayoutPassHandler)(COSLayoutPassStatistics statistics);
+
+
+// Time spent on one rule while profiling, summed over every view using it.
+// Rule is the whole text added, subrule the index of the comma separated
+// rule in it and attribute the coordinate it was evaluated for.
+@interface COSLayoutRuleProfile : NSObject
+
+@property (nonatomic, copy, readonly) NSString *rule;
+@property (nonatomic, assign, readonly) NSUInteger subrule;
+@property (nonatomic, copy, readonly) NSString *attribute;
+@property (nonatomic, assign, readonly) NSUInteger calls;
+@property (nonatomic, assign, readonly) NSTimeInterval time;
+
+@end
+
+
+// A view of a solve over budget, with the rules it was solved with.
+@interface COSLayoutSlowView : NSObject
+
+@property (nonatomic, weak, readonly) UIView *view;
+@property (nonatomic, assign, readonly) NSTimeInterval solveTime;
+@property (nonatomic, copy, readonly) NSArray *rules;
+
+@end
+
+// Views are the slowest views of the solve, slowest first.
+typedef void (^COSLayoutSlowSolveHandler)(UIView *container, NSTimeInterval solveTime, NSArray *views);
+
+typedef NS_ENUM(NSInteger, COSLayoutGraphFormat) {
+    COSLayoutGraphFormatDOT = 0,
+    COSLayoutGraphFormatJSON
+};
+
+
+typedef CGFloat(^COSFloatBlock)(UIView *);
+
+// Provider of %*f and %*p, called with its context and the view laid out
+// on every evaluation, without a block or a message send. The context is
+// not retained, it must outlive the rule.
+typedef double (*COSFloatFunction)(void *context, __unsafe_unretained UIView *view);
+
+typedef struct COSFloatProvider {
+    COSFloatFunction function;
+    void *context;
+} COSFloatProvider;
+
+typedef NS_ENUM(NSInteger, COSLayoutArgumentType) {
+    COSLayoutArgumentFloat = 0,
+    COSLayoutArgumentView,
+    COSLayoutArgumentBlock,
+    COSLayoutArgumentObject,
+    COSLayoutArgumentFunction
+};
+
+// Argument of a rule: a float for %f and percentages, a view for rule
+// names like %tt, a block for %^f, an object for %@ and a function with
+// its context for %*f. Arguments are not retained, they must outlive the
+// call adding the rule.
+typedef struct COSLayoutArgument {
+    COSLayoutArgumentType type;
+    union {
+        CGFloat floatValue;
+        __unsafe_unretained UIView *view;
+        __unsafe_unretained COSFloatBlock block;
+        __unsafe_unretained id object;
+        COSFloatProvider provider;
+    };
+} COSLayoutArgument;
+
+NS_INLINE COSLayoutArgument COSLayoutFloatArgument(CGFloat value) {
+    return (COSLayoutArgument){ .type = COSLayoutArgumentFloat, .floatValue = value };
+}
+
+NS_INLINE COSLayoutArgument COSLayoutViewArgument(UIView *view) {
+    return (COSLayoutArgument){ .type = COSLayoutArgumentView, .view = view };
+}
+
+NS_INLINE COSLayoutArgument COSLayoutBlockArgument(COSFloatBlock block) {
+    return (COSLayoutArgument){ .type = COSLayoutArgumentBlock, .block = block };
+}
+
+NS_INLINE COSLayoutArgument COSLayoutObjectArgument(id object) {
+    return (COSLayoutArgument){ .type = COSLayoutArgumentObject, .object = object };
+}
+
+NS_INLINE COSLayoutArgument COSLayoutFunctionArgument(COSFloatFunction function, void *context) {
+    return (COSLayoutArgument){ .type = COSLayoutArgumentFunction, .provider = { function, context } };
+}
+
+
 @interface COSLayout : NSObject
 
 + (instancetype)layoutOfView:(UIView *)view;
 
+// Frames solved for containers with a content key are cached, least
+// recently used first out. Zero means no limit.
++ (void)setCacheCountLimit:(NSUInteger)countLimit byteLimit:(NSUInteger)byteLimit;
+
++ (COSLayoutCacheStatistics)cacheStatistics;
++ (void)resetCacheStatistics;
++ (void)clearCache;
+
+// Statistics are off by default and cost next to nothing while off.
++ (void)setStatisticsEnabled:(BOOL)enabled;
++ (BOOL)statisticsEnabled;
+
++ (COSLayoutStatistics)statistics;
++ (void)resetStatistics;
+
+// Called after every solve while statistics are enabled, on the thread
+// solving, with no lock held. Calls may run concurrently, and may still
+// end after the handler is replaced. Nil removes the handler.
++ (void)setPassHandler:(COSLayoutPassHandler)handler;
+
+// Profiling times every rule evaluated and adds the time to the rule it
+// was added as. It is off by default and slows solving while on.
++ (void)setProfilingEnabled:(BOOL)enabled;
++ (BOOL)profilingEnabled;
+
+// Rules taking the most time since profiling began or was reset, slowest
+// first, at most limit of them.
++ (NSArray *)profiledRulesWithLimit:(NSUInteger)limit;
++ (void)resetProfile;
+
+// Solves taking longer than budget are reported to handler on the thread
+// solving, with no lock held, or logged if handler is nil. A budget of
+// zero disarms it. Reports may run concurrently, and may still end after
+// the handler is replaced.
++ (void)setSolveBudget:(NSTimeInterval)budget handler:(COSLayoutSlowSolveHandler)handler;
+
+// Tracing records spans of adding rules, ordering views, solving views and
+// committing frames, tagged with the views and their superviews. Spans are
+// kept per thread until written, in the Chrome trace event format, which
+// drains them. Returns NO if the file can not be written.
++ (void)setTracingEnabled:(BOOL)enabled;
++ (BOOL)tracingEnabled;
++ (BOOL)writeTraceToFile:(NSString *)path;
+
+// Records rules added with their arguments, views moving and frames
+// changed before each solve to a session file, which replays the same
+// solves on headless views, see Benchmarks/COSLayoutReplay.c. Blocks and
+// objects are recorded as their values when rules are added. Returns NO if
+// the file can not be opened or a session is already recorded.
++ (BOOL)startRecordingToFile:(NSString *)path;
++ (BOOL)stopRecording;
+
+// Solvers keep the evaluations and solve time of their views over their
+// last passes. Zero, the default, keeps none.
++ (void)setCostHistory:(NSUInteger)passes;
+
+// Writes the dependency graph of the views laid out in view: a node per
+// constrained view with its rules, level, number of dependents and costs
+// over the passes kept, and an edge from each view to the views whose
+// rules reference it. Returns NO if the file can not be written.
++ (BOOL)writeDependencyGraphOfView:(UIView *)view toFile:(NSString *)path format:(COSLayoutGraphFormat)format;
+
 - (void)addRule:(NSString *)format, ...;
 - (void)addRule:(NSString *)format args:(va_list)args;
 - (void)addRule:(NSString *)format arguments:(NSArray *)arguments;
 
+// Adds a rule with count typed arguments, in the order of its specifiers.
+// A rule whose arguments do not match the types of its specifiers is
+// ignored. Binding arguments allocates nothing.
+- (void)addRule:(NSString *)format arguments:(const COSLayoutArgument *)arguments count:(NSUInteger)count;
+
+// Rules reference parameters by name, as in @"tt = $topInset + 8". A
+// parameter of the view wins over the one of its superview, unset ones
+// are zero. Setting a value re-solves only the views reading it, no rule
+// is parsed again.
+- (void)setValue:(CGFloat)value forParameter:(NSString *)name;
+- (CGFloat)valueForParameter:(NSString *)name;
+
+@end
+
+
+// Frames of subviews computed from a snapshot of geometry.
+// -compute can be called on any thread, blocks and objects used as rule
+// arguments are then called on that thread. -commit must be called on the
+// main thread, it computes the pass first if needed.
+@interface COSLayoutPass : NSObject
+
+- (void)compute;
+- (void)commit;
+
 @end
 
 
@@ -42,6 +250,37 @@
 
 @property (nonatomic, strong, readonly) COSLayout *coslayout;
 
+// Captures geometry of subviews, must be called on the main thread.
+- (COSLayoutPass *)coslayoutPass;
+
+// Key of whatever rules do not describe, like values of blocks and
+// objects. When set, frames of subviews are reused from an earlier layout
+// with equal rules, bounds size, key and geometry of the views the rules
+// read but do not solve. Zero, the default, disables caching.
+@property (nonatomic, assign) NSUInteger coslayoutContentKey;
+
+// Whether layoutSubviews of the view solves its constrained subviews, YES
+// by default. The first constrained subview hooks layoutSubviews of the
+// class of the view. Clear it before adding subviews to keep the class
+// untouched, e.g. for private or already swizzled classes, and commit a
+// -coslayoutPass from its layoutSubviews instead.
+@property (nonatomic, assign) BOOL coslayoutDrivesLayout;
+
+// Names view for rules of the views below this one, which reference it
+// as name.attr, e.g. @"tt = header.bt + 8", without arguments. Names are
+// looked up in the superview of the view ruled, then in its ancestors,
+// when the rule is added, so name views before adding rules referencing
+// them. Adding a rule with a name not found raises an exception and adds
+// none of the rule. Rules added before keep the view they found when the
+// name is set again. The view is not retained, nil removes the name.
+- (void)coslayoutSetView:(UIView *)view forName:(NSString *)name;
+- (UIView *)coslayoutViewForName:(NSString *)name;
+
+// Parameters of the view as a container, read by rules of its subviews.
+// Containers whose rules read parameters are not cached.
+- (void)coslayoutSetValue:(CGFloat)value forParameter:(NSString *)name;
+- (CGFloat)coslayoutValueForParameter:(NSString *)name;
+
 @end
 
 
@@ -24,27 +24,33 @@
 // OTHER DEALINGS IN THE SOFTWARE.
 
 #import "COSLayout.h"
-#import "COSLayoutParser.h"
+#import "COSLayoutCore.h"
+#import "COSLayoutCache.h"
+#import "COSLayoutDump.h"
+#import "COSLayoutProfile.h"
+#import "COSLayoutProgram.h"
+#import "COSLayoutRegistry.h"
+#import "COSLayoutSession.h"
+#import "COSLayoutStats.h"
+#import "COSLayoutTrace.h"
 
 #import <objc/runtime.h>
+#import <pthread.h>
 
 #define COS_STREQ(a, b) (strcmp(a, b) == 0)
 
-@class COSLayoutRule;
-
-typedef CGFloat(^COSFloatBlock)(UIView *);
-typedef CGFloat(^COSCoordBlock)(COSLayoutRule *);
-
-typedef NS_ENUM(NSInteger, COSLayoutDir) {
-    COSLayoutDirv = 1,
-    COSLayoutDirh
-};
+#define COSLAYOUT_RECT_FROM_CG(rect) \
+    ((COSLAYOUT_RECT){ (rect).origin.x, (rect).origin.y, (rect).size.width, (rect).size.height })
 
 static const void *COSLayoutKey = &COSLayoutKey;
-static const void *COSLayoutDriverKey = &COSLayoutDriverKey;
+static const void *COSLayoutSolverKey = &COSLayoutSolverKey;
+static const void *COSLayoutSessionKey = &COSLayoutSessionKey;
 
-static NSMutableSet *swizzledDriverClasses = nil;
-static NSMutableSet *swizzledLayoutClasses = nil;
+// Classes whose methods are hooked. Checks take no lock, so views may be
+// constrained on any thread, hooking itself is serialized.
+static COSLAYOUT_REGISTRY *swizzledDriverClasses = NULL;
+static COSLAYOUT_REGISTRY *swizzledLayoutClasses = NULL;
+static pthread_mutex_t swizzleMutex = PTHREAD_MUTEX_INITIALIZER;
 
 static NSString *COSLayoutCycleExceptionName = @"COSLayoutCycleException";
 static NSString *COSLayoutCycleExceptionDesc = @"Layout can not be solved because of cycle";
@@ -52,1625 +58,2006 @@ static NSString *COSLayoutCycleExceptionDesc = @"Layout can not be solved becaus
 static NSString *COSLayoutSyntaxExceptionName = @"COSLayoutSyntaxException";
 static NSString *COSLayoutSyntaxExceptionDesc = @"Layout rule has a syntax error";
 
+static NSString *COSLayoutNameExceptionName = @"COSLayoutNameException";
+static NSString *COSLayoutNameExceptionDesc = @"Layout rule references a name no container above the view has";
 
-@interface COSCoord : NSObject
+#define COSLAYOUT_CACHE_COUNT_LIMIT 512
+#define COSLAYOUT_CACHE_BYTE_LIMIT (1 << 20)
 
-+ (instancetype)nilCoord;
 
-+ (instancetype)coordWithFloat:(CGFloat)value;
-+ (instancetype)coordWithPercentage:(CGFloat)percentage;
-+ (instancetype)coordWithPercentage:(CGFloat)percentage dir:(COSLayoutDir)dir;
-+ (instancetype)coordWithBlock:(COSCoordBlock)block;
+@interface COSLayout ()
 
-@property (nonatomic, strong) NSMutableSet *dependencies;
-@property (nonatomic, copy) COSCoordBlock block;
+@property (nonatomic, weak) UIView *view;
 
-- (instancetype)add:(COSCoord *)other;
-- (instancetype)sub:(COSCoord *)other;
-- (instancetype)mul:(COSCoord *)other;
-- (instancetype)div:(COSCoord *)other;
+@property (nonatomic, assign) CGRect frame;
 
-- (BOOL)valid;
+- (instancetype)initWithView:(UIView *)view;
 
-@end
+- (void)updateLayoutDriver;
 
+/* Bumped whenever rules of the layout change or its view moves, so that
+ * plans including the layout know they are stale. */
+- (NSUInteger)generation;
 
-@interface COSCoords : NSObject
+- (NSSet *)dependencies;
+
+- (void)referenceView:(UIView *)view;
 
-+ (instancetype)coordsOfView:(UIView *)view;
+- (COSLAYOUT_PROGRAM *)program;
+- (const COSLAYOUT_RULESET *)ruleSet;
+- (const COSLAYOUT_BINDINGS *)bindings;
+- (const COSLAYOUT_PARAMS *)params;
+
+- (int)applyFrame:(COSLAYOUT_RECT)rect;
 
 @end
 
 
-@interface COSLayoutRule : NSObject
+@interface COSLayoutPlan : NSObject
 
-+ (instancetype)layoutRuleWithView:(UIView *)view
-    name:(NSString *)name
-    coord:(COSCoord *)coord
-    dir:(COSLayoutDir)dir;
+/* Generation of the solver of the container the plan was made at. */
+@property (nonatomic, readonly) NSUInteger generation;
 
-@property (nonatomic, weak) UIView *view;
-@property (nonatomic, copy) NSString *name;
-@property (nonatomic, strong) COSCoord *coord;
-@property (nonatomic, assign) COSLayoutDir dir;
+/* Equal for plans of containers with the same rules, see COSLayoutCache.h. */
+@property (nonatomic, readonly) uint64_t signature;
 
-- (CGFloat)floatValue;
+@property (nonatomic, readonly) NSPointerArray *views;
+@property (nonatomic, readonly) NSArray *linearLayouts;
+@property (nonatomic, readonly) NSArray *generalLayouts;
 
-- (BOOL)valid;
+/* Whether rules of general layouts read parameters. */
+@property (nonatomic, readonly) BOOL readsParameters;
 
-@end
++ (NSArray *)layoutsOfContainer:(UIView *)container;
 
+- (instancetype)initWithView:(UIView *)container generation:(NSUInteger)generation;
 
-@interface COSLayoutRuleHub : NSObject
+/* Whether the solver is still at generation and no layout of the plan
+ * changed since it was made. */
+- (BOOL)isCurrentForGeneration:(NSUInteger)generation;
 
-@property (nonatomic, readonly) NSMutableArray *vRules;
-@property (nonatomic, readonly) NSMutableArray *hRules;
+- (const COSLAYOUT_AFFINE_TABLE *)table;
+- (const COSLAYOUT_RULESET *)ruleSetAtIndex:(NSUInteger)index;
+- (COSLAYOUT_EXPR *const *)bindingsAtIndex:(NSUInteger)index;
+- (const int *)levels;
 
-- (void)vAddRule:(COSLayoutRule *)rule;
-- (void)hAddRule:(COSLayoutRule *)rule;
+/* Whether layouts of subviews of container read the parameter, which is
+ * interned. */
+- (BOOL)readsParameter:(const char *)name ofContainer:(UIView *)container;
 
 @end
 
 
-@interface COSLayout ()
+@interface COSLayoutSolver : NSObject
 
-@property (nonatomic, weak) UIView *view;
++ (instancetype)layoutSolverOfView:(UIView *)view;
 
-@property (nonatomic, strong) COSLayoutRuleHub *ruleHub;
-@property (nonatomic, strong) NSMutableDictionary *ruleMap;
+@property (nonatomic, weak) UIView *view;
 
-@property (nonatomic, strong) COSLayoutRule *wRule;
-@property (nonatomic, strong) COSLayoutRule *hRule;
+@property (nonatomic, assign) NSUInteger contentKey;
 
-@property (nonatomic, strong) COSCoord *w;
-@property (nonatomic, strong) COSCoord *h;
+/* Set when a constrained view moves into the container. Its layoutSubviews
+ * then solves, unless drivesLayout, YES by default, was cleared. */
+@property (nonatomic, assign) BOOL constrainsSubviews;
+@property (nonatomic, assign) BOOL drivesLayout;
 
-@property (nonatomic, strong) COSCoord *minw;
-@property (nonatomic, strong) COSCoord *maxw;
+- (instancetype)initWithView:(UIView *)view;
 
-@property (nonatomic, strong) COSCoord *minh;
-@property (nonatomic, strong) COSCoord *maxh;
+- (BOOL)drivesLayoutOfView:(UIView *)view;
 
-@property (nonatomic, strong) COSCoord *tt;
-@property (nonatomic, strong) COSCoord *tb;
+/* Bumped when a constrained view moves into the container, the plan is
+ * made again by the next capture. */
+- (NSUInteger)generation;
+- (void)invalidatePlan;
 
-@property (nonatomic, strong) COSCoord *ll;
-@property (nonatomic, strong) COSCoord *lr;
+- (COSLayoutPass *)capture;
 
-@property (nonatomic, strong) COSCoord *bb;
-@property (nonatomic, strong) COSCoord *bt;
+/* Geometry is the snapshot of the views of the plan after the commit, or
+ * NULL if frames were not solved by a pass. */
+- (void)didCommitSize:(CGSize)size geometry:(const COSLAYOUT_SNAPSHOT *)geometry;
 
-@property (nonatomic, strong) COSCoord *rr;
-@property (nonatomic, strong) COSCoord *rl;
+/* Inputs of rules reading views which moved since the last commit, or -1
+ * if that is unknown. */
+- (int)changedInputsOfGeometry:(const COSLAYOUT_SNAPSHOT *)geometry;
 
-@property (nonatomic, strong) COSCoord *ct;
-@property (nonatomic, strong) COSCoord *cl;
-@property (nonatomic, strong) COSCoord *cb;
-@property (nonatomic, strong) COSCoord *cr;
+- (void)solve;
 
-@property (nonatomic, assign) CGRect frame;
+/* Solves the views reading inputs, COSLAYOUT_READ_* bits, if the size of
+ * the container did not change meanwhile. */
+- (void)solveInputs:(int)inputs;
 
-- (instancetype)initWithView:(UIView *)view;
+- (const COSLAYOUT_PARAMS *)params;
+- (void)setValue:(double)value forParameter:(const char *)name;
 
-- (void)updateLayoutDriver;
+/* Views named for rules of the views below the container. */
+- (void)setView:(UIView *)view forName:(NSString *)name;
+- (UIView *)viewForName:(NSString *)name;
 
-- (NSSet *)dependencies;
+- (BOOL)writeGraphToFile:(FILE *)file format:(int)format;
 
-- (void)startLayout;
+/* Solves nested in layoutSubviews run once, when the outermost ends. */
+- (void)beginSolves;
+- (void)endSolves;
 
 @end
 
 
-@interface COSLayoutRulesSolver : NSObject
+@interface COSLayoutPass ()
 
-@property (nonatomic, weak) UIView *view;
+- (instancetype)initWithPlan:(COSLayoutPlan *)plan solver:(COSLayoutSolver *)solver inputs:(int)inputs;
 
-- (CGRect)solveTt:(NSArray *)rules;
-- (CGRect)solveTtCt:(NSArray *)rules;
-- (CGRect)solveTtBt:(NSArray *)rules;
+/* Geometry the pass solves from, see coslayout_nodes_geometry(). Only
+ * valid before the pass is computed. */
+- (uint64_t)geometrySignature;
+- (void)storeInCache:(COSLAYOUT_CACHE *)cache key:(const COSLAYOUT_CACHE_KEY *)key;
 
-- (CGRect)solveLl:(NSArray *)rules;
-- (CGRect)solveLlCl:(NSArray *)rules;
-- (CGRect)solveLlRl:(NSArray *)rules;
+- (void)addStatistics:(COSLAYOUT_PASS_STATS *)stats;
+- (void)checkSolveTime:(NSTimeInterval)seconds;
+- (void)recordCosts:(COSLAYOUT_COSTS **)costs;
 
-- (CGRect)solveBt:(NSArray *)rules;
-- (CGRect)solveBtCt:(NSArray *)rules;
-- (CGRect)solveBtTt:(NSArray *)rules;
+@end
 
-- (CGRect)solveRl:(NSArray *)rules;
-- (CGRect)solveRlCl:(NSArray *)rules;
-- (CGRect)solveRlLl:(NSArray *)rules;
 
-- (CGRect)solveCt:(NSArray *)rules;
-- (CGRect)solveCtTt:(NSArray *)rules;
-- (CGRect)solveCtBt:(NSArray *)rules;
+/* Forgets its view in the session recorded when the view goes. */
+@interface COSLayoutSessionToken : NSObject
 
-- (CGRect)solveCl:(NSArray *)rules;
-- (CGRect)solveClLl:(NSArray *)rules;
-- (CGRect)solveClRl:(NSArray *)rules;
+- (instancetype)initWithView:(UIView *)view;
 
 @end
 
+@implementation COSLayoutSessionToken {
+    const void *_view;
+}
 
-@interface COSLayoutSolver : NSObject
-
-+ (instancetype)layoutSolverOfView:(UIView *)view;
+- (instancetype)initWithView:(UIView *)view {
+    self = [super init];
 
-@property (nonatomic, weak) UIView *view;
+    if (self) {
+        _view = (__bridge const void *)view;
+    }
 
-- (instancetype)initWithView:(UIView *)view;
+    return self;
+}
 
-- (void)solve;
+- (void)dealloc {
+    coslayout_session_forget(_view);
+}
 
 @end
 
+static COSLAYOUT_RECT cos_frame_of_view(const void *info, void *unused) {
+    __unsafe_unretained UIView *view = (__bridge UIView *)info;
 
-@interface COSLayoutDriver : NSObject
+    CGRect frame = view.frame;
+    CGSize size = view.bounds.size;
 
-@property (nonatomic, weak) UIView *view;
-
-@property (nonatomic, strong) COSLayoutSolver *solver;
+    return (COSLAYOUT_RECT){ frame.origin.x, frame.origin.y, size.width, size.height };
+}
 
-- (instancetype)initWithView:(UIView *)view;
+/* Number of view in the session recorded, declaring it and its superviews
+ * as needed, or -1 if no session is recorded. */
+static long cos_session_view(UIView *view) {
+    if (!view) return -1;
 
-- (void)beginSolves;
-- (void)endSolves;
+    long number = coslayout_session_find((__bridge void *)view);
 
-@end
+    if (number >= 0) return number;
 
+    long superview = cos_session_view(view.superview);
 
-@implementation COSLayoutRule
+    number = coslayout_session_view((__bridge void *)view, superview, cos_frame_of_view((__bridge void *)view, NULL));
 
-+ (instancetype)layoutRuleWithView:(UIView *)view
-    name:(NSString *)name
-    coord:(COSCoord *)coord
-    dir:(COSLayoutDir)dir
-{
-    COSLayoutRule *rule = [[COSLayoutRule alloc] init];
+    if (number >= 0 && !objc_getAssociatedObject(view, COSLayoutSessionKey)) {
+        COSLayoutSessionToken *token = [[COSLayoutSessionToken alloc] initWithView:view];
 
-    rule.view = view;
-    rule.name = name;
-    rule.coord = coord;
-    rule.dir = dir;
+        objc_setAssociatedObject(view, COSLayoutSessionKey, token, OBJC_ASSOCIATION_RETAIN);
+    }
 
-    return rule;
+    return number;
 }
 
-- (CGFloat)floatValue {
-    return self.coord.block(self);
-}
 
-- (BOOL)valid {
-    return [self.coord valid];
+@implementation COSLayoutPlan {
+    COSLAYOUT_AFFINE_TABLE _table;
+    COSLAYOUT_PROGRAM **_programs;
+    COSLAYOUT_BINDINGS *_bindings;
+    int *_levels;
+
+    /* Every layout of the plan with its generation when its rules were
+     * read. */
+    NSArray *_layouts;
+    NSUInteger *_generations;
 }
 
-@end
+- (instancetype)initWithView:(UIView *)container generation:(NSUInteger)generation {
+    self = [super init];
 
+    if (self) {
+        _generation = generation;
 
-@implementation COSLayoutRuleHub
+        coslayout_affine_table_init(&_table);
 
-@synthesize vRules = _vRules;
-@synthesize hRules = _hRules;
+        [self makePlanOfView:container];
+    }
 
-- (NSMutableArray *)vRules {
-    return _vRules ?: (_vRules = [[NSMutableArray alloc] init]);
+    return self;
 }
 
-- (NSMutableArray *)hRules {
-    return _hRules ?: (_hRules = [[NSMutableArray alloc] init]);
-}
+/* Views the layouts of container depend on, directly or through layouts
+ * of other containers, breadth first. The container itself is laid out by
+ * its own superview and is not expanded. Generations of layouts are read
+ * into generations, if not nil, before their rules: a rule added meanwhile
+ * leaves the plan stale, never current with old rules. */
++ (NSArray *)viewsOfContainer:(UIView *)container generations:(NSMutableData *)generations {
+    NSMutableArray *views = [[NSMutableArray alloc] init];
+    NSMutableSet *visited = [[NSMutableSet alloc] initWithObjects:container, nil];
+
+    [views addObject:container];
+
+    for (UIView *subview in [container subviews]) {
+        if (objc_getAssociatedObject(subview, COSLayoutKey)) {
+            [views addObject:subview];
+            [visited addObject:subview];
+        }
+    }
 
-- (void)addRule:(COSLayoutRule *)rule toRules:(NSMutableArray *)rules {
-    [rules filterUsingPredicate:[NSPredicate predicateWithFormat:@"SELF.name != %@", rule.name]];
+    for (NSUInteger i = 1; i < views.count; ++i) {
+        COSLayout *layout = objc_getAssociatedObject(views[i], COSLayoutKey);
 
-    if ([rules count] > 1) [rules removeObjectAtIndex:0];
+        if (layout && generations) {
+            NSUInteger generation = [layout generation];
 
-    if ([rule valid]) [rules addObject:rule];
+            [generations appendBytes:&generation length:sizeof(generation)];
+        }
+
+        for (UIView *view in [layout dependencies]) {
+            if (![visited containsObject:view]) {
+                [visited addObject:view];
+                [views addObject:view];
+            }
+        }
+    }
+
+    return views;
 }
 
-- (void)vAddRule:(COSLayoutRule *)rule {
-    [self addRule:rule toRules:self.vRules];
++ (NSArray *)layoutsOfViews:(NSArray *)views container:(UIView *)container {
+    NSMutableArray *layouts = [[NSMutableArray alloc] init];
+
+    for (UIView *view in views) {
+        COSLayout *layout = view == container ? nil : objc_getAssociatedObject(view, COSLayoutKey);
+
+        if (layout) {
+            [layouts addObject:layout];
+        }
+    }
+
+    return layouts;
 }
 
-- (void)hAddRule:(COSLayoutRule *)rule {
-    [self addRule:rule toRules:self.hRules];
++ (NSArray *)layoutsOfContainer:(UIView *)container {
+    return [self layoutsOfViews:[self viewsOfContainer:container generations:nil] container:container];
 }
 
-@end
+- (BOOL)isCurrentForGeneration:(NSUInteger)generation {
+    if (generation != _generation) return NO;
+
+    NSUInteger index = 0;
+
+    for (COSLayout *layout in _layouts) {
+        if ([layout generation] != _generations[index++]) return NO;
+    }
 
+    return YES;
+}
 
-#define COS_FRAME_WIDTH  (frame.size.width)
-#define COS_FRAME_HEIGHT (frame.size.height)
+- (void)makePlanOfView:(UIView *)container {
+    NSMutableData *generations = [[NSMutableData alloc] init];
+    NSArray *views = [COSLayoutPlan viewsOfContainer:container generations:generations];
+    NSArray *layouts = [COSLayoutPlan layoutsOfViews:views container:container];
 
-#define COS_SUPERVIEW_WIDTH  (view.superview.bounds.size.width)
-#define COS_SUPERVIEW_HEIGHT (view.superview.bounds.size.height)
+    _layouts = layouts;
+    _generations = (NSUInteger *)calloc(MAX(layouts.count, 1), sizeof(NSUInteger));
 
-#define COSLAYOUT_FRAME(view) \
-    ([objc_getAssociatedObject(view, COSLayoutKey) frame])
+    memcpy(_generations, generations.bytes, MIN(generations.length, layouts.count * sizeof(NSUInteger)));
 
-#define COSLAYOUT_SOLVE_SINGLE_H(var, left)    \
-do {                                           \
-    COSLayoutRule *rule = rules[0];            \
-    CGFloat var = [[rule coord] block](rule);  \
-    UIView *view = _view;                      \
-    CGRect frame = COSLAYOUT_FRAME(view);      \
-    frame.origin.x = (left);                   \
-    return frame;                              \
-} while (0)
+    NSUInteger count = layouts.count;
 
-#define COSLAYOUT_SOLVE_SINGLE_V(var, top)     \
-do {                                           \
-    COSLayoutRule *rule = rules[0];            \
-    CGFloat var = [[rule coord] block](rule);  \
-    UIView *view = _view;                      \
-    CGRect frame = COSLAYOUT_FRAME(view);      \
-    frame.origin.y = (top);                    \
-    return frame;                              \
-} while (0)
+    COSLAYOUT_NODE *nodes = (COSLAYOUT_NODE *)calloc(MAX(count, 1), sizeof(COSLAYOUT_NODE));
+    size_t *order = (size_t *)calloc(MAX(count, 1), sizeof(size_t));
 
-#define COSLAYOUT_SOLVE_DOUBLE_H(var1, var2, width_, left)  \
-do {                                                        \
-    COSLayoutRule *rule0 = rules[0];                        \
-    COSLayoutRule *rule1 = rules[1];                        \
-    CGFloat var1 = [[rule0 coord] block](rule0);            \
-    CGFloat var2 = [[rule1 coord] block](rule1);            \
-    UIView *view = _view;                                   \
-    CGRect frame = COSLAYOUT_FRAME(view);                   \
-    frame.size.width = [self calcWidth:(width_)];           \
-    frame.origin.x = (left);                                \
-    return frame;                                           \
-} while (0)
+    for (NSUInteger i = 0; i < count; ++i) {
+        COSLayout *layout = layouts[i];
 
-#define COSLAYOUT_SOLVE_DOUBLE_V(var1, var2, height_, top)  \
-do {                                                        \
-    COSLayoutRule *rule0 = rules[0];                        \
-    COSLayoutRule *rule1 = rules[1];                        \
-    CGFloat var1 = [[rule0 coord] block](rule0);            \
-    CGFloat var2 = [[rule1 coord] block](rule1);            \
-    UIView *view = _view;                                   \
-    CGRect frame = COSLAYOUT_FRAME(view);                   \
-    frame.size.height = [self calcHeight:(height_)];        \
-    frame.origin.y = (top);                                 \
-    return frame;                                           \
-} while (0)
+        nodes[i].set = [layout ruleSet];
+        nodes[i].bindings = [layout bindings]->exprs;
+        nodes[i].view = (__bridge void *)layout.view;
+        nodes[i].superview = (__bridge void *)layout.view.superview;
+    }
 
-#define COS_MM_RAW_VALUE(layout, var)               \
-({                                                  \
-    COSLayoutRule *rule = layout.ruleMap[@(#var)];  \
-                                                    \
-    [rule valid] ? [rule floatValue] : NAN;         \
-})
+    if (coslayout_nodes_order(nodes, count, order) < 0) {
+        free(nodes);
+        free(order);
 
-#define COS_VALID_DIM(value) (!isnan(value) && (value) >= 0)
+        [NSException raise:COSLayoutCycleExceptionName format:@"%@", COSLayoutCycleExceptionDesc];
+    }
 
+    NSMutableArray *generalLayouts = [[NSMutableArray alloc] init];
+    NSMutableArray *linearLayouts = [[NSMutableArray alloc] init];
 
-@implementation COSLayoutRulesSolver
+    _levels = (int *)calloc(MAX(count, 1), sizeof(int));
 
-- (CGFloat)calcWidth:(CGFloat)width {
-    COSLayout *layout = objc_getAssociatedObject(_view, COSLayoutKey);
+    for (NSUInteger i = 0; i < count; ++i) {
+        COSLayout *layout = layouts[order[i]];
 
-    CGFloat minw = COS_MM_RAW_VALUE(layout, minw);
+        if (layout.view.superview == container && coslayout_affine_table_add(&_table, [layout ruleSet]) >= 0) {
+            [linearLayouts addObject:layout];
+        } else {
+            _levels[generalLayouts.count] = nodes[order[i]].level;
 
-    if (COS_VALID_DIM(minw) && width < minw) {
-        width = minw;
+            [generalLayouts addObject:layout];
+        }
     }
 
-    CGFloat maxw = COS_MM_RAW_VALUE(layout, maxw);
+    free(nodes);
+    free(order);
 
-    if (COS_VALID_DIM(maxw) && width > maxw) {
-        width = maxw;
-    }
+    /* Programs are immutable and bindings are copied, so that a pass
+     * computed off the main thread never sees rules being replaced, a rule
+     * change makes a new plan instead. */
+    _programs = (COSLAYOUT_PROGRAM **)calloc(MAX(generalLayouts.count, 1), sizeof(COSLAYOUT_PROGRAM *));
+    _bindings = (COSLAYOUT_BINDINGS *)calloc(MAX(generalLayouts.count, 1), sizeof(COSLAYOUT_BINDINGS));
 
-    return MAX(width, 0);
-}
+    NSUInteger index = 0;
+
+    for (COSLayout *layout in generalLayouts) {
+        const COSLAYOUT_RULESET *set = [layout ruleSet];
 
-- (CGFloat)calcHeight:(CGFloat)height {
-    COSLayout *layout = objc_getAssociatedObject(_view, COSLayoutKey);
+        _programs[index] = coslayout_program_retain([layout program]);
+        coslayout_bindings_copy(&_bindings[index], [layout bindings]);
 
-    CGFloat minh = COS_MM_RAW_VALUE(layout, minh);
+        if ((set->h_reads | set->v_reads) & COSLAYOUT_READ_PARAM) _readsParameters = YES;
 
-    if (COS_VALID_DIM(minh) && height < minh) {
-        height = minh;
+        index += 1;
     }
 
-    CGFloat maxh = COS_MM_RAW_VALUE(layout, maxh);
+    NSPointerArray *weakViews = [NSPointerArray weakObjectsPointerArray];
 
-    if (COS_VALID_DIM(maxh) && height > maxh) {
-        height = maxh;
+    for (UIView *view in views) {
+        [weakViews addPointer:(__bridge void *)view];
     }
 
-    return MAX(height, 0);
+    _views = weakViews;
+    _generalLayouts = generalLayouts;
+    _linearLayouts = linearLayouts;
+    _signature = [self signatureOfViews:views container:container];
 }
 
-- (CGRect)solveTt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_SINGLE_V(top, top);
-}
+/* Views are numbered in subview order first, so that containers built the
+ * same way share a signature whatever order dependencies were found in. */
+- (uint64_t)signatureOfViews:(NSArray *)views container:(UIView *)container {
+    COSLAYOUT_SNAPSHOT refs;
 
-- (CGRect)solveTtCt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_V(top, axisY, (axisY - top) * 2, axisY - COS_FRAME_HEIGHT / 2);
-}
+    coslayout_snapshot_init(&refs);
+    coslayout_snapshot_insert(&refs, (__bridge void *)container);
 
-- (CGRect)solveTtBt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_V(top, bottom, bottom - top, bottom - COS_FRAME_HEIGHT);
-}
+    for (NSArray *list in @[container.subviews, views]) {
+        for (UIView *view in list) {
+            coslayout_snapshot_insert(&refs, (__bridge void *)view);
+        }
+    }
 
-- (CGRect)solveLl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_SINGLE_H(left, left);
-}
+    NSUInteger count = _linearLayouts.count + _generalLayouts.count;
+    COSLAYOUT_NODE *nodes = (COSLAYOUT_NODE *)calloc(MAX(count, 1), sizeof(COSLAYOUT_NODE));
+    NSUInteger index = 0;
 
-- (CGRect)solveLlCl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_H(left, axisX, (axisX - left) * 2, axisX - COS_FRAME_WIDTH / 2);
-}
+    for (NSArray *layouts in @[_linearLayouts, _generalLayouts]) {
+        for (COSLayout *layout in layouts) {
+            nodes[index].set = [layout ruleSet];
+            nodes[index].bindings = [layout bindings]->exprs;
+            nodes[index].view = (__bridge void *)layout.view;
+            nodes[index].superview = (__bridge void *)layout.view.superview;
 
-- (CGRect)solveLlRl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_H(left, right, right - left, right - COS_FRAME_WIDTH);
-}
+            index += 1;
+        }
+    }
 
-- (CGRect)solveBt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_SINGLE_V(bottom, bottom - COS_FRAME_HEIGHT);
-}
+    uint64_t signature = coslayout_nodes_signature(nodes, count, &refs);
 
-- (CGRect)solveBtCt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_V(bottom, axisY, (bottom - axisY) * 2, axisY - COS_FRAME_HEIGHT / 2);
-}
+    free(nodes);
+    coslayout_snapshot_destroy(&refs);
 
-- (CGRect)solveBtTt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_V(bottom, top, bottom - top, top);
+    return signature;
 }
 
-- (CGRect)solveRl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_SINGLE_H(right, right - COS_FRAME_WIDTH);
+- (const COSLAYOUT_AFFINE_TABLE *)table {
+    return &_table;
 }
 
-- (CGRect)solveRlCl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_H(right, axisX, (right - axisX) * 2, axisX - COS_FRAME_WIDTH / 2);
+- (const COSLAYOUT_RULESET *)ruleSetAtIndex:(NSUInteger)index {
+    return coslayout_program_ruleset(_programs[index]);
 }
 
-- (CGRect)solveRlLl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_H(right, left, right - left, left);
+- (COSLAYOUT_EXPR *const *)bindingsAtIndex:(NSUInteger)index {
+    return _bindings[index].exprs;
 }
 
-- (CGRect)solveCt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_SINGLE_V(axisY, axisY - COS_FRAME_HEIGHT / 2);
+- (const int *)levels {
+    return _levels;
 }
 
-- (CGRect)solveCtTt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_V(axisY, top, (axisY - top) * 2, top);
-}
+- (BOOL)readsParameter:(const char *)name ofContainer:(UIView *)container {
+    if (!_readsParameters) return NO;
 
-- (CGRect)solveCtBt:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_V(axisY, bottom, (bottom - axisY) * 2, bottom - COS_FRAME_HEIGHT);
-}
+    NSUInteger index = 0;
 
-- (CGRect)solveCl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_SINGLE_H(axisX, axisX - COS_FRAME_WIDTH / 2);
-}
+    for (COSLayout *layout in _generalLayouts) {
+        if (layout.view.superview == container && coslayout_ruleset_reads_param([self ruleSetAtIndex:index], name)) {
+            return YES;
+        }
 
-- (CGRect)solveClLl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_H(axisX, left, (axisX - left) * 2, left);
-}
+        index += 1;
+    }
 
-- (CGRect)solveClRl:(NSArray *)rules {
-    COSLAYOUT_SOLVE_DOUBLE_H(axisX, right, (right - axisX) * 2, right - COS_FRAME_WIDTH);
+    return NO;
 }
 
-@end
+- (void)dealloc {
+    for (NSUInteger i = 0; i < _generalLayouts.count; ++i) {
+        coslayout_program_release(_programs[i]);
+        coslayout_bindings_destroy(&_bindings[i]);
+    }
 
+    free(_programs);
+    free(_bindings);
+    free(_levels);
+    free(_generations);
 
-enum COSLayoutVisitStat {
-    COSLayoutVisitStatUnvisited,
-    COSLayoutVisitStatVisiting,
-    COSLayoutVisitStatVisited
-};
+    coslayout_affine_table_destroy(&_table);
+}
 
-typedef enum COSLayoutVisitStat COSLayoutVisitStat;
+@end
 
-static const void *COSVisitKey = &COSVisitKey;
 
-NS_INLINE
-void COSMakeViewUnvisited(UIView *view) {
-    objc_setAssociatedObject(view, COSVisitKey, nil, OBJC_ASSOCIATION_RETAIN);
-}
+/* Frames of containers with a content key, shared by all solvers. */
+static COSLAYOUT_CACHE *cos_shared_cache(void) {
+    static COSLAYOUT_CACHE *cache = NULL;
+    static dispatch_once_t onceToken;
 
-NS_INLINE
-void COSMakeViewVisiting(UIView *view) {
-    objc_setAssociatedObject(view, COSVisitKey, @(COSLayoutVisitStatVisiting), OBJC_ASSOCIATION_RETAIN);
-}
+    dispatch_once(&onceToken, ^{
+        cache = coslayout_cache_create(COSLAYOUT_CACHE_COUNT_LIMIT, COSLAYOUT_CACHE_BYTE_LIMIT);
+    });
 
-NS_INLINE
-void COSMakeViewVisited(UIView *view) {
-    objc_setAssociatedObject(view, COSVisitKey, @(COSLayoutVisitStatVisited), OBJC_ASSOCIATION_RETAIN);
+    return cache;
 }
 
 
-@interface COSLayoutIterator : NSObject
+/* Shared by all passes, NULL on single processor devices. */
+static COSLAYOUT_POOL *cos_shared_pool(void) {
+    static COSLAYOUT_POOL *pool = NULL;
+    static dispatch_once_t onceToken;
 
-@property (nonatomic, strong) NSSet *layouts;
+    dispatch_once(&onceToken, ^{
+        NSUInteger count = [[NSProcessInfo processInfo] activeProcessorCount];
 
-- (NSMutableArray *)viewTopo;
+        if (count > 1) {
+            pool = coslayout_pool_create((int)count);
+        }
+    });
 
-- (void)iterate;
+    return pool;
+}
 
-@end
+/* Solvers by container view. Lookups take no lock, so the layoutSubviews
+ * hook finds solvers without associated objects, which own them. */
+static COSLAYOUT_REGISTRY *cos_solver_registry(void) {
+    static COSLAYOUT_REGISTRY *registry = NULL;
+    static dispatch_once_t onceToken;
 
+    dispatch_once(&onceToken, ^{
+        registry = coslayout_registry_create();
+    });
 
-@implementation COSLayoutIterator {
-    NSMutableSet *_viewSet;
-    NSMutableArray *_viewTopo;
+    return registry;
 }
 
-- (NSMutableSet *)viewSet {
-    return (_viewSet ?: (_viewSet = [[NSMutableSet alloc] init]));
+/* Solver of view, which may be stale if an earlier view at the same address
+ * was deallocated while its solver was still alive. Stale solvers have no
+ * view and do nothing. */
+NS_INLINE
+COSLayoutSolver *cos_solver_of_view(UIView *view) {
+    return (__bridge COSLayoutSolver *)coslayout_registry_get(cos_solver_registry(), (__bridge void *)view);
 }
 
-- (NSMutableArray *)viewTopo {
-    return (_viewTopo ?: (_viewTopo = [[NSMutableArray alloc] init]));
-}
+#define COS_DRIVING_BUCKETS_LOG2 12
 
-- (void)iterate {
-    [self makeViewSet];
-    [self cleanVisitFlag];
-    [self makeViewTopo];
-    [self cleanVisitFlag];
-}
+/* Solvers driving layout, counted by a hash of their view. A view whose
+ * count is zero drives nothing, so the layoutSubviews hook passes it on
+ * after one load, without looking up its solver. Views sharing a count
+ * with a driving view only look up a solver in vain. */
+static uint32_t cosDrivingCounts[1 << COS_DRIVING_BUCKETS_LOG2];
 
-- (void)makeViewSet {
-    for (COSLayout *layout in _layouts) {
-        [self makeViewSetVisit:layout.view];
-    }
+NS_INLINE
+uint32_t *cos_driving_count(const void *view) {
+    return &cosDrivingCounts[((uint64_t)(uintptr_t)view * 0x9E3779B97F4A7C15ULL) >> (64 - COS_DRIVING_BUCKETS_LOG2)];
 }
 
-- (void)makeViewSetVisit:(UIView *)view {
-    COSMakeViewVisiting(view);
+/* Class of view as it presents itself, for dumps. */
+static void cos_name_of_view(void *info, const void *view, char *name, size_t size) {
+    __unsafe_unretained UIView *object = (__bridge UIView *)view;
 
-    COSLayout *layout = objc_getAssociatedObject(view, COSLayoutKey);
+    snprintf(name, size, "%s", object ? class_getName([object class]) : "");
+}
 
-    for (UIView *adjView in [layout dependencies]) {
-        NSNumber *stat = objc_getAssociatedObject(adjView, COSVisitKey);
-        COSLayoutVisitStat istat = stat ? [stat intValue] : COSLayoutVisitStatUnvisited;
+/* Loops of a pool must not overlap, passes may compute on any thread. */
+static void cos_solve_nodes(COSLAYOUT_NODE *nodes, size_t count, COSLAYOUT_SNAPSHOT *snapshot, void *container, int inputs) {
+    static dispatch_once_t onceToken;
+    static dispatch_semaphore_t semaphore;
 
-        if (istat == COSLayoutVisitStatUnvisited) {
-            [self makeViewSetVisit:adjView];
-        } else if (istat == COSLayoutVisitStatVisiting) {
-            [self cleanVisitFlag];
-            [self cycleError];
-        }
-    }
+    dispatch_once(&onceToken, ^{
+        semaphore = dispatch_semaphore_create(1);
+    });
 
-    [[self viewSet] addObject:view];
+    /* Passes finding the pool busy are solved serially. */
+    BOOL acquired = (count >= COSLAYOUT_PARALLEL_MIN &&
+                     dispatch_semaphore_wait(semaphore, DISPATCH_TIME_NOW) == 0);
 
-    COSMakeViewVisited(view);
-}
+    coslayout_nodes_solve(nodes, count, snapshot, container, inputs, acquired ? cos_shared_pool() : NULL);
 
-- (void)makeViewTopo {
-    for (UIView *view in [self viewSet]) {
-        NSNumber *stat = objc_getAssociatedObject(view, COSVisitKey);
-        COSLayoutVisitStat istat = stat ? [stat intValue] : COSLayoutVisitStatUnvisited;
-        if (istat == COSLayoutVisitStatUnvisited) {
-            [self makeViewTopoVisit:view];
-        }
+    if (acquired) {
+        dispatch_semaphore_signal(semaphore);
     }
 }
 
-- (void)makeViewTopoVisit:(UIView *)view {
-    COSMakeViewVisiting(view);
-
-    COSLayout *layout = objc_getAssociatedObject(view, COSLayoutKey);
-
-    for (UIView *adjView in [layout dependencies]) {
-        NSNumber *stat = objc_getAssociatedObject(adjView, COSVisitKey);
-        COSLayoutVisitStat istat = stat ? [stat intValue] : COSLayoutVisitStatUnvisited;
+@implementation COSLayoutPass {
+    COSLayoutPlan *_plan;
+    __weak COSLayoutSolver *_solver;
 
-        if (istat == COSLayoutVisitStatUnvisited) {
-            [self makeViewTopoVisit:adjView];
-        } else if (istat == COSLayoutVisitStatVisiting) {
-            [self cleanVisitFlag];
-            [self cycleError];
-        }
-    }
+    COSLAYOUT_SNAPSHOT _snapshot;
 
-    [[self viewTopo] addObject:view];
+    void *_container;
+    CGSize _size;
+    int _inputs;
 
-    COSMakeViewVisited(view);
-}
+    /* Linear layouts first, then general layouts in plan order. */
+    NSUInteger _count;
+    COSLAYOUT_NODE *_nodes;
+    COSLAYOUT_RECT *_frames;
 
-- (void)cleanVisitFlag {
-    for (UIView *view in [self viewSet]) {
-        COSMakeViewUnvisited(view);
-    }
+    /* Parameters of each node and of its superview, copied when the plan
+     * reads parameters so that values set meanwhile are not seen. */
+    COSLAYOUT_PARAMS *_params;
 
-    for (UIView *view in [self viewTopo]) {
-        COSMakeViewUnvisited(view);
-    }
-}
+    BOOL _computed;
 
-- (void)cycleError {
-    [NSException raise:COSLayoutCycleExceptionName format:@"%@", COSLayoutCycleExceptionDesc];
+    /* Frames changed by the last commit. */
+    NSUInteger _changed;
 }
 
-@end
+- (instancetype)initWithPlan:(COSLayoutPlan *)plan solver:(COSLayoutSolver *)solver inputs:(int)inputs {
+    self = [super init];
 
+    if (self) {
+        _plan = plan;
+        _solver = solver;
+        _inputs = inputs;
 
-@implementation COSLayoutSolver
+        coslayout_snapshot_init(&_snapshot);
 
-+ (instancetype)layoutSolverOfView:(UIView *)view {
-    static const void *layoutSolverKey = &layoutSolverKey;
+        [self captureView:solver.view];
+    }
 
-    COSLayoutSolver *solver = objc_getAssociatedObject(view, layoutSolverKey);
+    return self;
+}
 
-    if (!solver) {
-        solver = [[COSLayoutSolver alloc] initWithView:view];
+- (void)captureView:(UIView *)container {
+    _container = (__bridge void *)container;
+    _size = container.bounds.size;
 
-        objc_setAssociatedObject(view, layoutSolverKey, solver, OBJC_ASSOCIATION_RETAIN);
+    for (UIView *view in _plan.views) {
+        [self captureGeometryOfView:view container:container];
     }
 
-    return solver;
-}
+    [self captureGeometryOfView:container container:container];
 
-- (instancetype)initWithView:(UIView *)view {
-    self = [super init];
+    /* Views the pass does not solve, like siblings resized in layoutSubviews
+     * or views of other containers, may have moved since the last commit. */
+    if (_inputs >= 0) {
+        int moved = [_solver changedInputsOfGeometry:&_snapshot];
 
-    if (self) {
-        _view = view;
+        _inputs = moved < 0 ? -1 : _inputs | moved;
     }
 
-    return self;
-}
+    NSArray *linearLayouts = _plan.linearLayouts;
+    NSArray *generalLayouts = _plan.generalLayouts;
 
-- (void)solve {
-    NSArray *subviews = [self.view subviews];
+    const int *levels = [_plan levels];
 
-    NSMutableSet *layouts = [[NSMutableSet alloc] init];
+    _count = linearLayouts.count + generalLayouts.count;
 
-    for (UIView *subview in subviews) {
-        COSLayout *layout = objc_getAssociatedObject(subview, COSLayoutKey);
+    _nodes = (COSLAYOUT_NODE *)calloc(MAX(_count, 1), sizeof(COSLAYOUT_NODE));
+    _frames = (COSLAYOUT_RECT *)calloc(MAX(linearLayouts.count, 1), sizeof(COSLAYOUT_RECT));
 
-        if (layout) {
-            [layouts addObject:layout];
-        }
+    if (_plan.readsParameters) {
+        _params = (COSLAYOUT_PARAMS *)calloc(2 * _count, sizeof(COSLAYOUT_PARAMS));
     }
 
-    COSLayoutIterator *iterator = [[COSLayoutIterator alloc] init];
+    NSUInteger index = 0;
+
+    for (NSArray *layouts in @[linearLayouts, generalLayouts]) {
+        for (COSLayout *layout in layouts) {
+            COSLAYOUT_NODE *node = &_nodes[index];
+            UIView *view = layout.view;
+
+            if (index >= linearLayouts.count) {
+                node->set = [_plan ruleSetAtIndex:index - linearLayouts.count];
+                node->bindings = [_plan bindingsAtIndex:index - linearLayouts.count];
+                node->level = levels[index - linearLayouts.count];
+            }
+
+            if (view) {
+                CGRect frame = view.frame;
 
-    iterator.layouts = layouts;
+                node->view = (__bridge void *)view;
+                node->superview = (__bridge void *)view.superview;
+                node->start = COSLAYOUT_RECT_FROM_CG(frame);
 
-    [iterator iterate];
+                /* Frame was changed outside of layout, the other axis is stale too. */
+                node->axes = CGRectEqualToRect(layout.frame, frame) ? 0 : COSLAYOUT_AXIS_ALL;
 
-    for (UIView *view in [iterator viewTopo]) {
-        if (view == _view) continue;
+                if (_params && index >= linearLayouts.count) {
+                    [self captureParametersOfLayout:layout node:node index:index];
+                }
+            }
 
-        COSLayout *layout = objc_getAssociatedObject(view, COSLayoutKey);
+            node->frame = node->start;
 
-        [layout startLayout];
+            index += 1;
+        }
     }
 }
 
-@end
+- (void)captureParametersOfLayout:(COSLayout *)layout node:(COSLAYOUT_NODE *)node index:(NSUInteger)index {
+    UIView *superview = layout.view.superview;
+    COSLayoutSolver *solver = cos_solver_of_view(superview);
 
+    coslayout_params_copy(&_params[2 * index], [layout params]);
 
-@implementation COSLayoutDriver
+    if (solver && solver.view == superview) {
+        coslayout_params_copy(&_params[2 * index + 1], [solver params]);
+    }
 
-{
-    NSInteger stackId;
+    node->params = &_params[2 * index];
+    node->scope = &_params[2 * index + 1];
 }
 
-- (instancetype)initWithView:(UIView *)view {
-    self = [super init];
+- (void)captureGeometryOfView:(UIView *)view container:(UIView *)container {
+    if (!view) return;
 
-    if (self) {
-        _view = view;
-    }
+    CGRect bounds = view.bounds;
+    CGRect rect = [view convertRect:bounds toView:container];
+    CGSize size = view.superview.bounds.size;
 
-    return self;
-}
+    COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_insert(&_snapshot, (__bridge void *)view);
 
-- (COSLayoutSolver *)solver {
-    return _solver ?: (_solver = [COSLayoutSolver layoutSolverOfView:self.view]);
+    entry->rect = (COSLAYOUT_RECT){ rect.origin.x, rect.origin.y, bounds.size.width, bounds.size.height };
+    entry->origin_x = bounds.origin.x;
+    entry->origin_y = bounds.origin.y;
+    entry->width = size.width;
+    entry->height = size.height;
 }
 
-- (void)beginSolves {
-    stackId += 1;
-}
+- (void)compute {
+    if (_computed) return;
 
-- (void)endSolves {
-    if ((--stackId) == 0) {
-        [self.solver solve];
-    }
-}
+    const COSLAYOUT_AFFINE_TABLE *table = [_plan table];
 
-@end
+    NSUInteger linearCount = table->count;
 
+    int inputs = _inputs;
+    int moved = 0;
 
-#define COSCOORD_MAKE(dependencies_, expr)         \
-({                                                 \
-    __weak UIView *__view = _view;                 \
-                                                   \
-    COSCoord *coord = [[COSCoord alloc] init];     \
-                                                   \
-    coord.dependencies = (dependencies_);          \
-    coord.block = ^CGFloat(COSLayoutRule *rule) {  \
-        UIView *view = __view;                     \
-                                                   \
-        return (expr);                             \
-    };                                             \
-                                                   \
-    coord;                                         \
-})
-
-#define COSCOORD_OR_NIL(c_) ({ COSCoord *c = (c_); [c valid] ? c : nil; })
-
-#define COSLAYOUT_ADD_RULE(var, dir_)        \
-do {                                         \
-    _##var = COSCOORD_OR_NIL(var);           \
-                                             \
-    COSLayoutRule *rule =                    \
-    [COSLayoutRule layoutRuleWithView:_view  \
-        name:@(#var)                         \
-        coord:_##var                         \
-        dir:COSLayoutDir##dir_];             \
-                                             \
-    [self.ruleHub dir_##AddRule:rule];       \
-} while (0)
-
-#define COSLAYOUT_ADD_TRANS_RULE(var, dst, exp)                 \
-do {                                                            \
-    COSCoord *c = _##var = COSCOORD_OR_NIL(var);                \
-    self.dst = c ? COSCOORD_MAKE(c.dependencies, (exp)) : nil;  \
-} while (0)
-
-#define COSLAYOUT_ADD_BOUND_RULE(var, dir_)  \
-do {                                         \
-    _##var = COSCOORD_OR_NIL(var);           \
-    NSString *name = @(#var);                \
-                                             \
-    COSLayoutRule *rule =                    \
-    [COSLayoutRule layoutRuleWithView:_view  \
-        name:name                            \
-        coord:_##var                         \
-        dir:COSLayoutDir##dir_];             \
-                                             \
-    self.ruleMap[name] = rule;               \
-} while (0)
+    if (linearCount > 0) {
+        coslayout_affine_table_solve(table, _size.width, _size.height, _frames);
 
-NS_INLINE
-void cos_initialize_layout_if_needed(UIView *view) {
-    Class class = [view class];
+        for (NSUInteger i = 0; i < linearCount; ++i) {
+            COSLAYOUT_NODE *node = &_nodes[i];
 
-    if ([swizzledLayoutClasses containsObject:class]) return;
+            if (!node->view) continue;
 
-    SEL name = @selector(didMoveToSuperview);
+            node->frame = _frames[i];
 
-    IMP origImp = class_getMethodImplementation(class, name);
-    IMP overImp = imp_implementationWithBlock(^(UIView *view) {
-        ((void(*)(id, SEL))(origImp))(view, name);
+            moved |= coslayout_rect_changed_axes(node->start, node->frame);
+
+            coslayout_snapshot_move(&_snapshot, node->view, node->superview, node->frame);
+        }
+    }
 
-        COSLayout *layout = objc_getAssociatedObject(view, COSLayoutKey);
+    if (inputs >= 0) {
+        if (moved & COSLAYOUT_AXIS_H) inputs |= COSLAYOUT_READ_VIEW_H;
+        if (moved & COSLAYOUT_AXIS_V) inputs |= COSLAYOUT_READ_VIEW_V;
+    }
 
-        if (layout) [layout updateLayoutDriver];
-    });
+    cos_solve_nodes(_nodes + linearCount, _count - linearCount, &_snapshot, _container, inputs);
 
-    class_replaceMethod(class, name, overImp, "v@:");
-    
-    [swizzledLayoutClasses addObject:class];
+    _computed = YES;
 }
 
-NS_INLINE
-void cos_initialize_driver_if_needed(UIView *view) {
-    Class class = [view class];
+- (void)commit {
+    [self compute];
 
-    if ([swizzledDriverClasses containsObject:class]) return;
+    uint64_t traced = COSLAYOUT_TRACE_ENABLED() ? coslayout_stats_now() : 0;
+    NSUInteger index = 0;
 
-    SEL name = @selector(layoutSubviews);
+    _changed = 0;
 
-    IMP origImp = class_getMethodImplementation(class, name);
-    IMP overImp = imp_implementationWithBlock(^(UIView *view) {
-        COSLayoutDriver *driver = objc_getAssociatedObject(view, COSLayoutDriverKey);
+    for (NSArray *layouts in @[_plan.linearLayouts, _plan.generalLayouts]) {
+        for (COSLayout *layout in layouts) {
+            COSLAYOUT_NODE *node = &_nodes[index++];
 
-        if (driver) {
-            [driver beginSolves];
-            ((void(*)(id, SEL))(origImp))(view, name);
-            [driver endSolves];
-        } else {
-            ((void(*)(id, SEL))(origImp))(view, name);
+            /* View may have been released or moved since capture. */
+            if (node->view && (__bridge void *)layout.view == node->view) {
+                if ([layout applyFrame:node->frame]) _changed += 1;
+            }
         }
-    });
-
-    class_replaceMethod(class, name, overImp, "v@:");
+    }
 
-    [swizzledDriverClasses addObject:class];
-}
+    [_solver didCommitSize:_size geometry:&_snapshot];
 
+    if (traced) {
+        UIView *container = (__bridge UIView *)_container;
 
-@protocol COSLayoutArguments <NSObject>
+        coslayout_trace_span("commit", traced, _container, (__bridge void *)container.superview);
+    }
+}
 
-- (CGFloat)floatValue;
-- (COSFloatBlock)floatBlockValue;
-- (id)objectValue;
+- (uint64_t)geometrySignature {
+    return coslayout_nodes_geometry(_nodes, _count, &_snapshot);
+}
 
-@end
+- (void)storeInCache:(COSLAYOUT_CACHE *)cache key:(const COSLAYOUT_CACHE_KEY *)key {
+    [self compute];
 
+    COSLAYOUT_RECT *frames = (COSLAYOUT_RECT *)calloc(MAX(_count, 1), sizeof(COSLAYOUT_RECT));
 
-@interface COSLayoutVaList : NSObject <COSLayoutArguments>
+    for (NSUInteger i = 0; i < _count; ++i) {
+        frames[i] = _nodes[i].frame;
+    }
 
-- (instancetype)initWithVaList:(va_list)valist;
+    coslayout_cache_store(cache, key, frames, _count);
 
-@end
+    free(frames);
+}
 
+- (void)addStatistics:(COSLAYOUT_PASS_STATS *)stats {
+    NSUInteger linearCount = _plan.linearLayouts.count;
 
-@implementation COSLayoutVaList {
-    va_list _valist;
-}
+    for (NSUInteger i = 0; i < _count; ++i) {
+        if (!_nodes[i].view) continue;
 
-- (instancetype)initWithVaList:(va_list)valist {
-    self = [super init];
+        /* Linear layouts are solved by the table, without evaluations. */
+        if (i < linearCount || _nodes[i].evaluations > 0) stats->views += 1;
 
-    if (self) {
-        va_copy(_valist, valist);
+        stats->evaluations += _nodes[i].evaluations;
     }
 
-    return self;
-}
-
-- (CGFloat)floatValue {
-    return va_arg(_valist, double);
+    stats->changed += _changed;
 }
 
-- (COSFloatBlock)floatBlockValue {
-    return va_arg(_valist, COSFloatBlock);
+- (void)checkSolveTime:(NSTimeInterval)seconds {
+    coslayout_watchdog_check(_container, seconds, _nodes, _count);
 }
 
-- (id)objectValue {
-    return va_arg(_valist, id);
+- (void)recordCosts:(COSLAYOUT_COSTS **)costs {
+    coslayout_costs_record(costs, _nodes, _count);
 }
 
 - (void)dealloc {
-    va_end(_valist);
+    coslayout_snapshot_destroy(&_snapshot);
+
+    if (_params) {
+        for (NSUInteger i = 0; i < 2 * _count; ++i) {
+            coslayout_params_destroy(&_params[i]);
+        }
+    }
+
+    free(_nodes);
+    free(_frames);
+    free(_params);
 }
 
 @end
 
 
-@interface COSLayoutArrayArguments : NSObject <COSLayoutArguments>
+@implementation COSLayoutSolver {
+    COSLayoutPlan *_plan;
 
-- (instancetype)initWithArray:(NSArray *)array;
+    CGSize _size;
+    BOOL _sized;
 
-@end
+    /* Geometry of the views of the plan after the last commit. */
+    COSLAYOUT_SNAPSHOT _geometry;
+
+    NSInteger _solveDepth;
 
+    NSUInteger _generation;
 
-@implementation COSLayoutArrayArguments {
-    NSMutableArray *_array;
+    /* Parameters read by rules of subviews, and the inputs they changed
+     * since the last capture. */
+    COSLAYOUT_PARAMS _params;
+    int _pendingInputs;
+
+    /* Views by name, created with the first name. */
+    NSMapTable *_namedViews;
+
+    /* Key of the solver in the registry, the view may be gone. */
+    __unsafe_unretained UIView *_key;
+
+    /* Whether the solver is counted in the driving count of its key. */
+    BOOL _countsDriving;
+
+    /* Costs of the last passes, while a history is kept. */
+    COSLAYOUT_COSTS *_costs;
 }
 
-- (instancetype)initWithArray:(NSArray *)array {
-    self = [super init];
++ (instancetype)layoutSolverOfView:(UIView *)view {
+    COSLayoutSolver *solver = cos_solver_of_view(view);
 
-    if (self) {
-        _array = [array mutableCopy];
+    if (!solver || solver.view != view) {
+        solver = [[COSLayoutSolver alloc] initWithView:view];
+
+        objc_setAssociatedObject(view, COSLayoutSolverKey, solver, OBJC_ASSOCIATION_RETAIN);
+        coslayout_registry_set(cos_solver_registry(), (__bridge void *)view, (__bridge void *)solver);
     }
 
-    return self;
+    return solver;
 }
 
-- (id)shiftArgument {
-    id argument = [_array firstObject];
+- (instancetype)initWithView:(UIView *)view {
+    self = [super init];
 
-    [_array removeObjectAtIndex:0];
+    if (self) {
+        _view = view;
+        _key = view;
+        _drivesLayout = YES;
 
-    return argument;
+        coslayout_snapshot_init(&_geometry);
+        coslayout_params_init(&_params);
+    }
+
+    return self;
 }
 
-- (CGFloat)floatValue {
-    return (CGFloat)[[self shiftArgument] doubleValue];
+- (BOOL)drivesLayoutOfView:(UIView *)view {
+    return _constrainsSubviews && _drivesLayout && self.view == view;
 }
 
-- (COSFloatBlock)floatBlockValue {
-    return [self shiftArgument];
+- (void)setConstrainsSubviews:(BOOL)constrainsSubviews {
+    _constrainsSubviews = constrainsSubviews;
+    [self updateDrivingCount];
 }
 
-- (id)objectValue {
-    return [self shiftArgument];
+- (void)setDrivesLayout:(BOOL)drivesLayout {
+    _drivesLayout = drivesLayout;
+    [self updateDrivingCount];
 }
 
-@end
+- (void)updateDrivingCount {
+    BOOL drives = _constrainsSubviews && _drivesLayout;
 
+    if (drives == _countsDriving) return;
 
-#define COS_STRING(coord) \
-    [NSString stringWithCString:(coord) encoding:NSASCIIStringEncoding]
+    if (drives) {
+        __atomic_add_fetch(cos_driving_count((__bridge void *)_key), 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_sub_fetch(cos_driving_count((__bridge void *)_key), 1, __ATOMIC_RELAXED);
+    }
 
+    _countsDriving = drives;
+}
 
-@implementation COSLayout
+- (NSUInteger)generation {
+    return __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+}
 
-+ (void)initialize {
-    static dispatch_once_t onceToken;
-
-    dispatch_once(&onceToken, ^{
-        swizzledDriverClasses = [[NSMutableSet alloc] init];
-        swizzledLayoutClasses = [[NSMutableSet alloc] init];
-    });
+- (void)invalidatePlan {
+    __atomic_fetch_add(&_generation, 1, __ATOMIC_RELEASE);
 }
 
-+ (instancetype)layoutOfView:(UIView *)view {
-    if (![view isKindOfClass:[UIView class]]) return nil;
-
-    COSLayout *layout = objc_getAssociatedObject(view, COSLayoutKey);
+- (int)dirtyInputsForSize:(CGSize)size {
+    if (!_sized) {
+        return -1;
+    }
 
-    if (!layout) {
-        layout = [[COSLayout alloc] initWithView:view];
+    int inputs = 0;
 
-        objc_setAssociatedObject(view, COSLayoutKey, layout, OBJC_ASSOCIATION_RETAIN);
+    if (size.width != _size.width) {
+        inputs |= COSLAYOUT_READ_WIDTH | COSLAYOUT_READ_VIEW_H;
+    }
 
-        cos_initialize_layout_if_needed(view);
+    if (size.height != _size.height) {
+        inputs |= COSLAYOUT_READ_HEIGHT | COSLAYOUT_READ_VIEW_V;
+    }
 
-        [layout updateLayoutDriver];
+    /* Only one dimension or only parameters changed, the rest may be
+     * skipped. */
+    if (inputs == (COSLAYOUT_READ_WIDTH | COSLAYOUT_READ_VIEW_H) ||
+        inputs == (COSLAYOUT_READ_HEIGHT | COSLAYOUT_READ_VIEW_V) ||
+        (inputs == 0 && _pendingInputs)) {
+        return inputs | _pendingInputs;
     }
 
-    return layout;
+    return -1;
 }
 
-- (instancetype)initWithView:(UIView *)view {
-    self = [super init];
+- (BOOL)updatePlan {
+    NSUInteger generation = [self generation];
 
-    if (self) {
-        _view = view;
+    if (_plan && [_plan isCurrentForGeneration:generation]) {
+        return NO;
     }
 
-    return self;
+    _plan = [[COSLayoutPlan alloc] initWithView:self.view generation:generation];
+
+    return YES;
 }
 
-- (void)addRule:(NSString *)format, ... {
-    va_list argv;
-    va_start(argv, format);
+- (COSLayoutPass *)capture {
+    int inputs = [self dirtyInputsForSize:self.view.bounds.size];
 
-    [self addRule:format args:argv];
+    _pendingInputs = 0;
 
-    va_end(argv);
+    if ([self updatePlan]) {
+        inputs = -1;
+    }
+
+    return [[COSLayoutPass alloc] initWithPlan:_plan solver:self inputs:inputs];
 }
 
-- (void)addRule:(NSString *)format args:(va_list)args {
-    COSLayoutVaList *valist = [[COSLayoutVaList alloc] initWithVaList:args];
+/* Applies frames solved before for the same rules, size, content and
+ * geometry. */
+- (BOOL)applyCachedFramesForKey:(const COSLAYOUT_CACHE_KEY *)key stats:(COSLAYOUT_PASS_STATS *)stats {
+    NSArray *linearLayouts = _plan.linearLayouts;
+    NSArray *generalLayouts = _plan.generalLayouts;
+
+    NSUInteger count = linearLayouts.count + generalLayouts.count;
+    COSLAYOUT_RECT *frames = (COSLAYOUT_RECT *)calloc(MAX(count, 1), sizeof(COSLAYOUT_RECT));
+
+    BOOL hit = coslayout_cache_lookup(cos_shared_cache(), key, frames, count);
 
-    [self addRule:format _args:valist];
+    if (hit) {
+        NSUInteger index = 0;
+
+        for (NSArray *layouts in @[linearLayouts, generalLayouts]) {
+            for (COSLayout *layout in layouts) {
+                if (layout.view && [layout applyFrame:frames[index]]) {
+                    stats->changed += 1;
+                }
+
+                index += 1;
+            }
+        }
+    }
+
+    free(frames);
+
+    return hit;
 }
 
-- (void)addRule:(NSString *)format arguments:(NSArray *)arguments {
-    COSLayoutArrayArguments *array = [[COSLayoutArrayArguments alloc] initWithArray:arguments];
+- (void)didCommitSize:(CGSize)size geometry:(const COSLAYOUT_SNAPSHOT *)geometry {
+    _size = size;
+    _sized = YES;
+
+    if (geometry) {
+        coslayout_snapshot_copy(&_geometry, geometry);
+    } else {
+        coslayout_snapshot_clear(&_geometry);
+    }
+}
 
-    [self addRule:format _args:array];
+- (int)changedInputsOfGeometry:(const COSLAYOUT_SNAPSHOT *)geometry {
+    return _sized ? coslayout_snapshot_changed_inputs(&_geometry, geometry) : -1;
 }
 
-- (void)addRule:(NSString *)format _args:(id<COSLayoutArguments>)args {
-    NSArray *subRules = [format componentsSeparatedByString:@","];
+- (void)solve {
+    if (!self.view) return;
 
-    for (NSString *subRule in subRules) {
-        COSLAYOUT_AST *ast = NULL;
+    if (COSLAYOUT_SESSION_RECORDING() && cos_session_view(self.view) >= 0) {
+        coslayout_session_solve((__bridge void *)self.view, cos_frame_of_view, NULL);
+    }
 
-        char *expr = (char *)[subRule cStringUsingEncoding:NSASCIIStringEncoding];
+    BOOL counted = COSLAYOUT_STATS_ENABLED() != 0;
+    BOOL watched = (COSLAYOUT_PROFILE_FLAGS() & COSLAYOUT_PROFILE_NODES) != 0;
 
-        int result = coslayout_parse_rule(expr, &ast);
+    uint64_t start = counted || watched ? coslayout_stats_now() : 0;
+    COSLAYOUT_PASS_STATS stats = { 0, 0, 0, 0 };
 
-        switch (result) {
-        case 0: {
-            NSMutableSet *keeper = [NSMutableSet set];
+    COSLayoutPass *pass = [self solveWithStats:&stats];
 
-            [self parseAst:ast parent:NULL args:args keeper:keeper];
+    if (pass && (COSLAYOUT_PROFILE_FLAGS() & COSLAYOUT_PROFILE_COSTS)) {
+        [pass recordCosts:&_costs];
+    }
 
-            coslayout_destroy_ast(ast);
-        }
-            break;
+    if (!start) return;
 
-        case 1: {
-            [NSException raise:COSLayoutSyntaxExceptionName format:@"%@", COSLayoutSyntaxExceptionDesc];
-        }
-            break;
+    NSTimeInterval seconds = (coslayout_stats_now() - start) * 1e-9;
 
-        default:
-            return;
-        }
+    if (counted) {
+        [pass addStatistics:&stats];
+
+        stats.seconds = seconds;
+        coslayout_stats_record_pass(&stats);
     }
 
-    [self layoutSiblingViews];
+    if (watched) {
+        /* Frames from the cache are reported without views. */
+        if (pass) {
+            [pass checkSolveTime:seconds];
+        } else {
+            coslayout_watchdog_check((__bridge void *)self.view, seconds, NULL, 0);
+        }
+    }
 }
 
-- (void)layoutSiblingViews {
-    UIView *superview = self.view.superview;
+/* Returns the pass committed, or nil if frames came from the cache. */
+- (COSLayoutPass *)solveWithStats:(COSLAYOUT_PASS_STATS *)stats {
+    if (_contentKey) {
+        [self updatePlan];
+    }
 
-    if (superview) {
-        [[objc_getAssociatedObject(superview, COSLayoutDriverKey) solver] solve];
+    /* Values of parameters are not part of cache keys. */
+    if (!_contentKey || _plan.readsParameters) {
+        COSLayoutPass *pass = [self capture];
+
+        [pass compute];
+        [pass commit];
+
+        return pass;
+    }
+
+    /* Capturing also takes the pending inputs, which a hit leaves solved. */
+    COSLayoutPass *pass = [self capture];
+
+    CGSize size = self.view.bounds.size;
+    COSLAYOUT_CACHE_KEY key = { _plan.signature, size.width, size.height, _contentKey, [pass geometrySignature] };
+
+    if ([self applyCachedFramesForKey:&key stats:stats]) {
+        [self didCommitSize:size geometry:NULL];
+        return nil;
     }
+
+    [pass compute];
+    [pass commit];
+    [pass storeInCache:cos_shared_cache() key:&key];
+
+    return pass;
 }
 
-#define COSCOORD_FOR_NAME(name_) ({  \
-    [self valueForKey:name_] ?: ({   \
-        COSCoord *coord = [COSCoord coordWithFloat:0];  \
-        [keeper addObject:coord];    \
-        coord;                       \
-    });                              \
-})
+- (void)solveInputs:(int)inputs {
+    _pendingInputs |= inputs;
 
-- (void)parseAst:(COSLAYOUT_AST *)ast parent:(COSLAYOUT_AST *)parent args:(id<COSLayoutArguments>)args keeper:(NSMutableSet *)keeper {
-    if (ast == NULL) return;
+    [self solve];
+}
 
-    [self parseAst:ast->l parent:ast args:args keeper:keeper];
-    [self parseAst:ast->r parent:ast args:args keeper:keeper];
+- (const COSLAYOUT_PARAMS *)params {
+    return &_params;
+}
 
-    switch (ast->node_type) {
-    case COSLAYOUT_TOKEN_ATTR: {
-        if (parent) {
-            if (parent->node_type == '=' &&
-                parent->l == ast) break;
+- (void)setValue:(double)value forParameter:(const char *)name {
+    if (!coslayout_params_set(&_params, name, value)) return;
 
-            COSCoord *coord = COSCOORD_FOR_NAME(COS_STRING(ast->value.coord));
+    if (COSLAYOUT_SESSION_RECORDING()) {
+        coslayout_session_param(cos_session_view(self.view), name, value);
+    }
 
-            ast->data = (__bridge void *)(coord);
-        } else {
-            [self setValue:[COSCoord coordWithFloat:0] forKey:COS_STRING(ast->value.coord)];
-        }
+    /* A stale plan is rebuilt and solved whole by the next capture. */
+    BOOL stale = !_plan || ![_plan isCurrentForGeneration:[self generation]];
+
+    if (stale || [_plan readsParameter:name ofContainer:self.view]) {
+        [self solveInputs:COSLAYOUT_READ_PARAM];
+    }
+}
+
+- (void)setView:(UIView *)view forName:(NSString *)name {
+    if (!_namedViews) {
+        _namedViews = [NSMapTable strongToWeakObjectsMapTable];
     }
-        break;
 
-    case COSLAYOUT_TOKEN_NUMBER: {
-        COSCoord *coord = [COSCoord coordWithFloat:ast->value.number];
+    if (view) {
+        [_namedViews setObject:view forKey:name];
+    } else {
+        [_namedViews removeObjectForKey:name];
+    }
+}
 
-        ast->data = (__bridge void *)(coord);
+- (UIView *)viewForName:(NSString *)name {
+    return [_namedViews objectForKey:name];
+}
 
-        [keeper addObject:coord];
+- (void)beginSolves {
+    _solveDepth += 1;
+}
+
+- (void)endSolves {
+    if ((--_solveDepth) == 0) {
+        [self solve];
     }
-        break;
+}
 
-    case COSLAYOUT_TOKEN_PERCENTAGE:
-    case COSLAYOUT_TOKEN_PERCENTAGE_H:
-    case COSLAYOUT_TOKEN_PERCENTAGE_V: {
-        COSLayoutDir dir = 0;
+- (BOOL)writeGraphToFile:(FILE *)file format:(int)format {
+    UIView *container = self.view;
+    NSArray *layouts = container ? [COSLayoutPlan layoutsOfContainer:container] : @[];
+    NSUInteger count = layouts.count;
 
-        switch (ast->node_type) {
-        case COSLAYOUT_TOKEN_PERCENTAGE_H: dir = COSLayoutDirh; break;
-        case COSLAYOUT_TOKEN_PERCENTAGE_V: dir = COSLayoutDirv; break;
-        }
+    COSLAYOUT_NODE *nodes = (COSLAYOUT_NODE *)calloc(MAX(count, 1), sizeof(COSLAYOUT_NODE));
 
-        COSCoord *coord = [COSCoord coordWithPercentage:ast->value.percentage dir:dir];
+    for (NSUInteger i = 0; i < count; ++i) {
+        COSLayout *layout = layouts[i];
 
-        ast->data = (__bridge void *)(coord);
+        nodes[i].set = [layout ruleSet];
+        nodes[i].bindings = [layout bindings]->exprs;
+        nodes[i].view = (__bridge void *)layout.view;
+        nodes[i].superview = (__bridge void *)layout.view.superview;
+    }
+
+    int result = coslayout_dump_write(file, format, (__bridge void *)container, nodes, count, _costs, cos_name_of_view, NULL);
+
+    free(nodes);
 
-        [keeper addObject:coord];
+    return result == 0;
+}
+
+- (void)dealloc {
+    if (_countsDriving) {
+        __atomic_sub_fetch(cos_driving_count((__bridge void *)_key), 1, __ATOMIC_RELAXED);
     }
-        break;
 
-    case COSLAYOUT_TOKEN_COORD: {
-        COSCoord *coord = nil;
-        char *spec = ast->value.coord;
+    coslayout_registry_remove(cos_solver_registry(), (__bridge void *)_key, (__bridge void *)self);
+    coslayout_costs_destroy(_costs);
+    coslayout_params_destroy(&_params);
+    coslayout_snapshot_destroy(&_geometry);
+}
 
-        switch (spec[0]) {
-        case '^': {
-            COSFloatBlock block = [args floatBlockValue];
+@end
 
-            coord = [COSCoord coordWithBlock:^CGFloat(COSLayoutRule *rule) {
-                return block(rule.view);
-            }];
-        }
-            break;
 
-        case '@': {
-            id<COSCGFloatProtocol> value = [args objectValue];
+typedef id (^COSHookBlock)(IMP origImp);
 
-            coord = [COSCoord coordWithBlock:^CGFloat(COSLayoutRule *rule) {
-                return [value cos_CGFloatValue];
-            }];
-        }
-            break;
+/* Replaces the method name of class once, by the block made from the
+ * original implementation. Classes hooked before are found by loads of
+ * classes alone, the mutex is only taken to hook. */
+static void cos_hook_class_once(COSLAYOUT_REGISTRY *classes, Class class, SEL name, COSHookBlock makeBlock) {
+    if (coslayout_registry_get(classes, (__bridge void *)class)) return;
 
-        default: {
-            switch (spec[0]) {
-            case 'f':
-                coord = [COSCoord coordWithFloat:[args floatValue]];
-                break;
+    pthread_mutex_lock(&swizzleMutex);
 
-            default: {
-                COSCoords *coords = [COSCoords coordsOfView:[args objectValue]];
-                coord = [coords valueForKey:COS_STRING(spec)];
-            }
-                break;
-            }
-        }
-            break;
-        }
+    if (!coslayout_registry_get(classes, (__bridge void *)class)) {
+        IMP origImp = class_getMethodImplementation(class, name);
+        IMP overImp = imp_implementationWithBlock(makeBlock(origImp));
 
-        ast->data = (__bridge void *)(coord);
+        class_replaceMethod(class, name, overImp, "v@:");
 
-        [keeper addObject:coord];
+        coslayout_registry_set(classes, (__bridge void *)class, (__bridge void *)class);
     }
-        break;
 
-    case COSLAYOUT_TOKEN_COORD_PERCENTAGE:
-    case COSLAYOUT_TOKEN_COORD_PERCENTAGE_H:
-    case COSLAYOUT_TOKEN_COORD_PERCENTAGE_V: {
-        COSCoord *coord = nil;
-        char *spec = ast->value.coord;
+    pthread_mutex_unlock(&swizzleMutex);
+}
 
-        COSLayoutDir dir = 0;
+NS_INLINE
+void cos_initialize_layout_if_needed(UIView *view) {
+    SEL name = @selector(didMoveToSuperview);
 
-        switch (ast->node_type) {
-        case COSLAYOUT_TOKEN_COORD_PERCENTAGE_H: dir = COSLayoutDirh; break;
-        case COSLAYOUT_TOKEN_COORD_PERCENTAGE_V: dir = COSLayoutDirv; break;
-        }
+    cos_hook_class_once(swizzledLayoutClasses, [view class], name, ^id(IMP origImp) {
+        return ^(UIView *view) {
+            ((void(*)(id, SEL))(origImp))(view, name);
 
-        switch (spec[0]) {
-        case '^':{
-            COSFloatBlock block = [args floatBlockValue];
+            COSLayout *layout = objc_getAssociatedObject(view, COSLayoutKey);
 
-            coord = [COSCoord coordWithBlock:^CGFloat(COSLayoutRule *rule) {
-                CGFloat percentage = block(rule.view);
-                COSCoord *coord = [COSCoord coordWithPercentage:percentage dir:dir];
+            if (layout) [layout updateLayoutDriver];
+        };
+    });
+}
 
-                return coord.block(rule);
-            }];
-        }
-            break;
+/* Hooks layoutSubviews of the whole class. Only views whose solver drives
+ * layout solve. Other instances of class load their driving count, which
+ * is zero unless it is shared with a driving view, and call the original
+ * implementation. */
+NS_INLINE
+void cos_hook_driver_class(Class class) {
+    SEL name = @selector(layoutSubviews);
 
-        case '@': {
-            id<COSCGFloatProtocol> object = [args objectValue];
+    cos_hook_class_once(swizzledDriverClasses, class, name, ^id(IMP origImp) {
+        return ^(UIView *view) {
+            if (__atomic_load_n(cos_driving_count((__bridge void *)view), __ATOMIC_RELAXED) == 0) {
+                ((void(*)(id, SEL))(origImp))(view, name);
+                return;
+            }
 
-            coord = [COSCoord coordWithBlock:^CGFloat(COSLayoutRule *rule) {
-                CGFloat percentage = [object cos_CGFloatValue];
-                COSCoord *coord = [COSCoord coordWithPercentage:percentage dir:dir];
+            COSLayoutSolver *solver = cos_solver_of_view(view);
 
-                return coord.block(rule);
-            }];
-        }
-            break;
+            if ([solver drivesLayoutOfView:view]) {
+                [solver beginSolves];
+                ((void(*)(id, SEL))(origImp))(view, name);
+                [solver endSolves];
+            } else {
+                ((void(*)(id, SEL))(origImp))(view, name);
+            }
+        };
+    });
+}
 
-        default:
-            coord = [COSCoord coordWithPercentage:[args floatValue] dir:dir];
-            break;
-        }
+/* Makes layoutSubviews of the view of solver drive it, unless it opted
+ * out. The class the view reports is hooked, never the view: classes made
+ * at runtime for single views, e.g. by key value observing, report the
+ * class they derive from and inherit the hook. */
+NS_INLINE
+void cos_initialize_driver_if_needed(COSLayoutSolver *solver) {
+    UIView *view = solver.view;
 
-        ast->data = (__bridge void *)(coord);
+    solver.constrainsSubviews = YES;
 
-        [keeper addObject:coord];
+    if (view && solver.drivesLayout) {
+        cos_hook_driver_class([view class]);
     }
-        break;
+}
 
-    case COSLAYOUT_TOKEN_NIL: {
-        ast->data = (__bridge void *)([COSCoord nilCoord]);
+
+/* Arguments of a rule read in order, from typed arguments, a va_list or an
+ * array. Shift reads the next argument as type, arguments past the end
+ * are zero. Cursors live on the stack, reading allocates nothing. */
+typedef struct COSLAYOUT_ARGS_CURSOR {
+    COSLayoutArgument (*shift)(struct COSLAYOUT_ARGS_CURSOR *cursor, COSLayoutArgumentType type);
+    const COSLayoutArgument *arguments;
+    __unsafe_unretained NSArray *array;
+    va_list *valist;
+    NSUInteger count;
+    NSUInteger index;
+} COSLAYOUT_ARGS_CURSOR;
+
+/* Typed arguments are read as given, their types are checked by the
+ * caller. */
+static COSLayoutArgument cos_shift_typed_argument(COSLAYOUT_ARGS_CURSOR *cursor, COSLayoutArgumentType type) {
+    if (cursor->index >= cursor->count) {
+        return (COSLayoutArgument){ .type = type };
     }
-        break;
 
-    case '+': {
-        COSCoord *coord1 = (__bridge COSCoord *)(ast->l->data);
-        COSCoord *coord2 = (__bridge COSCoord *)(ast->r->data);
+    return cursor->arguments[cursor->index++];
+}
 
-        COSCoord *coord = [coord1 add:coord2];
+static COSLayoutArgument cos_shift_va_argument(COSLAYOUT_ARGS_CURSOR *cursor, COSLayoutArgumentType type) {
+    COSLayoutArgument argument = { .type = type };
 
-        ast->data = (__bridge void *)(coord);
+    switch (type) {
+    case COSLayoutArgumentFloat:
+        argument.floatValue = va_arg(*cursor->valist, double);
+        break;
 
-        [keeper addObject:coord];
-    }
+    case COSLayoutArgumentBlock:
+        argument.block = va_arg(*cursor->valist, COSFloatBlock);
         break;
 
-    case '-': {
-        COSCoord *coord1 = (__bridge COSCoord *)(ast->l->data);
-        COSCoord *coord2 = (__bridge COSCoord *)(ast->r->data);
+    case COSLayoutArgumentFunction:
+        argument.provider.function = va_arg(*cursor->valist, COSFloatFunction);
+        argument.provider.context = va_arg(*cursor->valist, void *);
+        break;
 
-        COSCoord *coord = [coord1 sub:coord2];
+    default:
+        argument.object = va_arg(*cursor->valist, id);
+        break;
+    }
 
-        ast->data = (__bridge void *)(coord);
+    return argument;
+}
 
-        [keeper addObject:coord];
-    }
-        break;
+static COSLayoutArgument cos_shift_array_argument(COSLAYOUT_ARGS_CURSOR *cursor, COSLayoutArgumentType type) {
+    COSLayoutArgument argument = { .type = type };
 
-    case '*': {
-        COSCoord *coord1 = (__bridge COSCoord *)(ast->l->data);
-        COSCoord *coord2 = (__bridge COSCoord *)(ast->r->data);
+    if (cursor->index >= cursor->count) return argument;
 
-        COSCoord *coord = [coord1 mul:coord2];
+    id object = cursor->array[cursor->index++];
 
-        ast->data = (__bridge void *)(coord);
+    if (type == COSLayoutArgumentFloat) {
+        argument.floatValue = (CGFloat)[object doubleValue];
+    } else if (type == COSLayoutArgumentFunction) {
+        /* A function and its context, both boxed with valueWithPointer:. */
+        id context = cursor->index < cursor->count ? cursor->array[cursor->index++] : nil;
 
-        [keeper addObject:coord];
+        argument.provider.function = (COSFloatFunction)[object pointerValue];
+        argument.provider.context = [context pointerValue];
+    } else {
+        argument.object = object;
     }
-        break;
 
-    case '/': {
-        COSCoord *coord1 = (__bridge COSCoord *)(ast->l->data);
-        COSCoord *coord2 = (__bridge COSCoord *)(ast->r->data);
+    return argument;
+}
 
-        COSCoord *coord = [coord1 div:coord2];
 
-        ast->data = (__bridge void *)(coord);
+static double cos_call_float_block(void *info, void *view) {
+    __unsafe_unretained COSFloatBlock block = (__bridge COSFloatBlock)info;
 
-        [keeper addObject:coord];
-    }
-        break;
+    return block((__bridge UIView *)view);
+}
 
-    case '=': {
-        COSCoord *coord = (__bridge COSCoord *)(ast->r->data);
+static double cos_call_float_object(void *info, void *view) {
+    __unsafe_unretained id<COSCGFloatProtocol> object = (__bridge id<COSCGFloatProtocol>)info;
 
-        [self setValue:coord forKey:COS_STRING(ast->l->value.coord)];
+    return [object cos_CGFloatValue];
+}
 
-        ast->data = (__bridge void *)(coord);
-    }
-        break;
+static void cos_call_pass_handler(const COSLAYOUT_PASS_STATS *pass, void *info) {
+    __unsafe_unretained COSLayoutPassHandler handler = (__bridge COSLayoutPassHandler)info;
 
-    case COSLAYOUT_TOKEN_ADD_ASSIGN:
-    case COSLAYOUT_TOKEN_SUB_ASSIGN:
-    case COSLAYOUT_TOKEN_MUL_ASSIGN:
-    case COSLAYOUT_TOKEN_DIV_ASSIGN: {
-        NSString *name = COS_STRING(ast->l->value.coord);
+    handler((COSLayoutPassStatistics){ pass->views, pass->evaluations, pass->changed, pass->seconds });
+}
 
-        COSCoord *lval  = COSCOORD_FOR_NAME(name);
-        COSCoord *rval = (__bridge COSCoord *)(ast->r->data);
+static void cos_release_info(void *info) {
+    CFRelease(info);
+}
 
-        SEL sel = NULL;
 
-        switch (ast->node_type) {
-        case COSLAYOUT_TOKEN_ADD_ASSIGN: sel = @selector(add:); break;
-        case COSLAYOUT_TOKEN_SUB_ASSIGN: sel = @selector(sub:); break;
-        case COSLAYOUT_TOKEN_MUL_ASSIGN: sel = @selector(mul:); break;
-        case COSLAYOUT_TOKEN_DIV_ASSIGN: sel = @selector(div:); break;
+/* Texts of the rules of set, each once. */
+static NSArray *cos_rules_of_ruleset(const COSLAYOUT_RULESET *set) {
+    NSMutableArray *rules = [NSMutableArray array];
+
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        const COSLAYOUT_SOURCE *source = set->sources[attr];
+        BOOL seen = NO;
+
+        /* Far edges share the source of the near edge they flip to. */
+        for (int prior = 0; prior < attr && !seen; ++prior) {
+            seen = set->sources[prior] == source;
         }
 
-        IMP imp = [lval methodForSelector:sel];
+        if (source == NULL || seen) continue;
 
-        COSCoord *coord = ((id(*)(id, SEL, id))(imp))(lval, sel, rval);
+        const char *start;
+        size_t length = coslayout_source_subrule(source, &start);
 
-        [self setValue:coord forKey:name];
+        NSString *rule = [[NSString alloc] initWithBytes:start length:length encoding:NSUTF8StringEncoding];
 
-        ast->data = (__bridge void *)(coord);
+        if (rule) [rules addObject:rule];
     }
-        break;
 
-    default:
-        break;
-    }
+    return rules;
 }
 
-- (void)setValue:(id)value forKey:(NSString *)key {
-    @try {
-        [super setValue:value forKey:key];
-    } @catch (NSException *exception) {
-        fprintf(stderr, "COSLayout: Invalid constraint \"%s\", ignored.\n", [key UTF8String]);
-    }
-}
 
-- (void)updateLayoutDriver {
-    UIView *superview = _view.superview;
+@implementation COSLayoutRuleProfile
 
-    if (superview && !objc_getAssociatedObject(superview, COSLayoutDriverKey)) {
-        COSLayoutDriver *driver = [[COSLayoutDriver alloc] initWithView:superview];
+- (instancetype)initWithEntry:(const COSLAYOUT_PROFILE_ENTRY *)entry {
+    self = [super init];
 
-        objc_setAssociatedObject(superview, COSLayoutDriverKey, driver, OBJC_ASSOCIATION_RETAIN);
-        cos_initialize_driver_if_needed(superview);
+    if (self) {
+        _rule = [NSString stringWithUTF8String:entry->rule];
+        _subrule = entry->subrule;
+        _attribute = [NSString stringWithUTF8String:coslayout_attr_name(entry->attr)];
+        _calls = (NSUInteger)entry->calls;
+        _time = entry->seconds;
     }
+
+    return self;
 }
 
-- (NSSet *)dependencies {
-    NSMutableSet *viewSet = [[NSMutableSet alloc] init];
-    NSMutableSet *ruleSet = [[NSMutableSet alloc] init];
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %.3f ms, %lu calls, %@ of \"%@\" #%lu>",
+            [self class], _time * 1e3, (unsigned long)_calls, _attribute, _rule, (unsigned long)_subrule];
+}
 
-    if (self.hRule) {
-        [ruleSet addObject:self.hRule];
-    }
+@end
 
-    if (self.wRule) {
-        [ruleSet addObject:self.wRule];
-    }
 
-    [ruleSet addObjectsFromArray:self.ruleHub.vRules];
-    [ruleSet addObjectsFromArray:self.ruleHub.hRules];
-    [ruleSet addObjectsFromArray:self.ruleMap.allValues];
+@implementation COSLayoutSlowView
 
-    for (COSLayoutRule *rule in ruleSet) {
-        [viewSet unionSet:rule.coord.dependencies];
-    }
+- (instancetype)initWithNode:(const COSLAYOUT_NODE *)node {
+    self = [super init];
 
-    if (_view.superview) {
-        [viewSet addObject:_view.superview];
+    if (self) {
+        _view = (__bridge UIView *)node->view;
+        _solveTime = node->nanoseconds * 1e-9;
+        _rules = cos_rules_of_ruleset(node->set);
     }
 
-    return viewSet;
+    return self;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %.3f ms, %@ %@>",
+            [self class], _solveTime * 1e3, _view, [_rules componentsJoinedByString:@", "]];
 }
 
-- (void)solveRules:(NSArray *)rules {
-    COSLayoutRulesSolver *solver = [[COSLayoutRulesSolver alloc] init];
+@end
+
 
-    solver.view = _view;
+static void cos_call_slow_solve_handler(const COSLAYOUT_SLOW_SOLVE *solve, void *info) {
+    __unsafe_unretained COSLayoutSlowSolveHandler handler = (__bridge COSLayoutSlowSolveHandler)info;
 
-    NSMutableString *selStr = [NSMutableString stringWithString:@"solve"];
+    NSMutableArray *views = [NSMutableArray arrayWithCapacity:solve->count];
 
-    for (COSLayoutRule *rule in rules) {
-        [selStr appendString:[rule.name capitalizedString]];
+    for (size_t i = 0; i < solve->count; ++i) {
+        [views addObject:[[COSLayoutSlowView alloc] initWithNode:solve->nodes[i]]];
     }
 
-    [selStr appendString:@":"];
+    handler((__bridge UIView *)solve->container, solve->seconds, views);
+}
 
-    SEL sel = NSSelectorFromString(selStr);
-    CGRect (*imp)(id, SEL, NSArray *) = (void *)[solver methodForSelector:sel];
 
-    _frame = imp(solver, sel, rules);
+typedef struct COSLAYOUT_ARGS_INFO {
+    COSLAYOUT_ARGS_CURSOR *args;
+    __unsafe_unretained COSLayout *layout;
+    /* Arguments as recorded in a session, nil if none is recorded. */
+    __unsafe_unretained NSMutableData *recorded;
+} COSLAYOUT_ARGS_INFO;
 
-    [self checkBounds];
-}
+static void cos_record_argument(COSLAYOUT_ARGS_INFO *info, double number, long view) {
+    if (!info->recorded) return;
 
-- (void)checkBounds {
-    CGSize size = _frame.size;
+    COSLAYOUT_SESSION_ARG arg = { number, view };
 
-    CGFloat minw = COS_MM_RAW_VALUE(self, minw);
+    [info->recorded appendBytes:&arg length:sizeof(arg)];
+}
 
-    if (COS_VALID_DIM(minw) && size.width < minw) {
-        size.width = minw;
-    }
+/* Expression of a reference by name like header.bt, looked up in the
+ * superview of the view ruled, then in its ancestors. The view is bound
+ * for good, NULL fails the rule. */
+static COSLAYOUT_EXPR *cos_expr_of_reference(COSLAYOUT_ARGS_INFO *info, const char *spec) {
+    size_t length;
+    int attr = coslayout_spec_reference(spec, &length);
 
-    CGFloat maxw = COS_MM_RAW_VALUE(self, maxw);
+    if (attr < 0) return NULL;
 
-    if (COS_VALID_DIM(maxw) && size.width > maxw) {
-        size.width = maxw;
-    }
+    NSString *name = [[NSString alloc] initWithBytes:spec length:length encoding:NSASCIIStringEncoding];
 
-    CGFloat minh = COS_MM_RAW_VALUE(self, minh);
+    for (UIView *container = info->layout.view.superview; container; container = container.superview) {
+        COSLayoutSolver *solver = cos_solver_of_view(container);
+        UIView *view = solver.view == container ? [solver viewForName:name] : nil;
 
-    if (COS_VALID_DIM(minh) && size.height < minh) {
-        size.height = minh;
-    }
+        if (!view) continue;
 
-    CGFloat maxh = COS_MM_RAW_VALUE(self, maxh);
+        if (info->recorded) {
+            coslayout_session_name(cos_session_view(container), cos_session_view(view), [name UTF8String]);
+        }
+
+        [info->layout referenceView:view];
 
-    if (COS_VALID_DIM(maxh) && size.height > maxh) {
-        size.height = maxh;
+        return coslayout_expr_create_attr(attr, (__bridge void *)view);
     }
 
-    _frame.size = size;
+    return NULL;
 }
 
-- (void)startLayout {
-    _frame = _view.frame;
+/* Expressions of format specifiers: %f for floats, %^f for blocks, %@ for
+ * objects, %*f for functions, or a rule name like %tt for the same rule
+ * of a view. */
+static COSLAYOUT_EXPR *cos_expr_of_argument(void *info, const char *spec, int percentage, int dir) {
+    COSLAYOUT_ARGS_INFO *argsInfo = (COSLAYOUT_ARGS_INFO *)info;
+    COSLAYOUT_ARGS_CURSOR *args = argsInfo->args;
+
+    if (strchr(spec, '.') != NULL) return cos_expr_of_reference(argsInfo, spec);
+
+    COSLayoutArgumentType type = (spec[0] == '^' ? COSLayoutArgumentBlock :
+                                  spec[0] == '@' ? COSLayoutArgumentObject :
+                                  spec[0] == '*' ? COSLayoutArgumentFunction :
+                                  spec[0] == 'f' || percentage ? COSLayoutArgumentFloat :
+                                  COSLayoutArgumentView);
+
+    COSLayoutArgument argument = args->shift(args, type);
+
+    if (argument.type != type) return NULL;
+
+    switch (spec[0]) {
+    case '^': {
+        void *block = (void *)CFBridgingRetain([argument.block copy]);
+
+        if (argsInfo->recorded) {
+            cos_record_argument(argsInfo, cos_call_float_block(block, (__bridge void *)argsInfo->layout.view), -1);
+        }
+
+        return (percentage ?
+                coslayout_expr_create_call_percentage(cos_call_float_block, block, cos_release_info, dir) :
+                coslayout_expr_create_call(cos_call_float_block, block, cos_release_info));
+    }
 
-    [self checkBounds];
+    case '@': {
+        void *object = (void *)CFBridgingRetain(argument.object);
 
-    NSUInteger hRuleCount = [_ruleHub.hRules count];
-    NSUInteger vRuleCount = [_ruleHub.vRules count];
+        if (argsInfo->recorded) {
+            cos_record_argument(argsInfo, cos_call_float_object(object, NULL), -1);
+        }
 
-    if (self.wRule && hRuleCount < 2) {
-        _frame.size.width = [self.wRule floatValue];
+        return (percentage ?
+                coslayout_expr_create_call_percentage(cos_call_float_object, object, cos_release_info, dir) :
+                coslayout_expr_create_call(cos_call_float_object, object, cos_release_info));
     }
 
-    if (self.hRule && vRuleCount < 2) {
-        _frame.size.height = [self.hRule floatValue];
+    case '*': {
+        /* An unretained view is passed like a void *, so the core calls
+         * functions directly and nothing is retained or released. */
+        COSLAYOUT_FUNC function = (COSLAYOUT_FUNC)argument.provider.function;
+        void *context = argument.provider.context;
+
+        if (function == NULL) return NULL;
+
+        if (argsInfo->recorded) {
+            cos_record_argument(argsInfo, function(context, (__bridge void *)argsInfo->layout.view), -1);
+        }
+
+        return (percentage ?
+                coslayout_expr_create_call_percentage(function, context, NULL, dir) :
+                coslayout_expr_create_call(function, context, NULL));
     }
 
-    if (hRuleCount > 0) {
-        [self solveRules:_ruleHub.hRules];
+    default:
+        break;
     }
 
-    if (vRuleCount > 0) {
-        [self solveRules:_ruleHub.vRules];
+    if (type == COSLayoutArgumentFloat) {
+        CGFloat value = argument.floatValue;
+
+        cos_record_argument(argsInfo, value, -1);
+
+        return (percentage ?
+                coslayout_expr_create_percentage(value, dir) :
+                coslayout_expr_create_const(value));
     }
 
-    [self checkBounds];
+    UIView *view = argument.view;
+    int attr = coslayout_attr_named(spec);
+
+    if (![view isKindOfClass:[UIView class]] || attr < 0) return NULL;
 
-    if (!CGRectEqualToRect(_frame, _view.frame)) {
-        _view.frame = _frame;
+    if (argsInfo->recorded) {
+        cos_record_argument(argsInfo, 0, cos_session_view(view));
     }
+
+    [argsInfo->layout referenceView:view];
+
+    return coslayout_expr_create_attr(attr, (__bridge void *)view);
 }
 
-- (void)setW:(COSCoord *)w {
-    _w = w;
-    self.wRule = [COSLayoutRule layoutRuleWithView:_view name:nil coord:w dir:COSLayoutDirh];
+
+@implementation COSLayout {
+    /* Rules shared with other views, and what they refer to for this one. */
+    COSLAYOUT_PROGRAM *_program;
+    COSLAYOUT_BINDINGS _bindings;
+
+    /* Parameters of the view, read before those of its superview. */
+    COSLAYOUT_PARAMS _params;
+
+    /* Views referenced by rules, expressions hold unretained pointers.
+     * Created with the first reference, most views reference none. */
+    NSHashTable *_referencedViews;
+
+    NSUInteger _generation;
 }
 
-- (void)setH:(COSCoord *)h {
-    _h = h;
-    self.hRule = [COSLayoutRule layoutRuleWithView:_view name:nil coord:h dir:COSLayoutDirv];
++ (void)initialize {
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        swizzledDriverClasses = coslayout_registry_create();
+        swizzledLayoutClasses = coslayout_registry_create();
+    });
 }
 
-- (void)setMinw:(COSCoord *)minw {
-    COSLAYOUT_ADD_BOUND_RULE(minw, h);
++ (instancetype)layoutOfView:(UIView *)view {
+    if (![view isKindOfClass:[UIView class]]) return nil;
+
+    COSLayout *layout = objc_getAssociatedObject(view, COSLayoutKey);
+
+    if (!layout) {
+        layout = [[COSLayout alloc] initWithView:view];
+
+        objc_setAssociatedObject(view, COSLayoutKey, layout, OBJC_ASSOCIATION_RETAIN);
+
+        cos_initialize_layout_if_needed(view);
+
+        [layout updateLayoutDriver];
+    }
+
+    return layout;
 }
 
-- (void)setMaxw:(COSCoord *)maxw {
-    COSLAYOUT_ADD_BOUND_RULE(maxw, h);
++ (void)setCacheCountLimit:(NSUInteger)countLimit byteLimit:(NSUInteger)byteLimit {
+    coslayout_cache_set_limits(cos_shared_cache(), countLimit, byteLimit);
 }
 
-- (void)setMinh:(COSCoord *)minh {
-    COSLAYOUT_ADD_BOUND_RULE(minh, v);
++ (COSLayoutCacheStatistics)cacheStatistics {
+    COSLAYOUT_CACHE_STATS stats = coslayout_cache_stats(cos_shared_cache());
+
+    return (COSLayoutCacheStatistics){ stats.hits, stats.misses, stats.evictions, stats.count, stats.bytes };
 }
 
-- (void)setMaxh:(COSCoord *)maxh {
-    COSLAYOUT_ADD_BOUND_RULE(maxh, v);
++ (void)resetCacheStatistics {
+    coslayout_cache_reset_stats(cos_shared_cache());
 }
 
-- (void)setTt:(COSCoord *)tt {
-    COSLAYOUT_ADD_RULE(tt, v);
++ (void)clearCache {
+    coslayout_cache_clear(cos_shared_cache());
 }
 
-- (void)setTb:(COSCoord *)tb {
-    COSLAYOUT_ADD_TRANS_RULE(tb, tt, COS_SUPERVIEW_HEIGHT - tb.block(rule));
++ (void)setStatisticsEnabled:(BOOL)enabled {
+    coslayout_stats_set_enabled(enabled);
 }
 
-- (void)setLl:(COSCoord *)ll {
-    COSLAYOUT_ADD_RULE(ll, h);
++ (BOOL)statisticsEnabled {
+    return COSLAYOUT_STATS_ENABLED() != 0;
 }
 
-- (void)setLr:(COSCoord *)lr {
-    COSLAYOUT_ADD_TRANS_RULE(lr, ll, COS_SUPERVIEW_WIDTH - lr.block(rule));
++ (COSLayoutStatistics)statistics {
+    COSLAYOUT_STATS stats = coslayout_stats_get();
+
+    return (COSLayoutStatistics){
+        stats.passes, stats.views, stats.evaluations, stats.changed,
+        stats.solve_seconds, stats.parses, stats.parse_seconds, stats.elapsed
+    };
 }
 
-- (void)setBb:(COSCoord *)bb {
-    COSLAYOUT_ADD_TRANS_RULE(bb, bt, COS_SUPERVIEW_HEIGHT - bb.block(rule));
++ (void)resetStatistics {
+    coslayout_stats_reset();
 }
 
-- (void)setBt:(COSCoord *)bt {
-    COSLAYOUT_ADD_RULE(bt, v);
++ (void)setPassHandler:(COSLayoutPassHandler)handler {
+    if (handler) {
+        coslayout_stats_set_pass_func(cos_call_pass_handler, (__bridge_retained void *)[handler copy], cos_release_info);
+    } else {
+        coslayout_stats_set_pass_func(NULL, NULL, NULL);
+    }
 }
 
-- (void)setRr:(COSCoord *)rr {
-    COSLAYOUT_ADD_TRANS_RULE(rr, rl, COS_SUPERVIEW_WIDTH - rr.block(rule));
++ (void)setProfilingEnabled:(BOOL)enabled {
+    coslayout_profile_set_enabled(enabled);
 }
 
-- (void)setRl:(COSCoord *)rl {
-    COSLAYOUT_ADD_RULE(rl, h);
++ (BOOL)profilingEnabled {
+    return (COSLAYOUT_PROFILE_FLAGS() & COSLAYOUT_PROFILE_RULES) != 0;
 }
 
-- (void)setCt:(COSCoord *)ct {
-    COSLAYOUT_ADD_RULE(ct, v);
++ (NSArray *)profiledRulesWithLimit:(NSUInteger)limit {
+    COSLAYOUT_PROFILE_ENTRY *entries = (COSLAYOUT_PROFILE_ENTRY *)calloc(MAX(limit, 1), sizeof(COSLAYOUT_PROFILE_ENTRY));
+    size_t count = coslayout_profile_copy(entries, limit);
+
+    NSMutableArray *rules = [NSMutableArray arrayWithCapacity:count];
+
+    for (size_t i = 0; i < count; ++i) {
+        [rules addObject:[[COSLayoutRuleProfile alloc] initWithEntry:&entries[i]]];
+    }
+
+    coslayout_profile_entries_destroy(entries, count);
+    free(entries);
+
+    return rules;
 }
 
-- (void)setCl:(COSCoord *)cl {
-    COSLAYOUT_ADD_RULE(cl, h);
++ (void)resetProfile {
+    coslayout_profile_reset();
 }
 
-- (void)setCb:(COSCoord *)cb {
-    COSLAYOUT_ADD_TRANS_RULE(cb, ct, COS_SUPERVIEW_HEIGHT - cb.block(rule));
++ (void)setSolveBudget:(NSTimeInterval)budget handler:(COSLayoutSlowSolveHandler)handler {
+    if (handler) {
+        coslayout_watchdog_set(budget, cos_call_slow_solve_handler, (__bridge_retained void *)[handler copy], cos_release_info);
+    } else {
+        coslayout_watchdog_set(budget, NULL, NULL, NULL);
+    }
 }
 
-- (void)setCr:(COSCoord *)cr {
-    COSLAYOUT_ADD_TRANS_RULE(cr, cl, COS_SUPERVIEW_WIDTH - cr.block(rule));
++ (void)setTracingEnabled:(BOOL)enabled {
+    coslayout_trace_set_enabled(enabled);
 }
 
-- (COSLayoutRuleHub *)ruleHub {
-    return (_ruleHub ?: (_ruleHub = [[COSLayoutRuleHub alloc] init]));
++ (BOOL)tracingEnabled {
+    return COSLAYOUT_TRACE_ENABLED() != 0;
 }
 
-- (NSMutableDictionary *)ruleMap {
-    return (_ruleMap ?: (_ruleMap = [[NSMutableDictionary alloc] init]));
++ (void)setCostHistory:(NSUInteger)passes {
+    coslayout_costs_set_history(passes);
 }
 
-@end
++ (BOOL)writeDependencyGraphOfView:(UIView *)view toFile:(NSString *)path format:(COSLayoutGraphFormat)format {
+    FILE *file = fopen([path fileSystemRepresentation], "w");
 
+    if (!file) return NO;
 
-#define COSCOORD_CALC(expr)                              \
-do {                                                     \
-    if ([self valid] && [other valid]) {                 \
-        COSCoord *coord = [[COSCoord alloc] init];       \
-        NSMutableSet *dependencies = self.dependencies;  \
-                                                         \
-        [dependencies unionSet:other.dependencies];      \
-                                                         \
-        coord.dependencies = dependencies;               \
-        coord.block = ^CGFloat(COSLayoutRule *rule) {    \
-            return (expr);                               \
-        };                                               \
-                                                         \
-        return coord;                                    \
-    } else if ([self valid] && ![other valid]) {         \
-        return self;                                     \
-    } else if (![self valid] && [other valid]) {         \
-        return other;                                    \
-    } else {                                             \
-        return self;                                     \
-    }                                                    \
-} while (0)
-
-
-@implementation COSCoord
-
-+ (instancetype)nilCoord {
-    static COSCoord *nilCoord = nil;
-    static dispatch_once_t onceToken;
+    COSLayoutSolver *solver = cos_solver_of_view(view);
+    BOOL written;
 
-    dispatch_once(&onceToken, ^{
-        nilCoord = [[COSCoord alloc] init];
-    });
+    if (solver.view == view) {
+        written = [solver writeGraphToFile:file format:(int)format];
+    } else {
+        written = coslayout_dump_write(file, (int)format, (__bridge void *)view, NULL, 0, NULL, NULL, NULL) == 0;
+    }
 
-    return nilCoord;
+    return fclose(file) == 0 && written;
 }
 
-+ (instancetype)coordWithFloat:(CGFloat)value {
-    COSCoord *coord = [[COSCoord alloc] init];
++ (BOOL)startRecordingToFile:(NSString *)path {
+    FILE *file = fopen([path fileSystemRepresentation], "w");
 
-    coord.block = ^CGFloat(COSLayoutRule *rule) {
-        return value;
-    };
+    if (!file) return NO;
 
-    return coord;
+    if (coslayout_session_start(file) != 0) {
+        fclose(file);
+        return NO;
+    }
+
+    return YES;
 }
 
-+ (instancetype)coordWithPercentage:(CGFloat)percentage {
-    return [self coordWithPercentage:percentage dir:0];
++ (BOOL)stopRecording {
+    return coslayout_session_stop() == 0;
 }
 
-+ (instancetype)coordWithPercentage:(CGFloat)percentage dir:(COSLayoutDir)dir_ {
-    COSCoord *coord = [[COSCoord alloc] init];
++ (BOOL)writeTraceToFile:(NSString *)path {
+    FILE *file = fopen([path fileSystemRepresentation], "w");
 
-    percentage /= 100.0;
+    if (!file) return NO;
 
-    coord.block = ^CGFloat(COSLayoutRule *rule) {
-        UIView *view = rule.view;
+    long count = coslayout_trace_write(file);
 
-        COSLayoutDir dir = dir_ ? dir_ : rule.dir;
-        CGFloat size = (dir == COSLayoutDirv ? COS_SUPERVIEW_HEIGHT : COS_SUPERVIEW_WIDTH);
+    return fclose(file) == 0 && count >= 0;
+}
 
-        return size * percentage;
-    };
+- (instancetype)initWithView:(UIView *)view {
+    self = [super init];
+
+    if (self) {
+        _view = view;
+
+        _program = coslayout_program_create();
+        coslayout_bindings_init(&_bindings);
+        coslayout_params_init(&_params);
+    }
 
-    return coord;
+    return self;
 }
 
-+ (instancetype)coordWithBlock:(COSCoordBlock)block {
-    COSCoord *coord = [[COSCoord alloc] init];
+- (void)addRule:(NSString *)format, ... {
+    va_list argv;
+    va_start(argv, format);
 
-    coord.block = block;
+    [self addRule:format args:argv];
 
-    return coord;
+    va_end(argv);
 }
 
-- (instancetype)add:(COSCoord *)other {
-    COSCOORD_CALC(self.block(rule) + other.block(rule));
-}
+- (void)addRule:(NSString *)format args:(va_list)args {
+    va_list valist;
+    va_copy(valist, args);
 
-- (instancetype)sub:(COSCoord *)other {
-    COSCOORD_CALC(self.block(rule) - other.block(rule));
-}
+    COSLAYOUT_ARGS_CURSOR cursor = { cos_shift_va_argument, NULL, nil, &valist, 0, 0 };
 
-- (instancetype)mul:(COSCoord *)other {
-    COSCOORD_CALC(self.block(rule) * other.block(rule));
-}
+    [self addRule:format cursor:&cursor];
 
-- (instancetype)div:(COSCoord *)other {
-    COSCOORD_CALC(self.block(rule) / other.block(rule));
+    va_end(valist);
 }
 
-- (NSMutableSet *)dependencies {
-    return _dependencies ?: (_dependencies = [[NSMutableSet alloc] init]);
+- (void)addRule:(NSString *)format arguments:(NSArray *)arguments {
+    COSLAYOUT_ARGS_CURSOR cursor = { cos_shift_array_argument, NULL, arguments, NULL, arguments.count, 0 };
+
+    [self addRule:format cursor:&cursor];
 }
 
-- (BOOL)valid {
-    return self != [COSCoord nilCoord] && self.block;
+- (void)addRule:(NSString *)format arguments:(const COSLayoutArgument *)arguments count:(NSUInteger)count {
+    COSLAYOUT_ARGS_CURSOR cursor = { cos_shift_typed_argument, arguments, nil, NULL, count, 0 };
+
+    [self addRule:format cursor:&cursor];
 }
 
-@end
+- (void)addRule:(NSString *)format cursor:(COSLAYOUT_ARGS_CURSOR *)args {
+    const char *rule = [format cStringUsingEncoding:NSASCIIStringEncoding];
 
+    NSMutableData *recorded = COSLAYOUT_SESSION_RECORDING() ? [NSMutableData data] : nil;
+    COSLAYOUT_ARGS_INFO info = { args, self, recorded };
 
-@interface COSCoords ()
+    uint64_t traced = COSLAYOUT_TRACE_ENABLED() ? coslayout_stats_now() : 0;
+    int result = coslayout_program_add_rule(&_program, &_bindings, rule, cos_expr_of_argument, &info);
 
-@property (nonatomic, weak) UIView *view;
+    if (traced) {
+        coslayout_trace_span("add_rule", traced, (__bridge void *)_view, (__bridge void *)_view.superview);
+    }
 
-@property (nonatomic, strong) COSCoord *w;
-@property (nonatomic, strong) COSCoord *h;
+    if (recorded && result == 0) {
+        coslayout_session_rule(cos_session_view(_view), rule, recorded.bytes, recorded.length / sizeof(COSLAYOUT_SESSION_ARG));
+    }
 
-@property (nonatomic, strong) COSCoord *tt;
-@property (nonatomic, strong) COSCoord *tb;
+    switch (result) {
+    case 0:
+        break;
+
+    case 1:
+        [NSException raise:COSLayoutSyntaxExceptionName format:@"%@", COSLayoutSyntaxExceptionDesc];
+        break;
+
+    case 3:
+        [NSException raise:COSLayoutNameExceptionName format:@"%@", COSLayoutNameExceptionDesc];
+        break;
 
-@property (nonatomic, strong) COSCoord *ll;
-@property (nonatomic, strong) COSCoord *lr;
+    default:
+        return;
+    }
 
-@property (nonatomic, strong) COSCoord *bb;
-@property (nonatomic, strong) COSCoord *bt;
+    __atomic_fetch_add(&_generation, 1, __ATOMIC_RELEASE);
 
-@property (nonatomic, strong) COSCoord *rr;
-@property (nonatomic, strong) COSCoord *rl;
+    [self layoutSiblingViews];
+}
 
-@property (nonatomic, strong) COSCoord *ct;
-@property (nonatomic, strong) COSCoord *cl;
-@property (nonatomic, strong) COSCoord *cb;
-@property (nonatomic, strong) COSCoord *cr;
+- (void)setValue:(CGFloat)value forParameter:(NSString *)name {
+    const char *param = coslayout_param_intern([name UTF8String]);
 
-- (instancetype)initWithView:(UIView *)view;
+    if (!coslayout_params_set(&_params, param, value)) return;
 
-@end
+    if (COSLAYOUT_SESSION_RECORDING()) {
+        coslayout_session_param(cos_session_view(_view), param, value);
+    }
 
+    UIView *superview = _view.superview;
 
-#define COS_VIEW_TOP    ([view convertRect:view.bounds toView:rule.view.superview].origin.y)
-#define COS_VIEW_LEFT   ([view convertRect:view.bounds toView:rule.view.superview].origin.x)
-#define COS_VIEW_WIDTH  (view.bounds.size.width)
-#define COS_VIEW_HEIGHT (view.bounds.size.height)
+    if (superview && coslayout_ruleset_reads_param([self ruleSet], param)) {
+        [cos_solver_of_view(superview) solveInputs:COSLAYOUT_READ_PARAM];
+    }
+}
 
-#define LAZY_LOAD_COORD(ivar, expr) \
-    (ivar ?: (ivar = COSCOORD_MAKE([NSMutableSet setWithObject:_view], expr)))
+- (CGFloat)valueForParameter:(NSString *)name {
+    double value = 0;
 
+    coslayout_params_get(&_params, coslayout_param_intern([name UTF8String]), &value);
 
-@implementation COSCoords
+    return value;
+}
 
-+ (instancetype)coordsOfView:(UIView *)view {
-    static const void *coordsKey = &coordsKey;
+- (void)layoutSiblingViews {
+    UIView *superview = self.view.superview;
 
-    if (![view isKindOfClass:[UIView class]]) {
-        return nil;
+    if (superview) {
+        [cos_solver_of_view(superview) solve];
     }
+}
 
-    COSCoords *coords = objc_getAssociatedObject(view, coordsKey);
+- (void)updateLayoutDriver {
+    UIView *superview = _view.superview;
+
+    /* Plans including the layout are stale, and so is the plan of the
+     * container it moved into. */
+    __atomic_fetch_add(&_generation, 1, __ATOMIC_RELEASE);
 
-    if (!coords) {
-        coords = [[COSCoords alloc] initWithView:view];
+    if (COSLAYOUT_SESSION_RECORDING()) {
+        long number = coslayout_session_find((__bridge void *)_view);
 
-        objc_setAssociatedObject(view, coordsKey, coords, OBJC_ASSOCIATION_RETAIN);
+        if (number >= 0) coslayout_session_move(number, cos_session_view(superview));
     }
 
-    return coords;
+    /* The solver of a container also drives its layoutSubviews. */
+    if (superview) {
+        COSLayoutSolver *solver = [COSLayoutSolver layoutSolverOfView:superview];
+
+        [solver invalidatePlan];
+        cos_initialize_driver_if_needed(solver);
+    }
 }
 
-- (instancetype)initWithView:(UIView *)view {
-    self = [super init];
+- (NSUInteger)generation {
+    return __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+}
 
-    if (self) {
-        _view = view;
+- (void)referenceView:(UIView *)view {
+    if (!_referencedViews) {
+        _referencedViews = [NSHashTable weakObjectsHashTable];
     }
 
-    return self;
+    [_referencedViews addObject:view];
 }
 
-- (COSCoord *)tt {
-    return LAZY_LOAD_COORD(_tt, COS_VIEW_TOP);
+- (NSSet *)dependencies {
+    NSMutableSet *viewSet = [[NSMutableSet alloc] init];
+
+    for (UIView *view in _referencedViews) {
+        if (coslayout_ruleset_references([self ruleSet], _bindings.exprs, (__bridge void *)view)) {
+            [viewSet addObject:view];
+        }
+    }
+
+    if (_view.superview) {
+        [viewSet addObject:_view.superview];
+    }
+
+    return viewSet;
 }
 
-- (COSCoord *)tb {
-    return LAZY_LOAD_COORD(_tb, COS_SUPERVIEW_HEIGHT - COS_VIEW_TOP);
+- (COSLAYOUT_PROGRAM *)program {
+    return _program;
 }
 
-- (COSCoord *)ll {
-    return LAZY_LOAD_COORD(_ll, COS_VIEW_LEFT);
+- (const COSLAYOUT_RULESET *)ruleSet {
+    return coslayout_program_ruleset(_program);
 }
 
-- (COSCoord *)lr {
-    return LAZY_LOAD_COORD(_lr, COS_SUPERVIEW_WIDTH - COS_VIEW_LEFT);
+- (const COSLAYOUT_BINDINGS *)bindings {
+    return &_bindings;
 }
 
-- (COSCoord *)bb {
-    return LAZY_LOAD_COORD(_bb, COS_SUPERVIEW_HEIGHT - COS_VIEW_TOP - COS_VIEW_HEIGHT);
+- (const COSLAYOUT_PARAMS *)params {
+    return &_params;
 }
 
-- (COSCoord *)bt {
-    return LAZY_LOAD_COORD(_bt, COS_VIEW_TOP + COS_VIEW_HEIGHT);
+- (int)applyFrame:(COSLAYOUT_RECT)rect {
+    UIView *view = _view;
+
+    int changed = coslayout_rect_changed_axes(COSLAYOUT_RECT_FROM_CG(view.frame), rect);
+
+    _frame = CGRectMake(rect.x, rect.y, rect.w, rect.h);
+
+    if (changed) {
+        view.frame = _frame;
+    }
+
+    return changed;
 }
 
-- (COSCoord *)rr {
-    return LAZY_LOAD_COORD(_rr, COS_SUPERVIEW_WIDTH - COS_VIEW_LEFT - COS_VIEW_WIDTH);
+- (void)dealloc {
+    coslayout_program_release(_program);
+    coslayout_bindings_destroy(&_bindings);
+    coslayout_params_destroy(&_params);
 }
 
-- (COSCoord *)rl {
-    return LAZY_LOAD_COORD(_rl, COS_VIEW_LEFT + COS_VIEW_WIDTH);
+@end
+
+
+@implementation UIView (COSLayout)
+
+- (COSLayout *)coslayout {
+    return [COSLayout layoutOfView:self];
 }
 
-- (COSCoord *)ct {
-    return LAZY_LOAD_COORD(_ct, COS_VIEW_TOP + COS_VIEW_HEIGHT / 2);
+- (COSLayoutPass *)coslayoutPass {
+    return [[COSLayoutSolver layoutSolverOfView:self] capture];
 }
 
-- (COSCoord *)cl {
-    return LAZY_LOAD_COORD(_cl, COS_VIEW_LEFT + COS_VIEW_WIDTH / 2);
+- (NSUInteger)coslayoutContentKey {
+    return [COSLayoutSolver layoutSolverOfView:self].contentKey;
 }
 
-- (COSCoord *)cb {
-    return LAZY_LOAD_COORD(_cb, COS_SUPERVIEW_HEIGHT - COS_VIEW_TOP - COS_VIEW_HEIGHT / 2);
+- (void)setCoslayoutContentKey:(NSUInteger)contentKey {
+    [COSLayoutSolver layoutSolverOfView:self].contentKey = contentKey;
 }
 
-- (COSCoord *)cr {
-    return LAZY_LOAD_COORD(_cr, COS_SUPERVIEW_WIDTH - COS_VIEW_LEFT - COS_VIEW_WIDTH / 2);
+- (BOOL)coslayoutDrivesLayout {
+    COSLayoutSolver *solver = cos_solver_of_view(self);
+
+    return solver.view == self ? solver.drivesLayout : YES;
 }
 
-- (COSCoord *)w {
-    return LAZY_LOAD_COORD(_w, COS_VIEW_WIDTH);
+- (void)setCoslayoutDrivesLayout:(BOOL)drivesLayout {
+    COSLayoutSolver *solver = [COSLayoutSolver layoutSolverOfView:self];
+
+    solver.drivesLayout = drivesLayout;
+
+    if (solver.constrainsSubviews) {
+        cos_initialize_driver_if_needed(solver);
+    }
 }
 
-- (COSCoord *)h {
-    return LAZY_LOAD_COORD(_h, COS_VIEW_HEIGHT);
+- (void)coslayoutSetValue:(CGFloat)value forParameter:(NSString *)name {
+    [[COSLayoutSolver layoutSolverOfView:self] setValue:value forParameter:coslayout_param_intern([name UTF8String])];
 }
 
-@end
+- (void)coslayoutSetView:(UIView *)view forName:(NSString *)name {
+    [[COSLayoutSolver layoutSolverOfView:self] setView:view forName:name];
+}
 
+- (UIView *)coslayoutViewForName:(NSString *)name {
+    COSLayoutSolver *solver = cos_solver_of_view(self);
 
-@implementation UIView (COSLayout)
+    return solver.view == self ? [solver viewForName:name] : nil;
+}
 
-- (COSLayout *)coslayout {
-    return [COSLayout layoutOfView:self];
+- (CGFloat)coslayoutValueForParameter:(NSString *)name {
+    COSLayoutSolver *solver = cos_solver_of_view(self);
+    double value = 0;
+
+    if (solver.view == self) {
+        coslayout_params_get([solver params], coslayout_param_intern([name UTF8String]), &value);
+    }
+
+    return value;
 }
 
 @end
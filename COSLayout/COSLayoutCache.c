@@ -0,0 +1,411 @@
+// COSLayoutCache.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutCache.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct COSLAYOUT_CACHE_ENTRY {
+    COSLAYOUT_CACHE_KEY key;
+    uint64_t hash;
+    struct COSLAYOUT_CACHE_ENTRY *chain;
+    struct COSLAYOUT_CACHE_ENTRY *prev;
+    struct COSLAYOUT_CACHE_ENTRY *next;
+    size_t count;
+    COSLAYOUT_RECT frames[];
+} COSLAYOUT_CACHE_ENTRY;
+
+/* Buckets chain entries with the same hash slot, the list runs from the
+ * most recently used entry at head to the least recently used at tail. */
+struct COSLAYOUT_CACHE {
+    pthread_mutex_t mutex;
+    COSLAYOUT_CACHE_ENTRY **buckets;
+    size_t bucket_count;
+    COSLAYOUT_CACHE_ENTRY *head;
+    COSLAYOUT_CACHE_ENTRY *tail;
+    size_t count_limit;
+    size_t byte_limit;
+    COSLAYOUT_CACHE_STATS stats;
+};
+
+static uint64_t coslayout_mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+
+    return h;
+}
+
+static uint64_t coslayout_double_bits(double value) {
+    uint64_t bits;
+
+    /* Zeros of both signs compare equal and must hash equal. */
+    if (value == 0) value = 0;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
+
+static uint64_t coslayout_cache_hash(const COSLAYOUT_CACHE_KEY *key) {
+    uint64_t h = coslayout_mix(0, key->identity);
+
+    h = coslayout_mix(h, coslayout_double_bits(key->width));
+    h = coslayout_mix(h, coslayout_double_bits(key->height));
+    h = coslayout_mix(h, key->content);
+    h = coslayout_mix(h, key->geometry);
+
+    return h;
+}
+
+static int coslayout_cache_key_equal(const COSLAYOUT_CACHE_KEY *a, const COSLAYOUT_CACHE_KEY *b) {
+    return (a->identity == b->identity &&
+            a->width == b->width &&
+            a->height == b->height &&
+            a->content == b->content &&
+            a->geometry == b->geometry);
+}
+
+static size_t coslayout_cache_entry_bytes(size_t count) {
+    return sizeof(COSLAYOUT_CACHE_ENTRY) + count * sizeof(COSLAYOUT_RECT);
+}
+
+COSLAYOUT_CACHE *coslayout_cache_create(size_t count_limit, size_t byte_limit) {
+    COSLAYOUT_CACHE *cache = (COSLAYOUT_CACHE *)calloc(1, sizeof(COSLAYOUT_CACHE));
+
+    pthread_mutex_init(&cache->mutex, NULL);
+
+    cache->bucket_count = 64;
+    cache->buckets = (COSLAYOUT_CACHE_ENTRY **)calloc(cache->bucket_count, sizeof(COSLAYOUT_CACHE_ENTRY *));
+    cache->count_limit = count_limit;
+    cache->byte_limit = byte_limit;
+
+    return cache;
+}
+
+static void coslayout_cache_unlink(COSLAYOUT_CACHE *cache, COSLAYOUT_CACHE_ENTRY *entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else cache->head = entry->next;
+
+    if (entry->next) entry->next->prev = entry->prev;
+    else cache->tail = entry->prev;
+
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+static void coslayout_cache_push(COSLAYOUT_CACHE *cache, COSLAYOUT_CACHE_ENTRY *entry) {
+    entry->prev = NULL;
+    entry->next = cache->head;
+
+    if (cache->head) cache->head->prev = entry;
+    else cache->tail = entry;
+
+    cache->head = entry;
+}
+
+static void coslayout_cache_remove(COSLAYOUT_CACHE *cache, COSLAYOUT_CACHE_ENTRY *entry) {
+    COSLAYOUT_CACHE_ENTRY **link = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+
+    while (*link != entry) link = &(*link)->chain;
+
+    *link = entry->chain;
+
+    coslayout_cache_unlink(cache, entry);
+
+    cache->stats.count -= 1;
+    cache->stats.bytes -= coslayout_cache_entry_bytes(entry->count);
+
+    free(entry);
+}
+
+static void coslayout_cache_trim(COSLAYOUT_CACHE *cache) {
+    while (cache->tail != NULL &&
+           ((cache->count_limit && cache->stats.count > cache->count_limit) ||
+            (cache->byte_limit && cache->stats.bytes > cache->byte_limit))) {
+        coslayout_cache_remove(cache, cache->tail);
+
+        cache->stats.evictions += 1;
+    }
+}
+
+static void coslayout_cache_rehash(COSLAYOUT_CACHE *cache, size_t bucket_count) {
+    COSLAYOUT_CACHE_ENTRY **buckets = (COSLAYOUT_CACHE_ENTRY **)calloc(bucket_count, sizeof(COSLAYOUT_CACHE_ENTRY *));
+
+    for (COSLAYOUT_CACHE_ENTRY *entry = cache->head; entry != NULL; entry = entry->next) {
+        size_t slot = entry->hash & (bucket_count - 1);
+
+        entry->chain = buckets[slot];
+        buckets[slot] = entry;
+    }
+
+    free(cache->buckets);
+
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+}
+
+static COSLAYOUT_CACHE_ENTRY *coslayout_cache_find(const COSLAYOUT_CACHE *cache, const COSLAYOUT_CACHE_KEY *key, uint64_t hash) {
+    COSLAYOUT_CACHE_ENTRY *entry = cache->buckets[hash & (cache->bucket_count - 1)];
+
+    while (entry != NULL && !(entry->hash == hash && coslayout_cache_key_equal(&entry->key, key))) {
+        entry = entry->chain;
+    }
+
+    return entry;
+}
+
+void coslayout_cache_clear(COSLAYOUT_CACHE *cache) {
+    pthread_mutex_lock(&cache->mutex);
+
+    while (cache->head != NULL) {
+        coslayout_cache_remove(cache, cache->head);
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+void coslayout_cache_destroy(COSLAYOUT_CACHE *cache) {
+    if (cache == NULL) return;
+
+    coslayout_cache_clear(cache);
+
+    pthread_mutex_destroy(&cache->mutex);
+
+    free(cache->buckets);
+    free(cache);
+}
+
+void coslayout_cache_set_limits(COSLAYOUT_CACHE *cache, size_t count_limit, size_t byte_limit) {
+    pthread_mutex_lock(&cache->mutex);
+
+    cache->count_limit = count_limit;
+    cache->byte_limit = byte_limit;
+
+    coslayout_cache_trim(cache);
+
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+int coslayout_cache_lookup(COSLAYOUT_CACHE *cache, const COSLAYOUT_CACHE_KEY *key, COSLAYOUT_RECT *frames, size_t count) {
+    uint64_t hash = coslayout_cache_hash(key);
+
+    pthread_mutex_lock(&cache->mutex);
+
+    COSLAYOUT_CACHE_ENTRY *entry = coslayout_cache_find(cache, key, hash);
+    int hit = entry != NULL && entry->count == count;
+
+    if (hit) {
+        memcpy(frames, entry->frames, count * sizeof(COSLAYOUT_RECT));
+
+        coslayout_cache_unlink(cache, entry);
+        coslayout_cache_push(cache, entry);
+
+        cache->stats.hits += 1;
+    } else {
+        cache->stats.misses += 1;
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+
+    return hit;
+}
+
+void coslayout_cache_store(COSLAYOUT_CACHE *cache, const COSLAYOUT_CACHE_KEY *key, const COSLAYOUT_RECT *frames, size_t count) {
+    uint64_t hash = coslayout_cache_hash(key);
+    size_t bytes = coslayout_cache_entry_bytes(count);
+
+    pthread_mutex_lock(&cache->mutex);
+
+    COSLAYOUT_CACHE_ENTRY *entry = coslayout_cache_find(cache, key, hash);
+
+    if (entry != NULL) {
+        coslayout_cache_remove(cache, entry);
+    }
+
+    /* An entry larger than the limit would evict everything, then itself. */
+    if (cache->byte_limit && bytes > cache->byte_limit) {
+        pthread_mutex_unlock(&cache->mutex);
+        return;
+    }
+
+    entry = (COSLAYOUT_CACHE_ENTRY *)malloc(bytes);
+
+    entry->key = *key;
+    entry->hash = hash;
+    entry->count = count;
+
+    memcpy(entry->frames, frames, count * sizeof(COSLAYOUT_RECT));
+
+    if (cache->stats.count + 1 > cache->bucket_count) {
+        coslayout_cache_rehash(cache, cache->bucket_count * 2);
+    }
+
+    size_t slot = hash & (cache->bucket_count - 1);
+
+    entry->chain = cache->buckets[slot];
+    cache->buckets[slot] = entry;
+
+    coslayout_cache_push(cache, entry);
+
+    cache->stats.count += 1;
+    cache->stats.bytes += bytes;
+
+    coslayout_cache_trim(cache);
+
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+COSLAYOUT_CACHE_STATS coslayout_cache_stats(COSLAYOUT_CACHE *cache) {
+    pthread_mutex_lock(&cache->mutex);
+
+    COSLAYOUT_CACHE_STATS stats = cache->stats;
+
+    pthread_mutex_unlock(&cache->mutex);
+
+    return stats;
+}
+
+void coslayout_cache_reset_stats(COSLAYOUT_CACHE *cache) {
+    pthread_mutex_lock(&cache->mutex);
+
+    cache->stats.hits = 0;
+    cache->stats.misses = 0;
+    cache->stats.evictions = 0;
+
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+static uint64_t coslayout_ref_signature(const void *ref, const COSLAYOUT_SNAPSHOT *refs) {
+    const COSLAYOUT_SNAPSHOT_ENTRY *entry = refs ? coslayout_snapshot_find(refs, ref) : NULL;
+
+    /* Views outside refs can only match themselves. */
+    if (entry == NULL) return (uint64_t)(uintptr_t)ref;
+
+    return (uint64_t)(entry - refs->entries) + 1;
+}
+
+static uint64_t coslayout_expr_signature(uint64_t h, const COSLAYOUT_EXPR *expr, COSLAYOUT_EXPR *const *bindings, const COSLAYOUT_SNAPSHOT *refs) {
+    expr = coslayout_expr_bound(expr, bindings);
+
+    if (expr == NULL) return coslayout_mix(h, 0);
+
+    h = coslayout_mix(h, (uint64_t)expr->kind + 1);
+    h = coslayout_mix(h, (uint64_t)expr->dir);
+
+    switch (expr->kind) {
+    case COSLAYOUT_EXPR_CONST:
+    case COSLAYOUT_EXPR_PERCENTAGE:
+        return coslayout_mix(h, coslayout_double_bits(expr->value));
+    case COSLAYOUT_EXPR_FLIP:
+        return coslayout_expr_signature(h, expr->l, bindings, refs);
+    case COSLAYOUT_EXPR_ATTR:
+        h = coslayout_mix(h, (uint64_t)expr->attr);
+        return coslayout_mix(h, coslayout_ref_signature(expr->ref, refs));
+    case COSLAYOUT_EXPR_CALL:
+    case COSLAYOUT_EXPR_CALL_PERCENTAGE:
+        /* What callbacks return is covered by the content key. */
+        return coslayout_mix(h, (uint64_t)(uintptr_t)expr->func);
+    case COSLAYOUT_EXPR_PARAM:
+        /* Names are interned, values are not cached. */
+        return coslayout_mix(h, (uint64_t)(uintptr_t)expr->ref);
+    default:
+        h = coslayout_expr_signature(h, expr->l, bindings, refs);
+        return coslayout_expr_signature(h, expr->r, bindings, refs);
+    }
+}
+
+uint64_t coslayout_nodes_signature(const COSLAYOUT_NODE *nodes, size_t count, const COSLAYOUT_SNAPSHOT *refs) {
+    uint64_t h = coslayout_mix(0, count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const COSLAYOUT_NODE *node = &nodes[i];
+
+        h = coslayout_mix(h, coslayout_ref_signature(node->view, refs));
+        h = coslayout_mix(h, coslayout_ref_signature(node->superview, refs));
+
+        for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+            const COSLAYOUT_EXPR *expr = node->set ? node->set->exprs[attr] : NULL;
+
+            if (node->set != NULL && !coslayout_ruleset_active(node->set, attr)) expr = NULL;
+
+            h = coslayout_expr_signature(h, expr, node->bindings, refs);
+        }
+    }
+
+    return h;
+}
+
+uint64_t coslayout_nodes_geometry(const COSLAYOUT_NODE *nodes, size_t count, const COSLAYOUT_SNAPSHOT *snapshot) {
+    uint64_t h = coslayout_mix(0, snapshot->count);
+    char *solved = (char *)calloc(snapshot->count + 1, 1);
+
+    for (size_t i = 0; i < count; ++i) {
+        const COSLAYOUT_NODE *node = &nodes[i];
+        const COSLAYOUT_SNAPSHOT_ENTRY *entry = node->view ? coslayout_snapshot_find(snapshot, node->view) : NULL;
+
+        if (entry == NULL) continue;
+
+        solved[entry - snapshot->entries] = 1;
+
+        /* Nodes of linear layouts have no rule set, and solve both axes. */
+        int open = node->set ? COSLAYOUT_AXIS_ALL & ~coslayout_ruleset_fixed_axes(node->set) : 0;
+
+        h = coslayout_mix(h, (uint64_t)open);
+
+        if (open & COSLAYOUT_AXIS_H) {
+            h = coslayout_mix(h, coslayout_double_bits(node->start.x));
+            h = coslayout_mix(h, coslayout_double_bits(node->start.w));
+        }
+
+        if (open & COSLAYOUT_AXIS_V) {
+            h = coslayout_mix(h, coslayout_double_bits(node->start.y));
+            h = coslayout_mix(h, coslayout_double_bits(node->start.h));
+        }
+    }
+
+    for (size_t i = 0; i < snapshot->count; ++i) {
+        const COSLAYOUT_SNAPSHOT_ENTRY *entry = &snapshot->entries[i];
+
+        if (solved[i]) continue;
+
+        h = coslayout_mix(h, i);
+        h = coslayout_mix(h, coslayout_double_bits(entry->rect.x));
+        h = coslayout_mix(h, coslayout_double_bits(entry->rect.y));
+        h = coslayout_mix(h, coslayout_double_bits(entry->rect.w));
+        h = coslayout_mix(h, coslayout_double_bits(entry->rect.h));
+        h = coslayout_mix(h, coslayout_double_bits(entry->origin_x));
+        h = coslayout_mix(h, coslayout_double_bits(entry->origin_y));
+        h = coslayout_mix(h, coslayout_double_bits(entry->width));
+        h = coslayout_mix(h, coslayout_double_bits(entry->height));
+    }
+
+    free(solved);
+
+    return h;
+}
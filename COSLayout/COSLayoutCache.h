@@ -0,0 +1,95 @@
+// COSLayoutCache.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Least recently used cache of solved frames.
+//
+// Entries are keyed by the identity of what was solved, usually a
+// signature of its rules, the size of the container, a key of the
+// content given by the caller, and a hash of the geometry the rules read
+// but do not solve. The content key must change whenever anything else
+// changes the result, e.g. values returned by blocks and objects.
+// A cache is safe to use from any thread.
+
+#ifndef COSLAYOUT_CACHE_H
+#define COSLAYOUT_CACHE_H
+
+#include <stdint.h>
+
+#include "COSLayoutCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct COSLAYOUT_CACHE_KEY {
+    uint64_t identity;
+    double width;
+    double height;
+    uint64_t content;
+    uint64_t geometry;
+} COSLAYOUT_CACHE_KEY;
+
+typedef struct COSLAYOUT_CACHE_STATS {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t count;
+    size_t bytes;
+} COSLAYOUT_CACHE_STATS;
+
+typedef struct COSLAYOUT_CACHE COSLAYOUT_CACHE;
+
+/* Limits are the number of entries and the bytes they use, zero means no
+ * limit. The least recently used entries are evicted to stay below both. */
+COSLAYOUT_CACHE *coslayout_cache_create(size_t count_limit, size_t byte_limit);
+void coslayout_cache_destroy(COSLAYOUT_CACHE *cache);
+
+void coslayout_cache_set_limits(COSLAYOUT_CACHE *cache, size_t count_limit, size_t byte_limit);
+void coslayout_cache_clear(COSLAYOUT_CACHE *cache);
+
+/* Copies count frames of the entry of key to frames. Returns 1 on a hit,
+ * 0 if there is no entry or it holds a different number of frames. */
+int coslayout_cache_lookup(COSLAYOUT_CACHE *cache, const COSLAYOUT_CACHE_KEY *key, COSLAYOUT_RECT *frames, size_t count);
+void coslayout_cache_store(COSLAYOUT_CACHE *cache, const COSLAYOUT_CACHE_KEY *key, const COSLAYOUT_RECT *frames, size_t count);
+
+COSLAYOUT_CACHE_STATS coslayout_cache_stats(COSLAYOUT_CACHE *cache);
+void coslayout_cache_reset_stats(COSLAYOUT_CACHE *cache);
+
+/* Signature of the rules of nodes, equal for nodes whose rules have the
+ * same structure and constants. Views are hashed by their index in refs,
+ * so identical view hierarchies share a signature. */
+uint64_t coslayout_nodes_signature(const COSLAYOUT_NODE *nodes, size_t count, const COSLAYOUT_SNAPSHOT *refs);
+
+/* Hash of the geometry nodes are solved from: views of snapshot that are
+ * not nodes, like siblings without rules or views of other containers,
+ * and the frames nodes start from on axes their rules leave open. Views
+ * are hashed in snapshot order, not by address. */
+uint64_t coslayout_nodes_geometry(const COSLAYOUT_NODE *nodes, size_t count, const COSLAYOUT_SNAPSHOT *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1885 @@
+// COSLayoutCore.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutCore.h"
+#include "COSLayoutParser.h"
+#include "COSLayoutProfile.h"
+#include "COSLayoutStats.h"
+#include "COSLayoutTrace.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COS_VALID_DIM(value) (!isnan(value) && (value) >= 0)
+#define MAX_SIZE(a, b) ((a) > (b) ? (a) : (b))
+
+static COSLAYOUT_EXPR *coslayout_expr_create(int kind) {
+    COSLAYOUT_EXPR *expr = (COSLAYOUT_EXPR *)calloc(1, sizeof(COSLAYOUT_EXPR));
+
+    expr->kind = kind;
+    expr->binding = -1;
+    expr->refcount = 1;
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_const(double value) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create(COSLAYOUT_EXPR_CONST);
+
+    expr->value = value;
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_percentage(double percentage, int dir) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create(COSLAYOUT_EXPR_PERCENTAGE);
+
+    expr->value = percentage / 100.0;
+    expr->dir = dir;
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_flip(COSLAYOUT_EXPR *l, int dir) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create(COSLAYOUT_EXPR_FLIP);
+
+    expr->l = coslayout_expr_retain(l);
+    expr->dir = dir;
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_attr(int attr, void *ref) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create(COSLAYOUT_EXPR_ATTR);
+
+    expr->attr = attr;
+    expr->ref = ref;
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_call(COSLAYOUT_FUNC func, void *info, COSLAYOUT_RELEASE release) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create(COSLAYOUT_EXPR_CALL);
+
+    expr->func = func;
+    expr->info = info;
+    expr->release = release;
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_call_percentage(COSLAYOUT_FUNC func, void *info, COSLAYOUT_RELEASE release, int dir) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create_call(func, info, release);
+
+    expr->kind = COSLAYOUT_EXPR_CALL_PERCENTAGE;
+    expr->dir = dir;
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_binding(int binding, int reads) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create(COSLAYOUT_EXPR_BINDING);
+
+    expr->binding = binding;
+    expr->reads = reads;
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_binary(int kind, COSLAYOUT_EXPR *l, COSLAYOUT_EXPR *r) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create(kind);
+
+    expr->l = coslayout_expr_retain(l);
+    expr->r = coslayout_expr_retain(r);
+
+    return expr;
+}
+
+COSLAYOUT_EXPR *coslayout_expr_create_param(const char *name) {
+    COSLAYOUT_EXPR *expr = coslayout_expr_create(COSLAYOUT_EXPR_PARAM);
+
+    expr->ref = (void *)coslayout_param_intern(name);
+
+    return expr;
+}
+
+/* Reference counts are atomic, rule sets copied into a layout pass may be
+ * released on the thread which computed it. */
+COSLAYOUT_EXPR *coslayout_expr_retain(COSLAYOUT_EXPR *expr) {
+    if (expr != NULL) __atomic_add_fetch(&expr->refcount, 1, __ATOMIC_RELAXED);
+
+    return expr;
+}
+
+void coslayout_expr_release(COSLAYOUT_EXPR *expr) {
+    if (expr == NULL || __atomic_sub_fetch(&expr->refcount, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+    coslayout_expr_release(expr->l);
+    coslayout_expr_release(expr->r);
+
+    if (expr->release != NULL) expr->release(expr->info);
+
+    free(expr);
+}
+
+COSLAYOUT_SOURCE *coslayout_source_create(const char *text, int subrule) {
+    size_t length = strlen(text);
+    COSLAYOUT_SOURCE *source = (COSLAYOUT_SOURCE *)malloc(sizeof(COSLAYOUT_SOURCE) + length + 1);
+
+    source->refcount = 1;
+    source->subrule = subrule;
+
+    memcpy(source->text, text, length + 1);
+
+    return source;
+}
+
+COSLAYOUT_SOURCE *coslayout_source_retain(COSLAYOUT_SOURCE *source) {
+    if (source != NULL) __atomic_add_fetch(&source->refcount, 1, __ATOMIC_RELAXED);
+
+    return source;
+}
+
+void coslayout_source_release(COSLAYOUT_SOURCE *source) {
+    if (source == NULL || __atomic_sub_fetch(&source->refcount, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+    free(source);
+}
+
+/* Next comma separating rules in text, commas between parentheses
+ * separate arguments of functions. */
+static const char *coslayout_rule_comma(const char *text) {
+    int depth = 0;
+
+    for (; *text; ++text) {
+        if (*text == '(') {
+            ++depth;
+        } else if (*text == ')') {
+            if (depth > 0) --depth;
+        } else if (*text == ',' && depth == 0) {
+            return text;
+        }
+    }
+
+    return NULL;
+}
+
+size_t coslayout_source_subrule(const COSLAYOUT_SOURCE *source, const char **start) {
+    const char *text = source->text;
+
+    for (int i = 0; i < source->subrule && text != NULL; ++i) {
+        text = coslayout_rule_comma(text);
+
+        if (text != NULL) text += 1;
+    }
+
+    if (text == NULL) text = source->text + strlen(source->text);
+
+    while (*text == ' ') ++text;
+
+    *start = text;
+
+    const char *comma = coslayout_rule_comma(text);
+
+    return comma ? (size_t)(comma - text) : strlen(text);
+}
+
+/* Interned names are never freed. The table is open addressed and kept
+ * at most half full. */
+static pthread_mutex_t coslayout_param_lock = PTHREAD_MUTEX_INITIALIZER;
+static char **coslayout_param_names = NULL;
+static size_t coslayout_param_slots = 0;
+static size_t coslayout_param_count = 0;
+
+static size_t coslayout_param_hash(const char *name) {
+    size_t h = 5381;
+
+    while (*name) h = h * 33 + (unsigned char)*name++;
+
+    return h;
+}
+
+static void coslayout_param_rehash(size_t slots) {
+    char **names = (char **)calloc(slots, sizeof(char *));
+
+    for (size_t i = 0; i < coslayout_param_slots; ++i) {
+        char *name = coslayout_param_names[i];
+
+        if (name == NULL) continue;
+
+        size_t slot = coslayout_param_hash(name) & (slots - 1);
+
+        while (names[slot] != NULL) slot = (slot + 1) & (slots - 1);
+
+        names[slot] = name;
+    }
+
+    free(coslayout_param_names);
+
+    coslayout_param_names = names;
+    coslayout_param_slots = slots;
+}
+
+const char *coslayout_param_intern(const char *name) {
+    pthread_mutex_lock(&coslayout_param_lock);
+
+    if ((coslayout_param_count + 1) * 2 > coslayout_param_slots) {
+        coslayout_param_rehash(coslayout_param_slots ? coslayout_param_slots * 2 : 64);
+    }
+
+    size_t slot = coslayout_param_hash(name) & (coslayout_param_slots - 1);
+
+    while (coslayout_param_names[slot] != NULL && strcmp(coslayout_param_names[slot], name) != 0) {
+        slot = (slot + 1) & (coslayout_param_slots - 1);
+    }
+
+    if (coslayout_param_names[slot] == NULL) {
+        size_t length = strlen(name);
+
+        coslayout_param_names[slot] = (char *)malloc(length + 1);
+        memcpy(coslayout_param_names[slot], name, length + 1);
+        coslayout_param_count += 1;
+    }
+
+    const char *interned = coslayout_param_names[slot];
+
+    pthread_mutex_unlock(&coslayout_param_lock);
+
+    return interned;
+}
+
+void coslayout_params_init(COSLAYOUT_PARAMS *params) {
+    memset(params, 0, sizeof(COSLAYOUT_PARAMS));
+}
+
+void coslayout_params_copy(COSLAYOUT_PARAMS *dst, const COSLAYOUT_PARAMS *src) {
+    coslayout_params_init(dst);
+
+    if (src->count == 0) return;
+
+    dst->count = src->count;
+    dst->capacity = src->count;
+    dst->names = (const char **)malloc(src->count * sizeof(const char *));
+    dst->values = (double *)malloc(src->count * sizeof(double));
+
+    memcpy(dst->names, src->names, src->count * sizeof(const char *));
+    memcpy(dst->values, src->values, src->count * sizeof(double));
+}
+
+void coslayout_params_destroy(COSLAYOUT_PARAMS *params) {
+    free(params->names);
+    free(params->values);
+
+    coslayout_params_init(params);
+}
+
+int coslayout_params_set(COSLAYOUT_PARAMS *params, const char *name, double value) {
+    for (size_t i = 0; i < params->count; ++i) {
+        if (params->names[i] != name) continue;
+
+        if (params->values[i] == value) return 0;
+
+        params->values[i] = value;
+
+        return 1;
+    }
+
+    if (params->count == params->capacity) {
+        params->capacity = params->capacity ? params->capacity * 2 : 4;
+        params->names = (const char **)realloc(params->names, params->capacity * sizeof(const char *));
+        params->values = (double *)realloc(params->values, params->capacity * sizeof(double));
+    }
+
+    params->names[params->count] = name;
+    params->values[params->count] = value;
+    params->count += 1;
+
+    return 1;
+}
+
+int coslayout_params_get(const COSLAYOUT_PARAMS *params, const char *name, double *value) {
+    if (params == NULL) return 0;
+
+    for (size_t i = 0; i < params->count; ++i) {
+        if (params->names[i] == name) {
+            *value = params->values[i];
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static double coslayout_geometry_attr(COSLAYOUT_GEOMETRY geometry, int attr) {
+    COSLAYOUT_RECT rect = geometry.rect;
+
+    switch (attr) {
+    case COSLAYOUT_ATTR_W:  return rect.w;
+    case COSLAYOUT_ATTR_H:  return rect.h;
+    case COSLAYOUT_ATTR_TT: return rect.y;
+    case COSLAYOUT_ATTR_TB: return geometry.height - rect.y;
+    case COSLAYOUT_ATTR_LL: return rect.x;
+    case COSLAYOUT_ATTR_LR: return geometry.width - rect.x;
+    case COSLAYOUT_ATTR_BB: return geometry.height - rect.y - rect.h;
+    case COSLAYOUT_ATTR_BT: return rect.y + rect.h;
+    case COSLAYOUT_ATTR_RR: return geometry.width - rect.x - rect.w;
+    case COSLAYOUT_ATTR_RL: return rect.x + rect.w;
+    case COSLAYOUT_ATTR_CT: return rect.y + rect.h / 2;
+    case COSLAYOUT_ATTR_CL: return rect.x + rect.w / 2;
+    case COSLAYOUT_ATTR_CB: return geometry.height - rect.y - rect.h / 2;
+    case COSLAYOUT_ATTR_CR: return geometry.width - rect.x - rect.w / 2;
+    default: return NAN;
+    }
+}
+
+static inline
+double coslayout_env_size(const COSLAYOUT_ENV *env, int dir) {
+    return dir == COSLAYOUT_DIR_V ? env->height : env->width;
+}
+
+/* Parameters of the view win over those of its superview, missing ones
+ * are zero. */
+static double coslayout_env_param(const COSLAYOUT_ENV *env, const char *name) {
+    double value = 0;
+
+    if (!coslayout_params_get(env->params, name, &value)) {
+        coslayout_params_get(env->scope, name, &value);
+    }
+
+    return value;
+}
+
+double coslayout_expr_eval(const COSLAYOUT_EXPR *expr, int dir, const COSLAYOUT_ENV *env) {
+    switch (expr->kind) {
+    case COSLAYOUT_EXPR_CONST:
+        return expr->value;
+
+    case COSLAYOUT_EXPR_PERCENTAGE:
+        return coslayout_env_size(env, expr->dir ? expr->dir : dir) * expr->value;
+
+    case COSLAYOUT_EXPR_FLIP:
+        return coslayout_env_size(env, expr->dir) - coslayout_expr_eval(expr->l, dir, env);
+
+    case COSLAYOUT_EXPR_ATTR:
+        return coslayout_geometry_attr(env->geometry(expr->ref, env), expr->attr);
+
+    case COSLAYOUT_EXPR_CALL:
+        return expr->func(expr->info, env->view);
+
+    case COSLAYOUT_EXPR_CALL_PERCENTAGE:
+        return coslayout_env_size(env, expr->dir ? expr->dir : dir) * expr->func(expr->info, env->view) / 100.0;
+
+    case COSLAYOUT_EXPR_BINDING:
+        return coslayout_expr_eval(env->bindings[expr->binding], dir, env);
+
+    case COSLAYOUT_EXPR_ADD:
+        return coslayout_expr_eval(expr->l, dir, env) + coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_SUB:
+        return coslayout_expr_eval(expr->l, dir, env) - coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_MUL:
+        return coslayout_expr_eval(expr->l, dir, env) * coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_DIV:
+        return coslayout_expr_eval(expr->l, dir, env) / coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_PARAM:
+        return coslayout_env_param(env, (const char *)expr->ref);
+
+    case COSLAYOUT_EXPR_MIN:
+        return fmin(coslayout_expr_eval(expr->l, dir, env), coslayout_expr_eval(expr->r, dir, env));
+
+    case COSLAYOUT_EXPR_MAX:
+        return fmax(coslayout_expr_eval(expr->l, dir, env), coslayout_expr_eval(expr->r, dir, env));
+
+    case COSLAYOUT_EXPR_LT:
+        return coslayout_expr_eval(expr->l, dir, env) < coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_GT:
+        return coslayout_expr_eval(expr->l, dir, env) > coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_LE:
+        return coslayout_expr_eval(expr->l, dir, env) <= coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_GE:
+        return coslayout_expr_eval(expr->l, dir, env) >= coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_EQ:
+        return coslayout_expr_eval(expr->l, dir, env) == coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_NE:
+        return coslayout_expr_eval(expr->l, dir, env) != coslayout_expr_eval(expr->r, dir, env);
+
+    case COSLAYOUT_EXPR_COND:
+        return coslayout_expr_eval(coslayout_expr_eval(expr->l, dir, env) != 0 ? expr->r->l : expr->r->r, dir, env);
+
+    default:
+        return NAN;
+    }
+}
+
+int coslayout_expr_reads(const COSLAYOUT_EXPR *expr, int dir) {
+    if (expr == NULL) return 0;
+
+    switch (expr->kind) {
+    case COSLAYOUT_EXPR_CONST:
+        return 0;
+
+    case COSLAYOUT_EXPR_PERCENTAGE:
+        return (expr->dir ? expr->dir : dir) == COSLAYOUT_DIR_V ? COSLAYOUT_READ_HEIGHT : COSLAYOUT_READ_WIDTH;
+
+    case COSLAYOUT_EXPR_FLIP:
+        return (coslayout_expr_reads(expr->l, dir) |
+                (expr->dir == COSLAYOUT_DIR_V ? COSLAYOUT_READ_HEIGHT : COSLAYOUT_READ_WIDTH));
+
+    case COSLAYOUT_EXPR_ATTR:
+        return coslayout_attr_dir(expr->attr) == COSLAYOUT_DIR_V ? COSLAYOUT_READ_VIEW_V : COSLAYOUT_READ_VIEW_H;
+
+    case COSLAYOUT_EXPR_CALL:
+        return COSLAYOUT_READ_CALL;
+
+    case COSLAYOUT_EXPR_CALL_PERCENTAGE:
+        return (COSLAYOUT_READ_CALL |
+                ((expr->dir ? expr->dir : dir) == COSLAYOUT_DIR_V ? COSLAYOUT_READ_HEIGHT : COSLAYOUT_READ_WIDTH));
+
+    case COSLAYOUT_EXPR_BINDING:
+        return expr->reads;
+
+    case COSLAYOUT_EXPR_PARAM:
+        return COSLAYOUT_READ_PARAM;
+
+    default:
+        return coslayout_expr_reads(expr->l, dir) | coslayout_expr_reads(expr->r, dir);
+    }
+}
+
+int coslayout_attr_dir(int attr) {
+    switch (attr) {
+    case COSLAYOUT_ATTR_W:
+    case COSLAYOUT_ATTR_MINW:
+    case COSLAYOUT_ATTR_MAXW:
+    case COSLAYOUT_ATTR_LL:
+    case COSLAYOUT_ATTR_LR:
+    case COSLAYOUT_ATTR_RR:
+    case COSLAYOUT_ATTR_RL:
+    case COSLAYOUT_ATTR_CL:
+    case COSLAYOUT_ATTR_CR:
+        return COSLAYOUT_DIR_H;
+
+    default:
+        return COSLAYOUT_DIR_V;
+    }
+}
+
+static const char *coslayout_attr_names[COSLAYOUT_ATTR_COUNT] = {
+    "w", "h", "minw", "maxw", "minh", "maxh",
+    "tt", "tb", "ll", "lr", "bb", "bt", "rr", "rl",
+    "ct", "cl", "cb", "cr"
+};
+
+int coslayout_attr_named(const char *name) {
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        if (strcmp(coslayout_attr_names[attr], name) == 0) return attr;
+    }
+
+    return -1;
+}
+
+const char *coslayout_attr_name(int attr) {
+    return attr >= 0 && attr < COSLAYOUT_ATTR_COUNT ? coslayout_attr_names[attr] : NULL;
+}
+
+int coslayout_spec_reference(const char *spec, size_t *length) {
+    const char *dot = strchr(spec, '.');
+
+    if (dot == NULL || dot == spec) return -1;
+
+    int attr = coslayout_attr_named(dot + 1);
+
+    /* Limits are not geometry of the view referenced. */
+    if (attr >= COSLAYOUT_ATTR_MINW && attr <= COSLAYOUT_ATTR_MAXH) return -1;
+
+    *length = (size_t)(dot - spec);
+
+    return attr;
+}
+
+void coslayout_ruleset_init(COSLAYOUT_RULESET *set) {
+    memset(set, 0, sizeof(COSLAYOUT_RULESET));
+}
+
+void coslayout_ruleset_copy(COSLAYOUT_RULESET *dst, const COSLAYOUT_RULESET *src) {
+    *dst = *src;
+
+    for (int i = 0; i < COSLAYOUT_ATTR_COUNT; ++i) {
+        coslayout_expr_retain(dst->exprs[i]);
+        coslayout_source_retain(dst->sources[i]);
+    }
+}
+
+void coslayout_ruleset_destroy(COSLAYOUT_RULESET *set) {
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        coslayout_expr_release(set->exprs[attr]);
+        coslayout_source_release(set->sources[attr]);
+    }
+
+    coslayout_ruleset_init(set);
+}
+
+/* Keeps the two most recent position rules of an axis, the same rule name
+ * only once. */
+static void coslayout_ruleset_push(int *attrs, int *count, int attr, int valid) {
+    for (int i = 0; i < *count; ++i) {
+        if (attrs[i] == attr) {
+            if (i == 0) attrs[0] = attrs[1];
+            *count -= 1;
+            break;
+        }
+    }
+
+    if (*count > 1) {
+        attrs[0] = attrs[1];
+        *count -= 1;
+    }
+
+    if (valid) attrs[(*count)++] = attr;
+}
+
+void coslayout_ruleset_set(COSLAYOUT_RULESET *set, int attr, COSLAYOUT_EXPR *expr) {
+    coslayout_expr_retain(expr);
+    coslayout_expr_release(set->exprs[attr]);
+
+    set->exprs[attr] = expr;
+
+    switch (attr) {
+    case COSLAYOUT_ATTR_TT:
+    case COSLAYOUT_ATTR_BT:
+    case COSLAYOUT_ATTR_CT:
+        coslayout_ruleset_push(set->v_attrs, &set->v_count, attr, expr != NULL);
+        break;
+
+    case COSLAYOUT_ATTR_LL:
+    case COSLAYOUT_ATTR_RL:
+    case COSLAYOUT_ATTR_CL:
+        coslayout_ruleset_push(set->h_attrs, &set->h_count, attr, expr != NULL);
+        break;
+
+    default:
+        break;
+    }
+
+    set->h_reads = 0;
+    set->v_reads = 0;
+
+    for (int i = 0; i < COSLAYOUT_ATTR_COUNT; ++i) {
+        int dir = coslayout_attr_dir(i);
+
+        if (!coslayout_ruleset_active(set, i)) continue;
+
+        if (dir == COSLAYOUT_DIR_H) {
+            set->h_reads |= coslayout_expr_reads(set->exprs[i], dir);
+        } else {
+            set->v_reads |= coslayout_expr_reads(set->exprs[i], dir);
+        }
+    }
+}
+
+/* Near edge attribute a far edge attribute is flipped to, or -1. */
+static int coslayout_attr_flipped(int attr, int *dir) {
+    switch (attr) {
+    case COSLAYOUT_ATTR_TB: *dir = COSLAYOUT_DIR_V; return COSLAYOUT_ATTR_TT;
+    case COSLAYOUT_ATTR_LR: *dir = COSLAYOUT_DIR_H; return COSLAYOUT_ATTR_LL;
+    case COSLAYOUT_ATTR_BB: *dir = COSLAYOUT_DIR_V; return COSLAYOUT_ATTR_BT;
+    case COSLAYOUT_ATTR_RR: *dir = COSLAYOUT_DIR_H; return COSLAYOUT_ATTR_RL;
+    case COSLAYOUT_ATTR_CB: *dir = COSLAYOUT_DIR_V; return COSLAYOUT_ATTR_CT;
+    case COSLAYOUT_ATTR_CR: *dir = COSLAYOUT_DIR_H; return COSLAYOUT_ATTR_CL;
+    default: return -1;
+    }
+}
+
+void coslayout_ruleset_assign(COSLAYOUT_RULESET *set, int attr, COSLAYOUT_EXPR *expr) {
+    int dir = COSLAYOUT_DIR_NONE;
+    int dst = coslayout_attr_flipped(attr, &dir);
+
+    coslayout_ruleset_set(set, attr, expr);
+
+    if (dst >= 0) {
+        COSLAYOUT_EXPR *flip = expr ? coslayout_expr_create_flip(expr, dir) : NULL;
+
+        coslayout_ruleset_set(set, dst, flip);
+        coslayout_expr_release(flip);
+    }
+}
+
+const COSLAYOUT_EXPR *coslayout_expr_bound(const COSLAYOUT_EXPR *expr, COSLAYOUT_EXPR *const *bindings) {
+    if (expr != NULL && expr->kind == COSLAYOUT_EXPR_BINDING) {
+        return bindings != NULL ? bindings[expr->binding] : NULL;
+    }
+
+    return expr;
+}
+
+static int coslayout_expr_references(const COSLAYOUT_EXPR *expr, COSLAYOUT_EXPR *const *bindings, const void *ref) {
+    expr = coslayout_expr_bound(expr, bindings);
+
+    if (expr == NULL) return 0;
+
+    if (expr->kind == COSLAYOUT_EXPR_ATTR) return expr->ref == ref;
+
+    return coslayout_expr_references(expr->l, bindings, ref) || coslayout_expr_references(expr->r, bindings, ref);
+}
+
+int coslayout_ruleset_references(const COSLAYOUT_RULESET *set, COSLAYOUT_EXPR *const *bindings, const void *ref) {
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        if (coslayout_ruleset_active(set, attr) && coslayout_expr_references(set->exprs[attr], bindings, ref)) return 1;
+    }
+
+    return 0;
+}
+
+static int coslayout_expr_reads_param(const COSLAYOUT_EXPR *expr, const char *name) {
+    if (expr == NULL) return 0;
+
+    if (expr->kind == COSLAYOUT_EXPR_PARAM) return expr->ref == name;
+
+    return coslayout_expr_reads_param(expr->l, name) || coslayout_expr_reads_param(expr->r, name);
+}
+
+int coslayout_ruleset_reads_param(const COSLAYOUT_RULESET *set, const char *name) {
+    if (!((set->h_reads | set->v_reads) & COSLAYOUT_READ_PARAM)) return 0;
+
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        if (coslayout_ruleset_active(set, attr) && coslayout_expr_reads_param(set->exprs[attr], name)) return 1;
+    }
+
+    return 0;
+}
+
+int coslayout_ruleset_active(const COSLAYOUT_RULESET *set, int attr) {
+    switch (attr) {
+    case COSLAYOUT_ATTR_TT:
+    case COSLAYOUT_ATTR_BT:
+    case COSLAYOUT_ATTR_CT:
+        for (int i = 0; i < set->v_count; ++i) {
+            if (set->v_attrs[i] == attr) return 1;
+        }
+        return 0;
+
+    case COSLAYOUT_ATTR_LL:
+    case COSLAYOUT_ATTR_RL:
+    case COSLAYOUT_ATTR_CL:
+        for (int i = 0; i < set->h_count; ++i) {
+            if (set->h_attrs[i] == attr) return 1;
+        }
+        return 0;
+
+    case COSLAYOUT_ATTR_W:
+    case COSLAYOUT_ATTR_H:
+    case COSLAYOUT_ATTR_MINW:
+    case COSLAYOUT_ATTR_MAXW:
+    case COSLAYOUT_ATTR_MINH:
+    case COSLAYOUT_ATTR_MAXH:
+        return set->exprs[attr] != NULL;
+
+    default:
+        return 0;
+    }
+}
+
+static inline
+double coslayout_ruleset_eval(const COSLAYOUT_RULESET *set, int attr, const COSLAYOUT_ENV *env) {
+    COSLAYOUT_EXPR *expr = set->exprs[attr];
+
+    if (expr == NULL) return NAN;
+
+    if (env->evaluations != NULL) *env->evaluations += 1;
+
+    if (env->profile != NULL) {
+        uint64_t start = coslayout_stats_now();
+        double value = coslayout_expr_eval(expr, coslayout_attr_dir(attr), env);
+
+        env->profile->nanoseconds[attr] += coslayout_stats_now() - start;
+        env->profile->calls[attr] += 1;
+
+        return value;
+    }
+
+    return coslayout_expr_eval(expr, coslayout_attr_dir(attr), env);
+}
+
+static inline
+double coslayout_clamp(double value, double min, double max) {
+    if (COS_VALID_DIM(min) && value < min) value = min;
+    if (COS_VALID_DIM(max) && value > max) value = max;
+
+    return value;
+}
+
+/* Edge of a position rule: 0 for leading, 1 for center, 2 for trailing. */
+static inline
+int coslayout_attr_edge(int attr) {
+    switch (attr) {
+    case COSLAYOUT_ATTR_CT:
+    case COSLAYOUT_ATTR_CL:
+        return 1;
+
+    case COSLAYOUT_ATTR_BT:
+    case COSLAYOUT_ATTR_RL:
+        return 2;
+
+    default:
+        return 0;
+    }
+}
+
+/* Solves one axis. With a single rule, only the origin is moved. With two
+ * rules, the size is the distance between both edges and the origin is
+ * derived from the most recent rule. */
+static void coslayout_ruleset_solve_axis(
+    const COSLAYOUT_RULESET *set,
+    const int *attrs,
+    int count,
+    double min,
+    double max,
+    double *origin,
+    double *size,
+    const COSLAYOUT_ENV *env)
+{
+    int attr1 = attrs[count - 1];
+    int edge1 = coslayout_attr_edge(attr1);
+    double value1 = coslayout_ruleset_eval(set, attr1, env);
+
+    if (count > 1) {
+        int attr0 = attrs[0];
+        int edge0 = coslayout_attr_edge(attr0);
+        double value0 = coslayout_ruleset_eval(set, attr0, env);
+
+        double distance = (value1 - value0) * 2 / (edge1 - edge0);
+
+        *size = fmax(coslayout_clamp(distance, min, max), 0);
+    }
+
+    *origin = value1 - *size * edge1 / 2;
+}
+
+/* Solves the size and origin of one axis, bounded by its min and max. */
+static void coslayout_ruleset_solve_dim(
+    const COSLAYOUT_RULESET *set,
+    const int *attrs,
+    int count,
+    int sizeAttr,
+    int minAttr,
+    int maxAttr,
+    double *origin,
+    double *size,
+    const COSLAYOUT_ENV *env)
+{
+    double min = coslayout_ruleset_eval(set, minAttr, env);
+    double max = coslayout_ruleset_eval(set, maxAttr, env);
+
+    *size = coslayout_clamp(*size, min, max);
+
+    if (set->exprs[sizeAttr] != NULL && count < 2) {
+        *size = coslayout_ruleset_eval(set, sizeAttr, env);
+    }
+
+    if (count > 0) {
+        coslayout_ruleset_solve_axis(set, attrs, count, min, max, origin, size, env);
+    }
+
+    *size = coslayout_clamp(*size, min, max);
+}
+
+COSLAYOUT_RECT coslayout_ruleset_solve(const COSLAYOUT_RULESET *set, COSLAYOUT_RECT frame, const COSLAYOUT_ENV *env, int axes) {
+    if (axes & COSLAYOUT_AXIS_H) {
+        coslayout_ruleset_solve_dim(set, set->h_attrs, set->h_count,
+            COSLAYOUT_ATTR_W, COSLAYOUT_ATTR_MINW, COSLAYOUT_ATTR_MAXW, &frame.x, &frame.w, env);
+    }
+
+    if (axes & COSLAYOUT_AXIS_V) {
+        coslayout_ruleset_solve_dim(set, set->v_attrs, set->v_count,
+            COSLAYOUT_ATTR_H, COSLAYOUT_ATTR_MINH, COSLAYOUT_ATTR_MAXH, &frame.y, &frame.h, env);
+    }
+
+    return frame;
+}
+
+int coslayout_expr_affine(const COSLAYOUT_EXPR *expr, int dir, COSLAYOUT_AFFINE *affine) {
+    COSLAYOUT_AFFINE l, r;
+
+    switch (expr->kind) {
+    case COSLAYOUT_EXPR_CONST:
+        *affine = (COSLAYOUT_AFFINE){ expr->value, 0, 0 };
+        return 1;
+
+    case COSLAYOUT_EXPR_PERCENTAGE:
+        if ((expr->dir ? expr->dir : dir) == COSLAYOUT_DIR_V) {
+            *affine = (COSLAYOUT_AFFINE){ 0, 0, expr->value };
+        } else {
+            *affine = (COSLAYOUT_AFFINE){ 0, expr->value, 0 };
+        }
+        return 1;
+
+    case COSLAYOUT_EXPR_FLIP:
+        if (!coslayout_expr_affine(expr->l, dir, &l)) return 0;
+
+        if (expr->dir == COSLAYOUT_DIR_V) {
+            *affine = (COSLAYOUT_AFFINE){ -l.a, -l.b, 1 - l.c };
+        } else {
+            *affine = (COSLAYOUT_AFFINE){ -l.a, 1 - l.b, -l.c };
+        }
+        return 1;
+
+    case COSLAYOUT_EXPR_ADD:
+    case COSLAYOUT_EXPR_SUB: {
+        if (!coslayout_expr_affine(expr->l, dir, &l)) return 0;
+        if (!coslayout_expr_affine(expr->r, dir, &r)) return 0;
+
+        double sign = expr->kind == COSLAYOUT_EXPR_ADD ? 1 : -1;
+
+        *affine = (COSLAYOUT_AFFINE){ l.a + sign * r.a, l.b + sign * r.b, l.c + sign * r.c };
+    }
+        return 1;
+
+    case COSLAYOUT_EXPR_MUL:
+        if (!coslayout_expr_affine(expr->l, dir, &l)) return 0;
+        if (!coslayout_expr_affine(expr->r, dir, &r)) return 0;
+
+        if (r.b == 0 && r.c == 0) {
+            *affine = (COSLAYOUT_AFFINE){ l.a * r.a, l.b * r.a, l.c * r.a };
+        } else if (l.b == 0 && l.c == 0) {
+            *affine = (COSLAYOUT_AFFINE){ r.a * l.a, r.b * l.a, r.c * l.a };
+        } else {
+            return 0;
+        }
+        return 1;
+
+    case COSLAYOUT_EXPR_DIV:
+        if (!coslayout_expr_affine(expr->l, dir, &l)) return 0;
+        if (!coslayout_expr_affine(expr->r, dir, &r)) return 0;
+
+        if (r.b != 0 || r.c != 0 || r.a == 0) return 0;
+
+        *affine = (COSLAYOUT_AFFINE){ l.a / r.a, l.b / r.a, l.c / r.a };
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+static int coslayout_ruleset_affine_attr(const COSLAYOUT_RULESET *set, int attr, COSLAYOUT_AFFINE *affine) {
+    return coslayout_expr_affine(set->exprs[attr], coslayout_attr_dir(attr), affine);
+}
+
+/* Affine form of one axis: the anchor is the value of the most recent
+ * rule, the size is the distance between both rules, or the size rule
+ * when there is only one. */
+static int coslayout_ruleset_affine_axis(
+    const COSLAYOUT_RULESET *set,
+    const int *attrs,
+    int count,
+    int sizeAttr,
+    COSLAYOUT_AFFINE *anchor,
+    COSLAYOUT_AFFINE *size,
+    double *k,
+    double *lower)
+{
+    if (count == 0) return 0;
+
+    int attr1 = attrs[count - 1];
+    int edge1 = coslayout_attr_edge(attr1);
+
+    if (!coslayout_ruleset_affine_attr(set, attr1, anchor)) return 0;
+
+    if (count > 1) {
+        int attr0 = attrs[0];
+        int edge0 = coslayout_attr_edge(attr0);
+        double scale = 2.0 / (edge1 - edge0);
+        COSLAYOUT_AFFINE value0;
+
+        if (!coslayout_ruleset_affine_attr(set, attr0, &value0)) return 0;
+
+        size->a = (anchor->a - value0.a) * scale;
+        size->b = (anchor->b - value0.b) * scale;
+        size->c = (anchor->c - value0.c) * scale;
+
+        *lower = 0;
+    } else {
+        if (set->exprs[sizeAttr] == NULL) return 0;
+        if (!coslayout_ruleset_affine_attr(set, sizeAttr, size)) return 0;
+
+        *lower = -INFINITY;
+    }
+
+    *k = edge1 / 2.0;
+
+    return 1;
+}
+
+static int coslayout_ruleset_affine(const COSLAYOUT_RULESET *set, COSLAYOUT_AFFINE rows[4], double k[2], double lower[2]) {
+    if (set->exprs[COSLAYOUT_ATTR_MINW] != NULL || set->exprs[COSLAYOUT_ATTR_MAXW] != NULL ||
+        set->exprs[COSLAYOUT_ATTR_MINH] != NULL || set->exprs[COSLAYOUT_ATTR_MAXH] != NULL)
+        return 0;
+
+    return (coslayout_ruleset_affine_axis(set, set->h_attrs, set->h_count, COSLAYOUT_ATTR_W, &rows[0], &rows[2], &k[0], &lower[0]) &&
+            coslayout_ruleset_affine_axis(set, set->v_attrs, set->v_count, COSLAYOUT_ATTR_H, &rows[1], &rows[3], &k[1], &lower[1]));
+}
+
+int coslayout_ruleset_linear(const COSLAYOUT_RULESET *set) {
+    COSLAYOUT_AFFINE rows[4];
+    double k[2], lower[2];
+
+    return coslayout_ruleset_affine(set, rows, k, lower);
+}
+
+int coslayout_ruleset_fixed_axes(const COSLAYOUT_RULESET *set) {
+    int axes = 0;
+
+    if (set->h_count > 1 || (set->h_count > 0 && set->exprs[COSLAYOUT_ATTR_W] != NULL)) axes |= COSLAYOUT_AXIS_H;
+    if (set->v_count > 1 || (set->v_count > 0 && set->exprs[COSLAYOUT_ATTR_H] != NULL)) axes |= COSLAYOUT_AXIS_V;
+
+    return axes;
+}
+
+void coslayout_affine_table_init(COSLAYOUT_AFFINE_TABLE *table) {
+    memset(table, 0, sizeof(COSLAYOUT_AFFINE_TABLE));
+}
+
+void coslayout_affine_table_destroy(COSLAYOUT_AFFINE_TABLE *table) {
+    free(table->a);
+    free(table->b);
+    free(table->c);
+    free(table->k);
+    free(table->lower);
+
+    coslayout_affine_table_init(table);
+}
+
+void coslayout_affine_table_clear(COSLAYOUT_AFFINE_TABLE *table) {
+    table->count = 0;
+}
+
+static void coslayout_affine_table_reserve(COSLAYOUT_AFFINE_TABLE *table, size_t capacity) {
+    if (capacity <= table->capacity) return;
+
+    capacity = MAX_SIZE(capacity, table->capacity * 2);
+
+    table->a = (double *)realloc(table->a, 4 * capacity * sizeof(double));
+    table->b = (double *)realloc(table->b, 4 * capacity * sizeof(double));
+    table->c = (double *)realloc(table->c, 4 * capacity * sizeof(double));
+    table->k = (double *)realloc(table->k, 2 * capacity * sizeof(double));
+    table->lower = (double *)realloc(table->lower, 2 * capacity * sizeof(double));
+
+    table->capacity = capacity;
+}
+
+int coslayout_affine_table_add(COSLAYOUT_AFFINE_TABLE *table, const COSLAYOUT_RULESET *set) {
+    COSLAYOUT_AFFINE rows[4];
+    double k[2], lower[2];
+
+    if (!coslayout_ruleset_affine(set, rows, k, lower)) return -1;
+
+    coslayout_affine_table_reserve(table, table->count + 1);
+
+    size_t index = table->count++;
+
+    for (int i = 0; i < 4; ++i) {
+        table->a[index * 4 + i] = rows[i].a;
+        table->b[index * 4 + i] = rows[i].b;
+        table->c[index * 4 + i] = rows[i].c;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        table->k[index * 2 + i] = k[i];
+        table->lower[index * 2 + i] = lower[i];
+    }
+
+    return (int)index;
+}
+
+void coslayout_affine_table_solve(const COSLAYOUT_AFFINE_TABLE *table, double width, double height, COSLAYOUT_RECT *frames) {
+    size_t count = table->count;
+    size_t rows = count * 4;
+
+    const double *restrict a = table->a;
+    const double *restrict b = table->b;
+    const double *restrict c = table->c;
+    const double *restrict k = table->k;
+    const double *restrict lower = table->lower;
+
+    double *restrict values = (double *)frames;
+
+    for (size_t i = 0; i < rows; ++i) {
+        values[i] = a[i] + b[i] * width + c[i] * height;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        double *frame = values + i * 4;
+
+        frame[2] = fmax(frame[2], lower[i * 2]);
+        frame[3] = fmax(frame[3], lower[i * 2 + 1]);
+
+        frame[0] -= frame[2] * k[i * 2];
+        frame[1] -= frame[3] * k[i * 2 + 1];
+    }
+}
+
+#define COSLAYOUT_SNAPSHOT_EMPTY ((size_t)-1)
+
+static size_t coslayout_snapshot_hash(const void *ref, size_t mask) {
+    size_t h = (size_t)ref;
+
+    h ^= h >> 17;
+    h *= (size_t)0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+
+    return h & mask;
+}
+
+void coslayout_snapshot_init(COSLAYOUT_SNAPSHOT *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+void coslayout_snapshot_destroy(COSLAYOUT_SNAPSHOT *snapshot) {
+    free(snapshot->entries);
+    free(snapshot->slots);
+
+    coslayout_snapshot_init(snapshot);
+}
+
+void coslayout_snapshot_clear(COSLAYOUT_SNAPSHOT *snapshot) {
+    snapshot->count = 0;
+
+    for (size_t i = 0; i < snapshot->slot_count; ++i) {
+        snapshot->slots[i] = COSLAYOUT_SNAPSHOT_EMPTY;
+    }
+}
+
+static void coslayout_snapshot_rehash(COSLAYOUT_SNAPSHOT *snapshot, size_t slot_count) {
+    free(snapshot->slots);
+
+    snapshot->slots = (size_t *)malloc(slot_count * sizeof(size_t));
+    snapshot->slot_count = slot_count;
+
+    for (size_t i = 0; i < slot_count; ++i) {
+        snapshot->slots[i] = COSLAYOUT_SNAPSHOT_EMPTY;
+    }
+
+    for (size_t i = 0; i < snapshot->count; ++i) {
+        size_t slot = coslayout_snapshot_hash(snapshot->entries[i].ref, slot_count - 1);
+
+        while (snapshot->slots[slot] != COSLAYOUT_SNAPSHOT_EMPTY) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+
+        snapshot->slots[slot] = i;
+    }
+}
+
+COSLAYOUT_SNAPSHOT_ENTRY *coslayout_snapshot_find(const COSLAYOUT_SNAPSHOT *snapshot, const void *ref) {
+    if (snapshot->slot_count == 0) return NULL;
+
+    size_t mask = snapshot->slot_count - 1;
+    size_t slot = coslayout_snapshot_hash(ref, mask);
+
+    while (snapshot->slots[slot] != COSLAYOUT_SNAPSHOT_EMPTY) {
+        COSLAYOUT_SNAPSHOT_ENTRY *entry = &snapshot->entries[snapshot->slots[slot]];
+
+        if (entry->ref == ref) return entry;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return NULL;
+}
+
+COSLAYOUT_SNAPSHOT_ENTRY *coslayout_snapshot_insert(COSLAYOUT_SNAPSHOT *snapshot, void *ref) {
+    COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_find(snapshot, ref);
+
+    if (entry != NULL) return entry;
+
+    if (snapshot->count == snapshot->capacity) {
+        snapshot->capacity = snapshot->capacity ? snapshot->capacity * 2 : 16;
+        snapshot->entries = (COSLAYOUT_SNAPSHOT_ENTRY *)realloc(snapshot->entries, snapshot->capacity * sizeof(COSLAYOUT_SNAPSHOT_ENTRY));
+    }
+
+    /* Keep the load factor of slots at most one half. */
+    if ((snapshot->count + 1) * 2 > snapshot->slot_count) {
+        coslayout_snapshot_rehash(snapshot, snapshot->slot_count ? snapshot->slot_count * 2 : 32);
+    }
+
+    size_t index = snapshot->count++;
+    size_t mask = snapshot->slot_count - 1;
+    size_t slot = coslayout_snapshot_hash(ref, mask);
+
+    while (snapshot->slots[slot] != COSLAYOUT_SNAPSHOT_EMPTY) {
+        slot = (slot + 1) & mask;
+    }
+
+    snapshot->slots[slot] = index;
+
+    entry = &snapshot->entries[index];
+
+    memset(entry, 0, sizeof(*entry));
+    entry->ref = ref;
+
+    return entry;
+}
+
+COSLAYOUT_GEOMETRY coslayout_snapshot_geometry(void *ref, const COSLAYOUT_ENV *env) {
+    const COSLAYOUT_SNAPSHOT *snapshot = (const COSLAYOUT_SNAPSHOT *)env->info;
+    const COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_find(snapshot, ref);
+    const COSLAYOUT_SNAPSHOT_ENTRY *superview = coslayout_snapshot_find(snapshot, env->superview);
+
+    COSLAYOUT_GEOMETRY geometry = { { 0, 0, 0, 0 }, 0, 0 };
+
+    if (entry == NULL) return geometry;
+
+    geometry.rect = entry->rect;
+    geometry.width = entry->width;
+    geometry.height = entry->height;
+
+    if (superview != NULL) {
+        geometry.rect.x -= superview->rect.x - superview->origin_x;
+        geometry.rect.y -= superview->rect.y - superview->origin_y;
+    }
+
+    return geometry;
+}
+
+void coslayout_snapshot_move(COSLAYOUT_SNAPSHOT *snapshot, void *ref, void *superview, COSLAYOUT_RECT frame) {
+    COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_find(snapshot, ref);
+    const COSLAYOUT_SNAPSHOT_ENTRY *parent = coslayout_snapshot_find(snapshot, superview);
+
+    if (entry == NULL) return;
+
+    if (parent != NULL) {
+        frame.x += parent->rect.x - parent->origin_x;
+        frame.y += parent->rect.y - parent->origin_y;
+    }
+
+    entry->rect = frame;
+}
+
+int coslayout_rect_changed_axes(COSLAYOUT_RECT a, COSLAYOUT_RECT b) {
+    int axes = 0;
+
+    if (a.x != b.x || a.w != b.w) axes |= COSLAYOUT_AXIS_H;
+    if (a.y != b.y || a.h != b.h) axes |= COSLAYOUT_AXIS_V;
+
+    return axes;
+}
+
+static int coslayout_inputs_of_axes(int axes) {
+    int inputs = 0;
+
+    if (axes & COSLAYOUT_AXIS_H) inputs |= COSLAYOUT_READ_VIEW_H;
+    if (axes & COSLAYOUT_AXIS_V) inputs |= COSLAYOUT_READ_VIEW_V;
+
+    return inputs;
+}
+
+void coslayout_snapshot_copy(COSLAYOUT_SNAPSHOT *copy, const COSLAYOUT_SNAPSHOT *snapshot) {
+    coslayout_snapshot_clear(copy);
+
+    for (size_t i = 0; i < snapshot->count; ++i) {
+        const COSLAYOUT_SNAPSHOT_ENTRY *entry = &snapshot->entries[i];
+
+        *coslayout_snapshot_insert(copy, entry->ref) = *entry;
+    }
+}
+
+int coslayout_snapshot_changed_inputs(const COSLAYOUT_SNAPSHOT *before, const COSLAYOUT_SNAPSHOT *snapshot) {
+    int axes = 0;
+
+    for (size_t i = 0; i < snapshot->count; ++i) {
+        const COSLAYOUT_SNAPSHOT_ENTRY *entry = &snapshot->entries[i];
+        const COSLAYOUT_SNAPSHOT_ENTRY *old = coslayout_snapshot_find(before, entry->ref);
+
+        if (old == NULL) return -1;
+
+        axes |= coslayout_rect_changed_axes(old->rect, entry->rect);
+
+        /* Both convert rects of views below and flipped attributes. */
+        if (old->origin_x != entry->origin_x || old->width != entry->width) axes |= COSLAYOUT_AXIS_H;
+        if (old->origin_y != entry->origin_y || old->height != entry->height) axes |= COSLAYOUT_AXIS_V;
+    }
+
+    return coslayout_inputs_of_axes(axes);
+}
+
+/* Solves one node, returns the axes on which it moved. */
+static int coslayout_node_solve(COSLAYOUT_NODE *node, COSLAYOUT_SNAPSHOT *snapshot, void *container, int inputs) {
+    node->frame = node->start;
+    node->evaluations = 0;
+    node->nanoseconds = 0;
+
+    if (node->set == NULL || node->view == NULL) return 0;
+
+    const COSLAYOUT_SNAPSHOT_ENTRY *superview = coslayout_snapshot_find(snapshot, node->superview);
+
+    int axes = node->axes;
+
+    if (inputs < 0 || superview == NULL || superview->ref != container) {
+        axes = COSLAYOUT_AXIS_ALL;
+    } else {
+        if (node->set->h_reads & inputs) axes |= COSLAYOUT_AXIS_H;
+        if (node->set->v_reads & inputs) axes |= COSLAYOUT_AXIS_V;
+    }
+
+    if (!axes) return 0;
+
+    int flags = COSLAYOUT_PROFILE_FLAGS();
+
+    COSLAYOUT_ENV env = {
+        node->view,
+        node->superview,
+        superview ? superview->rect.w : 0,
+        superview ? superview->rect.h : 0,
+        coslayout_snapshot_geometry,
+        snapshot,
+        node->bindings,
+        COSLAYOUT_STATS_ENABLED() || flags ? &node->evaluations : NULL,
+        NULL,
+        node->params,
+        node->scope
+    };
+
+    uint64_t traced = COSLAYOUT_TRACE_ENABLED() ? coslayout_stats_now() : 0;
+
+    if (flags) {
+        COSLAYOUT_PROFILE_SAMPLE sample;
+
+        if (flags & COSLAYOUT_PROFILE_RULES) {
+            memset(&sample, 0, sizeof(sample));
+            env.profile = &sample;
+        }
+
+        uint64_t start = coslayout_stats_now();
+
+        node->frame = coslayout_ruleset_solve(node->set, node->start, &env, axes);
+        node->nanoseconds = coslayout_stats_now() - start;
+
+        if (env.profile) coslayout_profile_record(node->set, &sample);
+    } else {
+        node->frame = coslayout_ruleset_solve(node->set, node->start, &env, axes);
+    }
+
+    if (traced) coslayout_trace_span("solve", traced, node->view, node->superview);
+
+    int changed = coslayout_rect_changed_axes(node->start, node->frame);
+
+    if (changed) {
+        coslayout_snapshot_move(snapshot, node->view, node->superview, node->frame);
+    }
+
+    return changed;
+}
+
+typedef struct COSLAYOUT_LEVEL {
+    COSLAYOUT_NODE *nodes;
+    COSLAYOUT_SNAPSHOT *snapshot;
+    void *container;
+    int inputs;
+    int changed;
+} COSLAYOUT_LEVEL;
+
+static void coslayout_level_task(void *info, size_t index, int worker) {
+    COSLAYOUT_LEVEL *level = (COSLAYOUT_LEVEL *)info;
+
+    (void)worker;
+
+    int changed = coslayout_node_solve(&level->nodes[index], level->snapshot, level->container, level->inputs);
+
+    if (changed) {
+        __atomic_fetch_or(&level->changed, changed, __ATOMIC_RELAXED);
+    }
+}
+
+/* Callbacks may not be thread safe, levels reading them stay serial. */
+static int coslayout_level_parallel(const COSLAYOUT_NODE *nodes, size_t count) {
+    if (count < COSLAYOUT_PARALLEL_MIN) return 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const COSLAYOUT_RULESET *set = nodes[i].set;
+
+        if (set != NULL && ((set->h_reads | set->v_reads) & COSLAYOUT_READ_CALL)) return 0;
+    }
+
+    return 1;
+}
+
+void coslayout_nodes_solve(
+    COSLAYOUT_NODE *nodes,
+    size_t count,
+    COSLAYOUT_SNAPSHOT *snapshot,
+    void *container,
+    int inputs,
+    COSLAYOUT_POOL *pool)
+{
+    if (inputs >= 0) inputs |= COSLAYOUT_READ_CALL;
+
+    size_t begin = 0;
+
+    while (begin < count) {
+        size_t end = begin + 1;
+
+        while (end < count && nodes[end].level == nodes[begin].level) ++end;
+
+        if (pool != NULL && coslayout_pool_thread_count(pool) > 1 && coslayout_level_parallel(nodes + begin, end - begin)) {
+            COSLAYOUT_LEVEL level = { nodes + begin, snapshot, container, inputs, 0 };
+
+            coslayout_pool_run(pool, end - begin, coslayout_level_task, &level);
+
+            if (inputs >= 0) inputs |= coslayout_inputs_of_axes(level.changed);
+        } else {
+            for (size_t i = begin; i < end; ++i) {
+                int changed = coslayout_node_solve(&nodes[i], snapshot, container, inputs);
+
+                if (inputs >= 0) inputs |= coslayout_inputs_of_axes(changed);
+            }
+        }
+
+        begin = end;
+    }
+}
+
+/* Combines operands the way rules always did: a cleared operand yields
+ * the other one. */
+static COSLAYOUT_EXPR *coslayout_rule_binary(int kind, COSLAYOUT_EXPR *l, COSLAYOUT_EXPR *r) {
+    if (l != NULL && r != NULL) return coslayout_expr_create_binary(kind, l, r);
+
+    return coslayout_expr_retain(l != NULL ? l : r);
+}
+
+/* Operands of comparisons and conditionals which were cleared are zero. */
+static COSLAYOUT_EXPR *coslayout_rule_strict(int kind, COSLAYOUT_EXPR *l, COSLAYOUT_EXPR *r) {
+    COSLAYOUT_EXPR *zero = l != NULL && r != NULL ? NULL : coslayout_expr_create_const(0);
+    COSLAYOUT_EXPR *expr = coslayout_expr_create_binary(kind, l ? l : zero, r ? r : zero);
+
+    coslayout_expr_release(zero);
+
+    return expr;
+}
+
+static int coslayout_rule_binary_kind(int node_type) {
+    switch (node_type) {
+    case '+': case COSLAYOUT_TOKEN_ADD_ASSIGN: return COSLAYOUT_EXPR_ADD;
+    case '-': case COSLAYOUT_TOKEN_SUB_ASSIGN: return COSLAYOUT_EXPR_SUB;
+    case '*': case COSLAYOUT_TOKEN_MUL_ASSIGN: return COSLAYOUT_EXPR_MUL;
+    case '/': case COSLAYOUT_TOKEN_DIV_ASSIGN: return COSLAYOUT_EXPR_DIV;
+    default:  return -1;
+    }
+}
+
+/* Value of a rule name on the right hand side, zero if not set yet. */
+static COSLAYOUT_EXPR *coslayout_rule_current(COSLAYOUT_RULESET *set, const char *name) {
+    int attr = coslayout_attr_named(name);
+
+    if (attr < 0) {
+        fprintf(stderr, "COSLayout: Invalid constraint \"%s\", ignored.\n", name);
+    } else if (set->exprs[attr] != NULL) {
+        return coslayout_expr_retain(set->exprs[attr]);
+    }
+
+    return coslayout_expr_create_const(0);
+}
+
+static void coslayout_ruleset_set_source(COSLAYOUT_RULESET *set, int attr, COSLAYOUT_SOURCE *source) {
+    coslayout_source_retain(source);
+    coslayout_source_release(set->sources[attr]);
+
+    set->sources[attr] = source;
+}
+
+static void coslayout_rule_assign(COSLAYOUT_RULESET *set, const char *name, COSLAYOUT_EXPR *expr, COSLAYOUT_SOURCE *source) {
+    int attr = coslayout_attr_named(name);
+
+    if (attr < 0) {
+        fprintf(stderr, "COSLayout: Invalid constraint \"%s\", ignored.\n", name);
+        return;
+    }
+
+    coslayout_ruleset_assign(set, attr, expr);
+
+    int dir;
+    int dst = coslayout_attr_flipped(attr, &dir);
+
+    coslayout_ruleset_set_source(set, attr, expr ? source : NULL);
+
+    if (dst >= 0) coslayout_ruleset_set_source(set, dst, expr ? source : NULL);
+}
+
+static COSLAYOUT_EXPR *coslayout_rule_eval(
+    COSLAYOUT_RULESET *set,
+    COSLAYOUT_AST *ast,
+    COSLAYOUT_AST *parent,
+    COSLAYOUT_ARG_FUNC arg,
+    void *info,
+    COSLAYOUT_SOURCE *source);
+
+/* Folds the comma separated arguments of call with kind, left to right. */
+static COSLAYOUT_EXPR *coslayout_rule_fold(
+    int kind,
+    COSLAYOUT_RULESET *set,
+    COSLAYOUT_AST *args,
+    COSLAYOUT_AST *call,
+    COSLAYOUT_ARG_FUNC arg,
+    void *info,
+    COSLAYOUT_SOURCE *source)
+{
+    if (args->node_type != ',') return coslayout_rule_eval(set, args, call, arg, info, source);
+
+    COSLAYOUT_EXPR *l = coslayout_rule_fold(kind, set, args->l, call, arg, info, source);
+    COSLAYOUT_EXPR *r = coslayout_rule_eval(set, args->r, call, arg, info, source);
+    COSLAYOUT_EXPR *expr = coslayout_rule_binary(kind, l, r);
+
+    coslayout_expr_release(l);
+    coslayout_expr_release(r);
+
+    return expr;
+}
+
+/* Built in functions, clamp(x, lo, hi) is min(max(x, lo), hi). */
+static COSLAYOUT_EXPR *coslayout_rule_call(
+    COSLAYOUT_RULESET *set,
+    COSLAYOUT_AST *ast,
+    COSLAYOUT_ARG_FUNC arg,
+    void *info,
+    COSLAYOUT_SOURCE *source)
+{
+    switch (ast->node_type) {
+    case COSLAYOUT_TOKEN_MIN:
+        return coslayout_rule_fold(COSLAYOUT_EXPR_MIN, set, ast->l, ast, arg, info, source);
+
+    case COSLAYOUT_TOKEN_MAX:
+        return coslayout_rule_fold(COSLAYOUT_EXPR_MAX, set, ast->l, ast, arg, info, source);
+
+    default: {
+        COSLAYOUT_EXPR *l = coslayout_rule_fold(COSLAYOUT_EXPR_MAX, set, ast->l->l, ast, arg, info, source);
+        COSLAYOUT_EXPR *r = coslayout_rule_eval(set, ast->l->r, ast, arg, info, source);
+        COSLAYOUT_EXPR *expr = coslayout_rule_binary(COSLAYOUT_EXPR_MIN, l, r);
+
+        coslayout_expr_release(l);
+        coslayout_expr_release(r);
+
+        return expr;
+    }
+    }
+}
+
+/* Evaluates an AST bottom up, returns a new reference. */
+static COSLAYOUT_EXPR *coslayout_rule_eval(
+    COSLAYOUT_RULESET *set,
+    COSLAYOUT_AST *ast,
+    COSLAYOUT_AST *parent,
+    COSLAYOUT_ARG_FUNC arg,
+    void *info,
+    COSLAYOUT_SOURCE *source)
+{
+    if (ast == NULL) return NULL;
+
+    switch (ast->node_type) {
+    case COSLAYOUT_TOKEN_MIN:
+    case COSLAYOUT_TOKEN_MAX:
+    case COSLAYOUT_TOKEN_CLAMP:
+        return coslayout_rule_call(set, ast, arg, info, source);
+
+    default:
+        break;
+    }
+
+    COSLAYOUT_EXPR *l = coslayout_rule_eval(set, ast->l, ast, arg, info, source);
+    COSLAYOUT_EXPR *r = coslayout_rule_eval(set, ast->r, ast, arg, info, source);
+    COSLAYOUT_EXPR *expr = NULL;
+
+    switch (ast->node_type) {
+    case COSLAYOUT_TOKEN_ATTR:
+        if (parent == NULL) {
+            COSLAYOUT_EXPR *zero = coslayout_expr_create_const(0);
+
+            coslayout_rule_assign(set, ast->value.coord, zero, source);
+            coslayout_expr_release(zero);
+        } else if (parent->l != ast || parent->node_type != '=') {
+            expr = coslayout_rule_current(set, ast->value.coord);
+        }
+        break;
+
+    case COSLAYOUT_TOKEN_NUMBER:
+        expr = coslayout_expr_create_const(ast->value.number);
+        break;
+
+    case COSLAYOUT_TOKEN_PERCENTAGE:
+        expr = coslayout_expr_create_percentage(ast->value.percentage, COSLAYOUT_DIR_NONE);
+        break;
+
+    case COSLAYOUT_TOKEN_PERCENTAGE_H:
+        expr = coslayout_expr_create_percentage(ast->value.percentage, COSLAYOUT_DIR_H);
+        break;
+
+    case COSLAYOUT_TOKEN_PERCENTAGE_V:
+        expr = coslayout_expr_create_percentage(ast->value.percentage, COSLAYOUT_DIR_V);
+        break;
+
+    case COSLAYOUT_TOKEN_COORD:
+        expr = arg ? arg(info, ast->value.coord, 0, COSLAYOUT_DIR_NONE) : NULL;
+        break;
+
+    case COSLAYOUT_TOKEN_COORD_PERCENTAGE:
+        expr = arg ? arg(info, ast->value.coord, 1, COSLAYOUT_DIR_NONE) : NULL;
+        break;
+
+    case COSLAYOUT_TOKEN_COORD_PERCENTAGE_H:
+        expr = arg ? arg(info, ast->value.coord, 1, COSLAYOUT_DIR_H) : NULL;
+        break;
+
+    case COSLAYOUT_TOKEN_COORD_PERCENTAGE_V:
+        expr = arg ? arg(info, ast->value.coord, 1, COSLAYOUT_DIR_V) : NULL;
+        break;
+
+    case COSLAYOUT_TOKEN_PARAM:
+        expr = coslayout_expr_create_param(ast->value.coord);
+        break;
+
+    case COSLAYOUT_TOKEN_REFERENCE:
+        expr = arg ? arg(info, ast->value.coord, 0, COSLAYOUT_DIR_NONE) : NULL;
+        break;
+
+    case COSLAYOUT_TOKEN_NIL:
+        break;
+
+    case '+':
+    case '-':
+    case '*':
+    case '/':
+        expr = coslayout_rule_binary(coslayout_rule_binary_kind(ast->node_type), l, r);
+        break;
+
+    case '<':
+        expr = coslayout_rule_strict(COSLAYOUT_EXPR_LT, l, r);
+        break;
+
+    case '>':
+        expr = coslayout_rule_strict(COSLAYOUT_EXPR_GT, l, r);
+        break;
+
+    case COSLAYOUT_TOKEN_LE:
+        expr = coslayout_rule_strict(COSLAYOUT_EXPR_LE, l, r);
+        break;
+
+    case COSLAYOUT_TOKEN_GE:
+        expr = coslayout_rule_strict(COSLAYOUT_EXPR_GE, l, r);
+        break;
+
+    case COSLAYOUT_TOKEN_EQ:
+        expr = coslayout_rule_strict(COSLAYOUT_EXPR_EQ, l, r);
+        break;
+
+    case COSLAYOUT_TOKEN_NE:
+        expr = coslayout_rule_strict(COSLAYOUT_EXPR_NE, l, r);
+        break;
+
+    case '?':
+        expr = coslayout_rule_strict(COSLAYOUT_EXPR_COND, l, r);
+        break;
+
+    case ':':
+        expr = coslayout_rule_strict(COSLAYOUT_EXPR_CHOICE, l, r);
+        break;
+
+    case '=':
+        coslayout_rule_assign(set, ast->l->value.coord, r, source);
+        expr = coslayout_expr_retain(r);
+        break;
+
+    case COSLAYOUT_TOKEN_ADD_ASSIGN:
+    case COSLAYOUT_TOKEN_SUB_ASSIGN:
+    case COSLAYOUT_TOKEN_MUL_ASSIGN:
+    case COSLAYOUT_TOKEN_DIV_ASSIGN:
+        expr = coslayout_rule_binary(coslayout_rule_binary_kind(ast->node_type), l, r);
+        coslayout_rule_assign(set, ast->l->value.coord, expr, source);
+        break;
+
+    default:
+        break;
+    }
+
+    coslayout_expr_release(l);
+    coslayout_expr_release(r);
+
+    return expr;
+}
+
+/* Arguments of a rule, noting references by name arg resolved to nothing. */
+typedef struct COSLAYOUT_RULE_ARGS {
+    COSLAYOUT_ARG_FUNC arg;
+    void *info;
+    int unresolved;
+} COSLAYOUT_RULE_ARGS;
+
+static COSLAYOUT_EXPR *coslayout_rule_arg(void *info, const char *spec, int percentage, int dir) {
+    COSLAYOUT_RULE_ARGS *args = (COSLAYOUT_RULE_ARGS *)info;
+    COSLAYOUT_EXPR *expr = args->arg ? args->arg(args->info, spec, percentage, dir) : NULL;
+
+    if (expr == NULL && strchr(spec, '.') != NULL) args->unresolved = 1;
+
+    return expr;
+}
+
+int coslayout_ruleset_add_rule(COSLAYOUT_RULESET *set, const char *rule, COSLAYOUT_ARG_FUNC arg, void *info) {
+    COSLAYOUT_RULE_ARGS args = { arg, info, 0 };
+    size_t length = strlen(rule);
+    char *copy = (char *)malloc(length + 1);
+
+    memcpy(copy, rule, length + 1);
+
+    int result = 0;
+    int index = 0;
+    char *subrule = copy;
+
+    for (;;) {
+        char *comma = (char *)coslayout_rule_comma(subrule);
+
+        if (comma != NULL) *comma = '\0';
+
+        COSLAYOUT_AST *ast = NULL;
+
+        uint64_t start = COSLAYOUT_STATS_ENABLED() ? coslayout_stats_now() : 0;
+
+        result = coslayout_parse_rule(subrule, &ast);
+
+        if (start) coslayout_stats_record_parse(coslayout_stats_now() - start);
+
+        if (result != 0) break;
+
+        COSLAYOUT_SOURCE *source = coslayout_source_create(rule, index);
+
+        coslayout_expr_release(coslayout_rule_eval(set, ast, NULL, coslayout_rule_arg, &args, source));
+        coslayout_source_release(source);
+        coslayout_destroy_ast(ast);
+
+        if (args.unresolved) {
+            result = 3;
+            break;
+        }
+
+        if (comma == NULL) break;
+
+        subrule = comma + 1;
+        index += 1;
+    }
+
+    free(copy);
+
+    return result;
+}
+
+typedef struct COSLAYOUT_REF_INDEX {
+    const void *ref;
+    size_t index;
+} COSLAYOUT_REF_INDEX;
+
+static int coslayout_ref_index_compare(const void *a, const void *b) {
+    const void *ra = ((const COSLAYOUT_REF_INDEX *)a)->ref;
+    const void *rb = ((const COSLAYOUT_REF_INDEX *)b)->ref;
+
+    return ra < rb ? -1 : (ra > rb ? 1 : 0);
+}
+
+typedef struct COSLAYOUT_GRAPH {
+    const COSLAYOUT_REF_INDEX *index;
+    size_t count;
+    size_t *edges;
+    size_t edge_count;
+    size_t edge_capacity;
+    size_t from;
+} COSLAYOUT_GRAPH;
+
+/* Records an edge from the node a reference points to, to the node being
+ * visited. Edges are pairs of indices. */
+static void coslayout_graph_add_ref(COSLAYOUT_GRAPH *graph, const void *ref) {
+    COSLAYOUT_REF_INDEX key = { ref, 0 };
+    const COSLAYOUT_REF_INDEX *found = (const COSLAYOUT_REF_INDEX *)bsearch(
+        &key, graph->index, graph->count, sizeof(COSLAYOUT_REF_INDEX), coslayout_ref_index_compare);
+
+    if (found == NULL) return;
+
+    if (graph->edge_count + 2 > graph->edge_capacity) {
+        graph->edge_capacity = graph->edge_capacity ? graph->edge_capacity * 2 : 64;
+        graph->edges = (size_t *)realloc(graph->edges, graph->edge_capacity * sizeof(size_t));
+    }
+
+    graph->edges[graph->edge_count++] = found->index;
+    graph->edges[graph->edge_count++] = graph->from;
+}
+
+static void coslayout_graph_add_expr(COSLAYOUT_GRAPH *graph, const COSLAYOUT_EXPR *expr, COSLAYOUT_EXPR *const *bindings) {
+    expr = coslayout_expr_bound(expr, bindings);
+
+    if (expr == NULL) return;
+
+    if (expr->kind == COSLAYOUT_EXPR_ATTR) {
+        coslayout_graph_add_ref(graph, expr->ref);
+    } else {
+        coslayout_graph_add_expr(graph, expr->l, bindings);
+        coslayout_graph_add_expr(graph, expr->r, bindings);
+    }
+}
+
+/* Edges between nodes, graph owns its index and edges. */
+static void coslayout_nodes_graph(const COSLAYOUT_NODE *nodes, size_t count, COSLAYOUT_GRAPH *graph) {
+    COSLAYOUT_REF_INDEX *index = (COSLAYOUT_REF_INDEX *)malloc((count ? count : 1) * sizeof(COSLAYOUT_REF_INDEX));
+
+    for (size_t i = 0; i < count; ++i) {
+        index[i].ref = nodes[i].view;
+        index[i].index = i;
+    }
+
+    qsort(index, count, sizeof(COSLAYOUT_REF_INDEX), coslayout_ref_index_compare);
+
+    *graph = (COSLAYOUT_GRAPH){ index, count, NULL, 0, 0, 0 };
+
+    for (size_t i = 0; i < count; ++i) {
+        graph->from = i;
+
+        if (nodes[i].view == NULL) continue;
+
+        coslayout_graph_add_ref(graph, nodes[i].superview);
+
+        if (nodes[i].set == NULL) continue;
+
+        for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+            if (coslayout_ruleset_active(nodes[i].set, attr)) {
+                coslayout_graph_add_expr(graph, nodes[i].set->exprs[attr], nodes[i].bindings);
+            }
+        }
+    }
+}
+
+size_t coslayout_nodes_edges(const COSLAYOUT_NODE *nodes, size_t count, size_t **edges) {
+    COSLAYOUT_GRAPH graph;
+
+    coslayout_nodes_graph(nodes, count, &graph);
+
+    free((void *)graph.index);
+
+    *edges = graph.edges;
+
+    return graph.edge_count / 2;
+}
+
+int coslayout_nodes_order(COSLAYOUT_NODE *nodes, size_t count, size_t *order) {
+    if (count == 0) return 0;
+
+    uint64_t traced = COSLAYOUT_TRACE_ENABLED() ? coslayout_stats_now() : 0;
+
+    COSLAYOUT_GRAPH graph;
+
+    coslayout_nodes_graph(nodes, count, &graph);
+
+    /* Dependents of each node in compressed rows, then Kahn's algorithm. */
+    size_t *starts = (size_t *)calloc(count + 1, sizeof(size_t));
+    size_t *dependents = (size_t *)malloc((graph.edge_count / 2 + 1) * sizeof(size_t));
+    size_t *pending = (size_t *)calloc(count, sizeof(size_t));
+    size_t *queue = (size_t *)malloc(count * sizeof(size_t));
+
+    for (size_t e = 0; e < graph.edge_count; e += 2) {
+        starts[graph.edges[e] + 1] += 1;
+        pending[graph.edges[e + 1]] += 1;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        starts[i + 1] += starts[i];
+    }
+
+    size_t *fill = (size_t *)malloc((count + 1) * sizeof(size_t));
+
+    memcpy(fill, starts, (count + 1) * sizeof(size_t));
+
+    for (size_t e = 0; e < graph.edge_count; e += 2) {
+        dependents[fill[graph.edges[e]]++] = graph.edges[e + 1];
+    }
+
+    size_t head = 0, tail = 0;
+    int max_level = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        nodes[i].level = 0;
+
+        if (pending[i] == 0) queue[tail++] = i;
+    }
+
+    while (head < tail) {
+        size_t i = queue[head++];
+
+        for (size_t d = starts[i]; d < starts[i + 1]; ++d) {
+            size_t j = dependents[d];
+
+            if (nodes[j].level < nodes[i].level + 1) nodes[j].level = nodes[i].level + 1;
+
+            if (--pending[j] == 0) queue[tail++] = j;
+        }
+
+        if (nodes[i].level > max_level) max_level = nodes[i].level;
+    }
+
+    int result = tail == count ? 0 : -1;
+
+    if (result == 0) {
+        /* Stable counting sort by level. */
+        size_t *offsets = (size_t *)calloc((size_t)max_level + 2, sizeof(size_t));
+
+        for (size_t i = 0; i < count; ++i) {
+            offsets[nodes[i].level + 1] += 1;
+        }
+
+        for (int level = 0; level <= max_level; ++level) {
+            offsets[level + 1] += offsets[level];
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            order[offsets[nodes[i].level]++] = i;
+        }
+
+        free(offsets);
+    }
+
+    free(fill);
+    free(queue);
+    free(pending);
+    free(dependents);
+    free(starts);
+    free(graph.edges);
+    free((void *)graph.index);
+
+    if (traced) coslayout_trace_span("order", traced, NULL, nodes[0].superview);
+
+    return result;
+}
@@ -0,0 +1,416 @@
+// COSLayoutCore.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Evaluation core of COSLayout.
+//
+// Everything in this file is plain C. Expressions and rule sets hold
+// unretained pointers only, they are valid for the duration of a solve.
+// Ownership of views, blocks and objects is managed by COSLayout.
+
+#ifndef COSLAYOUT_CORE_H
+#define COSLAYOUT_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "COSLayoutPool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    COSLAYOUT_DIR_NONE = 0,
+    COSLAYOUT_DIR_V,
+    COSLAYOUT_DIR_H
+};
+
+enum {
+    COSLAYOUT_AXIS_H = 1 << 0,
+    COSLAYOUT_AXIS_V = 1 << 1,
+    COSLAYOUT_AXIS_ALL = COSLAYOUT_AXIS_H | COSLAYOUT_AXIS_V
+};
+
+/* Inputs an expression reads: the superview's width or height, the
+ * horizontal or vertical geometry of other views, opaque callbacks, or
+ * named parameters. */
+enum {
+    COSLAYOUT_READ_WIDTH  = 1 << 0,
+    COSLAYOUT_READ_HEIGHT = 1 << 1,
+    COSLAYOUT_READ_VIEW_H = 1 << 2,
+    COSLAYOUT_READ_VIEW_V = 1 << 3,
+    COSLAYOUT_READ_CALL   = 1 << 4,
+    COSLAYOUT_READ_PARAM  = 1 << 5
+};
+
+enum {
+    COSLAYOUT_ATTR_W,
+    COSLAYOUT_ATTR_H,
+    COSLAYOUT_ATTR_MINW,
+    COSLAYOUT_ATTR_MAXW,
+    COSLAYOUT_ATTR_MINH,
+    COSLAYOUT_ATTR_MAXH,
+    COSLAYOUT_ATTR_TT,
+    COSLAYOUT_ATTR_TB,
+    COSLAYOUT_ATTR_LL,
+    COSLAYOUT_ATTR_LR,
+    COSLAYOUT_ATTR_BB,
+    COSLAYOUT_ATTR_BT,
+    COSLAYOUT_ATTR_RR,
+    COSLAYOUT_ATTR_RL,
+    COSLAYOUT_ATTR_CT,
+    COSLAYOUT_ATTR_CL,
+    COSLAYOUT_ATTR_CB,
+    COSLAYOUT_ATTR_CR,
+    COSLAYOUT_ATTR_COUNT
+};
+
+enum {
+    COSLAYOUT_EXPR_CONST,
+    COSLAYOUT_EXPR_PERCENTAGE,
+    COSLAYOUT_EXPR_FLIP,
+    COSLAYOUT_EXPR_ATTR,
+    COSLAYOUT_EXPR_CALL,
+    COSLAYOUT_EXPR_CALL_PERCENTAGE,
+    COSLAYOUT_EXPR_BINDING,
+    COSLAYOUT_EXPR_ADD,
+    COSLAYOUT_EXPR_SUB,
+    COSLAYOUT_EXPR_MUL,
+    COSLAYOUT_EXPR_DIV,
+    COSLAYOUT_EXPR_PARAM,
+    COSLAYOUT_EXPR_MIN,
+    COSLAYOUT_EXPR_MAX,
+    COSLAYOUT_EXPR_LT,
+    COSLAYOUT_EXPR_GT,
+    COSLAYOUT_EXPR_LE,
+    COSLAYOUT_EXPR_GE,
+    COSLAYOUT_EXPR_EQ,
+    COSLAYOUT_EXPR_NE,
+    COSLAYOUT_EXPR_COND,
+    COSLAYOUT_EXPR_CHOICE
+};
+
+typedef struct COSLAYOUT_RECT {
+    double x;
+    double y;
+    double w;
+    double h;
+} COSLAYOUT_RECT;
+
+/* Geometry of a referenced view: its rect in the coordinate space of the
+ * superview being laid out, plus the size of its own superview. */
+typedef struct COSLAYOUT_GEOMETRY {
+    COSLAYOUT_RECT rect;
+    double width;
+    double height;
+} COSLAYOUT_GEOMETRY;
+
+typedef struct COSLAYOUT_ENV COSLAYOUT_ENV;
+typedef struct COSLAYOUT_EXPR COSLAYOUT_EXPR;
+
+typedef double (*COSLAYOUT_FUNC)(void *info, void *view);
+typedef void (*COSLAYOUT_RELEASE)(void *info);
+typedef COSLAYOUT_GEOMETRY (*COSLAYOUT_GEOMETRY_FUNC)(void *ref, const COSLAYOUT_ENV *env);
+
+struct COSLAYOUT_PROFILE_SAMPLE;
+
+/* Named parameters and their values. Names are interned, so tables are
+ * searched by pointer. */
+typedef struct COSLAYOUT_PARAMS {
+    size_t count;
+    size_t capacity;
+    const char **names;
+    double *values;
+} COSLAYOUT_PARAMS;
+
+/* Returns the interned copy of name, which lives as long as the process. */
+const char *coslayout_param_intern(const char *name);
+
+void coslayout_params_init(COSLAYOUT_PARAMS *params);
+void coslayout_params_copy(COSLAYOUT_PARAMS *dst, const COSLAYOUT_PARAMS *src);
+void coslayout_params_destroy(COSLAYOUT_PARAMS *params);
+
+/* Sets the value of an interned name. Returns 1 if the value changed. */
+int coslayout_params_set(COSLAYOUT_PARAMS *params, const char *name, double value);
+
+/* Looks up an interned name, returns 0 if it is not set. */
+int coslayout_params_get(const COSLAYOUT_PARAMS *params, const char *name, double *value);
+
+/* Evaluations, if not NULL, counts rules evaluated, and profile, if not
+ * NULL, times them by attribute. Parameters are looked up in params, then
+ * in scope, either may be NULL. */
+struct COSLAYOUT_ENV {
+    void *view;
+    void *superview;
+    double width;
+    double height;
+    COSLAYOUT_GEOMETRY_FUNC geometry;
+    void *info;
+    COSLAYOUT_EXPR *const *bindings;
+    size_t *evaluations;
+    struct COSLAYOUT_PROFILE_SAMPLE *profile;
+    const COSLAYOUT_PARAMS *params;
+    const COSLAYOUT_PARAMS *scope;
+};
+
+/* Comparisons are 1 if they hold and 0 otherwise. A conditional has its
+ * condition as l and a choice as r, whose l is taken if the condition is
+ * not zero and r otherwise. Choices are not evaluated on their own.
+ *
+ * Binding expressions stand for the expression at index binding of the
+ * bindings of the environment, so that rules can be shared by views
+ * referencing different views, blocks or objects. Reads are those of the
+ * bound expression. Parameter expressions reference their interned name,
+ * and are shared like constants. */
+struct COSLAYOUT_EXPR {
+    signed char kind;
+    signed char dir;
+    signed char attr;
+    signed char reads;
+    int binding;
+    unsigned int refcount;
+    double value;
+    struct COSLAYOUT_EXPR *l;
+    struct COSLAYOUT_EXPR *r;
+    void *ref;
+    COSLAYOUT_FUNC func;
+    COSLAYOUT_RELEASE release;
+    void *info;
+};
+
+/* Affine form of an expression: a + b * width + c * height, where width
+ * and height are the size of the superview. */
+typedef struct COSLAYOUT_AFFINE {
+    double a;
+    double b;
+    double c;
+} COSLAYOUT_AFFINE;
+
+/* Where a rule came from: the text it was added with and the index of the
+ * comma separated subrule, kept for profiling and reports. */
+typedef struct COSLAYOUT_SOURCE {
+    unsigned int refcount;
+    int subrule;
+    char text[];
+} COSLAYOUT_SOURCE;
+
+COSLAYOUT_SOURCE *coslayout_source_create(const char *text, int subrule);
+COSLAYOUT_SOURCE *coslayout_source_retain(COSLAYOUT_SOURCE *source);
+void coslayout_source_release(COSLAYOUT_SOURCE *source);
+
+/* Points start to the subrule in the text of source, returns its length. */
+size_t coslayout_source_subrule(const COSLAYOUT_SOURCE *source, const char **start);
+
+/* Sources are those of the rules last assigned to each attribute. They do
+ * not take part in solving, equal rules from different text are equal. */
+typedef struct COSLAYOUT_RULESET {
+    COSLAYOUT_EXPR *exprs[COSLAYOUT_ATTR_COUNT];
+    COSLAYOUT_SOURCE *sources[COSLAYOUT_ATTR_COUNT];
+    int h_attrs[2];
+    int v_attrs[2];
+    int h_count;
+    int v_count;
+    int h_reads;
+    int v_reads;
+} COSLAYOUT_RULESET;
+
+COSLAYOUT_EXPR *coslayout_expr_create_const(double value);
+COSLAYOUT_EXPR *coslayout_expr_create_percentage(double percentage, int dir);
+COSLAYOUT_EXPR *coslayout_expr_create_flip(COSLAYOUT_EXPR *expr, int dir);
+COSLAYOUT_EXPR *coslayout_expr_create_attr(int attr, void *ref);
+COSLAYOUT_EXPR *coslayout_expr_create_call(COSLAYOUT_FUNC func, void *info, COSLAYOUT_RELEASE release);
+COSLAYOUT_EXPR *coslayout_expr_create_call_percentage(COSLAYOUT_FUNC func, void *info, COSLAYOUT_RELEASE release, int dir);
+COSLAYOUT_EXPR *coslayout_expr_create_binding(int binding, int reads);
+COSLAYOUT_EXPR *coslayout_expr_create_binary(int kind, COSLAYOUT_EXPR *l, COSLAYOUT_EXPR *r);
+COSLAYOUT_EXPR *coslayout_expr_create_param(const char *name);
+
+COSLAYOUT_EXPR *coslayout_expr_retain(COSLAYOUT_EXPR *expr);
+void coslayout_expr_release(COSLAYOUT_EXPR *expr);
+
+double coslayout_expr_eval(const COSLAYOUT_EXPR *expr, int dir, const COSLAYOUT_ENV *env);
+int coslayout_expr_reads(const COSLAYOUT_EXPR *expr, int dir);
+
+int coslayout_attr_dir(int attr);
+int coslayout_attr_named(const char *name);
+const char *coslayout_attr_name(int attr);
+
+void coslayout_ruleset_init(COSLAYOUT_RULESET *set);
+void coslayout_ruleset_copy(COSLAYOUT_RULESET *dst, const COSLAYOUT_RULESET *src);
+void coslayout_ruleset_destroy(COSLAYOUT_RULESET *set);
+void coslayout_ruleset_set(COSLAYOUT_RULESET *set, int attr, COSLAYOUT_EXPR *expr);
+int coslayout_ruleset_active(const COSLAYOUT_RULESET *set, int attr);
+/* Expression a binding expression stands for, or expr itself. */
+const COSLAYOUT_EXPR *coslayout_expr_bound(const COSLAYOUT_EXPR *expr, COSLAYOUT_EXPR *const *bindings);
+
+int coslayout_ruleset_references(const COSLAYOUT_RULESET *set, COSLAYOUT_EXPR *const *bindings, const void *ref);
+
+/* Returns 1 if a rule of set reads the parameter, name is interned. */
+int coslayout_ruleset_reads_param(const COSLAYOUT_RULESET *set, const char *name);
+
+/* Sets a rule as written. Rules measured from the far edge, like tb or rr,
+ * also set the rule of the near edge they are flipped to. */
+void coslayout_ruleset_assign(COSLAYOUT_RULESET *set, int attr, COSLAYOUT_EXPR *expr);
+
+/* Returns a new expression for a format specifier of a rule, spec is the
+ * text after '%'. Percentage specifiers pass a direction, which is
+ * COSLAYOUT_DIR_NONE for the direction of the rule. References to views
+ * by name, like header.bt, pass the whole reference as spec and consume
+ * no argument. NULL clears the rule. */
+typedef COSLAYOUT_EXPR *(*COSLAYOUT_ARG_FUNC)(void *info, const char *spec, int percentage, int dir);
+
+/* Returns the attribute of a reference by name, and sets length to the
+ * length of the name, or returns -1 if spec is not a valid reference. */
+int coslayout_spec_reference(const char *spec, size_t *length);
+
+/* Parses and assigns comma separated rules. Returns 0 on success, 1 on a
+ * syntax error, 2 if parsing ran out of memory, or 3 if arg resolved no
+ * view for a reference by name. Rules after the one failing are not
+ * assigned. */
+int coslayout_ruleset_add_rule(COSLAYOUT_RULESET *set, const char *rule, COSLAYOUT_ARG_FUNC arg, void *info);
+
+COSLAYOUT_RECT coslayout_ruleset_solve(const COSLAYOUT_RULESET *set, COSLAYOUT_RECT frame, const COSLAYOUT_ENV *env, int axes);
+
+int coslayout_expr_affine(const COSLAYOUT_EXPR *expr, int dir, COSLAYOUT_AFFINE *affine);
+int coslayout_ruleset_linear(const COSLAYOUT_RULESET *set);
+
+/* Axes whose origin and size set solves without the frame it starts from,
+ * those with two position rules or with one and a size rule. */
+int coslayout_ruleset_fixed_axes(const COSLAYOUT_RULESET *set);
+
+/* Structure-of-arrays table of linear rule sets. Each entry has four rows
+ * laid out like COSLAYOUT_RECT: the anchor of both axes, then the size of
+ * both axes. Solving evaluates all rows with one multiply-add pass, then
+ * moves every anchor to the origin. */
+typedef struct COSLAYOUT_AFFINE_TABLE {
+    size_t count;
+    size_t capacity;
+    double *a;
+    double *b;
+    double *c;
+    double *k;
+    double *lower;
+} COSLAYOUT_AFFINE_TABLE;
+
+void coslayout_affine_table_init(COSLAYOUT_AFFINE_TABLE *table);
+void coslayout_affine_table_destroy(COSLAYOUT_AFFINE_TABLE *table);
+void coslayout_affine_table_clear(COSLAYOUT_AFFINE_TABLE *table);
+int coslayout_affine_table_add(COSLAYOUT_AFFINE_TABLE *table, const COSLAYOUT_RULESET *set);
+void coslayout_affine_table_solve(const COSLAYOUT_AFFINE_TABLE *table, double width, double height, COSLAYOUT_RECT *frames);
+
+/* Geometry of views captured before a solve. Rects are in the coordinate
+ * space of one container view, so a solve can run on any thread without
+ * touching the views. Moving an entry makes the new rect visible to rules
+ * evaluated later in the same solve. The origin is the bounds origin of the
+ * view, width and height are the size of its superview. */
+typedef struct COSLAYOUT_SNAPSHOT_ENTRY {
+    void *ref;
+    COSLAYOUT_RECT rect;
+    double origin_x;
+    double origin_y;
+    double width;
+    double height;
+} COSLAYOUT_SNAPSHOT_ENTRY;
+
+typedef struct COSLAYOUT_SNAPSHOT {
+    size_t count;
+    size_t capacity;
+    COSLAYOUT_SNAPSHOT_ENTRY *entries;
+    size_t slot_count;
+    size_t *slots;
+} COSLAYOUT_SNAPSHOT;
+
+void coslayout_snapshot_init(COSLAYOUT_SNAPSHOT *snapshot);
+void coslayout_snapshot_destroy(COSLAYOUT_SNAPSHOT *snapshot);
+void coslayout_snapshot_clear(COSLAYOUT_SNAPSHOT *snapshot);
+COSLAYOUT_SNAPSHOT_ENTRY *coslayout_snapshot_insert(COSLAYOUT_SNAPSHOT *snapshot, void *ref);
+COSLAYOUT_SNAPSHOT_ENTRY *coslayout_snapshot_find(const COSLAYOUT_SNAPSHOT *snapshot, const void *ref);
+void coslayout_snapshot_move(COSLAYOUT_SNAPSHOT *snapshot, void *ref, void *superview, COSLAYOUT_RECT frame);
+
+/* Replaces the entries of copy by those of snapshot. */
+void coslayout_snapshot_copy(COSLAYOUT_SNAPSHOT *copy, const COSLAYOUT_SNAPSHOT *snapshot);
+
+/* Inputs, COSLAYOUT_READ_VIEW_* bits, of rules reading views whose
+ * geometry in snapshot differs from the one in before, e.g. views resized
+ * outside of layout since the last solve. Returns -1 if a view of
+ * snapshot is missing from before. */
+int coslayout_snapshot_changed_inputs(const COSLAYOUT_SNAPSHOT *before, const COSLAYOUT_SNAPSHOT *snapshot);
+
+/* Geometry function reading a snapshot passed as the info of environment. */
+COSLAYOUT_GEOMETRY coslayout_snapshot_geometry(void *ref, const COSLAYOUT_ENV *env);
+
+/* A view solved against a snapshot. Level is the length of the longest
+ * chain of nodes the view depends on, nodes are sorted by level. Axes are
+ * solved regardless of inputs, e.g. when the frame was changed outside.
+ * Evaluations counts rules evaluated by the last solve, while statistics
+ * are enabled. Params and scope are the parameters of the view and of its
+ * superview, either may be NULL. */
+typedef struct COSLAYOUT_NODE {
+    const COSLAYOUT_RULESET *set;
+    COSLAYOUT_EXPR *const *bindings;
+    void *view;
+    void *superview;
+    COSLAYOUT_RECT start;
+    COSLAYOUT_RECT frame;
+    int axes;
+    int level;
+    size_t evaluations;
+    uint64_t nanoseconds;
+    const COSLAYOUT_PARAMS *params;
+    const COSLAYOUT_PARAMS *scope;
+} COSLAYOUT_NODE;
+
+/* Minimum number of nodes in a level to solve it on a pool. */
+#define COSLAYOUT_PARALLEL_MIN 64
+
+int coslayout_rect_changed_axes(COSLAYOUT_RECT a, COSLAYOUT_RECT b);
+
+/* Levels nodes by the nodes their rules reference and their superview.
+ * Writes to order the indices of nodes sorted by level, keeping the given
+ * order inside a level. Returns -1 if nodes depend on each other in a
+ * cycle, 0 otherwise. */
+int coslayout_nodes_order(COSLAYOUT_NODE *nodes, size_t count, size_t *order);
+
+/* Sets edges to the pairs of indices of a node and of a node depending on
+ * it, one pair per reference, and returns the number of pairs. Edges are
+ * freed by the caller. */
+size_t coslayout_nodes_edges(const COSLAYOUT_NODE *nodes, size_t count, size_t **edges);
+
+/* Solves nodes level by level, moving them in the snapshot. Inputs are the
+ * COSLAYOUT_READ_* bits changed since the last solve of the container, or
+ * negative to solve every axis. Levels wide enough and free of callbacks
+ * are spread over pool, which may be NULL. */
+void coslayout_nodes_solve(
+    COSLAYOUT_NODE *nodes,
+    size_t count,
+    COSLAYOUT_SNAPSHOT *snapshot,
+    void *container,
+    int inputs,
+    COSLAYOUT_POOL *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
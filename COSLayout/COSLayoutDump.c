@@ -0,0 +1,279 @@
+// COSLayoutDump.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutDump.h"
+
+#include <stdlib.h>
+
+/* Edge from a node to a node referencing it, count times. */
+typedef struct COSLAYOUT_DUMP_EDGE {
+    size_t from;
+    size_t to;
+    size_t count;
+} COSLAYOUT_DUMP_EDGE;
+
+static int coslayout_dump_edge_compare(const void *a, const void *b) {
+    const COSLAYOUT_DUMP_EDGE *ea = (const COSLAYOUT_DUMP_EDGE *)a;
+    const COSLAYOUT_DUMP_EDGE *eb = (const COSLAYOUT_DUMP_EDGE *)b;
+
+    if (ea->from != eb->from) return ea->from < eb->from ? -1 : 1;
+    if (ea->to != eb->to) return ea->to < eb->to ? -1 : 1;
+
+    return 0;
+}
+
+/* Edges of nodes without duplicates, sorted by node. */
+static size_t coslayout_dump_edges(const COSLAYOUT_NODE *nodes, size_t count, COSLAYOUT_DUMP_EDGE **edges) {
+    size_t *pairs = NULL;
+    size_t pair_count = coslayout_nodes_edges(nodes, count, &pairs);
+
+    *edges = (COSLAYOUT_DUMP_EDGE *)malloc((pair_count ? pair_count : 1) * sizeof(COSLAYOUT_DUMP_EDGE));
+
+    for (size_t i = 0; i < pair_count; ++i) {
+        (*edges)[i] = (COSLAYOUT_DUMP_EDGE){ pairs[i * 2], pairs[i * 2 + 1], 1 };
+    }
+
+    free(pairs);
+
+    qsort(*edges, pair_count, sizeof(COSLAYOUT_DUMP_EDGE), coslayout_dump_edge_compare);
+
+    size_t unique = 0;
+
+    for (size_t i = 0; i < pair_count; ++i) {
+        if (unique > 0 && coslayout_dump_edge_compare(&(*edges)[unique - 1], &(*edges)[i]) == 0) {
+            (*edges)[unique - 1].count += 1;
+        } else {
+            (*edges)[unique++] = (*edges)[i];
+        }
+    }
+
+    return unique;
+}
+
+/* Sources of the rules of set, each once, returns their number. */
+static int coslayout_dump_sources(const COSLAYOUT_RULESET *set, const COSLAYOUT_SOURCE **sources) {
+    int count = 0;
+
+    if (set == NULL) return 0;
+
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        const COSLAYOUT_SOURCE *source = set->sources[attr];
+        int seen = source == NULL;
+
+        for (int i = 0; i < count && !seen; ++i) {
+            seen = sources[i] == source;
+        }
+
+        if (!seen) sources[count++] = source;
+    }
+
+    return count;
+}
+
+static void coslayout_dump_string(FILE *file, const char *text, size_t length) {
+    for (size_t i = 0; i < length && text[i] != '\0'; ++i) {
+        unsigned char c = (unsigned char)text[i];
+
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if (c >= 0x20) {
+            fputc(c, file);
+        }
+    }
+}
+
+static void coslayout_dump_rule(FILE *file, const COSLAYOUT_SOURCE *source) {
+    const char *start;
+    size_t length = coslayout_source_subrule(source, &start);
+
+    coslayout_dump_string(file, start, length);
+}
+
+static void coslayout_dump_write_dot(
+    FILE *file,
+    void *container,
+    const COSLAYOUT_NODE *nodes,
+    size_t count,
+    const COSLAYOUT_DUMP_EDGE *edges,
+    size_t edge_count,
+    const size_t *dependents,
+    int levelled,
+    const COSLAYOUT_COSTS *costs,
+    COSLAYOUT_NAME_FUNC name,
+    void *info)
+{
+    size_t passes = coslayout_costs_passes(costs);
+
+    fprintf(file, "digraph coslayout {\n    label=\"%p\";\n    node [shape=box, fontname=\"Menlo\"];\n", container);
+
+    for (size_t i = 0; i < count; ++i) {
+        const COSLAYOUT_NODE *node = &nodes[i];
+        const COSLAYOUT_SOURCE *sources[COSLAYOUT_ATTR_COUNT];
+        int source_count = coslayout_dump_sources(node->set, sources);
+        char label[128] = "";
+
+        if (name != NULL) name(info, node->view, label, sizeof(label));
+
+        fprintf(file, "    n%zu [label=\"", i);
+        coslayout_dump_string(file, label, sizeof(label));
+        fprintf(file, label[0] ? " %p\\n" : "%p\\n", node->view);
+
+        if (levelled) fprintf(file, "level %d, ", node->level);
+
+        fprintf(file, "%zu dependents", dependents[i]);
+
+        if (passes > 0) {
+            COSLAYOUT_COST cost = coslayout_costs_sum(costs, node->view);
+
+            fprintf(file, "\\n%zu evaluations, %.3f ms in %zu passes", cost.evaluations, cost.nanoseconds * 1e-6, passes);
+        }
+
+        for (int s = 0; s < source_count; ++s) {
+            fputs("\\l", file);
+            coslayout_dump_rule(file, sources[s]);
+        }
+
+        fputs(source_count > 0 ? "\\l\"];\n" : "\"];\n", file);
+    }
+
+    for (size_t e = 0; e < edge_count; ++e) {
+        fprintf(file, "    n%zu -> n%zu", edges[e].from, edges[e].to);
+
+        if (edges[e].count > 1) fprintf(file, " [label=\"%zu\"]", edges[e].count);
+
+        fputs(";\n", file);
+    }
+
+    fputs("}\n", file);
+}
+
+static void coslayout_dump_write_json(
+    FILE *file,
+    void *container,
+    const COSLAYOUT_NODE *nodes,
+    size_t count,
+    const COSLAYOUT_DUMP_EDGE *edges,
+    size_t edge_count,
+    const size_t *dependents,
+    int levelled,
+    const COSLAYOUT_COSTS *costs,
+    COSLAYOUT_NAME_FUNC name,
+    void *info)
+{
+    size_t passes = coslayout_costs_passes(costs);
+    int depth = 0;
+
+    for (size_t i = 0; levelled && i < count; ++i) {
+        if (nodes[i].level + 1 > depth) depth = nodes[i].level + 1;
+    }
+
+    fprintf(file, "{\"container\":\"%p\",\"passes\":%zu,\"cycle\":%s", container, passes, levelled ? "false" : "true");
+
+    if (levelled) fprintf(file, ",\"depth\":%d", depth);
+
+    fputs(",\"nodes\":[", file);
+
+    for (size_t i = 0; i < count; ++i) {
+        const COSLAYOUT_NODE *node = &nodes[i];
+        const COSLAYOUT_SOURCE *sources[COSLAYOUT_ATTR_COUNT];
+        int source_count = coslayout_dump_sources(node->set, sources);
+
+        fprintf(file, "%s\n{\"id\":%zu,\"view\":\"%p\"", i ? "," : "", i, node->view);
+
+        if (name != NULL) {
+            char label[128] = "";
+
+            name(info, node->view, label, sizeof(label));
+
+            fputs(",\"name\":\"", file);
+            coslayout_dump_string(file, label, sizeof(label));
+            fputc('"', file);
+        }
+
+        if (levelled) fprintf(file, ",\"level\":%d", node->level);
+
+        fprintf(file, ",\"dependents\":%zu", dependents[i]);
+
+        if (passes > 0) {
+            COSLAYOUT_COST cost = coslayout_costs_sum(costs, node->view);
+
+            fprintf(file, ",\"evaluations\":%zu,\"seconds\":%.9f", cost.evaluations, cost.nanoseconds * 1e-9);
+        }
+
+        fputs(",\"rules\":[", file);
+
+        for (int s = 0; s < source_count; ++s) {
+            fputs(s ? ",\"" : "\"", file);
+            coslayout_dump_rule(file, sources[s]);
+            fputc('"', file);
+        }
+
+        fputs("]}", file);
+    }
+
+    fputs("\n],\"edges\":[", file);
+
+    for (size_t e = 0; e < edge_count; ++e) {
+        fprintf(file, "%s\n{\"from\":%zu,\"to\":%zu,\"references\":%zu}",
+                e ? "," : "", edges[e].from, edges[e].to, edges[e].count);
+    }
+
+    fputs("\n]}\n", file);
+}
+
+int coslayout_dump_write(
+    FILE *file,
+    int format,
+    void *container,
+    COSLAYOUT_NODE *nodes,
+    size_t count,
+    const COSLAYOUT_COSTS *costs,
+    COSLAYOUT_NAME_FUNC name,
+    void *info)
+{
+    size_t *order = (size_t *)malloc((count ? count : 1) * sizeof(size_t));
+    size_t *dependents = (size_t *)calloc(count ? count : 1, sizeof(size_t));
+    COSLAYOUT_DUMP_EDGE *edges = NULL;
+
+    int levelled = coslayout_nodes_order(nodes, count, order) == 0;
+    size_t edge_count = coslayout_dump_edges(nodes, count, &edges);
+
+    for (size_t e = 0; e < edge_count; ++e) {
+        dependents[edges[e].from] += 1;
+    }
+
+    if (format == COSLAYOUT_DUMP_JSON) {
+        coslayout_dump_write_json(file, container, nodes, count, edges, edge_count, dependents, levelled, costs, name, info);
+    } else {
+        coslayout_dump_write_dot(file, container, nodes, count, edges, edge_count, dependents, levelled, costs, name, info);
+    }
+
+    free(edges);
+    free(dependents);
+    free(order);
+
+    return ferror(file) ? -1 : 0;
+}
@@ -0,0 +1,71 @@
+// COSLayoutDump.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Dependency graphs of containers, for offline analysis.
+//
+// A graph has a node per constrained view, labeled with the rules of the
+// view, its level, the number of views depending on it and its costs over
+// the passes kept, and an edge from each view to each view referencing
+// it. Wide fan in shows as nodes with many dependents, chains that keep
+// levels from being solved in parallel as deep levels.
+
+#ifndef COSLAYOUT_DUMP_H
+#define COSLAYOUT_DUMP_H
+
+#include <stdio.h>
+
+#include "COSLayoutCore.h"
+#include "COSLayoutProfile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    COSLAYOUT_DUMP_DOT = 0,
+    COSLAYOUT_DUMP_JSON
+};
+
+/* Writes a name of view, such as its class, to name of size bytes. */
+typedef void (*COSLAYOUT_NAME_FUNC)(void *info, const void *view, char *name, size_t size);
+
+/* Writes the graph of nodes of container to file in format, levelling the
+ * nodes. Costs and name may be NULL. Levels are left out if nodes depend
+ * on each other in a cycle. Returns -1 if writing failed, 0 otherwise. */
+int coslayout_dump_write(
+    FILE *file,
+    int format,
+    void *container,
+    COSLAYOUT_NODE *nodes,
+    size_t count,
+    const COSLAYOUT_COSTS *costs,
+    COSLAYOUT_NAME_FUNC name,
+    void *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,8 +1,9 @@
-/* A Bison parser, made by GNU Bison 3.0.2.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2013 Free Software Foundation, Inc.
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
 
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
@@ -15,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -33,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -40,17 +45,17 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.0.2"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 2
+#define YYPURE 1
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -67,148 +72,185 @@
 #define yydebug         coslayoutdebug
 #define yynerrs         coslayoutnerrs
 
-
-/* Copy the first part of user declarations.  */
-#line 1 "COSLayoutParser.y" /* yacc.c:339  */
+/* First part of user prologue.  */
+#line 34 "COSLayoutParser.y"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "COSLayoutParser.h"
 #include "COSLayoutLex.h"
 
 void coslayouterror(void *scanner, COSLAYOUT_AST **astpp, char *msg);
 int coslayoutlex(YYSTYPE *lvalp, void *scanner, COSLAYOUT_AST **astpp);
 
-#line 82 "COSLayoutParser.c" /* yacc.c:339  */
+#line 88 "COSLayoutParser.c"
 
-# ifndef YY_NULLPTR
-#  if defined __cplusplus && 201103L <= __cplusplus
-#   define YY_NULLPTR nullptr
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
 #  else
-#   define YY_NULLPTR 0
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
 #  endif
 # endif
-
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 0
-#endif
-
-/* In a future release of Bison, this section will be replaced
-   by #include "COSLayoutParser.h".  */
-#ifndef YY_COSLAYOUT_COSLAYOUTPARSER_H_INCLUDED
-# define YY_COSLAYOUT_COSLAYOUTPARSER_H_INCLUDED
-/* Debug traces.  */
-#ifndef COSLAYOUTDEBUG
-# if defined YYDEBUG
-#if YYDEBUG
-#   define COSLAYOUTDEBUG 1
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
 #  else
-#   define COSLAYOUTDEBUG 0
+#   define YY_NULLPTR ((void*)0)
 #  endif
-# else /* ! defined YYDEBUG */
-#  define COSLAYOUTDEBUG 0
-# endif /* ! defined YYDEBUG */
-#endif  /* ! defined COSLAYOUTDEBUG */
-#if COSLAYOUTDEBUG
-extern int coslayoutdebug;
-#endif
-/* "%code requires" blocks.  */
-#line 18 "COSLayoutParser.y" /* yacc.c:355  */
-
-#define YYSTYPE COSLAYOUTSTYPE
-
-#define YY_DECL int coslayoutlex \
-    (YYSTYPE *yylval_param, yyscan_t yyscanner, COSLAYOUT_AST **astpp)
-
-struct COSLAYOUT_AST {
-    int node_type;
-    struct COSLAYOUT_AST *l;
-    struct COSLAYOUT_AST *r;
-    union {
-        float number;
-        float percentage;
-        char *coord;
-    } value;
-    void *data;
-};
-
-typedef struct COSLAYOUT_AST COSLAYOUT_AST;
+# endif
 
-COSLAYOUT_AST *coslayout_create_ast(int type, COSLAYOUT_AST *l, COSLAYOUT_AST *r);
+#include "COSLayoutParser.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_COSLAYOUT_TOKEN_ATTR = 3,       /* COSLAYOUT_TOKEN_ATTR  */
+  YYSYMBOL_COSLAYOUT_TOKEN_NUMBER = 4,     /* COSLAYOUT_TOKEN_NUMBER  */
+  YYSYMBOL_COSLAYOUT_TOKEN_PERCENTAGE = 5, /* COSLAYOUT_TOKEN_PERCENTAGE  */
+  YYSYMBOL_COSLAYOUT_TOKEN_PERCENTAGE_H = 6, /* COSLAYOUT_TOKEN_PERCENTAGE_H  */
+  YYSYMBOL_COSLAYOUT_TOKEN_PERCENTAGE_V = 7, /* COSLAYOUT_TOKEN_PERCENTAGE_V  */
+  YYSYMBOL_COSLAYOUT_TOKEN_COORD = 8,      /* COSLAYOUT_TOKEN_COORD  */
+  YYSYMBOL_COSLAYOUT_TOKEN_COORD_PERCENTAGE = 9, /* COSLAYOUT_TOKEN_COORD_PERCENTAGE  */
+  YYSYMBOL_COSLAYOUT_TOKEN_COORD_PERCENTAGE_H = 10, /* COSLAYOUT_TOKEN_COORD_PERCENTAGE_H  */
+  YYSYMBOL_COSLAYOUT_TOKEN_COORD_PERCENTAGE_V = 11, /* COSLAYOUT_TOKEN_COORD_PERCENTAGE_V  */
+  YYSYMBOL_COSLAYOUT_TOKEN_NIL = 12,       /* COSLAYOUT_TOKEN_NIL  */
+  YYSYMBOL_COSLAYOUT_TOKEN_ADD_ASSIGN = 13, /* COSLAYOUT_TOKEN_ADD_ASSIGN  */
+  YYSYMBOL_COSLAYOUT_TOKEN_SUB_ASSIGN = 14, /* COSLAYOUT_TOKEN_SUB_ASSIGN  */
+  YYSYMBOL_COSLAYOUT_TOKEN_MUL_ASSIGN = 15, /* COSLAYOUT_TOKEN_MUL_ASSIGN  */
+  YYSYMBOL_COSLAYOUT_TOKEN_DIV_ASSIGN = 16, /* COSLAYOUT_TOKEN_DIV_ASSIGN  */
+  YYSYMBOL_COSLAYOUT_TOKEN_PARAM = 17,     /* COSLAYOUT_TOKEN_PARAM  */
+  YYSYMBOL_COSLAYOUT_TOKEN_REFERENCE = 18, /* COSLAYOUT_TOKEN_REFERENCE  */
+  YYSYMBOL_COSLAYOUT_TOKEN_LE = 19,        /* COSLAYOUT_TOKEN_LE  */
+  YYSYMBOL_COSLAYOUT_TOKEN_GE = 20,        /* COSLAYOUT_TOKEN_GE  */
+  YYSYMBOL_COSLAYOUT_TOKEN_EQ = 21,        /* COSLAYOUT_TOKEN_EQ  */
+  YYSYMBOL_COSLAYOUT_TOKEN_NE = 22,        /* COSLAYOUT_TOKEN_NE  */
+  YYSYMBOL_COSLAYOUT_TOKEN_MIN = 23,       /* COSLAYOUT_TOKEN_MIN  */
+  YYSYMBOL_COSLAYOUT_TOKEN_MAX = 24,       /* COSLAYOUT_TOKEN_MAX  */
+  YYSYMBOL_COSLAYOUT_TOKEN_CLAMP = 25,     /* COSLAYOUT_TOKEN_CLAMP  */
+  YYSYMBOL_26_ = 26,                       /* '='  */
+  YYSYMBOL_27_ = 27,                       /* '?'  */
+  YYSYMBOL_28_ = 28,                       /* ':'  */
+  YYSYMBOL_29_ = 29,                       /* '<'  */
+  YYSYMBOL_30_ = 30,                       /* '>'  */
+  YYSYMBOL_31_ = 31,                       /* '+'  */
+  YYSYMBOL_32_ = 32,                       /* '-'  */
+  YYSYMBOL_33_ = 33,                       /* '*'  */
+  YYSYMBOL_34_ = 34,                       /* '/'  */
+  YYSYMBOL_35_ = 35,                       /* '('  */
+  YYSYMBOL_36_ = 36,                       /* ')'  */
+  YYSYMBOL_37_ = 37,                       /* ','  */
+  YYSYMBOL_YYACCEPT = 38,                  /* $accept  */
+  YYSYMBOL_rule = 39,                      /* rule  */
+  YYSYMBOL_expr = 40,                      /* expr  */
+  YYSYMBOL_assign = 41,                    /* assign  */
+  YYSYMBOL_rval = 42,                      /* rval  */
+  YYSYMBOL_test = 43,                      /* test  */
+  YYSYMBOL_sum = 44,                       /* sum  */
+  YYSYMBOL_item = 45,                      /* item  */
+  YYSYMBOL_atom = 46,                      /* atom  */
+  YYSYMBOL_args = 47                       /* args  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-int coslayout_parse_rule(char *rule, COSLAYOUT_AST **astpp);
-void coslayout_destroy_ast(COSLAYOUT_AST *astp);
 
-#line 146 "COSLayoutParser.c" /* yacc.c:355  */
 
-/* Token type.  */
-#ifndef COSLAYOUTTOKENTYPE
-# define COSLAYOUTTOKENTYPE
-  enum coslayouttokentype
-  {
-    COSLAYOUT_TOKEN_ATTR = 258,
-    COSLAYOUT_TOKEN_NUMBER = 259,
-    COSLAYOUT_TOKEN_PERCENTAGE = 260,
-    COSLAYOUT_TOKEN_PERCENTAGE_H = 261,
-    COSLAYOUT_TOKEN_PERCENTAGE_V = 262,
-    COSLAYOUT_TOKEN_COORD = 263,
-    COSLAYOUT_TOKEN_COORD_PERCENTAGE = 264,
-    COSLAYOUT_TOKEN_COORD_PERCENTAGE_H = 265,
-    COSLAYOUT_TOKEN_COORD_PERCENTAGE_V = 266,
-    COSLAYOUT_TOKEN_NIL = 267,
-    COSLAYOUT_TOKEN_ADD_ASSIGN = 268,
-    COSLAYOUT_TOKEN_SUB_ASSIGN = 269,
-    COSLAYOUT_TOKEN_MUL_ASSIGN = 270,
-    COSLAYOUT_TOKEN_DIV_ASSIGN = 271
-  };
-#endif
 
-/* Value type.  */
-#if ! defined COSLAYOUTSTYPE && ! defined COSLAYOUTSTYPE_IS_DECLARED
-typedef COSLAYOUT_AST * COSLAYOUTSTYPE;
-# define COSLAYOUTSTYPE_IS_TRIVIAL 1
-# define COSLAYOUTSTYPE_IS_DECLARED 1
+#ifdef short
+# undef short
 #endif
 
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
 
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
 
-int coslayoutparse (void *scanner, COSLAYOUT_AST **astpp);
-
-#endif /* !YY_COSLAYOUT_COSLAYOUTPARSER_H_INCLUDED  */
-
-/* Copy the second part of user declarations.  */
-
-#line 185 "COSLayoutParser.c" /* yacc.c:358  */
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
 
-#ifdef short
-# undef short
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
 #endif
 
-#ifdef YYTYPE_UINT8
-typedef YYTYPE_UINT8 yytype_uint8;
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
 #else
-typedef unsigned char yytype_uint8;
+typedef short yytype_int16;
 #endif
 
-#ifdef YYTYPE_INT8
-typedef YYTYPE_INT8 yytype_int8;
-#else
-typedef signed char yytype_int8;
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
 #endif
 
-#ifdef YYTYPE_UINT16
-typedef YYTYPE_UINT16 yytype_uint16;
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
 #else
-typedef unsigned short int yytype_uint16;
+typedef short yytype_uint8;
 #endif
 
-#ifdef YYTYPE_INT16
-typedef YYTYPE_INT16 yytype_int16;
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
 #else
-typedef short int yytype_int16;
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
 #endif
 
 #ifndef YYSIZE_T
@@ -216,15 +258,28 @@ typedef short int yytype_int16;
 #  define YYSIZE_T __SIZE_TYPE__
 # elif defined size_t
 #  define YYSIZE_T size_t
-# elif ! defined YYSIZE_T
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
 #  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
 #  define YYSIZE_T size_t
 # else
-#  define YYSIZE_T unsigned int
+#  define YYSIZE_T unsigned
 # endif
 #endif
 
-#define YYSIZE_MAXIMUM ((YYSIZE_T) -1)
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_int8 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
 
 #ifndef YY_
 # if defined YYENABLE_NLS && YYENABLE_NLS
@@ -238,47 +293,43 @@ typedef short int yytype_int16;
 # endif
 #endif
 
-#ifndef YY_ATTRIBUTE
-# if (defined __GNUC__                                               \
-      && (2 < __GNUC__ || (__GNUC__ == 2 && 96 <= __GNUC_MINOR__)))  \
-     || defined __SUNPRO_C && 0x5110 <= __SUNPRO_C
-#  define YY_ATTRIBUTE(Spec) __attribute__(Spec)
-# else
-#  define YY_ATTRIBUTE(Spec) /* empty */
-# endif
-#endif
 
 #ifndef YY_ATTRIBUTE_PURE
-# define YY_ATTRIBUTE_PURE   YY_ATTRIBUTE ((__pure__))
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
 #endif
 
 #ifndef YY_ATTRIBUTE_UNUSED
-# define YY_ATTRIBUTE_UNUSED YY_ATTRIBUTE ((__unused__))
-#endif
-
-#if !defined _Noreturn \
-     && (!defined __STDC_VERSION__ || __STDC_VERSION__ < 201112)
-# if defined _MSC_VER && 1200 <= _MSC_VER
-#  define _Noreturn __declspec (noreturn)
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
 # else
-#  define _Noreturn YY_ATTRIBUTE ((__noreturn__))
+#  define YY_ATTRIBUTE_UNUSED
 # endif
 #endif
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN \
-    _Pragma ("GCC diagnostic push") \
-    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")\
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
-# define YY_IGNORE_MAYBE_UNINITIALIZED_END \
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
 # define YY_INITIAL_VALUE(Value) Value
@@ -291,8 +342,22 @@ typedef short int yytype_int16;
 # define YY_INITIAL_VALUE(Value) /* Nothing. */
 #endif
 
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if !defined yyoverflow
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -357,8 +422,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* !defined yyoverflow */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -367,17 +431,17 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 /* A type that is properly aligned for any stack member.  */
 union yyalloc
 {
-  yytype_int16 yyss_alloc;
+  yy_state_t yyss_alloc;
   YYSTYPE yyvs_alloc;
 };
 
 /* The size of the maximum gap between one aligned stack and the next.  */
-# define YYSTACK_GAP_MAXIMUM (sizeof (union yyalloc) - 1)
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
 
 /* The size of an array large to enough to hold all stacks, each with
    N elements.  */
 # define YYSTACK_BYTES(N) \
-     ((N) * (sizeof (yytype_int16) + sizeof (YYSTYPE)) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
       + YYSTACK_GAP_MAXIMUM)
 
 # define YYCOPY_NEEDED 1
@@ -390,11 +454,11 @@ union yyalloc
 # define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
     do                                                                  \
       {                                                                 \
-        YYSIZE_T yynewbytes;                                            \
+        YYPTRDIFF_T yynewbytes;                                         \
         YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
         Stack = &yyptr->Stack_alloc;                                    \
-        yynewbytes = yystacksize * sizeof (*Stack) + YYSTACK_GAP_MAXIMUM; \
-        yyptr += yynewbytes / sizeof (*yyptr);                          \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
       }                                                                 \
     while (0)
 
@@ -406,12 +470,12 @@ union yyalloc
 # ifndef YYCOPY
 #  if defined __GNUC__ && 1 < __GNUC__
 #   define YYCOPY(Dst, Src, Count) \
-      __builtin_memcpy (Dst, Src, (Count) * sizeof (*(Src)))
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
 #  else
 #   define YYCOPY(Dst, Src, Count)              \
       do                                        \
         {                                       \
-          YYSIZE_T yyi;                         \
+          YYPTRDIFF_T yyi;                      \
           for (yyi = 0; yyi < (Count); yyi++)   \
             (Dst)[yyi] = (Src)[yyi];            \
         }                                       \
@@ -421,38 +485,41 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  24
+#define YYFINAL  31
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   88
+#define YYLAST   74
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  24
+#define YYNTOKENS  38
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  6
+#define YYNNTS  10
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  27
+#define YYNRULES  42
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  36
+#define YYNSTATES  63
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   280
 
-/* YYTRANSLATE[YYX] -- Symbol number corresponding to YYX as returned
-   by yylex, with out-of-bounds checking.  */
-#define YYUNDEFTOK  2
-#define YYMAXUTOK   271
 
-#define YYTRANSLATE(YYX)                                                \
-  ((unsigned int) (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
-   as returned by yylex, without out-of-bounds checking.  */
-static const yytype_uint8 yytranslate[] =
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
 {
        0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-      22,    23,    19,    17,     2,    18,     2,    20,     2,     2,
-       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
-       2,    21,     2,     2,     2,     2,     2,     2,     2,     2,
+      35,    36,    33,    31,    37,    32,     2,    34,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,    28,     2,
+      29,    26,    30,    27,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
@@ -473,180 +540,200 @@ static const yytype_uint8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
        5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
-      15,    16
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25
 };
 
 #if COSLAYOUTDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    70,    70,    71,    72,    73,    77,    78,    79,    80,
-      81,    85,    86,    87,    91,    92,    93,    97,    98,    99,
-     100,   101,   102,   103,   104,   105,   106,   107
+       0,   118,   118,   122,   123,   124,   125,   129,   130,   131,
+     132,   133,   137,   138,   142,   143,   144,   145,   146,   147,
+     148,   152,   153,   154,   158,   159,   160,   164,   165,   166,
+     167,   168,   169,   170,   171,   172,   173,   174,   175,   177,
+     178,   186,   187
 };
 #endif
 
-#if COSLAYOUTDEBUG || YYERROR_VERBOSE || 0
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if COSLAYOUTDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "COSLAYOUT_TOKEN_ATTR",
+  "\"end of file\"", "error", "\"invalid token\"", "COSLAYOUT_TOKEN_ATTR",
   "COSLAYOUT_TOKEN_NUMBER", "COSLAYOUT_TOKEN_PERCENTAGE",
   "COSLAYOUT_TOKEN_PERCENTAGE_H", "COSLAYOUT_TOKEN_PERCENTAGE_V",
   "COSLAYOUT_TOKEN_COORD", "COSLAYOUT_TOKEN_COORD_PERCENTAGE",
   "COSLAYOUT_TOKEN_COORD_PERCENTAGE_H",
   "COSLAYOUT_TOKEN_COORD_PERCENTAGE_V", "COSLAYOUT_TOKEN_NIL",
   "COSLAYOUT_TOKEN_ADD_ASSIGN", "COSLAYOUT_TOKEN_SUB_ASSIGN",
-  "COSLAYOUT_TOKEN_MUL_ASSIGN", "COSLAYOUT_TOKEN_DIV_ASSIGN", "'+'", "'-'",
-  "'*'", "'/'", "'='", "'('", "')'", "$accept", "expr", "assign", "rval",
-  "item", "atom", YY_NULLPTR
+  "COSLAYOUT_TOKEN_MUL_ASSIGN", "COSLAYOUT_TOKEN_DIV_ASSIGN",
+  "COSLAYOUT_TOKEN_PARAM", "COSLAYOUT_TOKEN_REFERENCE",
+  "COSLAYOUT_TOKEN_LE", "COSLAYOUT_TOKEN_GE", "COSLAYOUT_TOKEN_EQ",
+  "COSLAYOUT_TOKEN_NE", "COSLAYOUT_TOKEN_MIN", "COSLAYOUT_TOKEN_MAX",
+  "COSLAYOUT_TOKEN_CLAMP", "'='", "'?'", "':'", "'<'", "'>'", "'+'", "'-'",
+  "'*'", "'/'", "'('", "')'", "','", "$accept", "rule", "expr", "assign",
+  "rval", "test", "sum", "item", "atom", "args", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_uint16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,    43,    45,    42,
-      47,    61,    40,    41
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF -9
+#define YYPACT_NINF (-33)
 
-#define yypact_value_is_default(Yystate) \
-  (!!((Yystate) == (-9)))
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF -3
+#define YYTABLE_NINF (-4)
 
-#define yytable_value_is_error(Yytable_value) \
+#define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int8 yypact[] =
 {
-      24,    -9,    67,    -9,    -9,    -9,    -9,    -9,    -9,    -9,
-      -9,    -9,    44,     2,    -4,    -2,    -9,    -9,    -9,    -9,
-      -9,    -9,     0,    -8,    -9,    65,    65,    65,    65,    -9,
-      -9,    -9,    -2,    -2,    -9,    -9
+      16,   -33,    39,   -33,   -33,   -33,   -33,   -33,   -33,   -33,
+     -33,   -33,   -33,   -33,    32,    31,   -33,   -33,     5,    40,
+     -26,   -33,   -33,   -33,   -33,   -33,   -33,    32,    16,    12,
+      20,   -33,    32,    32,    32,    32,    32,    32,    32,    32,
+      32,    32,    32,   -33,   -27,   -33,   -33,    29,   -20,   -20,
+     -20,   -20,   -20,   -20,   -26,   -26,   -33,   -33,   -33,    32,
+      32,   -33,   -33
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
-static const yytype_uint8 yydefact[] =
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_int8 yydefact[] =
 {
-       0,     3,    17,    18,    19,    20,    21,    22,    23,    24,
-      25,    26,     0,     0,     5,    13,    16,     7,     8,     9,
-      10,     6,     0,     0,     1,     0,     0,     0,     0,     4,
-      27,    17,    11,    12,    14,    15
+       0,     4,    27,    28,    29,    30,    31,    32,    33,    34,
+      35,    36,    37,    38,     0,     0,     2,     6,    12,    14,
+      23,    26,     8,     9,    10,    11,     7,     0,     0,    27,
+       0,     1,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,    41,     0,     5,    39,     0,    17,    18,
+      19,    20,    15,    16,    21,    22,    24,    25,    40,     0,
+       0,    42,    13
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
+/* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-      -9,     4,    -9,    -9,    -6,    10
+     -33,   -33,    30,   -33,   -14,   -33,   -32,   -25,   -12,   -33
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
+/* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-      -1,    13,    22,    14,    15,    16
+       0,    15,    16,    28,    17,    18,    19,    20,    21,    44
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int8 yytable[] =
 {
-      -2,     1,    24,     2,     3,     4,     5,     6,     7,     8,
-       9,    10,    11,    25,    26,    30,    23,    27,    28,    32,
-      33,     0,    12,    -2,    -2,     1,    29,     2,     3,     4,
-       5,     6,     7,     8,     9,    10,    11,    34,    35,     0,
-       0,     0,     0,     0,     0,     1,    12,     2,     3,     4,
-       5,     6,     7,     8,     9,    10,    11,     0,     0,     0,
-       0,     0,     0,     0,     0,     0,    12,    -2,    31,     3,
-       4,     5,     6,     7,     8,     9,    10,    11,     0,     0,
-      17,    18,    19,    20,     0,     0,     0,    12,    21
+      30,    48,    49,    50,    51,    52,    53,    41,    42,    58,
+      59,    39,    40,    43,    54,    55,    -3,     1,    47,     2,
+       3,     4,     5,     6,     7,     8,     9,    10,    11,    56,
+      57,    31,    32,    12,    13,    29,     3,     4,     5,     6,
+       7,     8,     9,    10,    11,    61,    62,    27,     0,    12,
+      13,    14,    22,    23,    24,    25,    46,    60,    45,    33,
+      34,    35,    36,     0,     0,    26,     0,    14,     0,    37,
+      38,    39,    40,     0,    27
 };
 
 static const yytype_int8 yycheck[] =
 {
-       0,     1,     0,     3,     4,     5,     6,     7,     8,     9,
-      10,    11,    12,    17,    18,    23,    12,    19,    20,    25,
-      26,    -1,    22,    23,     0,     1,    22,     3,     4,     5,
-       6,     7,     8,     9,    10,    11,    12,    27,    28,    -1,
-      -1,    -1,    -1,    -1,    -1,     1,    22,     3,     4,     5,
-       6,     7,     8,     9,    10,    11,    12,    -1,    -1,    -1,
-      -1,    -1,    -1,    -1,    -1,    -1,    22,    23,     3,     4,
-       5,     6,     7,     8,     9,    10,    11,    12,    -1,    -1,
-      13,    14,    15,    16,    -1,    -1,    -1,    22,    21
+      14,    33,    34,    35,    36,    37,    38,    33,    34,    36,
+      37,    31,    32,    27,    39,    40,     0,     1,    32,     3,
+       4,     5,     6,     7,     8,     9,    10,    11,    12,    41,
+      42,     0,    27,    17,    18,     3,     4,     5,     6,     7,
+       8,     9,    10,    11,    12,    59,    60,    35,    -1,    17,
+      18,    35,    13,    14,    15,    16,    36,    28,    28,    19,
+      20,    21,    22,    -1,    -1,    26,    -1,    35,    -1,    29,
+      30,    31,    32,    -1,    35
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
-static const yytype_uint8 yystos[] =
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_int8 yystos[] =
 {
        0,     1,     3,     4,     5,     6,     7,     8,     9,    10,
-      11,    12,    22,    25,    27,    28,    29,    13,    14,    15,
-      16,    21,    26,    25,     0,    17,    18,    19,    20,    25,
-      23,     3,    28,    28,    29,    29
+      11,    12,    17,    18,    35,    39,    40,    42,    43,    44,
+      45,    46,    13,    14,    15,    16,    26,    35,    41,     3,
+      42,     0,    27,    19,    20,    21,    22,    29,    30,    31,
+      32,    33,    34,    42,    47,    40,    36,    42,    44,    44,
+      44,    44,    44,    44,    45,    45,    46,    46,    36,    37,
+      28,    42,    42
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
-static const yytype_uint8 yyr1[] =
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr1[] =
 {
-       0,    24,    25,    25,    25,    25,    26,    26,    26,    26,
-      26,    27,    27,    27,    28,    28,    28,    29,    29,    29,
-      29,    29,    29,    29,    29,    29,    29,    29
+       0,    38,    39,    40,    40,    40,    40,    41,    41,    41,
+      41,    41,    42,    42,    43,    43,    43,    43,    43,    43,
+      43,    44,    44,    44,    45,    45,    45,    46,    46,    46,
+      46,    46,    46,    46,    46,    46,    46,    46,    46,    46,
+      46,    47,    47
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
-static const yytype_uint8 yyr2[] =
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
 {
-       0,     2,     0,     1,     3,     1,     1,     1,     1,     1,
-       1,     3,     3,     1,     3,     3,     1,     1,     1,     1,
-       1,     1,     1,     1,     1,     1,     1,     3
+       0,     2,     1,     0,     1,     3,     1,     1,     1,     1,
+       1,     1,     1,     5,     1,     3,     3,     3,     3,     3,
+       3,     3,     3,     1,     3,     3,     1,     1,     1,     1,
+       1,     1,     1,     1,     1,     1,     1,     1,     1,     3,
+       4,     1,     3
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
-#define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
+#define yyclearin       (yychar = COSLAYOUTEMPTY)
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
 
-#define YYBACKUP(Token, Value)                                  \
-do                                                              \
-  if (yychar == YYEMPTY)                                        \
-    {                                                           \
-      yychar = (Token);                                         \
-      yylval = (Value);                                         \
-      YYPOPSTACK (yylen);                                       \
-      yystate = *yyssp;                                         \
-      goto yybackup;                                            \
-    }                                                           \
-  else                                                          \
-    {                                                           \
-      yyerror (scanner, astpp, YY_("syntax error: cannot back up")); \
-      YYERROR;                                                  \
-    }                                                           \
-while (0)
-
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == COSLAYOUTEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (scanner, astpp, YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use COSLAYOUTerror or COSLAYOUTUNDEF. */
+#define YYERRCODE COSLAYOUTUNDEF
 
 
 /* Enable debugging if requested.  */
@@ -663,57 +750,54 @@ do {                                            \
     YYFPRINTF Args;                             \
 } while (0)
 
-/* This macro is provided for backward compatibility. */
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
 
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, scanner, astpp); \
+                  Kind, Value, scanner, astpp); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
 
 
-/*----------------------------------------.
-| Print this symbol's value on YYOUTPUT.  |
-`----------------------------------------*/
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, void *scanner, COSLAYOUT_AST **astpp)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, void *scanner, COSLAYOUT_AST **astpp)
 {
-  FILE *yyo = yyoutput;
-  YYUSE (yyo);
-  YYUSE (scanner);
-  YYUSE (astpp);
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  YY_USE (scanner);
+  YY_USE (astpp);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyoutput, yytoknum[yytype], *yyvaluep);
-# endif
-  YYUSE (yytype);
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
-/*--------------------------------.
-| Print this symbol on YYOUTPUT.  |
-`--------------------------------*/
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, void *scanner, COSLAYOUT_AST **astpp)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, void *scanner, COSLAYOUT_AST **astpp)
 {
-  YYFPRINTF (yyoutput, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep, scanner, astpp);
-  YYFPRINTF (yyoutput, ")");
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner, astpp);
+  YYFPRINTF (yyo, ")");
 }
 
 /*------------------------------------------------------------------.
@@ -722,7 +806,7 @@ yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, voi
 `------------------------------------------------------------------*/
 
 static void
-yy_stack_print (yytype_int16 *yybottom, yytype_int16 *yytop)
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
 {
   YYFPRINTF (stderr, "Stack now");
   for (; yybottom <= yytop; yybottom++)
@@ -745,21 +829,21 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, int yyrule, void *scanner, COSLAYOUT_AST **astpp)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule, void *scanner, COSLAYOUT_AST **astpp)
 {
-  unsigned long int yylno = yyrline[yyrule];
+  int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
   int yyi;
-  YYFPRINTF (stderr, "Reducing stack by rule %d (line %lu):\n",
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
              yyrule - 1, yylno);
   /* The symbols being reduced.  */
   for (yyi = 0; yyi < yynrhs; yyi++)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[yyssp[yyi + 1 - yynrhs]],
-                       &(yyvsp[(yyi + 1) - (yynrhs)])
-                                              , scanner, astpp);
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner, astpp);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -774,8 +858,8 @@ do {                                    \
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !COSLAYOUTDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !COSLAYOUTDEBUG */
@@ -798,250 +882,159 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
-
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen strlen
-#  else
-/* Return the length of YYSTR.  */
-static YYSIZE_T
-yystrlen (const char *yystr)
-{
-  YYSIZE_T yylen;
-  for (yylen = 0; yystr[yylen]; yylen++)
-    continue;
-  return yylen;
-}
-#  endif
-# endif
-
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
-/* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
-   YYDEST.  */
-static char *
-yystpcpy (char *yydest, const char *yysrc)
-{
-  char *yyd = yydest;
-  const char *yys = yysrc;
-
-  while ((*yyd++ = *yys++) != '\0')
-    continue;
 
-  return yyd - 1;
-}
-#  endif
-# endif
 
-# ifndef yytnamerr
-/* Copy to YYRES the contents of YYSTR after stripping away unnecessary
-   quotes and backslashes, so that it's suitable for yyerror.  The
-   heuristic is that double-quoting is unnecessary unless the string
-   contains an apostrophe, a comma, or backslash (other than
-   backslash-backslash).  YYSTR is taken from yytname.  If YYRES is
-   null, do not copy; instead, return the length of what the result
-   would have been.  */
-static YYSIZE_T
-yytnamerr (char *yyres, const char *yystr)
-{
-  if (*yystr == '"')
-    {
-      YYSIZE_T yyn = 0;
-      char const *yyp = yystr;
-
-      for (;;)
-        switch (*++yyp)
-          {
-          case '\'':
-          case ',':
-            goto do_not_strip_quotes;
-
-          case '\\':
-            if (*++yyp != '\\')
-              goto do_not_strip_quotes;
-            /* Fall through.  */
-          default:
-            if (yyres)
-              yyres[yyn] = *yyp;
-            yyn++;
-            break;
-
-          case '"':
-            if (yyres)
-              yyres[yyn] = '\0';
-            return yyn;
-          }
-    do_not_strip_quotes: ;
-    }
 
-  if (! yyres)
-    return yystrlen (yystr);
-
-  return yystpcpy (yyres, yystr) - yyres;
-}
-# endif
-
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
-
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
-static int
-yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
-                yytype_int16 *yyssp, int yytoken)
-{
-  YYSIZE_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-  YYSIZE_T yysize = yysize0;
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat. */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
-  /* Number of reported tokens (one for the "unexpected", one per
-     "expected"). */
-  int yycount = 0;
-
-  /* There are many possibilities here to consider:
-     - If this state is a consistent state with a default action, then
-       the only way this function was invoked is if the default action
-       is an error action.  In that case, don't check for expected
-       tokens because there are none.
-     - The only way there can be no lookahead present (in yychar) is if
-       this state is a consistent state with a default action.  Thus,
-       detecting the absence of a lookahead is sufficient to determine
-       that there is no unexpected or expected token to report.  In that
-       case, just report a simple "syntax error".
-     - Don't assume there isn't a lookahead just because this state is a
-       consistent state with a default action.  There might have been a
-       previous inconsistent state, consistent state with a non-default
-       action, or user semantic action that manipulated yychar.
-     - Of course, the expected token list depends on states to have
-       correct lookahead information, and it depends on the parser not
-       to perform extra reductions after fetching a lookahead from the
-       scanner and before detecting a syntax error.  Thus, state merging
-       (from LALR or IELR) and default reductions corrupt the expected
-       token list.  However, the list is correct for canonical LR with
-       one exception: it will still contain any token that will not be
-       accepted due to an error action in a later state.
-  */
-  if (yytoken != YYEMPTY)
-    {
-      int yyn = yypact[*yyssp];
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYSIZE_T yysize1 = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (! (yysize <= yysize1
-                         && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-                    return 2;
-                  yysize = yysize1;
-                }
-              }
-        }
-    }
-
-  switch (yycount)
-    {
-# define YYCASE_(N, S)                      \
-      case N:                               \
-        yyformat = S;                       \
-      break
-      YYCASE_(0, YY_("syntax error"));
-      YYCASE_(1, YY_("syntax error, unexpected %s"));
-      YYCASE_(2, YY_("syntax error, unexpected %s, expecting %s"));
-      YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
-      YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
-      YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
-    }
-
-  {
-    YYSIZE_T yysize1 = yysize + yystrlen (yyformat);
-    if (! (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM))
-      return 2;
-    yysize = yysize1;
-  }
-
-  if (*yymsg_alloc < yysize)
-    {
-      *yymsg_alloc = 2 * yysize;
-      if (! (yysize <= *yymsg_alloc
-             && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
-        *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
-    }
-
-  /* Avoid sprintf, as that infringes on the user's name space.
-     Don't have undefined behavior even if the translation
-     produced a string with the wrong number of "%s"s.  */
-  {
-    char *yyp = *yymsg;
-    int yyi = 0;
-    while ((*yyp = *yyformat) != '\0')
-      if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
-        {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
-          yyformat += 2;
-        }
-      else
-        {
-          yyp++;
-          yyformat++;
-        }
-  }
-  return 0;
-}
-#endif /* YYERROR_VERBOSE */
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, void *scanner, COSLAYOUT_AST **astpp)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, void *scanner, COSLAYOUT_AST **astpp)
 {
-  YYUSE (yyvaluep);
-  YYUSE (scanner);
-  YYUSE (astpp);
+  YY_USE (yyvaluep);
+  YY_USE (scanner);
+  YY_USE (astpp);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  switch (yykind)
+    {
+    case YYSYMBOL_COSLAYOUT_TOKEN_ATTR: /* COSLAYOUT_TOKEN_ATTR  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 911 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_NUMBER: /* COSLAYOUT_TOKEN_NUMBER  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 917 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_PERCENTAGE: /* COSLAYOUT_TOKEN_PERCENTAGE  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 923 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_PERCENTAGE_H: /* COSLAYOUT_TOKEN_PERCENTAGE_H  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 929 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_PERCENTAGE_V: /* COSLAYOUT_TOKEN_PERCENTAGE_V  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 935 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_COORD: /* COSLAYOUT_TOKEN_COORD  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 941 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_COORD_PERCENTAGE: /* COSLAYOUT_TOKEN_COORD_PERCENTAGE  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 947 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_COORD_PERCENTAGE_H: /* COSLAYOUT_TOKEN_COORD_PERCENTAGE_H  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 953 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_COORD_PERCENTAGE_V: /* COSLAYOUT_TOKEN_COORD_PERCENTAGE_V  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 959 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_NIL: /* COSLAYOUT_TOKEN_NIL  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 965 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_PARAM: /* COSLAYOUT_TOKEN_PARAM  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 971 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_COSLAYOUT_TOKEN_REFERENCE: /* COSLAYOUT_TOKEN_REFERENCE  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 977 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_expr: /* expr  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 983 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_assign: /* assign  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 989 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_rval: /* rval  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 995 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_test: /* test  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 1001 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_sum: /* sum  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 1007 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_item: /* item  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 1013 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_atom: /* atom  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 1019 "COSLayoutParser.c"
+        break;
+
+    case YYSYMBOL_args: /* args  */
+#line 107 "COSLayoutParser.y"
+            { coslayout_destroy_ast((*yyvaluep)); }
+#line 1025 "COSLayoutParser.c"
+        break;
+
+      default:
+        break;
+    }
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
 
 
 
+
+
 /*----------.
 | yyparse.  |
 `----------*/
@@ -1049,7 +1042,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, void *scanner, COS
 int
 yyparse (void *scanner, COSLAYOUT_AST **astpp)
 {
-/* The lookahead symbol.  */
+/* Lookahead token kind.  */
 int yychar;
 
 
@@ -1060,45 +1053,38 @@ YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
 YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
 
     /* Number of syntax errors so far.  */
-    int yynerrs;
+    int yynerrs = 0;
 
-    int yystate;
+    yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
-
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
+    int yyerrstatus = 0;
 
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
-    yytype_int16 yyssa[YYINITDEPTH];
-    yytype_int16 *yyss;
-    yytype_int16 *yyssp;
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
 
-    /* The semantic value stack.  */
-    YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    YYSIZE_T yystacksize;
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
-  /* Buffer for error messages, and its allocated size.  */
-  char yymsgbuf[128];
-  char *yymsg = yymsgbuf;
-  YYSIZE_T yymsg_alloc = sizeof yymsgbuf;
-#endif
+
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1106,71 +1092,75 @@ YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
-  yychar = YYEMPTY; /* Cause a token to be read.  */
+  yychar = COSLAYOUTEMPTY; /* Cause a token to be read.  */
+
   goto yysetstate;
 
+
 /*------------------------------------------------------------.
-| yynewstate -- Push a new state, which is found in yystate.  |
+| yynewstate -- push a new state, which is found in yystate.  |
 `------------------------------------------------------------*/
- yynewstate:
+yynewstate:
   /* In all cases, when you get here, the value and location stacks
      have just been pushed.  So pushing a state here evens the stacks.  */
   yyssp++;
 
- yysetstate:
-  *yyssp = yystate;
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
     {
       /* Get the current used size of the three stacks, in elements.  */
-      YYSIZE_T yysize = yyssp - yyss + 1;
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
 
-#ifdef yyoverflow
+# if defined yyoverflow
       {
         /* Give user a chance to reallocate the stack.  Use copies of
            these so that the &'s don't force the real ones into
            memory.  */
+        yy_state_t *yyss1 = yyss;
         YYSTYPE *yyvs1 = yyvs;
-        yytype_int16 *yyss1 = yyss;
 
         /* Each stack pointer address is followed by the size of the
            data in use in that stack, in bytes.  This used to be a
            conditional around just the two extra args, but that might
            be undefined if yyoverflow is a macro.  */
         yyoverflow (YY_("memory exhausted"),
-                    &yyss1, yysize * sizeof (*yyssp),
-                    &yyvs1, yysize * sizeof (*yyvsp),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
                     &yystacksize);
-
         yyss = yyss1;
         yyvs = yyvs1;
       }
-#else /* no yyoverflow */
-# ifndef YYSTACK_RELOCATE
-      goto yyexhaustedlab;
-# else
+# else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
 
       {
-        yytype_int16 *yyss1 = yyss;
+        yy_state_t *yyss1 = yyss;
         union yyalloc *yyptr =
-          (union yyalloc *) YYSTACK_ALLOC (YYSTACK_BYTES (yystacksize));
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
 #  undef YYSTACK_RELOCATE
@@ -1178,30 +1168,31 @@ YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
           YYSTACK_FREE (yyss1);
       }
 # endif
-#endif /* no yyoverflow */
 
       yyssp = yyss + yysize - 1;
       yyvsp = yyvs + yysize - 1;
 
-      YYDPRINTF ((stderr, "Stack size increased to %lu\n",
-                  (unsigned long int) yystacksize));
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
 
       if (yyss + yystacksize - 1 <= yyssp)
         YYABORT;
     }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
-  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
 
   if (yystate == YYFINAL)
     YYACCEPT;
 
   goto yybackup;
 
+
 /*-----------.
 | yybackup.  |
 `-----------*/
 yybackup:
-
   /* Do appropriate processing given the current state.  Read a
      lookahead token if we need one and don't already have one.  */
 
@@ -1212,18 +1203,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
-  if (yychar == YYEMPTY)
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
+  if (yychar == COSLAYOUTEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
+      YYDPRINTF ((stderr, "Reading a token\n"));
       yychar = yylex (&yylval, scanner, astpp);
     }
 
-  if (yychar <= YYEOF)
+  if (yychar <= COSLAYOUTEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = COSLAYOUTEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == COSLAYOUTerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = COSLAYOUTUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1251,15 +1253,13 @@ yybackup:
 
   /* Shift the lookahead token.  */
   YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
-
-  /* Discard the shifted token.  */
-  yychar = YYEMPTY;
-
   yystate = yyn;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
   *++yyvsp = yylval;
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 
+  /* Discard the shifted token.  */
+  yychar = COSLAYOUTEMPTY;
   goto yynewstate;
 
 
@@ -1274,7 +1274,7 @@ yydefault:
 
 
 /*-----------------------------.
-| yyreduce -- Do a reduction.  |
+| yyreduce -- do a reduction.  |
 `-----------------------------*/
 yyreduce:
   /* yyn is the number of a rule to reduce with.  */
@@ -1294,158 +1294,259 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-        case 3:
-#line 71 "COSLayoutParser.y" /* yacc.c:1661  */
-    { coslayout_destroy_ast(*astpp); *astpp = NULL; YYABORT; }
-#line 1301 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 2: /* rule: expr  */
+#line 118 "COSLayoutParser.y"
+           { *astpp = yyval = yyvsp[0]; }
+#line 1301 "COSLayoutParser.c"
+    break;
+
+  case 3: /* expr: %empty  */
+#line 122 "COSLayoutParser.y"
+             { yyval = NULL; }
+#line 1307 "COSLayoutParser.c"
+    break;
+
+  case 4: /* expr: error  */
+#line 123 "COSLayoutParser.y"
+            { *astpp = yyval = NULL; YYABORT; }
+#line 1313 "COSLayoutParser.c"
+    break;
+
+  case 5: /* expr: COSLAYOUT_TOKEN_ATTR assign expr  */
+#line 124 "COSLayoutParser.y"
+                                       { *astpp = yyval = coslayout_create_ast(yyvsp[-1]->node_type, yyvsp[-2], yyvsp[0]); free(yyvsp[-1]); }
+#line 1319 "COSLayoutParser.c"
+    break;
+
+  case 6: /* expr: rval  */
+#line 125 "COSLayoutParser.y"
+           { *astpp = yyval = yyvsp[0]; }
+#line 1325 "COSLayoutParser.c"
+    break;
+
+  case 7: /* assign: '='  */
+#line 129 "COSLayoutParser.y"
+          { *astpp = yyval = coslayout_create_ast('=', NULL, NULL); }
+#line 1331 "COSLayoutParser.c"
+    break;
+
+  case 8: /* assign: COSLAYOUT_TOKEN_ADD_ASSIGN  */
+#line 130 "COSLayoutParser.y"
+                                 { *astpp = yyval = coslayout_create_ast(COSLAYOUT_TOKEN_ADD_ASSIGN, NULL, NULL); }
+#line 1337 "COSLayoutParser.c"
+    break;
+
+  case 9: /* assign: COSLAYOUT_TOKEN_SUB_ASSIGN  */
+#line 131 "COSLayoutParser.y"
+                                 { *astpp = yyval = coslayout_create_ast(COSLAYOUT_TOKEN_SUB_ASSIGN, NULL, NULL); }
+#line 1343 "COSLayoutParser.c"
     break;
 
-  case 4:
-#line 72 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast((yyvsp[-1])->node_type, (yyvsp[-2]), (yyvsp[0])); }
-#line 1307 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 10: /* assign: COSLAYOUT_TOKEN_MUL_ASSIGN  */
+#line 132 "COSLayoutParser.y"
+                                 { *astpp = yyval = coslayout_create_ast(COSLAYOUT_TOKEN_MUL_ASSIGN, NULL, NULL); }
+#line 1349 "COSLayoutParser.c"
     break;
 
-  case 5:
-#line 73 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1313 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 11: /* assign: COSLAYOUT_TOKEN_DIV_ASSIGN  */
+#line 133 "COSLayoutParser.y"
+                                 { *astpp = yyval = coslayout_create_ast(COSLAYOUT_TOKEN_DIV_ASSIGN, NULL, NULL); }
+#line 1355 "COSLayoutParser.c"
     break;
 
-  case 6:
-#line 77 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast('=', NULL, NULL); }
-#line 1319 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 12: /* rval: test  */
+#line 137 "COSLayoutParser.y"
+           { *astpp = yyval = yyvsp[0]; }
+#line 1361 "COSLayoutParser.c"
     break;
 
-  case 7:
-#line 78 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast(COSLAYOUT_TOKEN_ADD_ASSIGN, NULL, NULL); }
-#line 1325 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 13: /* rval: test '?' rval ':' rval  */
+#line 138 "COSLayoutParser.y"
+                             { *astpp = yyval = coslayout_create_ast('?', yyvsp[-4], coslayout_create_ast(':', yyvsp[-2], yyvsp[0])); }
+#line 1367 "COSLayoutParser.c"
     break;
 
-  case 8:
-#line 79 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast(COSLAYOUT_TOKEN_SUB_ASSIGN, NULL, NULL); }
-#line 1331 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 14: /* test: sum  */
+#line 142 "COSLayoutParser.y"
+          { *astpp = yyval = yyvsp[0]; }
+#line 1373 "COSLayoutParser.c"
     break;
 
-  case 9:
-#line 80 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast(COSLAYOUT_TOKEN_MUL_ASSIGN, NULL, NULL); }
-#line 1337 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 15: /* test: sum '<' sum  */
+#line 143 "COSLayoutParser.y"
+                  { *astpp = yyval = coslayout_create_ast('<', yyvsp[-2], yyvsp[0]); }
+#line 1379 "COSLayoutParser.c"
     break;
 
-  case 10:
-#line 81 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast(COSLAYOUT_TOKEN_DIV_ASSIGN, NULL, NULL); }
-#line 1343 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 16: /* test: sum '>' sum  */
+#line 144 "COSLayoutParser.y"
+                  { *astpp = yyval = coslayout_create_ast('>', yyvsp[-2], yyvsp[0]); }
+#line 1385 "COSLayoutParser.c"
     break;
 
-  case 11:
-#line 85 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast('+', (yyvsp[-2]), (yyvsp[0])); }
-#line 1349 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 17: /* test: sum COSLAYOUT_TOKEN_LE sum  */
+#line 145 "COSLayoutParser.y"
+                                 { *astpp = yyval = coslayout_create_ast(COSLAYOUT_TOKEN_LE, yyvsp[-2], yyvsp[0]); }
+#line 1391 "COSLayoutParser.c"
     break;
 
-  case 12:
-#line 86 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast('-', (yyvsp[-2]), (yyvsp[0])); }
-#line 1355 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 18: /* test: sum COSLAYOUT_TOKEN_GE sum  */
+#line 146 "COSLayoutParser.y"
+                                 { *astpp = yyval = coslayout_create_ast(COSLAYOUT_TOKEN_GE, yyvsp[-2], yyvsp[0]); }
+#line 1397 "COSLayoutParser.c"
     break;
 
-  case 13:
-#line 87 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1361 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 19: /* test: sum COSLAYOUT_TOKEN_EQ sum  */
+#line 147 "COSLayoutParser.y"
+                                 { *astpp = yyval = coslayout_create_ast(COSLAYOUT_TOKEN_EQ, yyvsp[-2], yyvsp[0]); }
+#line 1403 "COSLayoutParser.c"
     break;
 
-  case 14:
-#line 91 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast('*', (yyvsp[-2]), (yyvsp[0])); }
-#line 1367 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 20: /* test: sum COSLAYOUT_TOKEN_NE sum  */
+#line 148 "COSLayoutParser.y"
+                                 { *astpp = yyval = coslayout_create_ast(COSLAYOUT_TOKEN_NE, yyvsp[-2], yyvsp[0]); }
+#line 1409 "COSLayoutParser.c"
     break;
 
-  case 15:
-#line 92 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = coslayout_create_ast('/', (yyvsp[-2]), (yyvsp[0])); }
-#line 1373 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 21: /* sum: sum '+' item  */
+#line 152 "COSLayoutParser.y"
+                   { *astpp = yyval = coslayout_create_ast('+', yyvsp[-2], yyvsp[0]); }
+#line 1415 "COSLayoutParser.c"
     break;
 
-  case 16:
-#line 93 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1379 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 22: /* sum: sum '-' item  */
+#line 153 "COSLayoutParser.y"
+                   { *astpp = yyval = coslayout_create_ast('-', yyvsp[-2], yyvsp[0]); }
+#line 1421 "COSLayoutParser.c"
     break;
 
-  case 17:
-#line 97 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1385 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 23: /* sum: item  */
+#line 154 "COSLayoutParser.y"
+           { *astpp = yyval = yyvsp[0]; }
+#line 1427 "COSLayoutParser.c"
     break;
 
-  case 18:
-#line 98 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1391 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 24: /* item: item '*' atom  */
+#line 158 "COSLayoutParser.y"
+                    { *astpp = yyval = coslayout_create_ast('*', yyvsp[-2], yyvsp[0]); }
+#line 1433 "COSLayoutParser.c"
     break;
 
-  case 19:
-#line 99 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1397 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 25: /* item: item '/' atom  */
+#line 159 "COSLayoutParser.y"
+                    { *astpp = yyval = coslayout_create_ast('/', yyvsp[-2], yyvsp[0]); }
+#line 1439 "COSLayoutParser.c"
     break;
 
-  case 20:
-#line 100 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1403 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 26: /* item: atom  */
+#line 160 "COSLayoutParser.y"
+           { *astpp = yyval = yyvsp[0]; }
+#line 1445 "COSLayoutParser.c"
     break;
 
-  case 21:
-#line 101 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1409 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 27: /* atom: COSLAYOUT_TOKEN_ATTR  */
+#line 164 "COSLayoutParser.y"
+                           { *astpp = yyval = yyvsp[0]; }
+#line 1451 "COSLayoutParser.c"
     break;
 
-  case 22:
-#line 102 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1415 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 28: /* atom: COSLAYOUT_TOKEN_NUMBER  */
+#line 165 "COSLayoutParser.y"
+                             { *astpp = yyval = yyvsp[0]; }
+#line 1457 "COSLayoutParser.c"
     break;
 
-  case 23:
-#line 103 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1421 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 29: /* atom: COSLAYOUT_TOKEN_PERCENTAGE  */
+#line 166 "COSLayoutParser.y"
+                                 { *astpp = yyval = yyvsp[0]; }
+#line 1463 "COSLayoutParser.c"
     break;
 
-  case 24:
-#line 104 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1427 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 30: /* atom: COSLAYOUT_TOKEN_PERCENTAGE_H  */
+#line 167 "COSLayoutParser.y"
+                                   { *astpp = yyval = yyvsp[0]; }
+#line 1469 "COSLayoutParser.c"
     break;
 
-  case 25:
-#line 105 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1433 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 31: /* atom: COSLAYOUT_TOKEN_PERCENTAGE_V  */
+#line 168 "COSLayoutParser.y"
+                                   { *astpp = yyval = yyvsp[0]; }
+#line 1475 "COSLayoutParser.c"
     break;
 
-  case 26:
-#line 106 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[0]); }
-#line 1439 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 32: /* atom: COSLAYOUT_TOKEN_COORD  */
+#line 169 "COSLayoutParser.y"
+                            { *astpp = yyval = yyvsp[0]; }
+#line 1481 "COSLayoutParser.c"
     break;
 
-  case 27:
-#line 107 "COSLayoutParser.y" /* yacc.c:1661  */
-    { *astpp = (yyval) = (yyvsp[-1]); }
-#line 1445 "COSLayoutParser.c" /* yacc.c:1661  */
+  case 33: /* atom: COSLAYOUT_TOKEN_COORD_PERCENTAGE  */
+#line 170 "COSLayoutParser.y"
+                                       { *astpp = yyval = yyvsp[0]; }
+#line 1487 "COSLayoutParser.c"
     break;
 
+  case 34: /* atom: COSLAYOUT_TOKEN_COORD_PERCENTAGE_H  */
+#line 171 "COSLayoutParser.y"
+                                         { *astpp = yyval = yyvsp[0]; }
+#line 1493 "COSLayoutParser.c"
+    break;
+
+  case 35: /* atom: COSLAYOUT_TOKEN_COORD_PERCENTAGE_V  */
+#line 172 "COSLayoutParser.y"
+                                         { *astpp = yyval = yyvsp[0]; }
+#line 1499 "COSLayoutParser.c"
+    break;
+
+  case 36: /* atom: COSLAYOUT_TOKEN_NIL  */
+#line 173 "COSLayoutParser.y"
+                          { *astpp = yyval = yyvsp[0]; }
+#line 1505 "COSLayoutParser.c"
+    break;
+
+  case 37: /* atom: COSLAYOUT_TOKEN_PARAM  */
+#line 174 "COSLayoutParser.y"
+                            { *astpp = yyval = yyvsp[0]; }
+#line 1511 "COSLayoutParser.c"
+    break;
+
+  case 38: /* atom: COSLAYOUT_TOKEN_REFERENCE  */
+#line 175 "COSLayoutParser.y"
+                                { *astpp = yyval = yyvsp[0]; }
+#line 1517 "COSLayoutParser.c"
+    break;
+
+  case 39: /* atom: '(' rval ')'  */
+#line 177 "COSLayoutParser.y"
+                   { *astpp = yyval = yyvsp[-1]; }
+#line 1523 "COSLayoutParser.c"
+    break;
+
+  case 40: /* atom: COSLAYOUT_TOKEN_ATTR '(' args ')'  */
+#line 178 "COSLayoutParser.y"
+                                        {
+        yyval = coslayout_create_call_ast(yyvsp[-3], yyvsp[-1]);
+        *astpp = yyval;
+        if (yyval == NULL) YYERROR;
+    }
+#line 1533 "COSLayoutParser.c"
+    break;
+
+  case 41: /* args: rval  */
+#line 186 "COSLayoutParser.y"
+           { *astpp = yyval = yyvsp[0]; }
+#line 1539 "COSLayoutParser.c"
+    break;
+
+  case 42: /* args: args ',' rval  */
+#line 187 "COSLayoutParser.y"
+                    { *astpp = yyval = coslayout_create_ast(',', yyvsp[-2], yyvsp[0]); }
+#line 1545 "COSLayoutParser.c"
+    break;
+
+
+#line 1549 "COSLayoutParser.c"
 
-#line 1449 "COSLayoutParser.c" /* yacc.c:1661  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -1459,25 +1560,23 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
   /* Now 'shift' the result of the reduction.  Determine what state
      that goes to, based on the state we popped back to and the rule
      number reduced by.  */
-
-  yyn = yyr1[yyn];
-
-  yystate = yypgoto[yyn - YYNTOKENS] + *yyssp;
-  if (0 <= yystate && yystate <= YYLAST && yycheck[yystate] == *yyssp)
-    yystate = yytable[yystate];
-  else
-    yystate = yydefgoto[yyn - YYNTOKENS];
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
 
   goto yynewstate;
 
@@ -1488,66 +1587,30 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == COSLAYOUTEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
       yyerror (scanner, astpp, YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
-      {
-        char const *yymsgp = YY_("syntax error");
-        int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
-        if (yysyntax_error_status == 0)
-          yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
-          {
-            if (yymsg != yymsgbuf)
-              YYSTACK_FREE (yymsg);
-            yymsg = (char *) YYSTACK_ALLOC (yymsg_alloc);
-            if (!yymsg)
-              {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
-              }
-            else
-              {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
-              }
-          }
-        yyerror (scanner, astpp, yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
-      }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
          error, discard it.  */
 
-      if (yychar <= YYEOF)
+      if (yychar <= COSLAYOUTEOF)
         {
           /* Return failure if at end of input.  */
-          if (yychar == YYEOF)
+          if (yychar == COSLAYOUTEOF)
             YYABORT;
         }
       else
         {
           yydestruct ("Error: discarding",
                       yytoken, &yylval, scanner, astpp);
-          yychar = YYEMPTY;
+          yychar = COSLAYOUTEMPTY;
         }
     }
 
@@ -1560,6 +1623,11 @@ yyerrlab:
 | yyerrorlab -- error raised explicitly by YYERROR.  |
 `---------------------------------------------------*/
 yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -1576,13 +1644,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -1596,7 +1665,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, scanner, astpp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner, astpp);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1608,7 +1677,7 @@ yyerrlab1:
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -1619,27 +1688,31 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
+
 
 /*-----------------------------------.
 | yyabortlab -- YYABORT comes here.  |
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (scanner, astpp, YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
-yyreturn:
-  if (yychar != YYEMPTY)
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != COSLAYOUTEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
          user semantic actions for why this is necessary.  */
@@ -1654,29 +1727,58 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp, scanner, astpp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner, astpp);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
-  if (yymsg != yymsgbuf)
-    YYSTACK_FREE (yymsg);
-#endif
+
   return yyresult;
 }
-#line 110 "COSLayoutParser.y" /* yacc.c:1906  */
+
+#line 190 "COSLayoutParser.y"
 
 
 void coslayouterror(void *scanner, COSLAYOUT_AST **astpp, char *msg) {
+  (void)scanner;
+  (void)astpp;
+
   fprintf(stderr, "COSLayout: %s\n", msg);
 }
 
 int coslayoutparse (void *scanner, COSLAYOUT_AST **astpp);
-int coslayoutlex_init (yyscan_t* scanner);
-int coslayoutlex_destroy (yyscan_t yyscanner);
+
+/* Turns name into a call of a built in function on the comma separated
+ * args, or destroys both and returns NULL if the function is unknown or
+ * takes another number of arguments. */
+COSLAYOUT_AST *coslayout_create_call_ast(COSLAYOUT_AST *name, COSLAYOUT_AST *args) {
+    int count = 1;
+
+    for (COSLAYOUT_AST *arg = args; arg->node_type == ','; arg = arg->l) ++count;
+
+    int type = (strcmp(name->value.coord, "min") == 0 ? COSLAYOUT_TOKEN_MIN :
+                strcmp(name->value.coord, "max") == 0 ? COSLAYOUT_TOKEN_MAX :
+                strcmp(name->value.coord, "clamp") == 0 ? COSLAYOUT_TOKEN_CLAMP : 0);
+
+    if (type == 0 || (type == COSLAYOUT_TOKEN_CLAMP ? count != 3 : count < 2)) {
+        fprintf(stderr, "COSLayout: Unknown function \"%s\" of %d arguments.\n", name->value.coord, count);
+
+        coslayout_destroy_ast(name);
+        coslayout_destroy_ast(args);
+
+        return NULL;
+    }
+
+    free(name->value.coord);
+
+    name->node_type = type;
+    name->value.coord = NULL;
+    name->l = args;
+
+    return name;
+}
 
 COSLAYOUT_AST *coslayout_create_ast(int type, COSLAYOUT_AST *l, COSLAYOUT_AST *r) {
     COSLAYOUT_AST *astp = (COSLAYOUT_AST *)malloc(sizeof(COSLAYOUT_AST));
@@ -1700,8 +1802,8 @@ int coslayout_parse_rule(char *rule, COSLAYOUT_AST **astpp) {
     coslayout_delete_buffer(state, scanner);
     coslayoutlex_destroy(scanner);
 
+    /* Whatever the tree held was destroyed with the symbols discarded. */
     if (result) {
-        coslayout_destroy_ast(*astpp);
         *astpp = NULL;
     }
 
@@ -1716,7 +1818,10 @@ void coslayout_destroy_ast(COSLAYOUT_AST *astp) {
         int type = astp->node_type;
         char *coord = astp->value.coord;
 
-        if ((type == COSLAYOUT_TOKEN_ATTR || type == COSLAYOUT_TOKEN_COORD) && coord != NULL)
+        if ((type == COSLAYOUT_TOKEN_ATTR || type == COSLAYOUT_TOKEN_COORD ||
+             type == COSLAYOUT_TOKEN_COORD_PERCENTAGE || type == COSLAYOUT_TOKEN_COORD_PERCENTAGE_H ||
+             type == COSLAYOUT_TOKEN_COORD_PERCENTAGE_V ||
+             type == COSLAYOUT_TOKEN_PARAM || type == COSLAYOUT_TOKEN_REFERENCE) && coord != NULL)
             free(coord);
 
         free(astp);
@@ -1,8 +1,9 @@
-/* A Bison parser, made by GNU Bison 3.0.2.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2013 Free Software Foundation, Inc.
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
 
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
@@ -15,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -30,6 +31,10 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 #ifndef YY_COSLAYOUT_COSLAYOUTPARSER_H_INCLUDED
 # define YY_COSLAYOUT_COSLAYOUTPARSER_H_INCLUDED
 /* Debug traces.  */
@@ -48,7 +53,8 @@
 extern int coslayoutdebug;
 #endif
 /* "%code requires" blocks.  */
-#line 18 "COSLayoutParser.y" /* yacc.c:1915  */
+#line 45 "COSLayoutParser.y"
+
 
 #define YYSTYPE COSLAYOUTSTYPE
 
@@ -70,32 +76,48 @@ struct COSLAYOUT_AST {
 typedef struct COSLAYOUT_AST COSLAYOUT_AST;
 
 COSLAYOUT_AST *coslayout_create_ast(int type, COSLAYOUT_AST *l, COSLAYOUT_AST *r);
+COSLAYOUT_AST *coslayout_create_call_ast(COSLAYOUT_AST *name, COSLAYOUT_AST *args);
 
 int coslayout_parse_rule(char *rule, COSLAYOUT_AST **astpp);
 void coslayout_destroy_ast(COSLAYOUT_AST *astp);
 
-#line 78 "COSLayoutParser.h" /* yacc.c:1915  */
 
-/* Token type.  */
+#line 86 "COSLayoutParser.h"
+
+/* Token kinds.  */
 #ifndef COSLAYOUTTOKENTYPE
 # define COSLAYOUTTOKENTYPE
   enum coslayouttokentype
   {
-    COSLAYOUT_TOKEN_ATTR = 258,
-    COSLAYOUT_TOKEN_NUMBER = 259,
-    COSLAYOUT_TOKEN_PERCENTAGE = 260,
-    COSLAYOUT_TOKEN_PERCENTAGE_H = 261,
-    COSLAYOUT_TOKEN_PERCENTAGE_V = 262,
-    COSLAYOUT_TOKEN_COORD = 263,
-    COSLAYOUT_TOKEN_COORD_PERCENTAGE = 264,
-    COSLAYOUT_TOKEN_COORD_PERCENTAGE_H = 265,
-    COSLAYOUT_TOKEN_COORD_PERCENTAGE_V = 266,
-    COSLAYOUT_TOKEN_NIL = 267,
-    COSLAYOUT_TOKEN_ADD_ASSIGN = 268,
-    COSLAYOUT_TOKEN_SUB_ASSIGN = 269,
-    COSLAYOUT_TOKEN_MUL_ASSIGN = 270,
-    COSLAYOUT_TOKEN_DIV_ASSIGN = 271
+    COSLAYOUTEMPTY = -2,
+    COSLAYOUTEOF = 0,              /* "end of file"  */
+    COSLAYOUTerror = 256,          /* error  */
+    COSLAYOUTUNDEF = 257,          /* "invalid token"  */
+    COSLAYOUT_TOKEN_ATTR = 258,    /* COSLAYOUT_TOKEN_ATTR  */
+    COSLAYOUT_TOKEN_NUMBER = 259,  /* COSLAYOUT_TOKEN_NUMBER  */
+    COSLAYOUT_TOKEN_PERCENTAGE = 260, /* COSLAYOUT_TOKEN_PERCENTAGE  */
+    COSLAYOUT_TOKEN_PERCENTAGE_H = 261, /* COSLAYOUT_TOKEN_PERCENTAGE_H  */
+    COSLAYOUT_TOKEN_PERCENTAGE_V = 262, /* COSLAYOUT_TOKEN_PERCENTAGE_V  */
+    COSLAYOUT_TOKEN_COORD = 263,   /* COSLAYOUT_TOKEN_COORD  */
+    COSLAYOUT_TOKEN_COORD_PERCENTAGE = 264, /* COSLAYOUT_TOKEN_COORD_PERCENTAGE  */
+    COSLAYOUT_TOKEN_COORD_PERCENTAGE_H = 265, /* COSLAYOUT_TOKEN_COORD_PERCENTAGE_H  */
+    COSLAYOUT_TOKEN_COORD_PERCENTAGE_V = 266, /* COSLAYOUT_TOKEN_COORD_PERCENTAGE_V  */
+    COSLAYOUT_TOKEN_NIL = 267,     /* COSLAYOUT_TOKEN_NIL  */
+    COSLAYOUT_TOKEN_ADD_ASSIGN = 268, /* COSLAYOUT_TOKEN_ADD_ASSIGN  */
+    COSLAYOUT_TOKEN_SUB_ASSIGN = 269, /* COSLAYOUT_TOKEN_SUB_ASSIGN  */
+    COSLAYOUT_TOKEN_MUL_ASSIGN = 270, /* COSLAYOUT_TOKEN_MUL_ASSIGN  */
+    COSLAYOUT_TOKEN_DIV_ASSIGN = 271, /* COSLAYOUT_TOKEN_DIV_ASSIGN  */
+    COSLAYOUT_TOKEN_PARAM = 272,   /* COSLAYOUT_TOKEN_PARAM  */
+    COSLAYOUT_TOKEN_REFERENCE = 273, /* COSLAYOUT_TOKEN_REFERENCE  */
+    COSLAYOUT_TOKEN_LE = 274,      /* COSLAYOUT_TOKEN_LE  */
+    COSLAYOUT_TOKEN_GE = 275,      /* COSLAYOUT_TOKEN_GE  */
+    COSLAYOUT_TOKEN_EQ = 276,      /* COSLAYOUT_TOKEN_EQ  */
+    COSLAYOUT_TOKEN_NE = 277,      /* COSLAYOUT_TOKEN_NE  */
+    COSLAYOUT_TOKEN_MIN = 278,     /* COSLAYOUT_TOKEN_MIN  */
+    COSLAYOUT_TOKEN_MAX = 279,     /* COSLAYOUT_TOKEN_MAX  */
+    COSLAYOUT_TOKEN_CLAMP = 280    /* COSLAYOUT_TOKEN_CLAMP  */
   };
+  typedef enum coslayouttokentype coslayouttoken_kind_t;
 #endif
 
 /* Value type.  */
@@ -107,6 +129,8 @@ typedef COSLAYOUT_AST * COSLAYOUTSTYPE;
 
 
 
+
 int coslayoutparse (void *scanner, COSLAYOUT_AST **astpp);
 
+
 #endif /* !YY_COSLAYOUT_COSLAYOUTPARSER_H_INCLUDED  */
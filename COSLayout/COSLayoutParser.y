@@ -0,0 +1,277 @@
+/* COSLayoutParser.y
+ *
+ * Copyright (c) 2014 Tianyong Tang
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Grammar of rules. COSLayoutParser.c and COSLayoutParser.h are generated
+ * from it, edit this file and run:
+ *
+ *   bison -Wall --defines=COSLayoutParser.h -o COSLayoutParser.c COSLayoutParser.y
+ *
+ * The scanner, COSLayoutLex.c, is written by hand. */
+
+%{
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "COSLayoutParser.h"
+#include "COSLayoutLex.h"
+
+void coslayouterror(void *scanner, COSLAYOUT_AST **astpp, char *msg);
+int coslayoutlex(YYSTYPE *lvalp, void *scanner, COSLAYOUT_AST **astpp);
+%}
+
+%code requires {
+
+#define YYSTYPE COSLAYOUTSTYPE
+
+#define YY_DECL int coslayoutlex \
+    (YYSTYPE *yylval_param, yyscan_t yyscanner, COSLAYOUT_AST **astpp)
+
+struct COSLAYOUT_AST {
+    int node_type;
+    struct COSLAYOUT_AST *l;
+    struct COSLAYOUT_AST *r;
+    union {
+        float number;
+        float percentage;
+        char *coord;
+    } value;
+    void *data;
+};
+
+typedef struct COSLAYOUT_AST COSLAYOUT_AST;
+
+COSLAYOUT_AST *coslayout_create_ast(int type, COSLAYOUT_AST *l, COSLAYOUT_AST *r);
+COSLAYOUT_AST *coslayout_create_call_ast(COSLAYOUT_AST *name, COSLAYOUT_AST *args);
+
+int coslayout_parse_rule(char *rule, COSLAYOUT_AST **astpp);
+void coslayout_destroy_ast(COSLAYOUT_AST *astp);
+
+}
+
+%define api.pure
+%define api.prefix {coslayout}
+%define api.value.type {COSLAYOUT_AST *}
+
+%lex-param {void *scanner} {COSLAYOUT_AST **astpp}
+%parse-param {void *scanner} {COSLAYOUT_AST **astpp}
+
+%token COSLAYOUT_TOKEN_ATTR
+%token COSLAYOUT_TOKEN_NUMBER
+%token COSLAYOUT_TOKEN_PERCENTAGE
+%token COSLAYOUT_TOKEN_PERCENTAGE_H
+%token COSLAYOUT_TOKEN_PERCENTAGE_V
+%token COSLAYOUT_TOKEN_COORD
+%token COSLAYOUT_TOKEN_COORD_PERCENTAGE
+%token COSLAYOUT_TOKEN_COORD_PERCENTAGE_H
+%token COSLAYOUT_TOKEN_COORD_PERCENTAGE_V
+%token COSLAYOUT_TOKEN_NIL
+%token COSLAYOUT_TOKEN_ADD_ASSIGN
+%token COSLAYOUT_TOKEN_SUB_ASSIGN
+%token COSLAYOUT_TOKEN_MUL_ASSIGN
+%token COSLAYOUT_TOKEN_DIV_ASSIGN
+%token COSLAYOUT_TOKEN_PARAM
+%token COSLAYOUT_TOKEN_REFERENCE
+%token COSLAYOUT_TOKEN_LE
+%token COSLAYOUT_TOKEN_GE
+%token COSLAYOUT_TOKEN_EQ
+%token COSLAYOUT_TOKEN_NE
+%token COSLAYOUT_TOKEN_MIN
+%token COSLAYOUT_TOKEN_MAX
+%token COSLAYOUT_TOKEN_CLAMP
+
+/* Trees of symbols discarded by a syntax error. The tree of rule is the
+ * result, which the caller destroys. */
+%destructor { coslayout_destroy_ast($$); }
+    COSLAYOUT_TOKEN_ATTR COSLAYOUT_TOKEN_NUMBER
+    COSLAYOUT_TOKEN_PERCENTAGE COSLAYOUT_TOKEN_PERCENTAGE_H COSLAYOUT_TOKEN_PERCENTAGE_V
+    COSLAYOUT_TOKEN_COORD COSLAYOUT_TOKEN_COORD_PERCENTAGE
+    COSLAYOUT_TOKEN_COORD_PERCENTAGE_H COSLAYOUT_TOKEN_COORD_PERCENTAGE_V
+    COSLAYOUT_TOKEN_NIL COSLAYOUT_TOKEN_PARAM COSLAYOUT_TOKEN_REFERENCE
+    expr assign rval test sum item atom args
+
+%%
+
+rule
+    : expr { *astpp = $$ = $1; }
+    ;
+
+expr
+    : %empty { $$ = NULL; }
+    | error { *astpp = $$ = NULL; YYABORT; }
+    | COSLAYOUT_TOKEN_ATTR assign expr { *astpp = $$ = coslayout_create_ast($2->node_type, $1, $3); free($2); }
+    | rval { *astpp = $$ = $1; }
+    ;
+
+assign
+    : '=' { *astpp = $$ = coslayout_create_ast('=', NULL, NULL); }
+    | COSLAYOUT_TOKEN_ADD_ASSIGN { *astpp = $$ = coslayout_create_ast(COSLAYOUT_TOKEN_ADD_ASSIGN, NULL, NULL); }
+    | COSLAYOUT_TOKEN_SUB_ASSIGN { *astpp = $$ = coslayout_create_ast(COSLAYOUT_TOKEN_SUB_ASSIGN, NULL, NULL); }
+    | COSLAYOUT_TOKEN_MUL_ASSIGN { *astpp = $$ = coslayout_create_ast(COSLAYOUT_TOKEN_MUL_ASSIGN, NULL, NULL); }
+    | COSLAYOUT_TOKEN_DIV_ASSIGN { *astpp = $$ = coslayout_create_ast(COSLAYOUT_TOKEN_DIV_ASSIGN, NULL, NULL); }
+    ;
+
+rval
+    : test { *astpp = $$ = $1; }
+    | test '?' rval ':' rval { *astpp = $$ = coslayout_create_ast('?', $1, coslayout_create_ast(':', $3, $5)); }
+    ;
+
+test
+    : sum { *astpp = $$ = $1; }
+    | sum '<' sum { *astpp = $$ = coslayout_create_ast('<', $1, $3); }
+    | sum '>' sum { *astpp = $$ = coslayout_create_ast('>', $1, $3); }
+    | sum COSLAYOUT_TOKEN_LE sum { *astpp = $$ = coslayout_create_ast(COSLAYOUT_TOKEN_LE, $1, $3); }
+    | sum COSLAYOUT_TOKEN_GE sum { *astpp = $$ = coslayout_create_ast(COSLAYOUT_TOKEN_GE, $1, $3); }
+    | sum COSLAYOUT_TOKEN_EQ sum { *astpp = $$ = coslayout_create_ast(COSLAYOUT_TOKEN_EQ, $1, $3); }
+    | sum COSLAYOUT_TOKEN_NE sum { *astpp = $$ = coslayout_create_ast(COSLAYOUT_TOKEN_NE, $1, $3); }
+    ;
+
+sum
+    : sum '+' item { *astpp = $$ = coslayout_create_ast('+', $1, $3); }
+    | sum '-' item { *astpp = $$ = coslayout_create_ast('-', $1, $3); }
+    | item { *astpp = $$ = $1; }
+    ;
+
+item
+    : item '*' atom { *astpp = $$ = coslayout_create_ast('*', $1, $3); }
+    | item '/' atom { *astpp = $$ = coslayout_create_ast('/', $1, $3); }
+    | atom { *astpp = $$ = $1; }
+    ;
+
+atom
+    : COSLAYOUT_TOKEN_ATTR { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_NUMBER { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_PERCENTAGE { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_PERCENTAGE_H { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_PERCENTAGE_V { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_COORD { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_COORD_PERCENTAGE { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_COORD_PERCENTAGE_H { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_COORD_PERCENTAGE_V { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_NIL { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_PARAM { *astpp = $$ = $1; }
+    | COSLAYOUT_TOKEN_REFERENCE { *astpp = $$ = $1; }
+    /* Parentheses hold an expression, () is a syntax error. */
+    | '(' rval ')' { *astpp = $$ = $2; }
+    | COSLAYOUT_TOKEN_ATTR '(' args ')' {
+        $$ = coslayout_create_call_ast($1, $3);
+        *astpp = $$;
+        if ($$ == NULL) YYERROR;
+    }
+    ;
+
+args
+    : rval { *astpp = $$ = $1; }
+    | args ',' rval { *astpp = $$ = coslayout_create_ast(',', $1, $3); }
+    ;
+
+%%
+
+void coslayouterror(void *scanner, COSLAYOUT_AST **astpp, char *msg) {
+  (void)scanner;
+  (void)astpp;
+
+  fprintf(stderr, "COSLayout: %s\n", msg);
+}
+
+int coslayoutparse (void *scanner, COSLAYOUT_AST **astpp);
+
+/* Turns name into a call of a built in function on the comma separated
+ * args, or destroys both and returns NULL if the function is unknown or
+ * takes another number of arguments. */
+COSLAYOUT_AST *coslayout_create_call_ast(COSLAYOUT_AST *name, COSLAYOUT_AST *args) {
+    int count = 1;
+
+    for (COSLAYOUT_AST *arg = args; arg->node_type == ','; arg = arg->l) ++count;
+
+    int type = (strcmp(name->value.coord, "min") == 0 ? COSLAYOUT_TOKEN_MIN :
+                strcmp(name->value.coord, "max") == 0 ? COSLAYOUT_TOKEN_MAX :
+                strcmp(name->value.coord, "clamp") == 0 ? COSLAYOUT_TOKEN_CLAMP : 0);
+
+    if (type == 0 || (type == COSLAYOUT_TOKEN_CLAMP ? count != 3 : count < 2)) {
+        fprintf(stderr, "COSLayout: Unknown function \"%s\" of %d arguments.\n", name->value.coord, count);
+
+        coslayout_destroy_ast(name);
+        coslayout_destroy_ast(args);
+
+        return NULL;
+    }
+
+    free(name->value.coord);
+
+    name->node_type = type;
+    name->value.coord = NULL;
+    name->l = args;
+
+    return name;
+}
+
+COSLAYOUT_AST *coslayout_create_ast(int type, COSLAYOUT_AST *l, COSLAYOUT_AST *r) {
+    COSLAYOUT_AST *astp = (COSLAYOUT_AST *)malloc(sizeof(COSLAYOUT_AST));
+
+    astp->node_type = type;
+    astp->l = l;
+    astp->r = r;
+    astp->value.coord = NULL;
+    astp->data = NULL;
+
+    return astp;
+}
+
+int coslayout_parse_rule(char *rule, COSLAYOUT_AST **astpp) {
+    yyscan_t scanner;
+    coslayoutlex_init(&scanner);
+    YY_BUFFER_STATE state = coslayout_scan_string(rule, scanner);
+
+    int result = coslayoutparse(scanner, astpp);
+
+    coslayout_delete_buffer(state, scanner);
+    coslayoutlex_destroy(scanner);
+
+    /* Whatever the tree held was destroyed with the symbols discarded. */
+    if (result) {
+        *astpp = NULL;
+    }
+
+    return result;
+}
+
+void coslayout_destroy_ast(COSLAYOUT_AST *astp) {
+    if (astp != NULL) {
+        coslayout_destroy_ast(astp->l);
+        coslayout_destroy_ast(astp->r);
+
+        int type = astp->node_type;
+        char *coord = astp->value.coord;
+
+        if ((type == COSLAYOUT_TOKEN_ATTR || type == COSLAYOUT_TOKEN_COORD ||
+             type == COSLAYOUT_TOKEN_COORD_PERCENTAGE || type == COSLAYOUT_TOKEN_COORD_PERCENTAGE_H ||
+             type == COSLAYOUT_TOKEN_COORD_PERCENTAGE_V ||
+             type == COSLAYOUT_TOKEN_PARAM || type == COSLAYOUT_TOKEN_REFERENCE) && coord != NULL)
+            free(coord);
+
+        free(astp);
+    }
+}
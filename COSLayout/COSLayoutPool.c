@@ -0,0 +1,286 @@
+// COSLayoutPool.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutPool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct COSLAYOUT_RANGE {
+    pthread_mutex_t lock;
+    size_t head;
+    size_t tail;
+} COSLAYOUT_RANGE;
+
+typedef struct COSLAYOUT_WORKER {
+    COSLAYOUT_POOL *pool;
+    int index;
+} COSLAYOUT_WORKER;
+
+struct COSLAYOUT_POOL {
+    int thread_count;
+    pthread_t *threads;
+    COSLAYOUT_WORKER *workers;
+    COSLAYOUT_RANGE *ranges;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long epoch;
+    int busy;
+    int stop;
+
+    COSLAYOUT_TASK task;
+    void *info;
+    size_t grain;
+};
+
+/* Takes up to grain indices from the front of a range. */
+static int coslayout_range_pop(COSLAYOUT_RANGE *range, size_t grain, size_t *begin, size_t *end) {
+    int found = 0;
+
+    pthread_mutex_lock(&range->lock);
+
+    if (range->head < range->tail) {
+        *begin = range->head;
+        *end = range->tail - range->head > grain ? range->head + grain : range->tail;
+        range->head = *end;
+        found = 1;
+    }
+
+    pthread_mutex_unlock(&range->lock);
+
+    return found;
+}
+
+/* Moves the back half of the fullest other range into the range of worker. */
+static int coslayout_pool_steal(COSLAYOUT_POOL *pool, int worker) {
+    for (;;) {
+        int victim = -1;
+        size_t most = 0;
+
+        for (int i = 0; i < pool->thread_count; ++i) {
+            COSLAYOUT_RANGE *range = &pool->ranges[i];
+
+            if (i == worker) continue;
+
+            pthread_mutex_lock(&range->lock);
+            size_t size = range->tail - range->head;
+            pthread_mutex_unlock(&range->lock);
+
+            if (size > most) {
+                most = size;
+                victim = i;
+            }
+        }
+
+        if (victim < 0) return 0;
+
+        COSLAYOUT_RANGE *range = &pool->ranges[victim];
+        size_t begin = 0, end = 0;
+
+        pthread_mutex_lock(&range->lock);
+
+        if (range->head < range->tail) {
+            size_t half = (range->tail - range->head + 1) / 2;
+
+            end = range->tail;
+            begin = end - half;
+            range->tail = begin;
+        }
+
+        pthread_mutex_unlock(&range->lock);
+
+        if (begin < end) {
+            COSLAYOUT_RANGE *own = &pool->ranges[worker];
+
+            pthread_mutex_lock(&own->lock);
+            own->head = begin;
+            own->tail = end;
+            pthread_mutex_unlock(&own->lock);
+
+            return 1;
+        }
+    }
+}
+
+static void coslayout_pool_work(COSLAYOUT_POOL *pool, int worker) {
+    size_t begin, end;
+
+    do {
+        while (coslayout_range_pop(&pool->ranges[worker], pool->grain, &begin, &end)) {
+            for (size_t i = begin; i < end; ++i) {
+                pool->task(pool->info, i, worker);
+            }
+        }
+    } while (coslayout_pool_steal(pool, worker));
+}
+
+static void *coslayout_pool_main(void *arg) {
+    COSLAYOUT_WORKER *worker = (COSLAYOUT_WORKER *)arg;
+    COSLAYOUT_POOL *pool = worker->pool;
+
+    unsigned long epoch = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+
+        while (!pool->stop && pool->epoch == epoch) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+
+        epoch = pool->epoch;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        coslayout_pool_work(pool, worker->index);
+
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+COSLAYOUT_POOL *coslayout_pool_create(int thread_count) {
+    if (thread_count <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+        thread_count = online > 0 ? (int)online : 1;
+    }
+
+    COSLAYOUT_POOL *pool = (COSLAYOUT_POOL *)calloc(1, sizeof(COSLAYOUT_POOL));
+
+    pool->thread_count = thread_count;
+    pool->threads = (pthread_t *)calloc((size_t)thread_count, sizeof(pthread_t));
+    pool->workers = (COSLAYOUT_WORKER *)calloc((size_t)thread_count, sizeof(COSLAYOUT_WORKER));
+    pool->ranges = (COSLAYOUT_RANGE *)calloc((size_t)thread_count, sizeof(COSLAYOUT_RANGE));
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (int i = 0; i < thread_count; ++i) {
+        pthread_mutex_init(&pool->ranges[i].lock, NULL);
+
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+    }
+
+    /* Worker 0 is the thread calling coslayout_pool_run. */
+    for (int i = 1; i < thread_count; ++i) {
+        pthread_create(&pool->threads[i], NULL, coslayout_pool_main, &pool->workers[i]);
+    }
+
+    return pool;
+}
+
+void coslayout_pool_destroy(COSLAYOUT_POOL *pool) {
+    if (pool == NULL) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->thread_count; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pool->thread_count; ++i) {
+        pthread_mutex_destroy(&pool->ranges[i].lock);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+
+    free(pool->threads);
+    free(pool->workers);
+    free(pool->ranges);
+    free(pool);
+}
+
+int coslayout_pool_thread_count(const COSLAYOUT_POOL *pool) {
+    return pool->thread_count;
+}
+
+void coslayout_pool_run(COSLAYOUT_POOL *pool, size_t count, COSLAYOUT_TASK task, void *info) {
+    if (count == 0) return;
+
+    size_t threads = (size_t)pool->thread_count;
+
+    if (threads == 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(info, i, 0);
+        }
+
+        return;
+    }
+
+    pool->task = task;
+    pool->info = info;
+
+    /* Small grains keep ranges stealable near the end of a loop. */
+    pool->grain = count / (threads * 8);
+
+    if (pool->grain == 0) pool->grain = 1;
+
+    for (size_t i = 0; i < threads; ++i) {
+        COSLAYOUT_RANGE *range = &pool->ranges[i];
+
+        pthread_mutex_lock(&range->lock);
+        range->head = count * i / threads;
+        range->tail = count * (i + 1) / threads;
+        pthread_mutex_unlock(&range->lock);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->busy = pool->thread_count - 1;
+    pool->epoch += 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    coslayout_pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,61 @@
+// COSLayoutPool.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Work-stealing pool of worker threads running parallel loops.
+//
+// Indices of a loop are split evenly between workers up front. A worker
+// drains its own range from the front and, once empty, steals the back
+// half of the fullest range left. The calling thread works as one of the
+// workers, so a pool of one thread runs loops serially.
+
+#ifndef COSLAYOUT_POOL_H
+#define COSLAYOUT_POOL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*COSLAYOUT_TASK)(void *info, size_t index, int worker);
+
+typedef struct COSLAYOUT_POOL COSLAYOUT_POOL;
+
+/* Creates a pool with thread_count workers including the caller, or one
+ * per online processor if thread_count is not positive. */
+COSLAYOUT_POOL *coslayout_pool_create(int thread_count);
+void coslayout_pool_destroy(COSLAYOUT_POOL *pool);
+
+int coslayout_pool_thread_count(const COSLAYOUT_POOL *pool);
+
+/* Runs task for every index below count and returns when all are done.
+ * Loops of one pool must not be run concurrently. */
+void coslayout_pool_run(COSLAYOUT_POOL *pool, size_t count, COSLAYOUT_TASK task, void *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
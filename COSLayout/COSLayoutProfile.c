@@ -0,0 +1,424 @@
+// COSLayoutProfile.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutProfile.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COSLAYOUT_PROFILE_BUCKETS 256
+
+typedef struct COSLAYOUT_PROFILE_RULE {
+    struct COSLAYOUT_PROFILE_RULE *next;
+    uint64_t hash;
+    int subrule;
+    int attr;
+    uint64_t calls;
+    uint64_t nanoseconds;
+    char text[];
+} COSLAYOUT_PROFILE_RULE;
+
+int coslayout_profile_flags = 0;
+
+/* Rules and the watchdog each change under their own mutex. The watchdog
+ * function is called after its mutex is unlocked. */
+static pthread_mutex_t coslayout_profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+static COSLAYOUT_PROFILE_RULE *coslayout_profile_rules[COSLAYOUT_PROFILE_BUCKETS];
+static size_t coslayout_profile_count = 0;
+
+/* The watchdog function with its info, referenced by the watchdog and by
+ * every call running. */
+typedef struct COSLAYOUT_WATCHDOG {
+    COSLAYOUT_WATCHDOG_FUNC func;
+    void *info;
+    void (*release)(void *info);
+    size_t refcount;
+} COSLAYOUT_WATCHDOG;
+
+static pthread_mutex_t coslayout_watchdog_mutex = PTHREAD_MUTEX_INITIALIZER;
+static double coslayout_watchdog_budget = 0;
+static COSLAYOUT_WATCHDOG *coslayout_watchdog = NULL;
+
+static void coslayout_profile_set_flag(int flag, int on) {
+    if (on) {
+        __atomic_or_fetch(&coslayout_profile_flags, flag, __ATOMIC_RELAXED);
+    } else {
+        __atomic_and_fetch(&coslayout_profile_flags, ~flag, __ATOMIC_RELAXED);
+    }
+}
+
+void coslayout_profile_set_enabled(int enabled) {
+    coslayout_profile_set_flag(COSLAYOUT_PROFILE_RULES, enabled);
+}
+
+static uint64_t coslayout_profile_hash(const char *text, int subrule, int attr) {
+    uint64_t h = 14695981039346656037ULL;
+
+    for (const unsigned char *c = (const unsigned char *)text; *c; ++c) {
+        h = (h ^ *c) * 1099511628211ULL;
+    }
+
+    h = (h ^ (uint64_t)subrule) * 1099511628211ULL;
+
+    return (h ^ (uint64_t)attr) * 1099511628211ULL;
+}
+
+/* Rule of source and attr, created if needed. Called under the mutex. */
+static COSLAYOUT_PROFILE_RULE *coslayout_profile_rule(const COSLAYOUT_SOURCE *source, int attr) {
+    uint64_t hash = coslayout_profile_hash(source->text, source->subrule, attr);
+    COSLAYOUT_PROFILE_RULE **bucket = &coslayout_profile_rules[hash % COSLAYOUT_PROFILE_BUCKETS];
+
+    for (COSLAYOUT_PROFILE_RULE *rule = *bucket; rule != NULL; rule = rule->next) {
+        if (rule->hash == hash &&
+            rule->subrule == source->subrule &&
+            rule->attr == attr &&
+            strcmp(rule->text, source->text) == 0)
+        {
+            return rule;
+        }
+    }
+
+    size_t length = strlen(source->text);
+    COSLAYOUT_PROFILE_RULE *rule = (COSLAYOUT_PROFILE_RULE *)malloc(sizeof(COSLAYOUT_PROFILE_RULE) + length + 1);
+
+    rule->next = *bucket;
+    rule->hash = hash;
+    rule->subrule = source->subrule;
+    rule->attr = attr;
+    rule->calls = 0;
+    rule->nanoseconds = 0;
+
+    memcpy(rule->text, source->text, length + 1);
+
+    *bucket = rule;
+    coslayout_profile_count += 1;
+
+    return rule;
+}
+
+void coslayout_profile_record(const COSLAYOUT_RULESET *set, const COSLAYOUT_PROFILE_SAMPLE *sample) {
+    pthread_mutex_lock(&coslayout_profile_mutex);
+
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        const COSLAYOUT_SOURCE *source = set->sources[attr];
+
+        /* Rules built without text are not attributed. */
+        if (sample->calls[attr] == 0 || source == NULL) continue;
+
+        COSLAYOUT_PROFILE_RULE *rule = coslayout_profile_rule(source, attr);
+
+        rule->calls += sample->calls[attr];
+        rule->nanoseconds += sample->nanoseconds[attr];
+    }
+
+    pthread_mutex_unlock(&coslayout_profile_mutex);
+}
+
+static int coslayout_profile_compare(const void *a, const void *b) {
+    const COSLAYOUT_PROFILE_RULE *ra = *(const COSLAYOUT_PROFILE_RULE *const *)a;
+    const COSLAYOUT_PROFILE_RULE *rb = *(const COSLAYOUT_PROFILE_RULE *const *)b;
+
+    if (ra->nanoseconds != rb->nanoseconds) return ra->nanoseconds < rb->nanoseconds ? 1 : -1;
+    if (ra->calls != rb->calls) return ra->calls < rb->calls ? 1 : -1;
+
+    return 0;
+}
+
+size_t coslayout_profile_copy(COSLAYOUT_PROFILE_ENTRY *entries, size_t count) {
+    pthread_mutex_lock(&coslayout_profile_mutex);
+
+    size_t total = coslayout_profile_count;
+    COSLAYOUT_PROFILE_RULE **rules = (COSLAYOUT_PROFILE_RULE **)malloc((total ? total : 1) * sizeof(COSLAYOUT_PROFILE_RULE *));
+    size_t index = 0;
+
+    for (size_t i = 0; i < COSLAYOUT_PROFILE_BUCKETS; ++i) {
+        for (COSLAYOUT_PROFILE_RULE *rule = coslayout_profile_rules[i]; rule != NULL; rule = rule->next) {
+            rules[index++] = rule;
+        }
+    }
+
+    qsort(rules, total, sizeof(COSLAYOUT_PROFILE_RULE *), coslayout_profile_compare);
+
+    if (count > total) count = total;
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = strlen(rules[i]->text);
+
+        entries[i].rule = (char *)malloc(length + 1);
+        entries[i].subrule = rules[i]->subrule;
+        entries[i].attr = rules[i]->attr;
+        entries[i].calls = rules[i]->calls;
+        entries[i].seconds = rules[i]->nanoseconds * 1e-9;
+
+        memcpy(entries[i].rule, rules[i]->text, length + 1);
+    }
+
+    pthread_mutex_unlock(&coslayout_profile_mutex);
+
+    free(rules);
+
+    return count;
+}
+
+void coslayout_profile_entries_destroy(COSLAYOUT_PROFILE_ENTRY *entries, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        free(entries[i].rule);
+        entries[i].rule = NULL;
+    }
+}
+
+void coslayout_profile_reset(void) {
+    pthread_mutex_lock(&coslayout_profile_mutex);
+
+    for (size_t i = 0; i < COSLAYOUT_PROFILE_BUCKETS; ++i) {
+        COSLAYOUT_PROFILE_RULE *rule = coslayout_profile_rules[i];
+
+        while (rule != NULL) {
+            COSLAYOUT_PROFILE_RULE *next = rule->next;
+
+            free(rule);
+            rule = next;
+        }
+
+        coslayout_profile_rules[i] = NULL;
+    }
+
+    coslayout_profile_count = 0;
+
+    pthread_mutex_unlock(&coslayout_profile_mutex);
+}
+
+static void coslayout_watchdog_release(COSLAYOUT_WATCHDOG *watchdog) {
+    if (watchdog == NULL || __atomic_sub_fetch(&watchdog->refcount, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+    if (watchdog->release != NULL) watchdog->release(watchdog->info);
+
+    free(watchdog);
+}
+
+void coslayout_watchdog_set(double budget, COSLAYOUT_WATCHDOG_FUNC func, void *info, void (*release)(void *info)) {
+    COSLAYOUT_WATCHDOG *watchdog = (COSLAYOUT_WATCHDOG *)malloc(sizeof(COSLAYOUT_WATCHDOG));
+
+    if (func != NULL) {
+        *watchdog = (COSLAYOUT_WATCHDOG){ func, info, release, 1 };
+    } else {
+        *watchdog = (COSLAYOUT_WATCHDOG){ coslayout_watchdog_log, NULL, NULL, 1 };
+
+        if (release != NULL) release(info);
+    }
+
+    pthread_mutex_lock(&coslayout_watchdog_mutex);
+
+    COSLAYOUT_WATCHDOG *replaced = coslayout_watchdog;
+
+    coslayout_watchdog_budget = budget > 0 ? budget : 0;
+    coslayout_watchdog = watchdog;
+
+    coslayout_profile_set_flag(COSLAYOUT_PROFILE_NODES, budget > 0);
+
+    pthread_mutex_unlock(&coslayout_watchdog_mutex);
+
+    coslayout_watchdog_release(replaced);
+}
+
+void coslayout_watchdog_check(void *container, double seconds, const COSLAYOUT_NODE *nodes, size_t count) {
+    if (!(COSLAYOUT_PROFILE_FLAGS() & COSLAYOUT_PROFILE_NODES)) return;
+
+    pthread_mutex_lock(&coslayout_watchdog_mutex);
+
+    double budget = coslayout_watchdog_budget;
+    COSLAYOUT_WATCHDOG *watchdog = coslayout_watchdog;
+
+    if (budget <= 0 || seconds <= budget || watchdog == NULL) {
+        pthread_mutex_unlock(&coslayout_watchdog_mutex);
+        return;
+    }
+
+    __atomic_add_fetch(&watchdog->refcount, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&coslayout_watchdog_mutex);
+
+    COSLAYOUT_SLOW_SOLVE solve = { container, seconds, budget, 0, { NULL } };
+
+    /* Keeps the slowest nodes sorted by insertion. */
+    for (size_t i = 0; i < count; ++i) {
+        const COSLAYOUT_NODE *node = &nodes[i];
+
+        if (node->view == NULL || node->nanoseconds == 0) continue;
+
+        size_t j = solve.count < COSLAYOUT_WATCHDOG_NODES ? solve.count++ : COSLAYOUT_WATCHDOG_NODES;
+
+        for (; j > 0 && solve.nodes[j - 1]->nanoseconds < node->nanoseconds; --j) {
+            if (j < COSLAYOUT_WATCHDOG_NODES) solve.nodes[j] = solve.nodes[j - 1];
+        }
+
+        if (j < COSLAYOUT_WATCHDOG_NODES) solve.nodes[j] = node;
+    }
+
+    watchdog->func(&solve, watchdog->info);
+
+    coslayout_watchdog_release(watchdog);
+}
+
+void coslayout_watchdog_log(const COSLAYOUT_SLOW_SOLVE *solve, void *info) {
+    (void)info;
+
+    fprintf(stderr, "COSLayout: Solve of %p took %.3f ms, over the budget of %.3f ms.\n",
+            solve->container, solve->seconds * 1e3, solve->budget * 1e3);
+
+    for (size_t i = 0; i < solve->count; ++i) {
+        const COSLAYOUT_NODE *node = solve->nodes[i];
+        const COSLAYOUT_RULESET *set = node->set;
+
+        fprintf(stderr, "  %p: %.3f ms\n", node->view, node->nanoseconds * 1e-6);
+
+        for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+            const COSLAYOUT_SOURCE *source = set->sources[attr];
+            int seen = 0;
+
+            /* Far edges share the source of the near edge they flip to. */
+            for (int prior = 0; prior < attr && !seen; ++prior) {
+                seen = set->sources[prior] == source;
+            }
+
+            if (source == NULL || seen) continue;
+
+            const char *start;
+            size_t length = coslayout_source_subrule(source, &start);
+
+            fprintf(stderr, "    %.*s\n", (int)length, start);
+        }
+    }
+}
+
+typedef struct COSLAYOUT_COSTS_PASS {
+    COSLAYOUT_COST *costs;
+    size_t count;
+} COSLAYOUT_COSTS_PASS;
+
+/* Passes are a ring, each sorted by view. */
+struct COSLAYOUT_COSTS {
+    size_t history;
+    size_t next;
+    size_t recorded;
+    COSLAYOUT_COSTS_PASS passes[];
+};
+
+static size_t coslayout_costs_history_passes = 0;
+
+void coslayout_costs_set_history(size_t passes) {
+    __atomic_store_n(&coslayout_costs_history_passes, passes, __ATOMIC_RELAXED);
+
+    coslayout_profile_set_flag(COSLAYOUT_PROFILE_COSTS, passes > 0);
+}
+
+size_t coslayout_costs_history(void) {
+    return __atomic_load_n(&coslayout_costs_history_passes, __ATOMIC_RELAXED);
+}
+
+COSLAYOUT_COSTS *coslayout_costs_create(size_t passes) {
+    if (passes == 0) passes = 1;
+
+    COSLAYOUT_COSTS *costs = (COSLAYOUT_COSTS *)calloc(1, sizeof(COSLAYOUT_COSTS) + passes * sizeof(COSLAYOUT_COSTS_PASS));
+
+    costs->history = passes;
+
+    return costs;
+}
+
+void coslayout_costs_destroy(COSLAYOUT_COSTS *costs) {
+    if (costs == NULL) return;
+
+    for (size_t i = 0; i < costs->history; ++i) {
+        free(costs->passes[i].costs);
+    }
+
+    free(costs);
+}
+
+static int coslayout_cost_compare(const void *a, const void *b) {
+    const void *va = ((const COSLAYOUT_COST *)a)->view;
+    const void *vb = ((const COSLAYOUT_COST *)b)->view;
+
+    return va < vb ? -1 : va > vb ? 1 : 0;
+}
+
+void coslayout_costs_record(COSLAYOUT_COSTS **costs, const COSLAYOUT_NODE *nodes, size_t count) {
+    size_t history = coslayout_costs_history();
+
+    if (history == 0) return;
+
+    if (*costs != NULL && (*costs)->history != history) {
+        coslayout_costs_destroy(*costs);
+        *costs = NULL;
+    }
+
+    if (*costs == NULL) *costs = coslayout_costs_create(history);
+
+    COSLAYOUT_COSTS_PASS *pass = &(*costs)->passes[(*costs)->next];
+
+    pass->costs = (COSLAYOUT_COST *)realloc(pass->costs, (count ? count : 1) * sizeof(COSLAYOUT_COST));
+    pass->count = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (nodes[i].view == NULL) continue;
+
+        pass->costs[pass->count++] = (COSLAYOUT_COST){ nodes[i].view, nodes[i].evaluations, nodes[i].nanoseconds };
+    }
+
+    qsort(pass->costs, pass->count, sizeof(COSLAYOUT_COST), coslayout_cost_compare);
+
+    (*costs)->next = ((*costs)->next + 1) % history;
+
+    if ((*costs)->recorded < history) (*costs)->recorded += 1;
+}
+
+size_t coslayout_costs_passes(const COSLAYOUT_COSTS *costs) {
+    return costs ? costs->recorded : 0;
+}
+
+COSLAYOUT_COST coslayout_costs_sum(const COSLAYOUT_COSTS *costs, const void *view) {
+    COSLAYOUT_COST sum = { view, 0, 0 };
+
+    if (costs == NULL) return sum;
+
+    for (size_t i = 0; i < costs->history; ++i) {
+        const COSLAYOUT_COSTS_PASS *pass = &costs->passes[i];
+
+        if (pass->count == 0) continue;
+
+        const COSLAYOUT_COST *cost = (const COSLAYOUT_COST *)bsearch(
+            &sum, pass->costs, pass->count, sizeof(COSLAYOUT_COST), coslayout_cost_compare);
+
+        if (cost == NULL) continue;
+
+        sum.evaluations += cost->evaluations;
+        sum.nanoseconds += cost->nanoseconds;
+    }
+
+    return sum;
+}
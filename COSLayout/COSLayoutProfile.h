@@ -0,0 +1,148 @@
+// COSLayoutProfile.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Attribution of solving time to rules, and a watchdog of slow solves.
+//
+// Rule sets remember the text of the rules they were compiled from. While
+// profiling, every rule evaluated is timed and its time and calls are
+// added to the rule it came from, keyed by text, subrule and attribute, so
+// that the same rule of many views adds up. While a budget is set, nodes
+// are timed as a whole instead, which is cheap enough to keep on, and
+// solves over budget are reported with their slowest nodes. While a cost
+// history is kept, nodes are timed and counted the same way and solvers
+// keep the costs of their views over their last passes.
+
+#ifndef COSLAYOUT_PROFILE_H
+#define COSLAYOUT_PROFILE_H
+
+#include <stdint.h>
+
+#include "COSLayoutCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    COSLAYOUT_PROFILE_RULES = 1 << 0,
+    COSLAYOUT_PROFILE_NODES = 1 << 1,
+    COSLAYOUT_PROFILE_COSTS = 1 << 2
+};
+
+/* Time and calls of each attribute of the rule set of one node. */
+typedef struct COSLAYOUT_PROFILE_SAMPLE {
+    uint64_t nanoseconds[COSLAYOUT_ATTR_COUNT];
+    uint32_t calls[COSLAYOUT_ATTR_COUNT];
+} COSLAYOUT_PROFILE_SAMPLE;
+
+/* Rule is the whole text the rule was added with, subrule the index of
+ * the comma separated rule in it that assigned attr. */
+typedef struct COSLAYOUT_PROFILE_ENTRY {
+    char *rule;
+    int subrule;
+    int attr;
+    uint64_t calls;
+    double seconds;
+} COSLAYOUT_PROFILE_ENTRY;
+
+extern int coslayout_profile_flags;
+
+#define COSLAYOUT_PROFILE_FLAGS() __atomic_load_n(&coslayout_profile_flags, __ATOMIC_RELAXED)
+
+void coslayout_profile_set_enabled(int enabled);
+
+/* Adds sample of a node solved with set. */
+void coslayout_profile_record(const COSLAYOUT_RULESET *set, const COSLAYOUT_PROFILE_SAMPLE *sample);
+
+/* Copies up to count entries taking the most time, slowest first, and
+ * returns the number copied. Entries are freed by
+ * coslayout_profile_entries_destroy. */
+size_t coslayout_profile_copy(COSLAYOUT_PROFILE_ENTRY *entries, size_t count);
+void coslayout_profile_entries_destroy(COSLAYOUT_PROFILE_ENTRY *entries, size_t count);
+
+void coslayout_profile_reset(void);
+
+/* Maximum number of nodes reported with a slow solve. */
+#define COSLAYOUT_WATCHDOG_NODES 5
+
+/* Nodes are the slowest nodes of the solve, slowest first. They are valid
+ * for the duration of the call. */
+typedef struct COSLAYOUT_SLOW_SOLVE {
+    void *container;
+    double seconds;
+    double budget;
+    size_t count;
+    const COSLAYOUT_NODE *nodes[COSLAYOUT_WATCHDOG_NODES];
+} COSLAYOUT_SLOW_SOLVE;
+
+typedef void (*COSLAYOUT_WATCHDOG_FUNC)(const COSLAYOUT_SLOW_SOLVE *solve, void *info);
+
+/* Reports solves taking longer than budget seconds to func, or to stderr
+ * if func is NULL. A budget of zero or less disarms the watchdog. Func is
+ * called with no lock held. Calls may run concurrently, and calls begun
+ * before the watchdog is set again may end after. Release, if not NULL,
+ * is called with info once the last call ended. */
+void coslayout_watchdog_set(double budget, COSLAYOUT_WATCHDOG_FUNC func, void *info, void (*release)(void *info));
+
+/* Reports the solve of nodes if it took longer than the budget. Nodes
+ * must have been solved while the watchdog was armed. */
+void coslayout_watchdog_check(void *container, double seconds, const COSLAYOUT_NODE *nodes, size_t count);
+
+/* Writes a report of solve to stderr, listing the rules of its nodes. */
+void coslayout_watchdog_log(const COSLAYOUT_SLOW_SOLVE *solve, void *info);
+
+/* Evaluations and time of a view, in one pass or summed over passes. */
+typedef struct COSLAYOUT_COST {
+    const void *view;
+    size_t evaluations;
+    uint64_t nanoseconds;
+} COSLAYOUT_COST;
+
+/* Costs of the views of a container over its last passes. */
+typedef struct COSLAYOUT_COSTS COSLAYOUT_COSTS;
+
+/* Number of passes costs are kept for, zero to keep none. */
+void coslayout_costs_set_history(size_t passes);
+size_t coslayout_costs_history(void);
+
+COSLAYOUT_COSTS *coslayout_costs_create(size_t passes);
+void coslayout_costs_destroy(COSLAYOUT_COSTS *costs);
+
+/* Records the costs of nodes solved in one pass, dropping the oldest pass
+ * if costs are full. Costs is recreated if the history changed, and
+ * created if NULL. */
+void coslayout_costs_record(COSLAYOUT_COSTS **costs, const COSLAYOUT_NODE *nodes, size_t count);
+
+/* Passes recorded, at most the history. */
+size_t coslayout_costs_passes(const COSLAYOUT_COSTS *costs);
+
+/* Costs of view summed over the passes recorded. Costs may be NULL. */
+COSLAYOUT_COST coslayout_costs_sum(const COSLAYOUT_COSTS *costs, const void *view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
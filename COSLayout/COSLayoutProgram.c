@@ -0,0 +1,393 @@
+// COSLayoutProgram.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutProgram.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct COSLAYOUT_PROGRAM {
+    unsigned int refcount;
+    uint64_t hash;
+    COSLAYOUT_RULESET set;
+    struct COSLAYOUT_PROGRAM *next;
+};
+
+/* Interned programs by hash. Reference counts only drop to zero under the
+ * lock, so a program found in the table is always alive. */
+#define COSLAYOUT_PROGRAM_BUCKETS 256
+
+static pthread_mutex_t coslayout_programs_lock = PTHREAD_MUTEX_INITIALIZER;
+static COSLAYOUT_PROGRAM *coslayout_programs[COSLAYOUT_PROGRAM_BUCKETS];
+static size_t coslayout_programs_count = 0;
+
+void coslayout_bindings_init(COSLAYOUT_BINDINGS *bindings) {
+    bindings->count = 0;
+    bindings->exprs = NULL;
+}
+
+void coslayout_bindings_copy(COSLAYOUT_BINDINGS *dst, const COSLAYOUT_BINDINGS *src) {
+    dst->count = src->count;
+    dst->exprs = NULL;
+
+    if (src->count == 0) return;
+
+    dst->exprs = (COSLAYOUT_EXPR **)malloc(src->count * sizeof(COSLAYOUT_EXPR *));
+
+    for (size_t i = 0; i < src->count; ++i) {
+        dst->exprs[i] = coslayout_expr_retain(src->exprs[i]);
+    }
+}
+
+void coslayout_bindings_destroy(COSLAYOUT_BINDINGS *bindings) {
+    for (size_t i = 0; i < bindings->count; ++i) {
+        coslayout_expr_release(bindings->exprs[i]);
+    }
+
+    free(bindings->exprs);
+
+    coslayout_bindings_init(bindings);
+}
+
+static uint64_t coslayout_program_mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+
+    return h;
+}
+
+static uint64_t coslayout_program_hash_expr(uint64_t h, const COSLAYOUT_EXPR *expr) {
+    if (expr == NULL) return coslayout_program_mix(h, 0);
+
+    uint64_t bits;
+    double value = expr->value == 0 ? 0 : expr->value;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    h = coslayout_program_mix(h, (uint64_t)expr->kind + 1);
+    h = coslayout_program_mix(h, (uint64_t)expr->dir);
+    h = coslayout_program_mix(h, (uint64_t)expr->attr);
+    h = coslayout_program_mix(h, (uint64_t)(expr->binding + 1));
+    h = coslayout_program_mix(h, bits);
+
+    h = coslayout_program_hash_expr(h, expr->l);
+
+    return coslayout_program_hash_expr(h, expr->r);
+}
+
+static uint64_t coslayout_program_hash(const COSLAYOUT_RULESET *set) {
+    uint64_t h = coslayout_program_mix(0, (uint64_t)(set->h_count * 4 + set->v_count));
+
+    for (int i = 0; i < 2; ++i) {
+        h = coslayout_program_mix(h, (uint64_t)(set->h_attrs[i] * 64 + set->v_attrs[i]));
+    }
+
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        h = coslayout_program_hash_expr(h, set->exprs[attr]);
+    }
+
+    return h;
+}
+
+static int coslayout_expr_equal(const COSLAYOUT_EXPR *a, const COSLAYOUT_EXPR *b) {
+    if (a == b) return 1;
+    if (a == NULL || b == NULL) return 0;
+
+    return (a->kind == b->kind &&
+            a->dir == b->dir &&
+            a->attr == b->attr &&
+            a->binding == b->binding &&
+            a->reads == b->reads &&
+            a->value == b->value &&
+            a->ref == b->ref &&
+            a->func == b->func &&
+            a->info == b->info &&
+            coslayout_expr_equal(a->l, b->l) &&
+            coslayout_expr_equal(a->r, b->r));
+}
+
+static int coslayout_ruleset_equal(const COSLAYOUT_RULESET *a, const COSLAYOUT_RULESET *b) {
+    if (a->h_count != b->h_count || a->v_count != b->v_count) return 0;
+    if (a->h_reads != b->h_reads || a->v_reads != b->v_reads) return 0;
+
+    for (int i = 0; i < a->h_count; ++i) {
+        if (a->h_attrs[i] != b->h_attrs[i]) return 0;
+    }
+
+    for (int i = 0; i < a->v_count; ++i) {
+        if (a->v_attrs[i] != b->v_attrs[i]) return 0;
+    }
+
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        if (!coslayout_expr_equal(a->exprs[attr], b->exprs[attr])) return 0;
+    }
+
+    return 1;
+}
+
+/* Takes over set, returns a new reference to the interned program. */
+static COSLAYOUT_PROGRAM *coslayout_program_intern(COSLAYOUT_RULESET *set) {
+    uint64_t hash = coslayout_program_hash(set);
+    size_t bucket = hash % COSLAYOUT_PROGRAM_BUCKETS;
+
+    pthread_mutex_lock(&coslayout_programs_lock);
+
+    COSLAYOUT_PROGRAM *program = coslayout_programs[bucket];
+
+    while (program != NULL && !(program->hash == hash && coslayout_ruleset_equal(&program->set, set))) {
+        program = program->next;
+    }
+
+    if (program != NULL) {
+        __atomic_add_fetch(&program->refcount, 1, __ATOMIC_RELAXED);
+
+        pthread_mutex_unlock(&coslayout_programs_lock);
+
+        coslayout_ruleset_destroy(set);
+
+        return program;
+    }
+
+    program = (COSLAYOUT_PROGRAM *)malloc(sizeof(COSLAYOUT_PROGRAM));
+
+    program->refcount = 1;
+    program->hash = hash;
+    program->set = *set;
+    program->next = coslayout_programs[bucket];
+
+    coslayout_programs[bucket] = program;
+    coslayout_programs_count += 1;
+
+    pthread_mutex_unlock(&coslayout_programs_lock);
+
+    return program;
+}
+
+COSLAYOUT_PROGRAM *coslayout_program_create(void) {
+    COSLAYOUT_RULESET set;
+
+    coslayout_ruleset_init(&set);
+
+    return coslayout_program_intern(&set);
+}
+
+COSLAYOUT_PROGRAM *coslayout_program_retain(COSLAYOUT_PROGRAM *program) {
+    if (program != NULL) __atomic_add_fetch(&program->refcount, 1, __ATOMIC_RELAXED);
+
+    return program;
+}
+
+void coslayout_program_release(COSLAYOUT_PROGRAM *program) {
+    if (program == NULL) return;
+
+    pthread_mutex_lock(&coslayout_programs_lock);
+
+    if (__atomic_sub_fetch(&program->refcount, 1, __ATOMIC_ACQ_REL) > 0) {
+        pthread_mutex_unlock(&coslayout_programs_lock);
+        return;
+    }
+
+    COSLAYOUT_PROGRAM **link = &coslayout_programs[program->hash % COSLAYOUT_PROGRAM_BUCKETS];
+
+    while (*link != program) link = &(*link)->next;
+
+    *link = program->next;
+    coslayout_programs_count -= 1;
+
+    pthread_mutex_unlock(&coslayout_programs_lock);
+
+    coslayout_ruleset_destroy(&program->set);
+
+    free(program);
+}
+
+const COSLAYOUT_RULESET *coslayout_program_ruleset(const COSLAYOUT_PROGRAM *program) {
+    return &program->set;
+}
+
+size_t coslayout_program_count(void) {
+    pthread_mutex_lock(&coslayout_programs_lock);
+
+    size_t count = coslayout_programs_count;
+
+    pthread_mutex_unlock(&coslayout_programs_lock);
+
+    return count;
+}
+
+typedef struct COSLAYOUT_BIND_INFO {
+    COSLAYOUT_ARG_FUNC arg;
+    void *info;
+    COSLAYOUT_BINDINGS bindings;
+    size_t capacity;
+} COSLAYOUT_BIND_INFO;
+
+/* Moves expressions of views, blocks and objects into bindings. */
+static COSLAYOUT_EXPR *coslayout_program_arg(void *info, const char *spec, int percentage, int dir) {
+    COSLAYOUT_BIND_INFO *bind = (COSLAYOUT_BIND_INFO *)info;
+    COSLAYOUT_EXPR *expr = bind->arg(bind->info, spec, percentage, dir);
+
+    if (expr == NULL) return NULL;
+
+    switch (expr->kind) {
+    case COSLAYOUT_EXPR_ATTR:
+    case COSLAYOUT_EXPR_CALL:
+    case COSLAYOUT_EXPR_CALL_PERCENTAGE:
+        break;
+
+    default:
+        return expr;
+    }
+
+    if (bind->bindings.count == bind->capacity) {
+        bind->capacity = bind->capacity ? bind->capacity * 2 : 4;
+        bind->bindings.exprs = (COSLAYOUT_EXPR **)realloc(bind->bindings.exprs, bind->capacity * sizeof(COSLAYOUT_EXPR *));
+    }
+
+    int binding = (int)bind->bindings.count;
+
+    bind->bindings.exprs[bind->bindings.count++] = expr;
+
+    return coslayout_expr_create_binding(binding, coslayout_expr_reads(expr, COSLAYOUT_DIR_NONE));
+}
+
+static void coslayout_program_number(const COSLAYOUT_EXPR *expr, int *map, int *count) {
+    if (expr == NULL) return;
+
+    if (expr->kind == COSLAYOUT_EXPR_BINDING) {
+        if (map[expr->binding] < 0) map[expr->binding] = (*count)++;
+        return;
+    }
+
+    coslayout_program_number(expr->l, map, count);
+    coslayout_program_number(expr->r, map, count);
+}
+
+/* Returns a new reference to expr with bindings renumbered by map. */
+static COSLAYOUT_EXPR *coslayout_program_rebind(COSLAYOUT_EXPR *expr, const int *map) {
+    if (expr == NULL) return NULL;
+
+    if (expr->kind == COSLAYOUT_EXPR_BINDING) {
+        if (map[expr->binding] == expr->binding) return coslayout_expr_retain(expr);
+
+        return coslayout_expr_create_binding(map[expr->binding], expr->reads);
+    }
+
+    if (expr->l == NULL && expr->r == NULL) return coslayout_expr_retain(expr);
+
+    COSLAYOUT_EXPR *l = coslayout_program_rebind(expr->l, map);
+    COSLAYOUT_EXPR *r = coslayout_program_rebind(expr->r, map);
+    COSLAYOUT_EXPR *result;
+
+    if (l == expr->l && r == expr->r) {
+        result = coslayout_expr_retain(expr);
+    } else if (expr->kind == COSLAYOUT_EXPR_FLIP) {
+        result = coslayout_expr_create_flip(l, expr->dir);
+    } else {
+        result = coslayout_expr_create_binary(expr->kind, l, r);
+    }
+
+    coslayout_expr_release(l);
+    coslayout_expr_release(r);
+
+    return result;
+}
+
+int coslayout_program_add_rule(
+    COSLAYOUT_PROGRAM **program,
+    COSLAYOUT_BINDINGS *bindings,
+    const char *rule,
+    COSLAYOUT_ARG_FUNC arg,
+    void *info)
+{
+    COSLAYOUT_RULESET set;
+    COSLAYOUT_BIND_INFO bind = { arg, info, { 0, NULL }, 0 };
+
+    coslayout_ruleset_copy(&set, &(*program)->set);
+    coslayout_bindings_copy(&bind.bindings, bindings);
+
+    bind.capacity = bind.bindings.count;
+
+    int result = coslayout_ruleset_add_rule(&set, rule, coslayout_program_arg, &bind);
+
+    if (result != 0) {
+        coslayout_ruleset_destroy(&set);
+        coslayout_bindings_destroy(&bind.bindings);
+
+        return result;
+    }
+
+    /* Renumber bindings by first appearance, dropping replaced ones, so
+     * equal rules end up with equal programs. */
+    size_t total = bind.bindings.count;
+    int *map = (int *)malloc((total ? total : 1) * sizeof(int));
+    int count = 0;
+
+    for (size_t i = 0; i < total; ++i) map[i] = -1;
+
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        coslayout_program_number(set.exprs[attr], map, &count);
+    }
+
+    COSLAYOUT_RULESET canonical = set;
+
+    for (int attr = 0; attr < COSLAYOUT_ATTR_COUNT; ++attr) {
+        canonical.exprs[attr] = coslayout_program_rebind(set.exprs[attr], map);
+        canonical.sources[attr] = coslayout_source_retain(set.sources[attr]);
+    }
+
+    coslayout_ruleset_destroy(&set);
+
+    COSLAYOUT_BINDINGS result_bindings = { (size_t)count, NULL };
+
+    if (count > 0) {
+        result_bindings.exprs = (COSLAYOUT_EXPR **)malloc((size_t)count * sizeof(COSLAYOUT_EXPR *));
+    }
+
+    for (size_t i = 0; i < total; ++i) {
+        if (map[i] >= 0) {
+            result_bindings.exprs[map[i]] = coslayout_expr_retain(bind.bindings.exprs[i]);
+        }
+    }
+
+    free(map);
+
+    coslayout_bindings_destroy(&bind.bindings);
+    coslayout_bindings_destroy(bindings);
+
+    *bindings = result_bindings;
+
+    COSLAYOUT_PROGRAM *previous = *program;
+
+    *program = coslayout_program_intern(&canonical);
+
+    coslayout_program_release(previous);
+
+    return 0;
+}
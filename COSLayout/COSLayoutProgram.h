@@ -0,0 +1,83 @@
+// COSLayoutProgram.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Rule programs shared between views.
+//
+// A program is an immutable rule set whose references to views, blocks
+// and objects are binding expressions. What they stand for is kept per
+// view in bindings, numbered in the order they first appear in the rules.
+// Programs are interned: views with equal rules share one program however
+// the rules were added, so reusable cells built the same way hold a single
+// copy. Adding a rule never changes a program, it replaces the program of
+// the view with another one.
+
+#ifndef COSLAYOUT_PROGRAM_H
+#define COSLAYOUT_PROGRAM_H
+
+#include "COSLayoutCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct COSLAYOUT_PROGRAM COSLAYOUT_PROGRAM;
+
+/* Expressions bound by a view, each holding one reference. */
+typedef struct COSLAYOUT_BINDINGS {
+    size_t count;
+    COSLAYOUT_EXPR **exprs;
+} COSLAYOUT_BINDINGS;
+
+void coslayout_bindings_init(COSLAYOUT_BINDINGS *bindings);
+void coslayout_bindings_copy(COSLAYOUT_BINDINGS *dst, const COSLAYOUT_BINDINGS *src);
+void coslayout_bindings_destroy(COSLAYOUT_BINDINGS *bindings);
+
+/* Returns a new reference to the program without rules. */
+COSLAYOUT_PROGRAM *coslayout_program_create(void);
+
+COSLAYOUT_PROGRAM *coslayout_program_retain(COSLAYOUT_PROGRAM *program);
+void coslayout_program_release(COSLAYOUT_PROGRAM *program);
+
+const COSLAYOUT_RULESET *coslayout_program_ruleset(const COSLAYOUT_PROGRAM *program);
+
+/* Number of distinct programs alive. */
+size_t coslayout_program_count(void);
+
+/* Adds rules like coslayout_ruleset_add_rule. Expressions of views, blocks
+ * and objects returned by arg are moved to bindings. On success, program
+ * is replaced by a new reference to the resulting program and bindings by
+ * those of it. Both are left unchanged on failure. */
+int coslayout_program_add_rule(
+    COSLAYOUT_PROGRAM **program,
+    COSLAYOUT_BINDINGS *bindings,
+    const char *rule,
+    COSLAYOUT_ARG_FUNC arg,
+    void *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,202 @@
+// COSLayoutRegistry.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutRegistry.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define COSLAYOUT_REGISTRY_MIN_CAPACITY 16
+
+typedef struct COSLAYOUT_REGISTRY_SLOT {
+    const void *key;
+    void *value;
+} COSLAYOUT_REGISTRY_SLOT;
+
+/* Open addressed, at most half of the slots have a key so that probing
+ * always ends at an empty slot. Keys stay in their slot once inserted,
+ * a removed key keeps its slot with a NULL value until the table is
+ * rebuilt. */
+typedef struct COSLAYOUT_REGISTRY_TABLE {
+    struct COSLAYOUT_REGISTRY_TABLE *retired;
+    size_t mask;
+    COSLAYOUT_REGISTRY_SLOT slots[];
+} COSLAYOUT_REGISTRY_TABLE;
+
+/* Rebuilt tables are published atomically. A lookup may still read the
+ * table it replaced, so replaced tables are retired and only freed with
+ * the registry. Lookups then share no counter with each other, and a
+ * table retires only after at least as many insertions as it has keys,
+ * so retired tables take memory in proportion to insertions. */
+struct COSLAYOUT_REGISTRY {
+    pthread_mutex_t mutex;
+    COSLAYOUT_REGISTRY_TABLE *table;
+    COSLAYOUT_REGISTRY_TABLE *retired;
+    size_t used;
+    size_t count;
+};
+
+static size_t coslayout_registry_hash(const void *key) {
+    uint64_t h = (uint64_t)(uintptr_t)key;
+
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+
+    return (size_t)h;
+}
+
+static COSLAYOUT_REGISTRY_TABLE *coslayout_registry_table_create(size_t capacity) {
+    COSLAYOUT_REGISTRY_TABLE *table = (COSLAYOUT_REGISTRY_TABLE *)calloc(1, sizeof(COSLAYOUT_REGISTRY_TABLE) + capacity * sizeof(COSLAYOUT_REGISTRY_SLOT));
+
+    table->mask = capacity - 1;
+
+    return table;
+}
+
+static void coslayout_registry_table_free(COSLAYOUT_REGISTRY_TABLE *table) {
+    while (table != NULL) {
+        COSLAYOUT_REGISTRY_TABLE *retired = table->retired;
+
+        free(table);
+        table = retired;
+    }
+}
+
+COSLAYOUT_REGISTRY *coslayout_registry_create(void) {
+    COSLAYOUT_REGISTRY *registry = (COSLAYOUT_REGISTRY *)calloc(1, sizeof(COSLAYOUT_REGISTRY));
+
+    pthread_mutex_init(&registry->mutex, NULL);
+
+    registry->table = coslayout_registry_table_create(COSLAYOUT_REGISTRY_MIN_CAPACITY);
+
+    return registry;
+}
+
+void coslayout_registry_destroy(COSLAYOUT_REGISTRY *registry) {
+    if (registry == NULL) return;
+
+    coslayout_registry_table_free(registry->retired);
+    coslayout_registry_table_free(registry->table);
+
+    pthread_mutex_destroy(&registry->mutex);
+
+    free(registry);
+}
+
+void *coslayout_registry_get(COSLAYOUT_REGISTRY *registry, const void *key) {
+    COSLAYOUT_REGISTRY_TABLE *table = __atomic_load_n(&registry->table, __ATOMIC_ACQUIRE);
+
+    for (size_t i = coslayout_registry_hash(key) & table->mask;; i = (i + 1) & table->mask) {
+        const void *slot_key = __atomic_load_n(&table->slots[i].key, __ATOMIC_ACQUIRE);
+
+        if (slot_key == key) return __atomic_load_n(&table->slots[i].value, __ATOMIC_ACQUIRE);
+        if (slot_key == NULL) return NULL;
+    }
+}
+
+static COSLAYOUT_REGISTRY_SLOT *coslayout_registry_probe(COSLAYOUT_REGISTRY_TABLE *table, const void *key) {
+    size_t i = coslayout_registry_hash(key) & table->mask;
+
+    while (table->slots[i].key != NULL && table->slots[i].key != key) {
+        i = (i + 1) & table->mask;
+    }
+
+    return &table->slots[i];
+}
+
+/* Replaces the table by one holding only mapped keys, with room for at
+ * least as many insertions as there are keys. */
+static void coslayout_registry_rebuild(COSLAYOUT_REGISTRY *registry) {
+    COSLAYOUT_REGISTRY_TABLE *table = registry->table;
+
+    size_t capacity = COSLAYOUT_REGISTRY_MIN_CAPACITY;
+
+    while (capacity < (registry->count + 1) * 4) {
+        capacity *= 2;
+    }
+
+    COSLAYOUT_REGISTRY_TABLE *rebuilt = coslayout_registry_table_create(capacity);
+
+    for (size_t i = 0; i <= table->mask; ++i) {
+        if (table->slots[i].value != NULL) {
+            *coslayout_registry_probe(rebuilt, table->slots[i].key) = table->slots[i];
+        }
+    }
+
+    __atomic_store_n(&registry->table, rebuilt, __ATOMIC_RELEASE);
+
+    table->retired = registry->retired;
+    registry->retired = table;
+    registry->used = registry->count;
+}
+
+static void coslayout_registry_store(COSLAYOUT_REGISTRY *registry, const void *key, void *value) {
+    COSLAYOUT_REGISTRY_SLOT *slot = coslayout_registry_probe(registry->table, key);
+
+    if (slot->key == key) {
+        if (slot->value == NULL && value != NULL) registry->count += 1;
+        if (slot->value != NULL && value == NULL) registry->count -= 1;
+
+        __atomic_store_n(&slot->value, value, __ATOMIC_RELEASE);
+        return;
+    }
+
+    if (value == NULL) return;
+
+    if ((registry->used + 1) * 2 > registry->table->mask + 1) {
+        coslayout_registry_rebuild(registry);
+
+        slot = coslayout_registry_probe(registry->table, key);
+    }
+
+    /* The value is in place before lookups can find the key. */
+    slot->value = value;
+    __atomic_store_n(&slot->key, key, __ATOMIC_RELEASE);
+
+    registry->used += 1;
+    registry->count += 1;
+}
+
+void coslayout_registry_set(COSLAYOUT_REGISTRY *registry, const void *key, void *value) {
+    pthread_mutex_lock(&registry->mutex);
+
+    coslayout_registry_store(registry, key, value);
+
+    pthread_mutex_unlock(&registry->mutex);
+}
+
+void coslayout_registry_remove(COSLAYOUT_REGISTRY *registry, const void *key, void *value) {
+    pthread_mutex_lock(&registry->mutex);
+
+    COSLAYOUT_REGISTRY_SLOT *slot = coslayout_registry_probe(registry->table, key);
+
+    if (slot->key == key && slot->value == value) {
+        coslayout_registry_store(registry, key, NULL);
+    }
+
+    pthread_mutex_unlock(&registry->mutex);
+}
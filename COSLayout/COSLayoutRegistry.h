@@ -0,0 +1,59 @@
+// COSLayoutRegistry.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Map of pointers to pointers with lock free lookups.
+//
+// Lookups never block and may run on any thread while others change the
+// map. They only load, so concurrent lookups do not contend. Changes are
+// serialized by a mutex, and tables outgrown by changes are kept until
+// the map is destroyed. Meant for small maps which are read far more
+// often than written, such as solvers by container view.
+
+#ifndef COSLAYOUT_REGISTRY_H
+#define COSLAYOUT_REGISTRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct COSLAYOUT_REGISTRY COSLAYOUT_REGISTRY;
+
+COSLAYOUT_REGISTRY *coslayout_registry_create(void);
+void coslayout_registry_destroy(COSLAYOUT_REGISTRY *registry);
+
+/* Value of key, or NULL if key is not mapped. */
+void *coslayout_registry_get(COSLAYOUT_REGISTRY *registry, const void *key);
+
+/* Maps key to value, a NULL value removes key. */
+void coslayout_registry_set(COSLAYOUT_REGISTRY *registry, const void *key, void *value);
+
+/* Removes key only if it is still mapped to value. */
+void coslayout_registry_remove(COSLAYOUT_REGISTRY *registry, const void *key, void *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,596 @@
+// COSLayoutSession.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutSession.h"
+#include "COSLayoutRegistry.h"
+#include "COSLayoutStats.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct COSLAYOUT_SESSION_VIEW {
+    const void *view;
+    COSLAYOUT_RECT frame;
+    int live;
+} COSLAYOUT_SESSION_VIEW;
+
+int coslayout_session_recording = 0;
+
+/* The session changes under the mutex. Ids map views to their number plus
+ * one, so that no view maps to NULL. */
+static pthread_mutex_t coslayout_session_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {
+    FILE *file;
+    COSLAYOUT_REGISTRY *ids;
+    COSLAYOUT_SESSION_VIEW *views;
+    size_t count;
+    size_t capacity;
+} coslayout_session;
+
+int coslayout_session_start(FILE *file) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    if (coslayout_session.file != NULL) {
+        pthread_mutex_unlock(&coslayout_session_mutex);
+        return -1;
+    }
+
+    coslayout_session.file = file;
+    coslayout_session.ids = coslayout_registry_create();
+
+    fputs("coslayout-session 1\n", file);
+
+    __atomic_store_n(&coslayout_session_recording, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+
+    return 0;
+}
+
+int coslayout_session_stop(void) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    FILE *file = coslayout_session.file;
+    int result = 0;
+
+    __atomic_store_n(&coslayout_session_recording, 0, __ATOMIC_RELAXED);
+
+    if (file != NULL) {
+        result = ferror(file) ? -1 : 0;
+
+        if (fclose(file) != 0) result = -1;
+
+        coslayout_registry_destroy(coslayout_session.ids);
+        free(coslayout_session.views);
+
+        memset(&coslayout_session, 0, sizeof(coslayout_session));
+    }
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+
+    return result;
+}
+
+static long coslayout_session_id(const void *view) {
+    return (long)(intptr_t)coslayout_registry_get(coslayout_session.ids, view) - 1;
+}
+
+static void coslayout_session_write_rect(FILE *file, COSLAYOUT_RECT rect) {
+    fprintf(file, " %.17g %.17g %.17g %.17g\n", rect.x, rect.y, rect.w, rect.h);
+}
+
+long coslayout_session_view(const void *view, long superview, COSLAYOUT_RECT frame) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    if (coslayout_session.file == NULL) {
+        pthread_mutex_unlock(&coslayout_session_mutex);
+        return -1;
+    }
+
+    long id = coslayout_session_id(view);
+
+    if (id < 0) {
+        if (coslayout_session.count == coslayout_session.capacity) {
+            coslayout_session.capacity = coslayout_session.capacity ? coslayout_session.capacity * 2 : 64;
+            coslayout_session.views = (COSLAYOUT_SESSION_VIEW *)realloc(
+                coslayout_session.views, coslayout_session.capacity * sizeof(COSLAYOUT_SESSION_VIEW));
+        }
+
+        id = (long)coslayout_session.count++;
+
+        coslayout_session.views[id] = (COSLAYOUT_SESSION_VIEW){ view, frame, 1 };
+        coslayout_registry_set(coslayout_session.ids, view, (void *)(intptr_t)(id + 1));
+
+        fprintf(coslayout_session.file, "v %ld %ld", id, superview);
+        coslayout_session_write_rect(coslayout_session.file, frame);
+    }
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+
+    return id;
+}
+
+long coslayout_session_find(const void *view) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    long id = coslayout_session.file ? coslayout_session_id(view) : -1;
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+
+    return id;
+}
+
+void coslayout_session_rule(long view, const char *rule, const COSLAYOUT_SESSION_ARG *args, size_t count) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    FILE *file = coslayout_session.file;
+
+    if (file != NULL && view >= 0) {
+        fprintf(file, "r %ld %zu", view, count);
+
+        for (size_t i = 0; i < count; ++i) {
+            if (args[i].view >= 0) {
+                fprintf(file, " v:%ld", args[i].view);
+            } else {
+                fprintf(file, " n:%.17g", args[i].number);
+            }
+        }
+
+        fputc(' ', file);
+
+        /* Rules are kept on one line. */
+        for (const char *c = rule; *c; ++c) {
+            fputc(*c == '\n' || *c == '\r' ? ' ' : *c, file);
+        }
+
+        fputc('\n', file);
+    }
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+}
+
+void coslayout_session_move(long view, long superview) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    if (coslayout_session.file != NULL && view >= 0) {
+        fprintf(coslayout_session.file, "m %ld %ld\n", view, superview);
+    }
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+}
+
+void coslayout_session_name(long container, long view, const char *name) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    if (coslayout_session.file != NULL && container >= 0 && view >= 0) {
+        fprintf(coslayout_session.file, "n %ld %ld %s\n", container, view, name);
+    }
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+}
+
+void coslayout_session_param(long view, const char *name, double value) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    if (coslayout_session.file != NULL && view >= 0) {
+        fprintf(coslayout_session.file, "p %ld %.17g %s\n", view, value, name);
+    }
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+}
+
+void coslayout_session_solve(const void *container, COSLAYOUT_FRAME_FUNC frame, void *info) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    FILE *file = coslayout_session.file;
+    long id = file ? coslayout_session_id(container) : -1;
+
+    if (id >= 0) {
+        for (size_t i = 0; i < coslayout_session.count; ++i) {
+            COSLAYOUT_SESSION_VIEW *view = &coslayout_session.views[i];
+
+            if (!view->live) continue;
+
+            COSLAYOUT_RECT rect = frame(view->view, info);
+
+            if (rect.x != view->frame.x || rect.y != view->frame.y ||
+                rect.w != view->frame.w || rect.h != view->frame.h)
+            {
+                view->frame = rect;
+
+                fprintf(file, "f %zu", i);
+                coslayout_session_write_rect(file, rect);
+            }
+        }
+
+        fprintf(file, "s %ld\n", id);
+    }
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+}
+
+void coslayout_session_forget(const void *view) {
+    pthread_mutex_lock(&coslayout_session_mutex);
+
+    long id = coslayout_session.file ? coslayout_session_id(view) : -1;
+
+    if (id >= 0) {
+        coslayout_session.views[id].live = 0;
+        coslayout_registry_set(coslayout_session.ids, view, NULL);
+
+        fprintf(coslayout_session.file, "d %ld\n", id);
+    }
+
+    pthread_mutex_unlock(&coslayout_session_mutex);
+}
+
+/* Rule holds the text of a rule, or the name of a parameter or of the
+ * view in parent. */
+typedef struct COSLAYOUT_REPLAY_EVENT {
+    char kind;
+    long view;
+    long parent;
+    COSLAYOUT_RECT frame;
+    double value;
+    char *rule;
+    COSLAYOUT_SESSION_ARG *args;
+    size_t arg_count;
+} COSLAYOUT_REPLAY_EVENT;
+
+struct COSLAYOUT_REPLAY {
+    COSLAYOUT_REPLAY_EVENT *events;
+    size_t count;
+    size_t capacity;
+    size_t views;
+    size_t solves;
+    size_t max_args;
+};
+
+/* Reads a number of a declared view from text, or -1 if allowed. */
+static int coslayout_replay_read_view(const COSLAYOUT_REPLAY *replay, char **text, long *view, int allow_none) {
+    char *end;
+
+    *view = strtol(*text, &end, 10);
+
+    if (end == *text) return 0;
+
+    *text = end;
+
+    return (*view >= 0 && (size_t)*view < replay->views) || (allow_none && *view == -1);
+}
+
+static int coslayout_replay_read_rect(char **text, COSLAYOUT_RECT *rect) {
+    double *values[4] = { &rect->x, &rect->y, &rect->w, &rect->h };
+
+    for (int i = 0; i < 4; ++i) {
+        char *end;
+
+        *values[i] = strtod(*text, &end);
+
+        if (end == *text) return 0;
+
+        *text = end;
+    }
+
+    return 1;
+}
+
+/* Parses one line into event, returns 0 if the line is malformed. */
+static int coslayout_replay_parse(COSLAYOUT_REPLAY *replay, char *line, COSLAYOUT_REPLAY_EVENT *event) {
+    char *text = line + 1;
+
+    memset(event, 0, sizeof(*event));
+
+    event->kind = line[0];
+    event->parent = -1;
+
+    switch (event->kind) {
+    case 'v': {
+        char *end;
+
+        event->view = strtol(text, &end, 10);
+
+        if (end == text || event->view != (long)replay->views) return 0;
+
+        text = end;
+        replay->views += 1;
+
+        return (coslayout_replay_read_view(replay, &text, &event->parent, 1) &&
+                event->parent != event->view &&
+                coslayout_replay_read_rect(&text, &event->frame));
+    }
+
+    case 'r': {
+        if (!coslayout_replay_read_view(replay, &text, &event->view, 0)) return 0;
+
+        char *end;
+        long count = strtol(text, &end, 10);
+
+        if (end == text || count < 0) return 0;
+
+        text = end;
+
+        event->args = (COSLAYOUT_SESSION_ARG *)calloc((size_t)count + 1, sizeof(COSLAYOUT_SESSION_ARG));
+        event->arg_count = (size_t)count;
+
+        for (long i = 0; i < count; ++i) {
+            COSLAYOUT_SESSION_ARG *arg = &event->args[i];
+
+            while (*text == ' ') ++text;
+
+            if (text[0] == 'v' && text[1] == ':') {
+                text += 2;
+
+                if (!coslayout_replay_read_view(replay, &text, &arg->view, 1)) return 0;
+            } else if (text[0] == 'n' && text[1] == ':') {
+                text += 2;
+
+                arg->number = strtod(text, &end);
+                arg->view = -1;
+
+                if (end == text) return 0;
+
+                text = end;
+            } else {
+                return 0;
+            }
+        }
+
+        if (*text != ' ') return 0;
+
+        size_t length = strlen(text + 1);
+
+        event->rule = (char *)malloc(length + 1);
+        memcpy(event->rule, text + 1, length + 1);
+
+        if ((size_t)count > replay->max_args) replay->max_args = (size_t)count;
+
+        return 1;
+    }
+
+    case 'm':
+        return (coslayout_replay_read_view(replay, &text, &event->view, 0) &&
+                coslayout_replay_read_view(replay, &text, &event->parent, 1) &&
+                event->parent != event->view);
+
+    case 'f':
+        return (coslayout_replay_read_view(replay, &text, &event->view, 0) &&
+                coslayout_replay_read_rect(&text, &event->frame));
+
+    case 'n':
+        if (!coslayout_replay_read_view(replay, &text, &event->view, 0) ||
+            !coslayout_replay_read_view(replay, &text, &event->parent, 0) ||
+            *text != ' ' || text[1] == '\0')
+        {
+            return 0;
+        }
+
+        event->rule = (char *)malloc(strlen(text + 1) + 1);
+        strcpy(event->rule, text + 1);
+
+        return 1;
+
+    case 'p': {
+        if (!coslayout_replay_read_view(replay, &text, &event->view, 0)) return 0;
+
+        char *end;
+
+        event->value = strtod(text, &end);
+
+        if (end == text || *end != ' ' || end[1] == '\0') return 0;
+
+        size_t length = strlen(end + 1);
+
+        event->rule = (char *)malloc(length + 1);
+        memcpy(event->rule, end + 1, length + 1);
+
+        return 1;
+    }
+
+    case 's':
+        replay->solves += 1;
+
+        return coslayout_replay_read_view(replay, &text, &event->view, 0);
+
+    case 'd':
+        return coslayout_replay_read_view(replay, &text, &event->view, 0);
+
+    default:
+        return 0;
+    }
+}
+
+static void coslayout_replay_event_destroy(COSLAYOUT_REPLAY_EVENT *event) {
+    free(event->rule);
+    free(event->args);
+}
+
+COSLAYOUT_REPLAY *coslayout_replay_load(FILE *file, size_t *line) {
+    COSLAYOUT_REPLAY *replay = (COSLAYOUT_REPLAY *)calloc(1, sizeof(COSLAYOUT_REPLAY));
+    char *text = NULL;
+    size_t size = 0;
+    ssize_t length;
+
+    *line = 0;
+
+    while ((length = getline(&text, &size, file)) >= 0) {
+        *line += 1;
+
+        while (length > 0 && (text[length - 1] == '\n' || text[length - 1] == '\r')) {
+            text[--length] = '\0';
+        }
+
+        if (*line == 1) {
+            if (strcmp(text, "coslayout-session 1") != 0) break;
+            continue;
+        }
+
+        if (length == 0) continue;
+
+        if (replay->count == replay->capacity) {
+            replay->capacity = replay->capacity ? replay->capacity * 2 : 256;
+            replay->events = (COSLAYOUT_REPLAY_EVENT *)realloc(
+                replay->events, replay->capacity * sizeof(COSLAYOUT_REPLAY_EVENT));
+        }
+
+        COSLAYOUT_REPLAY_EVENT *event = &replay->events[replay->count];
+
+        if (!coslayout_replay_parse(replay, text, event)) {
+            coslayout_replay_event_destroy(event);
+            break;
+        }
+
+        replay->count += 1;
+    }
+
+    int complete = length < 0 && *line > 0 && !ferror(file);
+
+    free(text);
+
+    if (!complete) {
+        coslayout_replay_destroy(replay);
+        return NULL;
+    }
+
+    return replay;
+}
+
+void coslayout_replay_destroy(COSLAYOUT_REPLAY *replay) {
+    if (replay == NULL) return;
+
+    for (size_t i = 0; i < replay->count; ++i) {
+        coslayout_replay_event_destroy(&replay->events[i]);
+    }
+
+    free(replay->events);
+    free(replay);
+}
+
+size_t coslayout_replay_views(const COSLAYOUT_REPLAY *replay) {
+    return replay->views;
+}
+
+size_t coslayout_replay_solves(const COSLAYOUT_REPLAY *replay) {
+    return replay->solves;
+}
+
+/* Removes view from the tree but keeps it, rules may still refer to it. */
+static void coslayout_replay_detach(COSLAYOUT_VIEW *view) {
+    while (coslayout_view_subview_count(view) > 0) {
+        coslayout_view_remove_from_superview(coslayout_view_subview_at(view, 0));
+    }
+
+    coslayout_view_remove_from_superview(view);
+}
+
+size_t coslayout_replay_run(
+    const COSLAYOUT_REPLAY *replay,
+    COSLAYOUT_POOL *pool,
+    double *seconds,
+    COSLAYOUT_REPLAY_FUNC frames,
+    void *info)
+{
+    COSLAYOUT_VIEW **views = (COSLAYOUT_VIEW **)calloc(replay->views + 1, sizeof(COSLAYOUT_VIEW *));
+    COSLAYOUT_VIEW_ARG *args = (COSLAYOUT_VIEW_ARG *)calloc(replay->max_args + 1, sizeof(COSLAYOUT_VIEW_ARG));
+    size_t solves = 0;
+    size_t failures = 0;
+
+    for (size_t i = 0; i < replay->count; ++i) {
+        const COSLAYOUT_REPLAY_EVENT *event = &replay->events[i];
+        COSLAYOUT_VIEW *view = views[event->view];
+
+        switch (event->kind) {
+        case 'v':
+            view = views[event->view] = coslayout_view_create(event->frame);
+
+            if (event->parent >= 0) coslayout_view_add_subview(views[event->parent], view);
+            break;
+
+        case 'r':
+            for (size_t a = 0; a < event->arg_count; ++a) {
+                long ref = event->args[a].view;
+
+                args[a].number = event->args[a].number;
+                args[a].view = ref >= 0 ? views[ref] : NULL;
+            }
+
+            coslayout_view_add_rule_args(view, event->rule, args, event->arg_count);
+            break;
+
+        case 'm':
+            coslayout_view_remove_from_superview(view);
+
+            if (event->parent >= 0) coslayout_view_add_subview(views[event->parent], view);
+            break;
+
+        case 'f':
+            coslayout_view_set_frame(view, event->frame);
+            break;
+
+        case 'n':
+            coslayout_view_set_named(view, event->rule, views[event->parent]);
+            break;
+
+        case 'p':
+            coslayout_view_set_param(view, event->rule, event->value);
+            break;
+
+        case 's': {
+            uint64_t start = coslayout_stats_now();
+
+            if (coslayout_view_layout(view, pool) != 0) failures += 1;
+
+            if (seconds != NULL) seconds[solves] = (coslayout_stats_now() - start) * 1e-9;
+
+            solves += 1;
+            break;
+        }
+
+        case 'd':
+            coslayout_replay_detach(view);
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < replay->views; ++i) {
+        if (frames != NULL) frames((long)i, coslayout_view_frame(views[i]), info);
+    }
+
+    for (size_t i = 0; i < replay->views; ++i) {
+        coslayout_replay_detach(views[i]);
+    }
+
+    for (size_t i = 0; i < replay->views; ++i) {
+        coslayout_view_destroy(views[i]);
+    }
+
+    free(args);
+    free(views);
+
+    return failures;
+}
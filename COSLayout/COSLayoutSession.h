@@ -0,0 +1,128 @@
+// COSLayoutSession.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Recorded layout sessions, replayed on headless views.
+//
+// While a session is recorded, rules added with their arguments, views
+// moving between superviews, frames changed and solves are written to a
+// file, one event per line. Views are numbered in the order they are first
+// seen and declared with their superview and frame. Replaying a session
+// builds COSLAYOUT_VIEW trees and runs the same solves on them, so that
+// layouts seen on devices become benchmarks anywhere.
+//
+//   coslayout-session 1
+//   v ID PARENT X Y W H      view, with PARENT -1 for a root
+//   r ID ARGC ARG... RULE    rule, ARG n:NUMBER or v:ID, RULE to the end
+//   m ID PARENT              view moved
+//   p ID VALUE NAME          parameter set, NAME without '$'
+//   n ID VIEW NAME           view named in container ID
+//   f ID X Y W H             frame changed
+//   s ID                     subviews of view solved
+//   d ID                     view gone
+
+#ifndef COSLAYOUT_SESSION_H
+#define COSLAYOUT_SESSION_H
+
+#include <stdio.h>
+
+#include "COSLayoutTree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Argument of a recorded rule: a view, or a number if view is negative. */
+typedef struct COSLAYOUT_SESSION_ARG {
+    double number;
+    long view;
+} COSLAYOUT_SESSION_ARG;
+
+typedef COSLAYOUT_RECT (*COSLAYOUT_FRAME_FUNC)(const void *view, void *info);
+
+extern int coslayout_session_recording;
+
+#define COSLAYOUT_SESSION_RECORDING() __atomic_load_n(&coslayout_session_recording, __ATOMIC_RELAXED)
+
+/* Records a session to file, which is closed when recording stops. Returns
+ * -1 if a session is already recorded, 0 otherwise. */
+int coslayout_session_start(FILE *file);
+
+/* Returns -1 if the file could not be written, 0 otherwise. */
+int coslayout_session_stop(void);
+
+/* Number of view, declaring it with its frame in superview, a number or
+ * -1, the first time. Returns -1 if no session is recorded. */
+long coslayout_session_view(const void *view, long superview, COSLAYOUT_RECT frame);
+
+/* Number of view, or -1 if it was not declared. */
+long coslayout_session_find(const void *view);
+
+void coslayout_session_rule(long view, const char *rule, const COSLAYOUT_SESSION_ARG *args, size_t count);
+
+/* Records a view moving to superview, a number or -1. */
+void coslayout_session_move(long view, long superview);
+
+/* Records view named name in container, both numbers. */
+void coslayout_session_name(long container, long view, const char *name);
+
+/* Records a parameter of view set to value. */
+void coslayout_session_param(long view, const char *name, double value);
+
+/* Records frames changed of the views declared, as given by frame, then a
+ * solve of container, which must be declared. */
+void coslayout_session_solve(const void *container, COSLAYOUT_FRAME_FUNC frame, void *info);
+
+/* Records view gone. Views must be forgotten before their memory is
+ * reused. */
+void coslayout_session_forget(const void *view);
+
+typedef struct COSLAYOUT_REPLAY COSLAYOUT_REPLAY;
+
+/* Loads the session in file. Returns NULL and sets line to the line at
+ * fault if the session is malformed. */
+COSLAYOUT_REPLAY *coslayout_replay_load(FILE *file, size_t *line);
+void coslayout_replay_destroy(COSLAYOUT_REPLAY *replay);
+
+size_t coslayout_replay_views(const COSLAYOUT_REPLAY *replay);
+size_t coslayout_replay_solves(const COSLAYOUT_REPLAY *replay);
+
+typedef void (*COSLAYOUT_REPLAY_FUNC)(long view, COSLAYOUT_RECT frame, void *info);
+
+/* Runs the session on new headless views, solving on pool if not NULL.
+ * Seconds, if not NULL, receives the time of each solve. Frames, if not
+ * NULL, is called with the final frame of each view. Returns the number
+ * of solves failing on cycles. */
+size_t coslayout_replay_run(
+    const COSLAYOUT_REPLAY *replay,
+    COSLAYOUT_POOL *pool,
+    double *seconds,
+    COSLAYOUT_REPLAY_FUNC frames,
+    void *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
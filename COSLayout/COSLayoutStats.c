@@ -0,0 +1,177 @@
+// COSLayoutStats.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutStats.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+int coslayout_stats_enabled = 0;
+
+/* Counters are added to atomically and the start of the elapsed time
+ * changes under the mutex. The pass function is replaced under its own
+ * mutex, and called after it is unlocked. */
+static struct {
+    uint64_t passes;
+    uint64_t views;
+    uint64_t evaluations;
+    uint64_t changed;
+    uint64_t solve_ns;
+    uint64_t parses;
+    uint64_t parse_ns;
+    uint64_t start_ns;
+} coslayout_stats;
+
+static pthread_mutex_t coslayout_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* The pass function with its info, referenced by the stats and by every
+ * call running. */
+typedef struct COSLAYOUT_PASS_HANDLER {
+    COSLAYOUT_PASS_FUNC func;
+    void *info;
+    void (*release)(void *info);
+    size_t refcount;
+} COSLAYOUT_PASS_HANDLER;
+
+static pthread_mutex_t coslayout_stats_pass_mutex = PTHREAD_MUTEX_INITIALIZER;
+static COSLAYOUT_PASS_HANDLER *coslayout_stats_pass_handler = NULL;
+
+#define COSLAYOUT_STATS_ADD(field, value) \
+    __atomic_add_fetch(&coslayout_stats.field, (uint64_t)(value), __ATOMIC_RELAXED)
+
+#define COSLAYOUT_STATS_LOAD(field) \
+    __atomic_load_n(&coslayout_stats.field, __ATOMIC_RELAXED)
+
+uint64_t coslayout_stats_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void coslayout_stats_set_enabled(int enabled) {
+    pthread_mutex_lock(&coslayout_stats_mutex);
+
+    if (enabled && !coslayout_stats_enabled) {
+        __atomic_store_n(&coslayout_stats.start_ns, coslayout_stats_now(), __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&coslayout_stats_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&coslayout_stats_mutex);
+}
+
+static void coslayout_stats_pass_handler_release(COSLAYOUT_PASS_HANDLER *handler) {
+    if (handler == NULL || __atomic_sub_fetch(&handler->refcount, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+    if (handler->release != NULL) handler->release(handler->info);
+
+    free(handler);
+}
+
+void coslayout_stats_set_pass_func(COSLAYOUT_PASS_FUNC func, void *info, void (*release)(void *info)) {
+    COSLAYOUT_PASS_HANDLER *handler = NULL;
+
+    if (func != NULL) {
+        handler = (COSLAYOUT_PASS_HANDLER *)malloc(sizeof(COSLAYOUT_PASS_HANDLER));
+
+        *handler = (COSLAYOUT_PASS_HANDLER){ func, info, release, 1 };
+    } else if (release != NULL) {
+        release(info);
+    }
+
+    pthread_mutex_lock(&coslayout_stats_pass_mutex);
+
+    COSLAYOUT_PASS_HANDLER *replaced = coslayout_stats_pass_handler;
+
+    coslayout_stats_pass_handler = handler;
+
+    pthread_mutex_unlock(&coslayout_stats_pass_mutex);
+
+    coslayout_stats_pass_handler_release(replaced);
+}
+
+COSLAYOUT_STATS coslayout_stats_get(void) {
+    COSLAYOUT_STATS stats;
+
+    stats.passes = COSLAYOUT_STATS_LOAD(passes);
+    stats.views = COSLAYOUT_STATS_LOAD(views);
+    stats.evaluations = COSLAYOUT_STATS_LOAD(evaluations);
+    stats.changed = COSLAYOUT_STATS_LOAD(changed);
+    stats.solve_seconds = COSLAYOUT_STATS_LOAD(solve_ns) * 1e-9;
+    stats.parses = COSLAYOUT_STATS_LOAD(parses);
+    stats.parse_seconds = COSLAYOUT_STATS_LOAD(parse_ns) * 1e-9;
+
+    uint64_t start_ns = COSLAYOUT_STATS_LOAD(start_ns);
+
+    stats.elapsed = start_ns ? (coslayout_stats_now() - start_ns) * 1e-9 : 0;
+
+    return stats;
+}
+
+void coslayout_stats_reset(void) {
+    pthread_mutex_lock(&coslayout_stats_mutex);
+
+    __atomic_store_n(&coslayout_stats.passes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&coslayout_stats.views, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&coslayout_stats.evaluations, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&coslayout_stats.changed, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&coslayout_stats.solve_ns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&coslayout_stats.parses, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&coslayout_stats.parse_ns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&coslayout_stats.start_ns, coslayout_stats_enabled ? coslayout_stats_now() : 0, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&coslayout_stats_mutex);
+}
+
+void coslayout_stats_record_pass(const COSLAYOUT_PASS_STATS *pass) {
+    if (!COSLAYOUT_STATS_ENABLED()) return;
+
+    COSLAYOUT_STATS_ADD(passes, 1);
+    COSLAYOUT_STATS_ADD(views, pass->views);
+    COSLAYOUT_STATS_ADD(evaluations, pass->evaluations);
+    COSLAYOUT_STATS_ADD(changed, pass->changed);
+    COSLAYOUT_STATS_ADD(solve_ns, pass->seconds * 1e9);
+
+    pthread_mutex_lock(&coslayout_stats_pass_mutex);
+
+    COSLAYOUT_PASS_HANDLER *handler = coslayout_stats_pass_handler;
+
+    if (handler != NULL) __atomic_add_fetch(&handler->refcount, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&coslayout_stats_pass_mutex);
+
+    if (handler == NULL) return;
+
+    handler->func(pass, handler->info);
+
+    coslayout_stats_pass_handler_release(handler);
+}
+
+void coslayout_stats_record_parse(uint64_t nanoseconds) {
+    COSLAYOUT_STATS_ADD(parses, 1);
+    COSLAYOUT_STATS_ADD(parse_ns, nanoseconds);
+}
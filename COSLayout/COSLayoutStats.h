@@ -0,0 +1,91 @@
+// COSLayoutStats.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Opt-in statistics of parsing and solving.
+//
+// Counting is off by default. While off, instrumented code pays one load
+// and branch. Totals accumulate from passes recorded by whoever solves,
+// COSLayout for UIKit views and COSLayoutTree for headless ones, and a
+// callback may observe each pass as it is recorded.
+
+#ifndef COSLAYOUT_STATS_H
+#define COSLAYOUT_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct COSLAYOUT_PASS_STATS {
+    size_t views;
+    size_t evaluations;
+    size_t changed;
+    double seconds;
+} COSLAYOUT_PASS_STATS;
+
+/* Views are views solved, evaluations are rules evaluated and changed are
+ * frames that changed when applied. Elapsed is the time since counting was
+ * enabled or reset, so that passes / elapsed is solves per second. */
+typedef struct COSLAYOUT_STATS {
+    uint64_t passes;
+    uint64_t views;
+    uint64_t evaluations;
+    uint64_t changed;
+    double solve_seconds;
+    uint64_t parses;
+    double parse_seconds;
+    double elapsed;
+} COSLAYOUT_STATS;
+
+typedef void (*COSLAYOUT_PASS_FUNC)(const COSLAYOUT_PASS_STATS *pass, void *info);
+
+extern int coslayout_stats_enabled;
+
+#define COSLAYOUT_STATS_ENABLED() __atomic_load_n(&coslayout_stats_enabled, __ATOMIC_RELAXED)
+
+void coslayout_stats_set_enabled(int enabled);
+
+/* Called on the thread recording a pass, while counting is enabled, with
+ * no lock held. Calls may run concurrently, and calls begun before func
+ * is replaced may end after. Release, if not NULL, is called with info
+ * once the last call ended. */
+void coslayout_stats_set_pass_func(COSLAYOUT_PASS_FUNC func, void *info, void (*release)(void *info));
+
+COSLAYOUT_STATS coslayout_stats_get(void);
+void coslayout_stats_reset(void);
+
+/* Monotonic clock in nanoseconds. */
+uint64_t coslayout_stats_now(void);
+
+void coslayout_stats_record_pass(const COSLAYOUT_PASS_STATS *pass);
+void coslayout_stats_record_parse(uint64_t nanoseconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
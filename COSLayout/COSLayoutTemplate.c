@@ -0,0 +1,377 @@
+// COSLayoutTemplate.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutTemplate.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct COSLAYOUT_SLOT {
+    char *name;
+    COSLAYOUT_RULESET rules;
+} COSLAYOUT_SLOT;
+
+/* Slots and their contents are referenced through the addresses of refs:
+ * the container first, then one per slot, then one per content. Refs are
+ * allocated once compiled, so rule expressions can keep pointers to them. */
+struct COSLAYOUT_TEMPLATE {
+    COSLAYOUT_SLOT *slots;
+    size_t count;
+    size_t capacity;
+    char *refs;
+    size_t ref_count;
+    size_t *order;
+    int *levels;
+    int compiled;
+    unsigned long generation;
+};
+
+/* Generations of compiles are unique across templates, so scratches never
+ * take a template for one they prepared at the same address. */
+static unsigned long coslayout_template_generation = 0;
+
+#define COSLAYOUT_MAX_SLOTS 4096
+
+COSLAYOUT_TEMPLATE *coslayout_template_create(void) {
+    COSLAYOUT_TEMPLATE *tmpl = (COSLAYOUT_TEMPLATE *)calloc(1, sizeof(COSLAYOUT_TEMPLATE));
+
+    /* Refs must not move once rules point at them. */
+    tmpl->ref_count = 1 + 2 * COSLAYOUT_MAX_SLOTS;
+    tmpl->refs = (char *)calloc(tmpl->ref_count, 1);
+
+    return tmpl;
+}
+
+void coslayout_template_destroy(COSLAYOUT_TEMPLATE *tmpl) {
+    if (tmpl == NULL) return;
+
+    for (size_t i = 0; i < tmpl->count; ++i) {
+        free(tmpl->slots[i].name);
+        coslayout_ruleset_destroy(&tmpl->slots[i].rules);
+    }
+
+    free(tmpl->slots);
+    free(tmpl->refs);
+    free(tmpl->order);
+    free(tmpl->levels);
+    free(tmpl);
+}
+
+static void *coslayout_template_container_ref(const COSLAYOUT_TEMPLATE *tmpl) {
+    return &tmpl->refs[0];
+}
+
+static void *coslayout_template_slot_ref(const COSLAYOUT_TEMPLATE *tmpl, size_t slot) {
+    return &tmpl->refs[1 + slot];
+}
+
+static void *coslayout_template_content_ref(const COSLAYOUT_TEMPLATE *tmpl, size_t slot) {
+    return &tmpl->refs[1 + COSLAYOUT_MAX_SLOTS + slot];
+}
+
+int coslayout_template_slot_named(const COSLAYOUT_TEMPLATE *tmpl, const char *name) {
+    for (size_t i = 0; i < tmpl->count; ++i) {
+        if (strcmp(tmpl->slots[i].name, name) == 0) return (int)i;
+    }
+
+    return -1;
+}
+
+int coslayout_template_add_slot(COSLAYOUT_TEMPLATE *tmpl, const char *name) {
+    int index = coslayout_template_slot_named(tmpl, name);
+
+    if (index >= 0) return index;
+
+    if (tmpl->count == COSLAYOUT_MAX_SLOTS) return -1;
+
+    if (tmpl->count == tmpl->capacity) {
+        tmpl->capacity = tmpl->capacity ? tmpl->capacity * 2 : 8;
+        tmpl->slots = (COSLAYOUT_SLOT *)realloc(tmpl->slots, tmpl->capacity * sizeof(COSLAYOUT_SLOT));
+    }
+
+    COSLAYOUT_SLOT *slot = &tmpl->slots[tmpl->count];
+    size_t length = strlen(name);
+
+    slot->name = (char *)malloc(length + 1);
+    memcpy(slot->name, name, length + 1);
+
+    coslayout_ruleset_init(&slot->rules);
+
+    tmpl->compiled = 0;
+
+    return (int)tmpl->count++;
+}
+
+size_t coslayout_template_slot_count(const COSLAYOUT_TEMPLATE *tmpl) {
+    return tmpl->count;
+}
+
+typedef struct COSLAYOUT_TEMPLATE_ARGS {
+    COSLAYOUT_TEMPLATE *tmpl;
+    va_list args;
+} COSLAYOUT_TEMPLATE_ARGS;
+
+static COSLAYOUT_EXPR *coslayout_template_arg(void *info, const char *spec, int percentage, int dir) {
+    COSLAYOUT_TEMPLATE_ARGS *targs = (COSLAYOUT_TEMPLATE_ARGS *)info;
+
+    if (spec[0] == '^' || spec[0] == '@' || spec[0] == '*') {
+        fprintf(stderr, "COSLayout: Specifier \"%%%s\" is not supported by templates, ignored.\n", spec);
+        return NULL;
+    }
+
+    if (percentage) {
+        return coslayout_expr_create_percentage(va_arg(targs->args, double), dir);
+    }
+
+    if (spec[0] == 'f') {
+        return coslayout_expr_create_const(va_arg(targs->args, double));
+    }
+
+    int slot = va_arg(targs->args, int);
+    int attr = coslayout_attr_named(spec);
+
+    if (attr < 0) return NULL;
+
+    if (slot < 0) {
+        slot = -slot - 1;
+
+        if ((size_t)slot >= targs->tmpl->count) return NULL;
+
+        return coslayout_expr_create_attr(attr, coslayout_template_content_ref(targs->tmpl, (size_t)slot));
+    }
+
+    if ((size_t)slot >= targs->tmpl->count) return NULL;
+
+    return coslayout_expr_create_attr(attr, coslayout_template_slot_ref(targs->tmpl, (size_t)slot));
+}
+
+int coslayout_template_add_rule(COSLAYOUT_TEMPLATE *tmpl, int slot, const char *rule, ...) {
+    if (slot < 0 || (size_t)slot >= tmpl->count) return 1;
+
+    COSLAYOUT_TEMPLATE_ARGS targs;
+
+    targs.tmpl = tmpl;
+
+    va_start(targs.args, rule);
+
+    int result = coslayout_ruleset_add_rule(&tmpl->slots[slot].rules, rule, coslayout_template_arg, &targs);
+
+    va_end(targs.args);
+
+    tmpl->compiled = 0;
+
+    return result;
+}
+
+int coslayout_template_compile(COSLAYOUT_TEMPLATE *tmpl) {
+    size_t count = tmpl->count;
+
+    COSLAYOUT_NODE *nodes = (COSLAYOUT_NODE *)calloc(count ? count : 1, sizeof(COSLAYOUT_NODE));
+
+    free(tmpl->order);
+    free(tmpl->levels);
+
+    tmpl->order = (size_t *)calloc(count ? count : 1, sizeof(size_t));
+    tmpl->levels = (int *)calloc(count ? count : 1, sizeof(int));
+
+    for (size_t i = 0; i < count; ++i) {
+        nodes[i].set = &tmpl->slots[i].rules;
+        nodes[i].view = coslayout_template_slot_ref(tmpl, i);
+        nodes[i].superview = coslayout_template_container_ref(tmpl);
+    }
+
+    int result = coslayout_nodes_order(nodes, count, tmpl->order);
+
+    for (size_t i = 0; i < count; ++i) {
+        tmpl->levels[i] = nodes[i].level;
+    }
+
+    free(nodes);
+
+    tmpl->compiled = result == 0;
+    tmpl->generation = __atomic_add_fetch(&coslayout_template_generation, 1, __ATOMIC_RELAXED);
+
+    return result;
+}
+
+void coslayout_scratch_init(COSLAYOUT_SCRATCH *scratch) {
+    memset(scratch, 0, sizeof(*scratch));
+
+    coslayout_snapshot_init(&scratch->snapshot);
+}
+
+void coslayout_scratch_destroy(COSLAYOUT_SCRATCH *scratch) {
+    coslayout_snapshot_destroy(&scratch->snapshot);
+
+    free(scratch->nodes);
+
+    memset(scratch, 0, sizeof(*scratch));
+}
+
+/* Inserts the container, the slots and the contents, in this order, so
+ * that entries can be addressed by index while solving. */
+static void coslayout_scratch_prepare(COSLAYOUT_SCRATCH *scratch, const COSLAYOUT_TEMPLATE *tmpl) {
+    size_t count = tmpl->count;
+
+    if (scratch->generation == tmpl->generation) return;
+
+    coslayout_snapshot_clear(&scratch->snapshot);
+
+    coslayout_snapshot_insert(&scratch->snapshot, coslayout_template_container_ref(tmpl));
+
+    for (size_t i = 0; i < count; ++i) {
+        coslayout_snapshot_insert(&scratch->snapshot, coslayout_template_slot_ref(tmpl, i));
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        coslayout_snapshot_insert(&scratch->snapshot, coslayout_template_content_ref(tmpl, i));
+    }
+
+    if (scratch->capacity < count) {
+        scratch->capacity = count;
+        scratch->nodes = (COSLAYOUT_NODE *)realloc(scratch->nodes, count * sizeof(COSLAYOUT_NODE));
+    }
+
+    /* Nodes are static apart from their frames. */
+    for (size_t i = 0; i < count; ++i) {
+        size_t slot = tmpl->order[i];
+        COSLAYOUT_NODE *node = &scratch->nodes[i];
+
+        memset(node, 0, sizeof(*node));
+
+        node->set = &tmpl->slots[slot].rules;
+        node->view = coslayout_template_slot_ref(tmpl, slot);
+        node->superview = coslayout_template_container_ref(tmpl);
+        node->level = tmpl->levels[slot];
+    }
+
+    scratch->generation = tmpl->generation;
+}
+
+double coslayout_template_solve(
+    const COSLAYOUT_TEMPLATE *tmpl,
+    COSLAYOUT_SCRATCH *scratch,
+    double width,
+    const COSLAYOUT_SIZE *contents,
+    COSLAYOUT_RECT *frames)
+{
+    size_t count = tmpl->count;
+
+    if (!tmpl->compiled || count == 0) return 0;
+
+    coslayout_scratch_prepare(scratch, tmpl);
+
+    COSLAYOUT_SNAPSHOT_ENTRY *entries = scratch->snapshot.entries;
+    COSLAYOUT_RECT zero = { 0, 0, 0, 0 };
+
+    entries[0].rect = (COSLAYOUT_RECT){ 0, 0, width, 0 };
+
+    for (size_t i = 0; i < count; ++i) {
+        entries[1 + i].rect = zero;
+        entries[1 + i].width = width;
+
+        entries[1 + count + i].rect = (COSLAYOUT_RECT){ 0, 0, contents[i].w, contents[i].h };
+        entries[1 + count + i].width = width;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        scratch->nodes[i].start = zero;
+        scratch->nodes[i].frame = zero;
+    }
+
+    coslayout_nodes_solve(scratch->nodes, count, &scratch->snapshot, coslayout_template_container_ref(tmpl), -1, NULL);
+
+    double height = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t slot = tmpl->order[i];
+        COSLAYOUT_RECT frame = scratch->nodes[i].frame;
+
+        frames[slot] = frame;
+
+        if (frame.y + frame.h > height) height = frame.y + frame.h;
+    }
+
+    return height;
+}
+
+typedef struct COSLAYOUT_BATCH {
+    const COSLAYOUT_TEMPLATE *tmpl;
+    COSLAYOUT_SCRATCH *scratches;
+    double width;
+    const COSLAYOUT_SIZE *contents;
+    COSLAYOUT_RECT *frames;
+    double *heights;
+} COSLAYOUT_BATCH;
+
+static void coslayout_batch_task(void *info, size_t index, int worker) {
+    COSLAYOUT_BATCH *batch = (COSLAYOUT_BATCH *)info;
+    size_t row = index * batch->tmpl->count;
+
+    double height = coslayout_template_solve(
+        batch->tmpl,
+        &batch->scratches[worker],
+        batch->width,
+        batch->contents + row,
+        batch->frames + row);
+
+    if (batch->heights != NULL) batch->heights[index] = height;
+}
+
+void coslayout_template_solve_batch(
+    const COSLAYOUT_TEMPLATE *tmpl,
+    COSLAYOUT_POOL *pool,
+    double width,
+    size_t count,
+    const COSLAYOUT_SIZE *contents,
+    COSLAYOUT_RECT *frames,
+    double *heights)
+{
+    int thread_count = pool != NULL ? coslayout_pool_thread_count(pool) : 1;
+
+    COSLAYOUT_SCRATCH *scratches = (COSLAYOUT_SCRATCH *)malloc(thread_count * sizeof(COSLAYOUT_SCRATCH));
+
+    for (int i = 0; i < thread_count; ++i) {
+        coslayout_scratch_init(&scratches[i]);
+    }
+
+    COSLAYOUT_BATCH batch = { tmpl, scratches, width, contents, frames, heights };
+
+    if (pool != NULL && thread_count > 1) {
+        coslayout_pool_run(pool, count, coslayout_batch_task, &batch);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            coslayout_batch_task(&batch, i, 0);
+        }
+    }
+
+    for (int i = 0; i < thread_count; ++i) {
+        coslayout_scratch_destroy(&scratches[i]);
+    }
+
+    free(scratches);
+}
@@ -0,0 +1,112 @@
+// COSLayoutTemplate.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Layout templates for precomputing cell sizes without views.
+//
+// A template is a set of named slots, each with its own rules. Rules of a
+// slot reference other slots with view specifiers like %bt, passing the
+// slot index as an int argument, or the measured content size of a slot
+// with %w and %h, passing COSLAYOUT_CONTENT(slot). Solving a template for
+// a container width and the content sizes of one item yields the frame
+// of every slot and the height of the item: the lowest bottom edge among
+// slots. Use an empty slot below the others for a bottom margin.
+//
+// The container has no height while solving, vertical percentages of it
+// evaluate to zero.
+
+#ifndef COSLAYOUT_TEMPLATE_H
+#define COSLAYOUT_TEMPLATE_H
+
+#include "COSLayoutCore.h"
+#include "COSLayoutPool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COSLAYOUT_CONTENT(slot) (-(slot) - 1)
+
+typedef struct COSLAYOUT_SIZE {
+    double w;
+    double h;
+} COSLAYOUT_SIZE;
+
+typedef struct COSLAYOUT_TEMPLATE COSLAYOUT_TEMPLATE;
+
+/* Per-thread state of solving, reusable across items and templates. Nodes
+ * are prepared again whenever the template was compiled since. */
+typedef struct COSLAYOUT_SCRATCH {
+    COSLAYOUT_SNAPSHOT snapshot;
+    COSLAYOUT_NODE *nodes;
+    size_t capacity;
+    unsigned long generation;
+} COSLAYOUT_SCRATCH;
+
+COSLAYOUT_TEMPLATE *coslayout_template_create(void);
+void coslayout_template_destroy(COSLAYOUT_TEMPLATE *tmpl);
+
+/* Returns the index of the slot with name, adding it if needed. */
+int coslayout_template_add_slot(COSLAYOUT_TEMPLATE *tmpl, const char *name);
+int coslayout_template_slot_named(const COSLAYOUT_TEMPLATE *tmpl, const char *name);
+size_t coslayout_template_slot_count(const COSLAYOUT_TEMPLATE *tmpl);
+
+/* Adds rules to a slot. Arguments are doubles for %f and %p, and ints
+ * for view specifiers. Returns the result of coslayout_ruleset_add_rule. */
+int coslayout_template_add_rule(COSLAYOUT_TEMPLATE *tmpl, int slot, const char *rule, ...);
+
+/* Orders slots by their dependencies. Must be called after rules are
+ * added and before solving. Returns -1 on a cycle, 0 otherwise. */
+int coslayout_template_compile(COSLAYOUT_TEMPLATE *tmpl);
+
+void coslayout_scratch_init(COSLAYOUT_SCRATCH *scratch);
+void coslayout_scratch_destroy(COSLAYOUT_SCRATCH *scratch);
+
+/* Solves one item. Contents and frames have one element per slot, frames
+ * are relative to the container. Returns the height of the item. */
+double coslayout_template_solve(
+    const COSLAYOUT_TEMPLATE *tmpl,
+    COSLAYOUT_SCRATCH *scratch,
+    double width,
+    const COSLAYOUT_SIZE *contents,
+    COSLAYOUT_RECT *frames);
+
+/* Solves count items over pool, serially if pool is NULL. Contents and
+ * frames hold one row of slot_count elements per item, heights one
+ * element per item and may be NULL. Each worker solves with its own
+ * scratch. */
+void coslayout_template_solve_batch(
+    const COSLAYOUT_TEMPLATE *tmpl,
+    COSLAYOUT_POOL *pool,
+    double width,
+    size_t count,
+    const COSLAYOUT_SIZE *contents,
+    COSLAYOUT_RECT *frames,
+    double *heights);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
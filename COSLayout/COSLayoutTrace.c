@@ -0,0 +1,202 @@
+// COSLayoutTrace.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutTrace.h"
+#include "COSLayoutStats.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct COSLAYOUT_TRACE_SPAN {
+    const char *name;
+    const void *view;
+    const void *superview;
+    uint64_t start;
+    uint64_t duration;
+    uint32_t thread;
+} COSLAYOUT_TRACE_SPAN;
+
+/* Single producer, single consumer. Only the thread owning the ring moves
+ * head, only a drain moves tail, so each side publishes its index and
+ * reads the other one. */
+typedef struct COSLAYOUT_TRACE_RING {
+    struct COSLAYOUT_TRACE_RING *next;
+    int owned;
+    uint32_t thread;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t dropped;
+    COSLAYOUT_TRACE_SPAN spans[COSLAYOUT_TRACE_CAPACITY];
+} COSLAYOUT_TRACE_RING;
+
+int coslayout_trace_enabled = 0;
+
+/* Rings are pushed without a lock and live as long as the process. Drains
+ * are serialized by the mutex. */
+static COSLAYOUT_TRACE_RING *coslayout_trace_rings = NULL;
+static uint32_t coslayout_trace_threads = 0;
+static pthread_mutex_t coslayout_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t coslayout_trace_key;
+static pthread_once_t coslayout_trace_once = PTHREAD_ONCE_INIT;
+
+static void coslayout_trace_release_ring(void *ring) {
+    __atomic_store_n(&((COSLAYOUT_TRACE_RING *)ring)->owned, 0, __ATOMIC_RELEASE);
+}
+
+static void coslayout_trace_create_key(void) {
+    pthread_key_create(&coslayout_trace_key, coslayout_trace_release_ring);
+}
+
+/* Ring of the calling thread, claimed or made the first time. */
+static COSLAYOUT_TRACE_RING *coslayout_trace_ring(void) {
+    pthread_once(&coslayout_trace_once, coslayout_trace_create_key);
+
+    COSLAYOUT_TRACE_RING *ring = (COSLAYOUT_TRACE_RING *)pthread_getspecific(coslayout_trace_key);
+
+    if (ring != NULL) return ring;
+
+    for (ring = __atomic_load_n(&coslayout_trace_rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        int owned = 0;
+
+        if (__atomic_compare_exchange_n(&ring->owned, &owned, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) break;
+    }
+
+    if (ring == NULL) {
+        ring = (COSLAYOUT_TRACE_RING *)calloc(1, sizeof(COSLAYOUT_TRACE_RING));
+
+        if (ring == NULL) return NULL;
+
+        ring->owned = 1;
+        ring->next = __atomic_load_n(&coslayout_trace_rings, __ATOMIC_RELAXED);
+
+        while (!__atomic_compare_exchange_n(&coslayout_trace_rings, &ring->next, ring, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+    ring->thread = __atomic_add_fetch(&coslayout_trace_threads, 1, __ATOMIC_RELAXED);
+
+    pthread_setspecific(coslayout_trace_key, ring);
+
+    return ring;
+}
+
+void coslayout_trace_set_enabled(int enabled) {
+    __atomic_store_n(&coslayout_trace_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+void coslayout_trace_span(const char *name, uint64_t start, const void *view, const void *superview) {
+    uint64_t now = coslayout_stats_now();
+    COSLAYOUT_TRACE_RING *ring = coslayout_trace_ring();
+
+    if (ring == NULL) return;
+
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= COSLAYOUT_TRACE_CAPACITY) {
+        __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    COSLAYOUT_TRACE_SPAN *span = &ring->spans[head % COSLAYOUT_TRACE_CAPACITY];
+
+    span->name = name;
+    span->view = view;
+    span->superview = superview;
+    span->start = start;
+    span->duration = now - start;
+    span->thread = ring->thread;
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void coslayout_trace_write_span(FILE *file, const COSLAYOUT_TRACE_SPAN *span, long pid, int first) {
+    fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"coslayout\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%u",
+            first ? "" : ",", span->name, span->start * 1e-3, span->duration * 1e-3, pid, (unsigned)span->thread);
+
+    if (span->view != NULL || span->superview != NULL) {
+        fputs(",\"args\":{", file);
+
+        if (span->view != NULL) fprintf(file, "\"view\":\"%p\"", span->view);
+        if (span->view != NULL && span->superview != NULL) fputc(',', file);
+        if (span->superview != NULL) fprintf(file, "\"superview\":\"%p\"", span->superview);
+
+        fputc('}', file);
+    }
+
+    fputc('}', file);
+}
+
+/* Drains every ring, writing spans to file if not NULL. */
+static long coslayout_trace_drain(FILE *file, uint64_t *dropped) {
+    long pid = (long)getpid();
+    long count = 0;
+
+    *dropped = 0;
+
+    for (COSLAYOUT_TRACE_RING *ring = __atomic_load_n(&coslayout_trace_rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+        if (file != NULL) {
+            for (uint64_t i = tail; i < head; ++i) {
+                coslayout_trace_write_span(file, &ring->spans[i % COSLAYOUT_TRACE_CAPACITY], pid, count == 0);
+                count += 1;
+            }
+        }
+
+        *dropped += __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+
+        __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+long coslayout_trace_write(FILE *file) {
+    uint64_t dropped;
+
+    pthread_mutex_lock(&coslayout_trace_mutex);
+
+    fputs("{\"traceEvents\":[", file);
+
+    long count = coslayout_trace_drain(file, &dropped);
+
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%llu}}\n", (unsigned long long)dropped);
+
+    pthread_mutex_unlock(&coslayout_trace_mutex);
+
+    return ferror(file) ? -1 : count;
+}
+
+void coslayout_trace_clear(void) {
+    uint64_t dropped;
+
+    pthread_mutex_lock(&coslayout_trace_mutex);
+
+    coslayout_trace_drain(NULL, &dropped);
+
+    pthread_mutex_unlock(&coslayout_trace_mutex);
+}
@@ -0,0 +1,70 @@
+// COSLayoutTrace.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Trace events of layout, in the Chrome trace event format.
+//
+// Tracing is off by default. While on, spans of adding rules, ordering
+// views, solving each view and committing frames are written to a ring
+// buffer of the thread recording them without locks, and drained into JSON
+// on demand. A thread allocates its ring the first time it records, rings
+// of exited threads are reused. A full ring drops new spans and counts
+// them rather than wait.
+
+#ifndef COSLAYOUT_TRACE_H
+#define COSLAYOUT_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Spans each ring holds until drained. */
+#define COSLAYOUT_TRACE_CAPACITY 8192
+
+extern int coslayout_trace_enabled;
+
+#define COSLAYOUT_TRACE_ENABLED() __atomic_load_n(&coslayout_trace_enabled, __ATOMIC_RELAXED)
+
+void coslayout_trace_set_enabled(int enabled);
+
+/* Records a span named name from start, a time of coslayout_stats_now,
+ * until now. Name must be a string constant. View and superview tag the
+ * span and may be NULL. */
+void coslayout_trace_span(const char *name, uint64_t start, const void *view, const void *superview);
+
+/* Drains spans recorded so far into file as a trace event JSON object.
+ * Returns the number of spans written, or -1 if writing failed. */
+long coslayout_trace_write(FILE *file);
+
+/* Discards spans recorded so far. */
+void coslayout_trace_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,524 @@
+// COSLayoutTree.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "COSLayoutTree.h"
+#include "COSLayoutDump.h"
+#include "COSLayoutProfile.h"
+#include "COSLayoutStats.h"
+#include "COSLayoutTrace.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A view named for rules of the views below a container. */
+typedef struct COSLAYOUT_VIEW_NAME {
+    char *name;
+    COSLAYOUT_VIEW *view;
+} COSLAYOUT_VIEW_NAME;
+
+struct COSLAYOUT_VIEW {
+    COSLAYOUT_VIEW *superview;
+    COSLAYOUT_VIEW **subviews;
+    size_t subview_count;
+    size_t subview_capacity;
+    COSLAYOUT_RECT frame;
+    COSLAYOUT_PROGRAM *program;
+    COSLAYOUT_BINDINGS bindings;
+    COSLAYOUT_PARAMS params;
+    COSLAYOUT_VIEW_NAME *names;
+    size_t name_count;
+    size_t name_capacity;
+    COSLAYOUT_COSTS *costs;
+    int needs_layout;
+};
+
+COSLAYOUT_VIEW *coslayout_view_create(COSLAYOUT_RECT frame) {
+    COSLAYOUT_VIEW *view = (COSLAYOUT_VIEW *)calloc(1, sizeof(COSLAYOUT_VIEW));
+
+    view->frame = frame;
+    view->program = coslayout_program_create();
+
+    coslayout_bindings_init(&view->bindings);
+    coslayout_params_init(&view->params);
+
+    return view;
+}
+
+void coslayout_view_destroy(COSLAYOUT_VIEW *view) {
+    if (view == NULL) return;
+
+    coslayout_view_remove_from_superview(view);
+
+    while (view->subview_count > 0) {
+        coslayout_view_destroy(view->subviews[view->subview_count - 1]);
+    }
+
+    coslayout_program_release(view->program);
+    coslayout_bindings_destroy(&view->bindings);
+    coslayout_params_destroy(&view->params);
+    coslayout_costs_destroy(view->costs);
+
+    for (size_t i = 0; i < view->name_count; ++i) {
+        free(view->names[i].name);
+    }
+
+    free(view->names);
+    free(view->subviews);
+    free(view);
+}
+
+void coslayout_view_add_subview(COSLAYOUT_VIEW *view, COSLAYOUT_VIEW *subview) {
+    coslayout_view_remove_from_superview(subview);
+
+    if (view->subview_count == view->subview_capacity) {
+        view->subview_capacity = view->subview_capacity ? view->subview_capacity * 2 : 4;
+        view->subviews = (COSLAYOUT_VIEW **)realloc(view->subviews, view->subview_capacity * sizeof(COSLAYOUT_VIEW *));
+    }
+
+    view->subviews[view->subview_count++] = subview;
+    subview->superview = view;
+    view->needs_layout = 1;
+}
+
+void coslayout_view_remove_from_superview(COSLAYOUT_VIEW *view) {
+    COSLAYOUT_VIEW *superview = view->superview;
+
+    if (superview == NULL) return;
+
+    for (size_t i = 0; i < superview->subview_count; ++i) {
+        if (superview->subviews[i] == view) {
+            memmove(&superview->subviews[i], &superview->subviews[i + 1],
+                    (superview->subview_count - i - 1) * sizeof(COSLAYOUT_VIEW *));
+            superview->subview_count -= 1;
+            superview->needs_layout = 1;
+            break;
+        }
+    }
+
+    view->superview = NULL;
+}
+
+COSLAYOUT_VIEW *coslayout_view_superview(const COSLAYOUT_VIEW *view) {
+    return view->superview;
+}
+
+size_t coslayout_view_subview_count(const COSLAYOUT_VIEW *view) {
+    return view->subview_count;
+}
+
+COSLAYOUT_VIEW *coslayout_view_subview_at(const COSLAYOUT_VIEW *view, size_t index) {
+    return index < view->subview_count ? view->subviews[index] : NULL;
+}
+
+COSLAYOUT_RECT coslayout_view_frame(const COSLAYOUT_VIEW *view) {
+    return view->frame;
+}
+
+void coslayout_view_set_frame(COSLAYOUT_VIEW *view, COSLAYOUT_RECT frame) {
+    view->frame = frame;
+    view->needs_layout = 1;
+}
+
+static COSLAYOUT_VIEW_NAME *coslayout_view_name(const COSLAYOUT_VIEW *container, const char *name, size_t length) {
+    for (size_t i = 0; i < container->name_count; ++i) {
+        COSLAYOUT_VIEW_NAME *entry = &container->names[i];
+
+        if (strncmp(entry->name, name, length) == 0 && entry->name[length] == '\0') return entry;
+    }
+
+    return NULL;
+}
+
+void coslayout_view_set_named(COSLAYOUT_VIEW *container, const char *name, COSLAYOUT_VIEW *view) {
+    COSLAYOUT_VIEW_NAME *entry = coslayout_view_name(container, name, strlen(name));
+
+    if (entry != NULL) {
+        if (view != NULL) {
+            entry->view = view;
+            return;
+        }
+
+        free(entry->name);
+        *entry = container->names[--container->name_count];
+        return;
+    }
+
+    if (view == NULL) return;
+
+    if (container->name_count == container->name_capacity) {
+        container->name_capacity = container->name_capacity ? container->name_capacity * 2 : 4;
+        container->names = (COSLAYOUT_VIEW_NAME *)realloc(container->names, container->name_capacity * sizeof(COSLAYOUT_VIEW_NAME));
+    }
+
+    size_t length = strlen(name);
+
+    entry = &container->names[container->name_count++];
+    entry->name = (char *)malloc(length + 1);
+    entry->view = view;
+
+    memcpy(entry->name, name, length + 1);
+}
+
+/* Looks name up in container, then in its ancestors. */
+static COSLAYOUT_VIEW *coslayout_view_find(const COSLAYOUT_VIEW *container, const char *name, size_t length) {
+    for (; container != NULL; container = container->superview) {
+        const COSLAYOUT_VIEW_NAME *entry = coslayout_view_name(container, name, length);
+
+        if (entry != NULL) return entry->view;
+    }
+
+    return NULL;
+}
+
+COSLAYOUT_VIEW *coslayout_view_named(const COSLAYOUT_VIEW *container, const char *name) {
+    return coslayout_view_find(container, name, strlen(name));
+}
+
+const COSLAYOUT_RULESET *coslayout_view_ruleset(const COSLAYOUT_VIEW *view) {
+    return coslayout_program_ruleset(view->program);
+}
+
+COSLAYOUT_PROGRAM *coslayout_view_program(const COSLAYOUT_VIEW *view) {
+    return view->program;
+}
+
+/* Expression of a reference by name like header.bt in a rule of view. */
+static COSLAYOUT_EXPR *coslayout_view_reference(const COSLAYOUT_VIEW *view, const char *spec) {
+    size_t length;
+    int attr = coslayout_spec_reference(spec, &length);
+    COSLAYOUT_VIEW *named = attr >= 0 ? coslayout_view_find(view->superview, spec, length) : NULL;
+
+    return named ? coslayout_expr_create_attr(attr, named) : NULL;
+}
+
+typedef struct COSLAYOUT_VA_ARGS {
+    COSLAYOUT_VIEW *view;
+    va_list args;
+} COSLAYOUT_VA_ARGS;
+
+static COSLAYOUT_EXPR *coslayout_view_arg(void *info, const char *spec, int percentage, int dir) {
+    COSLAYOUT_VA_ARGS *va = (COSLAYOUT_VA_ARGS *)info;
+
+    if (strchr(spec, '.') != NULL) return coslayout_view_reference(va->view, spec);
+
+    if (spec[0] == '^' || spec[0] == '@') {
+        fprintf(stderr, "COSLayout: Specifier \"%%%s\" needs UIKit, ignored.\n", spec);
+        return NULL;
+    }
+
+    if (spec[0] == '*') {
+        COSLAYOUT_FUNC func = va_arg(va->args, COSLAYOUT_FUNC);
+        void *info = va_arg(va->args, void *);
+
+        if (func == NULL) return NULL;
+
+        return (percentage ?
+                coslayout_expr_create_call_percentage(func, info, NULL, dir) :
+                coslayout_expr_create_call(func, info, NULL));
+    }
+
+    if (percentage) {
+        return coslayout_expr_create_percentage(va_arg(va->args, double), dir);
+    }
+
+    if (spec[0] == 'f') {
+        return coslayout_expr_create_const(va_arg(va->args, double));
+    }
+
+    COSLAYOUT_VIEW *view = va_arg(va->args, COSLAYOUT_VIEW *);
+    int attr = coslayout_attr_named(spec);
+
+    if (view == NULL || attr < 0) return NULL;
+
+    return coslayout_expr_create_attr(attr, view);
+}
+
+int coslayout_view_add_rule(COSLAYOUT_VIEW *view, const char *rule, ...) {
+    COSLAYOUT_VA_ARGS va;
+    uint64_t traced = COSLAYOUT_TRACE_ENABLED() ? coslayout_stats_now() : 0;
+
+    va.view = view;
+
+    va_start(va.args, rule);
+
+    int result = coslayout_program_add_rule(&view->program, &view->bindings, rule, coslayout_view_arg, &va);
+
+    va_end(va.args);
+
+    if (view->superview != NULL) view->superview->needs_layout = 1;
+
+    if (traced) coslayout_trace_span("add_rule", traced, view, view->superview);
+
+    return result;
+}
+
+typedef struct COSLAYOUT_ARRAY_ARGS {
+    COSLAYOUT_VIEW *view;
+    const COSLAYOUT_VIEW_ARG *args;
+    size_t count;
+    size_t next;
+} COSLAYOUT_ARRAY_ARGS;
+
+static COSLAYOUT_EXPR *coslayout_view_array_arg(void *info, const char *spec, int percentage, int dir) {
+    COSLAYOUT_ARRAY_ARGS *array = (COSLAYOUT_ARRAY_ARGS *)info;
+    COSLAYOUT_VIEW_ARG arg = { 0, NULL, NULL, NULL };
+
+    if (strchr(spec, '.') != NULL) return coslayout_view_reference(array->view, spec);
+
+    if (array->next < array->count) arg = array->args[array->next];
+
+    array->next += 1;
+
+    if (spec[0] == '*' && arg.func != NULL) {
+        return (percentage ?
+                coslayout_expr_create_call_percentage(arg.func, arg.info, NULL, dir) :
+                coslayout_expr_create_call(arg.func, arg.info, NULL));
+    }
+
+    if (percentage) {
+        return coslayout_expr_create_percentage(arg.number, dir);
+    }
+
+    /* Blocks, objects and functions were evaluated into numbers. */
+    if (spec[0] == 'f' || spec[0] == '^' || spec[0] == '@' || spec[0] == '*') {
+        return coslayout_expr_create_const(arg.number);
+    }
+
+    int attr = coslayout_attr_named(spec);
+
+    if (arg.view == NULL || attr < 0) return NULL;
+
+    return coslayout_expr_create_attr(attr, arg.view);
+}
+
+int coslayout_view_add_rule_args(COSLAYOUT_VIEW *view, const char *rule, const COSLAYOUT_VIEW_ARG *args, size_t count) {
+    COSLAYOUT_ARRAY_ARGS array = { view, args, count, 0 };
+    uint64_t traced = COSLAYOUT_TRACE_ENABLED() ? coslayout_stats_now() : 0;
+
+    int result = coslayout_program_add_rule(&view->program, &view->bindings, rule, coslayout_view_array_arg, &array);
+
+    if (view->superview != NULL) view->superview->needs_layout = 1;
+
+    if (traced) coslayout_trace_span("add_rule", traced, view, view->superview);
+
+    return result;
+}
+
+int coslayout_view_set_param(COSLAYOUT_VIEW *view, const char *name, double value) {
+    const char *param = coslayout_param_intern(name);
+
+    if (!coslayout_params_set(&view->params, param, value)) return 0;
+
+    /* Rules of the view read it first, rules of its subviews through it. */
+    if (view->superview != NULL && coslayout_ruleset_reads_param(coslayout_program_ruleset(view->program), param)) {
+        view->superview->needs_layout = 1;
+    }
+
+    for (size_t i = 0; i < view->subview_count && !view->needs_layout; ++i) {
+        if (coslayout_ruleset_reads_param(coslayout_program_ruleset(view->subviews[i]->program), param)) {
+            view->needs_layout = 1;
+        }
+    }
+
+    return 1;
+}
+
+int coslayout_view_get_param(const COSLAYOUT_VIEW *view, const char *name, double *value) {
+    return coslayout_params_get(&view->params, coslayout_param_intern(name), value);
+}
+
+/* Origin of the coordinate space of view, in the space of its root. */
+static void coslayout_view_origin(const COSLAYOUT_VIEW *view, double *x, double *y) {
+    *x = 0;
+    *y = 0;
+
+    for (; view != NULL; view = view->superview) {
+        *x += view->frame.x;
+        *y += view->frame.y;
+    }
+}
+
+static void coslayout_view_capture(COSLAYOUT_SNAPSHOT *snapshot, COSLAYOUT_VIEW *view, double x, double y) {
+    COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_insert(snapshot, view);
+    COSLAYOUT_VIEW *superview = view->superview;
+
+    double ox, oy;
+
+    coslayout_view_origin(view, &ox, &oy);
+
+    entry->rect = (COSLAYOUT_RECT){ ox - x, oy - y, view->frame.w, view->frame.h };
+    entry->width = superview ? superview->frame.w : 0;
+    entry->height = superview ? superview->frame.h : 0;
+}
+
+/* Captures views outside of the container referenced by rules, all of
+ * which are bound. */
+static void coslayout_view_capture_refs(COSLAYOUT_SNAPSHOT *snapshot, const COSLAYOUT_BINDINGS *bindings, double x, double y) {
+    for (size_t i = 0; i < bindings->count; ++i) {
+        const COSLAYOUT_EXPR *expr = bindings->exprs[i];
+
+        if (expr->kind == COSLAYOUT_EXPR_ATTR && coslayout_snapshot_find(snapshot, expr->ref) == NULL) {
+            coslayout_view_capture(snapshot, (COSLAYOUT_VIEW *)expr->ref, x, y);
+        }
+    }
+}
+
+/* Nodes of the subviews of view, in subview order. */
+static COSLAYOUT_NODE *coslayout_view_nodes(COSLAYOUT_VIEW *view) {
+    size_t count = view->subview_count;
+    COSLAYOUT_NODE *nodes = (COSLAYOUT_NODE *)calloc(count ? count : 1, sizeof(COSLAYOUT_NODE));
+
+    for (size_t i = 0; i < count; ++i) {
+        COSLAYOUT_VIEW *subview = view->subviews[i];
+
+        nodes[i].set = coslayout_program_ruleset(subview->program);
+        nodes[i].bindings = subview->bindings.exprs;
+        nodes[i].view = subview;
+        nodes[i].superview = view;
+        nodes[i].start = subview->frame;
+        nodes[i].frame = subview->frame;
+        nodes[i].params = &subview->params;
+        nodes[i].scope = &view->params;
+    }
+
+    return nodes;
+}
+
+int coslayout_view_layout(COSLAYOUT_VIEW *view, COSLAYOUT_POOL *pool) {
+    size_t count = view->subview_count;
+
+    view->needs_layout = 0;
+
+    if (count == 0) return 0;
+
+    int watched = COSLAYOUT_PROFILE_FLAGS() & COSLAYOUT_PROFILE_NODES;
+    uint64_t start = COSLAYOUT_STATS_ENABLED() || watched ? coslayout_stats_now() : 0;
+
+    COSLAYOUT_NODE *nodes = coslayout_view_nodes(view);
+    COSLAYOUT_NODE *sorted = (COSLAYOUT_NODE *)calloc(count, sizeof(COSLAYOUT_NODE));
+    size_t *order = (size_t *)malloc(count * sizeof(size_t));
+
+    int result = coslayout_nodes_order(nodes, count, order);
+
+    if (result == 0) {
+        COSLAYOUT_SNAPSHOT snapshot;
+        double x, y;
+
+        coslayout_snapshot_init(&snapshot);
+        coslayout_view_origin(view, &x, &y);
+
+        coslayout_view_capture(&snapshot, view, x, y);
+
+        /* The container is measured from its bounds, not its frame. */
+        COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_find(&snapshot, view);
+
+        entry->rect.x = 0;
+        entry->rect.y = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            coslayout_view_capture(&snapshot, view->subviews[i], x, y);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            coslayout_view_capture_refs(&snapshot, &view->subviews[i]->bindings, x, y);
+
+            sorted[i] = nodes[order[i]];
+        }
+
+        coslayout_nodes_solve(sorted, count, &snapshot, view, -1, pool);
+
+        COSLAYOUT_PASS_STATS stats = { 0, 0, 0, 0 };
+        uint64_t traced = COSLAYOUT_TRACE_ENABLED() ? coslayout_stats_now() : 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            COSLAYOUT_VIEW *subview = (COSLAYOUT_VIEW *)sorted[i].view;
+
+            /* Subviews of a resized view are laid out again. */
+            if (sorted[i].frame.w != subview->frame.w || sorted[i].frame.h != subview->frame.h) {
+                subview->needs_layout = 1;
+            }
+
+            subview->frame = sorted[i].frame;
+
+            if (sorted[i].evaluations > 0) stats.views += 1;
+            if (coslayout_rect_changed_axes(sorted[i].start, sorted[i].frame)) stats.changed += 1;
+
+            stats.evaluations += sorted[i].evaluations;
+        }
+
+        if (traced) coslayout_trace_span("commit", traced, view, view->superview);
+
+        if (start) {
+            stats.seconds = (coslayout_stats_now() - start) * 1e-9;
+            coslayout_stats_record_pass(&stats);
+        }
+
+        if (watched) coslayout_watchdog_check(view, stats.seconds, sorted, count);
+
+        if (COSLAYOUT_PROFILE_FLAGS() & COSLAYOUT_PROFILE_COSTS) {
+            coslayout_costs_record(&view->costs, sorted, count);
+        }
+
+        coslayout_snapshot_destroy(&snapshot);
+    }
+
+    free(order);
+    free(sorted);
+    free(nodes);
+
+    return result;
+}
+
+int coslayout_view_layout_tree(COSLAYOUT_VIEW *view, COSLAYOUT_POOL *pool) {
+    int result = coslayout_view_layout(view, pool);
+
+    for (size_t i = 0; i < view->subview_count; ++i) {
+        if (coslayout_view_layout_tree(view->subviews[i], pool) != 0) result = -1;
+    }
+
+    return result;
+}
+
+int coslayout_view_layout_if_needed(COSLAYOUT_VIEW *view, COSLAYOUT_POOL *pool) {
+    int result = view->needs_layout ? coslayout_view_layout(view, pool) : 0;
+
+    for (size_t i = 0; i < view->subview_count; ++i) {
+        if (coslayout_view_layout_if_needed(view->subviews[i], pool) != 0) result = -1;
+    }
+
+    return result;
+}
+
+int coslayout_view_write_graph(COSLAYOUT_VIEW *view, FILE *file, int format) {
+    COSLAYOUT_NODE *nodes = coslayout_view_nodes(view);
+
+    int result = coslayout_dump_write(file, format, view, nodes, view->subview_count, view->costs, NULL, NULL);
+
+    free(nodes);
+
+    return result;
+}
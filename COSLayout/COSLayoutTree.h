@@ -0,0 +1,127 @@
+// COSLayoutTree.h
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Headless views laid out by the evaluation core.
+//
+// A COSLAYOUT_VIEW is a handle with a frame, a rule program with its
+// bindings and subviews, all plain C. Rules reference other handles the way UIKit rules reference
+// views, so layouts can be computed, tested and benchmarked without UIKit.
+// Bounds of headless views always start at the origin.
+
+#ifndef COSLAYOUT_TREE_H
+#define COSLAYOUT_TREE_H
+
+#include <stdio.h>
+
+#include "COSLayoutCore.h"
+#include "COSLayoutProgram.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct COSLAYOUT_VIEW COSLAYOUT_VIEW;
+
+COSLAYOUT_VIEW *coslayout_view_create(COSLAYOUT_RECT frame);
+
+/* Removes the view from its superview and destroys it with its subviews. */
+void coslayout_view_destroy(COSLAYOUT_VIEW *view);
+
+void coslayout_view_add_subview(COSLAYOUT_VIEW *view, COSLAYOUT_VIEW *subview);
+void coslayout_view_remove_from_superview(COSLAYOUT_VIEW *view);
+
+COSLAYOUT_VIEW *coslayout_view_superview(const COSLAYOUT_VIEW *view);
+size_t coslayout_view_subview_count(const COSLAYOUT_VIEW *view);
+COSLAYOUT_VIEW *coslayout_view_subview_at(const COSLAYOUT_VIEW *view, size_t index);
+
+COSLAYOUT_RECT coslayout_view_frame(const COSLAYOUT_VIEW *view);
+void coslayout_view_set_frame(COSLAYOUT_VIEW *view, COSLAYOUT_RECT frame);
+
+const COSLAYOUT_RULESET *coslayout_view_ruleset(const COSLAYOUT_VIEW *view);
+COSLAYOUT_PROGRAM *coslayout_view_program(const COSLAYOUT_VIEW *view);
+
+/* Adds rules like COSLayout does. Arguments are doubles for %f and
+ * percentages, and COSLAYOUT_VIEW pointers for view specifiers such as
+ * %tt. %*f and %*p take a COSLAYOUT_FUNC and its info, called with the
+ * view ruled on every evaluation. Views referenced by name take no
+ * argument. Returns the result of coslayout_ruleset_add_rule. */
+int coslayout_view_add_rule(COSLAYOUT_VIEW *view, const char *rule, ...);
+
+/* Argument of a rule given as an array: a view for view specifiers, a
+ * number otherwise, including block and object specifiers. Function
+ * specifiers call func with info if it is set and are number otherwise. */
+typedef struct COSLAYOUT_VIEW_ARG {
+    double number;
+    COSLAYOUT_VIEW *view;
+    COSLAYOUT_FUNC func;
+    void *info;
+} COSLAYOUT_VIEW_ARG;
+
+/* Adds rules like coslayout_view_add_rule, taking arguments from args.
+ * Missing arguments are zero. */
+int coslayout_view_add_rule_args(COSLAYOUT_VIEW *view, const char *rule, const COSLAYOUT_VIEW_ARG *args, size_t count);
+
+/* Sets a parameter rules reference as $name. Rules of a view read its own
+ * parameters first, then those of its superview. Returns 1 if the value
+ * changed. Nothing is laid out until the next layout, and only containers
+ * of views whose rules read the parameter need one. */
+int coslayout_view_set_param(COSLAYOUT_VIEW *view, const char *name, double value);
+
+/* Returns 0 if the parameter is not set on view itself. */
+int coslayout_view_get_param(const COSLAYOUT_VIEW *view, const char *name, double *value);
+
+/* Names view for rules of the views below container, which reference it
+ * as name.attr, e.g. header.bt. A NULL view removes the name. Names are
+ * resolved when rules are added, in the superview of the view ruled and
+ * then in its ancestors, and adding a rule with a name not found returns
+ * 3 and adds none of it. Rules added before keep their view when a name
+ * is set again. Names must be removed before their view is destroyed. */
+void coslayout_view_set_named(COSLAYOUT_VIEW *container, const char *name, COSLAYOUT_VIEW *view);
+
+/* View named name in container or in its nearest ancestor naming it. */
+COSLAYOUT_VIEW *coslayout_view_named(const COSLAYOUT_VIEW *container, const char *name);
+
+/* Lays out the subviews of view, on pool if not NULL. Returns -1 if rules
+ * of subviews depend on each other in a cycle, 0 otherwise. */
+int coslayout_view_layout(COSLAYOUT_VIEW *view, COSLAYOUT_POOL *pool);
+
+/* Lays out view and then every view below it, top down. */
+int coslayout_view_layout_tree(COSLAYOUT_VIEW *view, COSLAYOUT_POOL *pool);
+
+/* Lays out, top down, the views below and including view that need it
+ * since their last layout: views that were resized, gained or lost
+ * subviews, or whose subviews gained rules or read a parameter that
+ * changed. */
+int coslayout_view_layout_if_needed(COSLAYOUT_VIEW *view, COSLAYOUT_POOL *pool);
+
+/* Writes the dependency graph of the subviews of view to file, in a
+ * COSLAYOUT_DUMP_* format, with their costs over the passes kept. */
+int coslayout_view_write_graph(COSLAYOUT_VIEW *view, FILE *file, int format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
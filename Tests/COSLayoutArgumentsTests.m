@@ -0,0 +1,284 @@
+// COSLayoutArgumentsTests.m
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+
+
+// Arguments of rules, read from typed arguments, a va_list and an array.
+//
+// Rules of a view in a container of 400 by 200 are added with arguments
+// and solved by a pass, next to a view at 10, 20 sized 100 by 30 they
+// reference. Equal arguments must solve equal frames whichever way they
+// are given. A typed argument of another type than its specifier drops
+// the comma separated rule it is in, the other arguments keep their
+// place. Arguments past the count or the end of the array are zero: a
+// float reads 0, a view or function drops its rule. A va_list carries no
+// count, reading past it is undefined and not checked. Exits with the
+// number of failed checks. Needs UIKit, run it in a booted simulator:
+//
+//   xcrun -sdk iphonesimulator clang -fobjc-arc -framework UIKit
+//      -I../COSLayout COSLayoutArgumentsTests.m ../COSLayout/COSLayout.m
+//      ../COSLayout/COSLayoutCore.c ../COSLayout/COSLayoutParser.c
+//      ../COSLayout/COSLayoutLex.c ../COSLayout/COSLayoutPool.c
+//      ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      ../COSLayout/COSLayoutDump.c
+//      ../COSLayout/COSLayoutCache.c
+//      ../COSLayout/COSLayoutProgram.c ../COSLayout/COSLayoutRegistry.c
+//      ../COSLayout/COSLayoutSession.c ../COSLayout/COSLayoutTree.c
+//      -o arguments-tests
+//   xcrun simctl spawn booted ./arguments-tests
+
+#import "COSLayout.h"
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures += 1; \
+    } \
+} while (0)
+
+#define CHECK_FRAME(frame, x, y, w, h) CHECK(CGRectEqualToRect(frame, CGRectMake(x, y, w, h)))
+
+@interface COSTestFloat : NSObject <COSCGFloatProtocol>
+
+@property (nonatomic, assign) CGFloat value;
+
+@end
+
+@implementation COSTestFloat
+
+- (CGFloat)cos_CGFloatValue {
+    return self.value;
+}
+
+@end
+
+static double cos_test_function(void *context, __unsafe_unretained UIView *view) {
+    return context ? *(double *)context : 0;
+}
+
+typedef void (^COSAddRule)(COSLayout *layout, UIView *anchor);
+
+/* Frame of a view at 1, 2 sized 3 by 4, solved after add adds its rules. */
+static CGRect cos_solve(COSAddRule add) {
+    UIView *container = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 400, 200)];
+    UIView *anchor = [[UIView alloc] initWithFrame:CGRectMake(10, 20, 100, 30)];
+    UIView *view = [[UIView alloc] initWithFrame:CGRectMake(1, 2, 3, 4)];
+
+    [container addSubview:anchor];
+    [container addSubview:view];
+
+    add(view.coslayout, anchor);
+
+    [[container coslayoutPass] commit];
+
+    return view.frame;
+}
+
+static void test_parity(void) {
+    static double inset = 16;
+
+    COSFloatBlock block = ^CGFloat(UIView *view) { return 12; };
+
+    COSTestFloat *object = [[COSTestFloat alloc] init];
+
+    object.value = 40;
+
+    /* Views, floats, percentages, functions and blocks. */
+    NSString *rule = @"ll = %rl + %f, tt = %bt + %*f, w = %p, h = %^f";
+
+    CGRect va = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:rule, anchor, 8.0, cos_test_function, &inset, 25.0, block];
+    });
+
+    CGRect array = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:rule arguments:@[anchor, @8,
+                                         [NSValue valueWithPointer:(void *)cos_test_function], [NSValue valueWithPointer:&inset],
+                                         @25, block]];
+    });
+
+    CGRect typed = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        COSLayoutArgument arguments[] = {
+            COSLayoutViewArgument(anchor),
+            COSLayoutFloatArgument(8),
+            COSLayoutFunctionArgument(cos_test_function, &inset),
+            COSLayoutFloatArgument(25),
+            COSLayoutBlockArgument(block)
+        };
+
+        [layout addRule:rule arguments:arguments count:5];
+    });
+
+    CHECK_FRAME(va, 118, 66, 100, 12);
+    CHECK(CGRectEqualToRect(array, va));
+    CHECK(CGRectEqualToRect(typed, va));
+
+    /* Objects, and views read for the other axis. */
+    rule = @"ct = %ct, w = %@f, h = %@p";
+
+    va = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:rule, anchor, object, object];
+    });
+
+    array = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:rule arguments:@[anchor, object, object]];
+    });
+
+    typed = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        COSLayoutArgument arguments[] = {
+            COSLayoutViewArgument(anchor),
+            COSLayoutObjectArgument(object),
+            COSLayoutObjectArgument(object)
+        };
+
+        [layout addRule:rule arguments:arguments count:3];
+    });
+
+    /* 40% of the height of the container. */
+    CHECK_FRAME(va, 1, -5, 40, 80);
+    CHECK(CGRectEqualToRect(array, va));
+    CHECK(CGRectEqualToRect(typed, va));
+}
+
+static void test_mismatch(void) {
+    static double inset = 16;
+
+    COSFloatBlock block = ^CGFloat(UIView *view) { return 12; };
+
+    /* A view for a float drops ll, tt still reads the second argument. */
+    CGRect frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        COSLayoutArgument arguments[] = { COSLayoutViewArgument(anchor), COSLayoutFloatArgument(20) };
+
+        [layout addRule:@"ll = %f, tt = %f" arguments:arguments count:2];
+    });
+
+    CHECK_FRAME(frame, 1, 20, 3, 4);
+
+    /* A float for a view. */
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        COSLayoutArgument arguments[] = { COSLayoutFloatArgument(5), COSLayoutFloatArgument(20) };
+
+        [layout addRule:@"ll = %rl, tt = %f" arguments:arguments count:2];
+    });
+
+    CHECK_FRAME(frame, 1, 20, 3, 4);
+
+    /* A block for a function and a function for a block. */
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        COSLayoutArgument arguments[] = {
+            COSLayoutBlockArgument(block),
+            COSLayoutFunctionArgument(cos_test_function, &inset),
+            COSLayoutFloatArgument(7)
+        };
+
+        [layout addRule:@"w = %*f, h = %^f, ll = %f" arguments:arguments count:3];
+    });
+
+    CHECK_FRAME(frame, 7, 2, 3, 4);
+
+    /* An object in the array which is not a view. */
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:@"ll = %rl, tt = %f" arguments:@[@5, @20]];
+    });
+
+    CHECK_FRAME(frame, 1, 20, 3, 4);
+}
+
+static void test_exhausted(void) {
+    static double inset = 16;
+
+    /* Floats past the count are zero. */
+    CGRect frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        COSLayoutArgument arguments[] = { COSLayoutFloatArgument(5) };
+
+        [layout addRule:@"ll = %f, tt = %f" arguments:arguments count:1];
+    });
+
+    CHECK_FRAME(frame, 5, 0, 3, 4);
+
+    /* Arguments past the count are not read, even if given. */
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        COSLayoutArgument arguments[] = { COSLayoutFloatArgument(5), COSLayoutViewArgument(anchor) };
+
+        [layout addRule:@"ll = %f, tt = %bt" arguments:arguments count:1];
+    });
+
+    CHECK_FRAME(frame, 5, 2, 3, 4);
+
+    /* Functions past the count are NULL. */
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        COSLayoutArgument arguments[] = { COSLayoutFloatArgument(5) };
+
+        [layout addRule:@"ll = %f, w = %*f" arguments:arguments count:1];
+    });
+
+    CHECK_FRAME(frame, 5, 2, 3, 4);
+
+    /* No arguments at all. */
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:@"ll = %f, tt = %bt" arguments:NULL count:0];
+    });
+
+    CHECK_FRAME(frame, 0, 2, 3, 4);
+
+    /* The array reads past its end the same way. */
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:@"ll = %f, tt = %f" arguments:@[@5]];
+    });
+
+    CHECK_FRAME(frame, 5, 0, 3, 4);
+
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:@"ll = %f, tt = %bt, w = %*f" arguments:@[@5]];
+    });
+
+    CHECK_FRAME(frame, 5, 2, 3, 4);
+
+    /* A function whose context is past the end of the array is called
+     * with a NULL context. */
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:@"w = %*f" arguments:@[[NSValue valueWithPointer:(void *)cos_test_function]]];
+    });
+
+    CHECK(frame.size.width == 0);
+
+    frame = cos_solve(^(COSLayout *layout, UIView *anchor) {
+        [layout addRule:@"w = %*f" arguments:@[[NSValue valueWithPointer:(void *)cos_test_function], [NSValue valueWithPointer:&inset]]];
+    });
+
+    CHECK(frame.size.width == 16);
+}
+
+int main(int argc, char **argv) {
+    @autoreleasepool {
+        test_parity();
+        test_mismatch();
+        test_exhausted();
+    }
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+
+    return failures;
+}
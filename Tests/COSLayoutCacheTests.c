@@ -0,0 +1,167 @@
+// COSLayoutCacheTests.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// Geometry of cache keys.
+//
+// Frames are cached by the rules of a container, its size and the
+// geometry the rules read but do not solve. Two containers whose views
+// only differ in a label without rules, or in the frame a view starts
+// from on an axis it has no rules for, must not share frames. Exits with
+// the number of failed checks. Runs on any POSIX system:
+//
+//   cc -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutCacheTests.c ../COSLayout/COSLayoutCache.c
+//      ../COSLayout/COSLayoutCore.c ../COSLayout/COSLayoutParser.c
+//      ../COSLayout/COSLayoutLex.c ../COSLayout/COSLayoutPool.c
+//      ../COSLayout/COSLayoutStats.c ../COSLayout/COSLayoutProfile.c
+//      ../COSLayout/COSLayoutTrace.c -lpthread -lm -o cache-tests
+//   ./cache-tests
+
+#include "COSLayoutCache.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures += 1; \
+    } \
+} while (0)
+
+/* A container with a label, which has no rules, and a view below it. */
+typedef struct CONTAINER {
+    char view;
+    char label;
+    char subview;
+    COSLAYOUT_SNAPSHOT snapshot;
+    COSLAYOUT_NODE node;
+} CONTAINER;
+
+static void set_rule(COSLAYOUT_RULESET *set, int attr, COSLAYOUT_EXPR *expr) {
+    coslayout_ruleset_set(set, attr, expr);
+    coslayout_expr_release(expr);
+}
+
+static void capture(CONTAINER *container, const COSLAYOUT_RULESET *set, double label, COSLAYOUT_RECT start) {
+    coslayout_snapshot_init(&container->snapshot);
+
+    COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_insert(&container->snapshot, &container->view);
+
+    entry->rect = (COSLAYOUT_RECT){ 0, 0, 320, 480 };
+
+    entry = coslayout_snapshot_insert(&container->snapshot, &container->label);
+    entry->rect = (COSLAYOUT_RECT){ 0, 0, 100, label };
+    entry->width = 320;
+    entry->height = 480;
+
+    entry = coslayout_snapshot_insert(&container->snapshot, &container->subview);
+    entry->rect = start;
+    entry->width = 320;
+    entry->height = 480;
+
+    container->node = (COSLAYOUT_NODE){ 0 };
+    container->node.set = set;
+    container->node.view = &container->subview;
+    container->node.superview = &container->view;
+    container->node.start = start;
+    container->node.frame = start;
+}
+
+static uint64_t geometry(CONTAINER *container) {
+    return coslayout_nodes_geometry(&container->node, 1, &container->snapshot);
+}
+
+static void test_geometry(void) {
+    COSLAYOUT_RULESET set;
+    CONTAINER a, b;
+
+    coslayout_ruleset_init(&set);
+
+    /* tt = label.bt + 8, ll = 10, w = 50% */
+    COSLAYOUT_EXPR *bottom = coslayout_expr_create_attr(COSLAYOUT_ATTR_BT, &a.label);
+    COSLAYOUT_EXPR *space = coslayout_expr_create_const(8);
+
+    set_rule(&set, COSLAYOUT_ATTR_TT, coslayout_expr_create_binary(COSLAYOUT_EXPR_ADD, bottom, space));
+    coslayout_expr_release(bottom);
+    coslayout_expr_release(space);
+
+    set_rule(&set, COSLAYOUT_ATTR_LL, coslayout_expr_create_const(10));
+    set_rule(&set, COSLAYOUT_ATTR_W, coslayout_expr_create_percentage(50, COSLAYOUT_DIR_NONE));
+
+    CHECK(coslayout_ruleset_fixed_axes(&set) == COSLAYOUT_AXIS_H);
+
+    /* Views at other addresses with the same geometry share frames, the
+     * horizontal axis does not depend on where the view starts. */
+    capture(&a, &set, 20, (COSLAYOUT_RECT){ 0, 0, 50, 30 });
+    capture(&b, &set, 20, (COSLAYOUT_RECT){ 5, 0, 80, 30 });
+
+    CHECK(geometry(&a) == geometry(&b));
+
+    coslayout_snapshot_destroy(&b.snapshot);
+
+    /* The label has no rules and got taller. */
+    capture(&b, &set, 40, (COSLAYOUT_RECT){ 0, 0, 50, 30 });
+
+    CHECK(geometry(&a) != geometry(&b));
+
+    coslayout_snapshot_destroy(&b.snapshot);
+
+    /* The view has no height rule, so it keeps the height it starts with. */
+    capture(&b, &set, 20, (COSLAYOUT_RECT){ 0, 0, 50, 60 });
+
+    CHECK(geometry(&a) != geometry(&b));
+
+    coslayout_snapshot_destroy(&a.snapshot);
+    coslayout_snapshot_destroy(&b.snapshot);
+    coslayout_ruleset_destroy(&set);
+}
+
+static void test_keys(void) {
+    COSLAYOUT_CACHE *cache = coslayout_cache_create(0, 0);
+    COSLAYOUT_RECT frame = { 10, 28, 300, 30 }, found;
+
+    COSLAYOUT_CACHE_KEY key = { 1, 320, 480, 7, 42 };
+    COSLAYOUT_CACHE_KEY moved = { 1, 320, 480, 7, 43 };
+
+    coslayout_cache_store(cache, &key, &frame, 1);
+
+    CHECK(coslayout_cache_lookup(cache, &key, &found, 1) == 1);
+    CHECK(found.y == 28);
+    CHECK(coslayout_cache_lookup(cache, &moved, &found, 1) == 0);
+
+    coslayout_cache_destroy(cache);
+}
+
+int main(void) {
+    test_geometry();
+    test_keys();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+
+    return failures;
+}
@@ -0,0 +1,534 @@
+// COSLayoutCoreTests.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// The evaluation core and what it is built from.
+//
+// Checks expressions evaluated against an environment, the affine fast
+// path against the general solver, ordering of nodes and its detection
+// of cycles, interning of rule programs, loops of the pool, the registry
+// under concurrent lookups, and a session recorded and replayed to the
+// same frames. Exits with the number of failed checks. Runs on any POSIX
+// system:
+//
+//   cc -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutCoreTests.c ../COSLayout/COSLayoutSession.c
+//      ../COSLayout/COSLayoutTree.c ../COSLayout/COSLayoutRegistry.c
+//      ../COSLayout/COSLayoutProgram.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      ../COSLayout/COSLayoutDump.c -lpthread -lm -o core-tests
+//   ./core-tests
+
+#include "COSLayoutCore.h"
+#include "COSLayoutPool.h"
+#include "COSLayoutProgram.h"
+#include "COSLayoutRegistry.h"
+#include "COSLayoutSession.h"
+#include "COSLayoutTree.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures += 1; \
+    } \
+} while (0)
+
+/* Views referenced by view specifiers of rules, in order. */
+typedef struct ARGS {
+    void **views;
+    size_t next;
+} ARGS;
+
+static COSLAYOUT_EXPR *arg(void *info, const char *spec, int percentage, int dir) {
+    ARGS *args = (ARGS *)info;
+
+    (void)percentage;
+    (void)dir;
+
+    return coslayout_expr_create_attr(coslayout_attr_named(spec), args->views[args->next++]);
+}
+
+static void add_rule(COSLAYOUT_RULESET *set, const char *rule, void *view) {
+    ARGS args = { &view, 0 };
+
+    CHECK(coslayout_ruleset_add_rule(set, rule, arg, &args) == 0);
+}
+
+static void test_evaluator(void) {
+    COSLAYOUT_PARAMS params, scope;
+    COSLAYOUT_ENV env = { 0 };
+
+    coslayout_params_init(&params);
+    coslayout_params_init(&scope);
+
+    env.width = 400;
+    env.height = 200;
+    env.params = &params;
+    env.scope = &scope;
+
+    COSLAYOUT_EXPR *ten = coslayout_expr_create_const(10);
+    COSLAYOUT_EXPR *half = coslayout_expr_create_percentage(50, COSLAYOUT_DIR_NONE);
+    COSLAYOUT_EXPR *sum = coslayout_expr_create_binary(COSLAYOUT_EXPR_ADD, half, ten);
+
+    /* Percentages take the direction evaluated in unless they have one. */
+    CHECK(coslayout_expr_eval(half, COSLAYOUT_DIR_H, &env) == 200);
+    CHECK(coslayout_expr_eval(half, COSLAYOUT_DIR_V, &env) == 100);
+    CHECK(coslayout_expr_eval(sum, COSLAYOUT_DIR_V, &env) == 110);
+    CHECK(coslayout_expr_reads(sum, COSLAYOUT_DIR_V) == COSLAYOUT_READ_HEIGHT);
+
+    /* Parameters of the view win over those of its scope, unset ones are
+     * zero. */
+    const char *gap = coslayout_param_intern("gap");
+    COSLAYOUT_EXPR *param = coslayout_expr_create_param(gap);
+
+    CHECK(coslayout_expr_eval(param, COSLAYOUT_DIR_H, &env) == 0);
+
+    coslayout_params_set(&scope, gap, 8);
+    CHECK(coslayout_expr_eval(param, COSLAYOUT_DIR_H, &env) == 8);
+
+    coslayout_params_set(&params, gap, 4);
+    CHECK(coslayout_expr_eval(param, COSLAYOUT_DIR_H, &env) == 4);
+    CHECK(coslayout_expr_reads(param, COSLAYOUT_DIR_H) == COSLAYOUT_READ_PARAM);
+
+    coslayout_expr_release(param);
+    coslayout_expr_release(sum);
+    coslayout_expr_release(half);
+    coslayout_expr_release(ten);
+
+    /* Rule sets solve both edges of an axis into an origin and a size. */
+    COSLAYOUT_RULESET set;
+
+    coslayout_ruleset_init(&set);
+
+    CHECK(coslayout_ruleset_add_rule(&set, "ll = 10, rr = 10, tt = $gap, h = 25%", NULL, NULL) == 0);
+
+    COSLAYOUT_RECT frame = coslayout_ruleset_solve(&set, (COSLAYOUT_RECT){ 0, 0, 0, 0 }, &env, COSLAYOUT_AXIS_ALL);
+
+    CHECK(frame.x == 10 && frame.w == 380);
+    CHECK(frame.y == 4 && frame.h == 50);
+
+    coslayout_ruleset_destroy(&set);
+    coslayout_params_destroy(&params);
+    coslayout_params_destroy(&scope);
+}
+
+static void test_affine(void) {
+    static const char *rules[] = {
+        "ll = 10%, tt = 20, w = 50% - 10, h = 30",
+        "rr = 8, bb = 10% + 2, w = 25%, h = 50% / 2",
+        "ct = 50%, cl = 50%, w = 100, h = 2 * 10%",
+    };
+
+    size_t count = sizeof(rules) / sizeof(rules[0]);
+    COSLAYOUT_RULESET sets[3];
+    COSLAYOUT_AFFINE_TABLE table;
+    COSLAYOUT_RECT frames[3];
+
+    coslayout_affine_table_init(&table);
+
+    for (size_t i = 0; i < count; ++i) {
+        coslayout_ruleset_init(&sets[i]);
+
+        CHECK(coslayout_ruleset_add_rule(&sets[i], rules[i], NULL, NULL) == 0);
+        CHECK(coslayout_ruleset_linear(&sets[i]));
+        CHECK(coslayout_affine_table_add(&table, &sets[i]) == (int)i);
+    }
+
+    /* The fast path solves what the general solver does, for any size. */
+    for (double width = 100; width <= 400; width += 150) {
+        COSLAYOUT_ENV env = { 0 };
+
+        env.width = width;
+        env.height = width / 2;
+
+        coslayout_affine_table_solve(&table, env.width, env.height, frames);
+
+        for (size_t i = 0; i < count; ++i) {
+            COSLAYOUT_RECT frame = coslayout_ruleset_solve(&sets[i], (COSLAYOUT_RECT){ 0, 0, 0, 0 }, &env, COSLAYOUT_AXIS_ALL);
+
+            CHECK(frames[i].x == frame.x && frames[i].y == frame.y);
+            CHECK(frames[i].w == frame.w && frames[i].h == frame.h);
+        }
+    }
+
+    /* Functions and conditionals are not affine. */
+    COSLAYOUT_RULESET other;
+
+    coslayout_ruleset_init(&other);
+
+    CHECK(coslayout_ruleset_add_rule(&other, "ll = 0, tt = 0, w = min(50%, 100), h = 10", NULL, NULL) == 0);
+    CHECK(!coslayout_ruleset_linear(&other));
+    CHECK(coslayout_affine_table_add(&table, &other) == -1);
+
+    coslayout_ruleset_destroy(&other);
+
+    for (size_t i = 0; i < count; ++i) {
+        coslayout_ruleset_destroy(&sets[i]);
+    }
+
+    coslayout_affine_table_destroy(&table);
+}
+
+static void test_order(void) {
+    char container, views[3];
+    COSLAYOUT_RULESET sets[3];
+    COSLAYOUT_NODE nodes[3];
+    size_t order[3];
+
+    for (int i = 0; i < 3; ++i) {
+        coslayout_ruleset_init(&sets[i]);
+
+        nodes[i] = (COSLAYOUT_NODE){ 0 };
+        nodes[i].set = &sets[i];
+        nodes[i].view = &views[i];
+        nodes[i].superview = &container;
+    }
+
+    /* 0 below 1 below 2, given in reverse. */
+    add_rule(&sets[0], "tt = %bt", &views[1]);
+    add_rule(&sets[1], "tt = %bt", &views[2]);
+    add_rule(&sets[2], "tt = 0", NULL);
+
+    CHECK(coslayout_nodes_order(nodes, 3, order) == 0);
+    CHECK(order[0] == 2 && order[1] == 1 && order[2] == 0);
+    CHECK(nodes[2].level == 0 && nodes[1].level == 1 && nodes[0].level == 2);
+
+    /* Views outside of the nodes are no dependency. */
+    add_rule(&sets[2], "tt = %bt", &container);
+
+    CHECK(coslayout_nodes_order(nodes, 3, order) == 0);
+
+    /* 2 below 0 closes a cycle. */
+    add_rule(&sets[2], "tt = %bt", &views[0]);
+
+    CHECK(coslayout_nodes_order(nodes, 3, order) == -1);
+
+    /* Axes do not matter, a cycle through both is one too. */
+    add_rule(&sets[2], "tt = 0, ll = %rr", &views[0]);
+
+    CHECK(coslayout_nodes_order(nodes, 3, order) == -1);
+
+    for (int i = 0; i < 3; ++i) {
+        coslayout_ruleset_destroy(&sets[i]);
+    }
+}
+
+static void test_interning(void) {
+    char header, footer;
+    size_t count = coslayout_program_count();
+
+    COSLAYOUT_PROGRAM *a = coslayout_program_create();
+    COSLAYOUT_PROGRAM *b = coslayout_program_create();
+    COSLAYOUT_BINDINGS a_bindings, b_bindings;
+    void *views[] = { &header, &footer };
+    ARGS args;
+
+    coslayout_bindings_init(&a_bindings);
+    coslayout_bindings_init(&b_bindings);
+
+    /* Equal rules added at once and one by one, referencing other views. */
+    args = (ARGS){ &views[0], 0 };
+    CHECK(coslayout_program_add_rule(&a, &a_bindings, "ll = 10, tt = %bt + 8", arg, &args) == 0);
+
+    args = (ARGS){ &views[1], 0 };
+    CHECK(coslayout_program_add_rule(&b, &b_bindings, "ll = 10", arg, &args) == 0);
+    CHECK(a != b);
+    CHECK(coslayout_program_add_rule(&b, &b_bindings, "tt = %bt + 8", arg, &args) == 0);
+
+    CHECK(a == b);
+    CHECK(coslayout_program_count() == count + 1);
+
+    /* What the rules reference stays with each view. */
+    CHECK(a_bindings.count == 1 && a_bindings.exprs[0]->ref == &header);
+    CHECK(b_bindings.count == 1 && b_bindings.exprs[0]->ref == &footer);
+
+    /* A failing rule changes neither program nor bindings. */
+    COSLAYOUT_PROGRAM *before = b;
+
+    CHECK(coslayout_program_add_rule(&b, &b_bindings, "w = 10 +", arg, &args) != 0);
+    CHECK(b == before && b_bindings.count == 1);
+
+    /* Other rules make another program, released once unused. */
+    CHECK(coslayout_program_add_rule(&b, &b_bindings, "w = 20", arg, &args) == 0);
+    CHECK(a != b);
+    CHECK(coslayout_program_count() == count + 2);
+
+    coslayout_program_release(b);
+    coslayout_bindings_destroy(&b_bindings);
+
+    CHECK(coslayout_program_count() == count + 1);
+
+    coslayout_program_release(a);
+    coslayout_bindings_destroy(&a_bindings);
+
+    CHECK(coslayout_program_count() == count);
+}
+
+#define POOL_COUNT 10000
+
+typedef struct POOL_RUN {
+    int calls[POOL_COUNT];
+    int workers[POOL_COUNT];
+} POOL_RUN;
+
+static void pool_task(void *info, size_t index, int worker) {
+    POOL_RUN *run = (POOL_RUN *)info;
+
+    __atomic_add_fetch(&run->calls[index], 1, __ATOMIC_RELAXED);
+    run->workers[index] = worker;
+}
+
+static void test_pool(void) {
+    static POOL_RUN run;
+    int threads[] = { 1, 4 };
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+        COSLAYOUT_POOL *pool = coslayout_pool_create(threads[t]);
+
+        CHECK(coslayout_pool_thread_count(pool) == threads[t]);
+
+        /* Loops run every index once, on workers of the pool, and pools
+         * run loop after loop. */
+        for (int loop = 0; loop < 3; ++loop) {
+            int once = 1, workers = 1;
+
+            for (size_t i = 0; i < POOL_COUNT; ++i) {
+                run.calls[i] = 0;
+            }
+
+            coslayout_pool_run(pool, POOL_COUNT, pool_task, &run);
+
+            for (size_t i = 0; i < POOL_COUNT; ++i) {
+                if (run.calls[i] != 1) once = 0;
+                if (run.workers[i] < 0 || run.workers[i] >= threads[t]) workers = 0;
+            }
+
+            CHECK(once);
+            CHECK(workers);
+        }
+
+        /* Empty loops return. */
+        coslayout_pool_run(pool, 0, pool_task, &run);
+
+        coslayout_pool_destroy(pool);
+    }
+}
+
+#define REGISTRY_KEYS 512
+
+typedef struct REGISTRY_READ {
+    COSLAYOUT_REGISTRY *registry;
+    int stop;
+    int wrong;
+} REGISTRY_READ;
+
+/* Keys are multiples of 16, mapped to the key plus one or not at all. */
+static void *registry_reader(void *info) {
+    REGISTRY_READ *read = (REGISTRY_READ *)info;
+
+    while (!__atomic_load_n(&read->stop, __ATOMIC_ACQUIRE)) {
+        for (uintptr_t key = 16; key <= REGISTRY_KEYS * 16; key += 16) {
+            void *value = coslayout_registry_get(read->registry, (void *)key);
+
+            if (value != NULL && value != (void *)(key + 1)) read->wrong += 1;
+        }
+    }
+
+    return NULL;
+}
+
+static void test_registry(void) {
+    COSLAYOUT_REGISTRY *registry = coslayout_registry_create();
+    int a, b;
+
+    CHECK(coslayout_registry_get(registry, &a) == NULL);
+
+    coslayout_registry_set(registry, &a, &b);
+    CHECK(coslayout_registry_get(registry, &a) == &b);
+
+    /* Removal only takes the value given. */
+    coslayout_registry_remove(registry, &a, &a);
+    CHECK(coslayout_registry_get(registry, &a) == &b);
+
+    coslayout_registry_remove(registry, &a, &b);
+    CHECK(coslayout_registry_get(registry, &a) == NULL);
+
+    /* Lookups running while keys come and go, through rebuilds of the
+     * table, only find values of their own key. */
+    REGISTRY_READ read = { registry, 0, 0 };
+    pthread_t readers[2];
+
+    for (int i = 0; i < 2; ++i) {
+        pthread_create(&readers[i], NULL, registry_reader, &read);
+    }
+
+    for (int round = 0; round < 20; ++round) {
+        for (uintptr_t key = 16; key <= REGISTRY_KEYS * 16; key += 16) {
+            coslayout_registry_set(registry, (void *)key, (void *)(key + 1));
+        }
+
+        for (uintptr_t key = 16; key <= REGISTRY_KEYS * 16; key += 32) {
+            coslayout_registry_set(registry, (void *)key, NULL);
+        }
+    }
+
+    __atomic_store_n(&read.stop, 1, __ATOMIC_RELEASE);
+
+    for (int i = 0; i < 2; ++i) {
+        pthread_join(readers[i], NULL);
+    }
+
+    CHECK(read.wrong == 0);
+
+    int mapped = 1;
+
+    for (uintptr_t key = 16; key <= REGISTRY_KEYS * 16; key += 16) {
+        void *expected = (key / 16) % 2 ? NULL : (void *)(key + 1);
+
+        if (coslayout_registry_get(registry, (void *)key) != expected) mapped = 0;
+    }
+
+    CHECK(mapped);
+
+    coslayout_registry_destroy(registry);
+}
+
+static COSLAYOUT_RECT frame_of_view(const void *view, void *info) {
+    (void)info;
+
+    return coslayout_view_frame((const COSLAYOUT_VIEW *)view);
+}
+
+typedef struct REPLAYED {
+    COSLAYOUT_RECT frames[3];
+    int count;
+} REPLAYED;
+
+static void replayed_frame(long view, COSLAYOUT_RECT frame, void *info) {
+    REPLAYED *replayed = (REPLAYED *)info;
+
+    if (view >= 0 && view < 3) {
+        replayed->frames[view] = frame;
+        replayed->count += 1;
+    }
+}
+
+static void test_session(void) {
+    char path[] = "/tmp/coslayout-session-XXXXXX";
+    int fd = mkstemp(path);
+
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+
+    close(fd);
+
+    COSLAYOUT_VIEW *root = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 320, 480 });
+    COSLAYOUT_VIEW *header = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 0, 0 });
+    COSLAYOUT_VIEW *body = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 0, 0 });
+
+    coslayout_view_add_subview(root, header);
+    coslayout_view_add_subview(root, body);
+
+    CHECK(coslayout_session_start(fopen(path, "w")) == 0);
+
+    /* Recorded the way COSLayout records UIKit views. */
+    long r = coslayout_session_view(root, -1, coslayout_view_frame(root));
+    long h = coslayout_session_view(header, r, coslayout_view_frame(header));
+    long b = coslayout_session_view(body, r, coslayout_view_frame(body));
+    COSLAYOUT_SESSION_ARG args[] = { { 0, h }, { 40, -1 } };
+
+    CHECK(r == 0 && h == 1 && b == 2);
+
+    coslayout_view_add_rule(header, "ll = 0, tt = 0, w = 100%, h = 44");
+    coslayout_session_rule(h, "ll = 0, tt = 0, w = 100%, h = 44", NULL, 0);
+
+    coslayout_view_add_rule(body, "ll = $gap, rr = $gap, tt = %bt + %f, bb = 0", header, 40.0);
+    coslayout_session_rule(b, "ll = $gap, rr = $gap, tt = %bt + %f, bb = 0", args, 2);
+
+    coslayout_view_set_param(root, "gap", 12);
+    coslayout_session_param(r, "gap", 12);
+
+    coslayout_view_layout(root, NULL);
+    coslayout_session_solve(root, frame_of_view, NULL);
+
+    CHECK(coslayout_session_stop() == 0);
+
+    size_t line = 0;
+    FILE *file = fopen(path, "r");
+    COSLAYOUT_REPLAY *replay = file ? coslayout_replay_load(file, &line) : NULL;
+
+    if (file) fclose(file);
+    remove(path);
+
+    CHECK(replay != NULL);
+    if (replay == NULL) return;
+
+    CHECK(coslayout_replay_views(replay) == 3);
+    CHECK(coslayout_replay_solves(replay) == 1);
+
+    /* Replayed views end where the recorded ones did. */
+    REPLAYED replayed = { { { 0, 0, 0, 0 } }, 0 };
+
+    CHECK(coslayout_replay_run(replay, NULL, NULL, replayed_frame, &replayed) == 0);
+    CHECK(replayed.count == 3);
+
+    COSLAYOUT_VIEW *views[] = { root, header, body };
+
+    for (int i = 0; i < 3; ++i) {
+        COSLAYOUT_RECT frame = coslayout_view_frame(views[i]);
+
+        CHECK(replayed.frames[i].x == frame.x && replayed.frames[i].y == frame.y);
+        CHECK(replayed.frames[i].w == frame.w && replayed.frames[i].h == frame.h);
+    }
+
+    CHECK(coslayout_view_frame(body).x == 12 && coslayout_view_frame(body).y == 84);
+
+    coslayout_replay_destroy(replay);
+    coslayout_view_destroy(root);
+}
+
+int main(void) {
+    test_evaluator();
+    test_affine();
+    test_order();
+    test_interning();
+    test_pool();
+    test_registry();
+    test_session();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+
+    return failures;
+}
@@ -0,0 +1,251 @@
+// COSLayoutEvaluationTests.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// Values of rules, solved on headless views.
+//
+// Every check adds rules to a view in a container of 400 by 200 and lays
+// it out, so rules are parsed, compiled and evaluated the way they are
+// for UIKit views. Function providers of %*f and %*p are checked for
+// the context and view they are called with. Exits with the number of
+// failed checks. Runs on any POSIX system:
+//
+//   cc -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutEvaluationTests.c ../COSLayout/COSLayoutTree.c
+//      ../COSLayout/COSLayoutProgram.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      ../COSLayout/COSLayoutDump.c -lpthread -lm -o evaluation-tests
+//   ./evaluation-tests
+
+#include "COSLayoutTree.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures += 1; \
+    } \
+} while (0)
+
+static COSLAYOUT_VIEW *container = NULL;
+
+/* Frame of a new view in the container, laid out by rule. */
+static COSLAYOUT_RECT solve(const char *rule) {
+    COSLAYOUT_VIEW *view = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 0, 0 });
+
+    coslayout_view_add_subview(container, view);
+    coslayout_view_add_rule(view, rule);
+    coslayout_view_layout(container, NULL);
+
+    COSLAYOUT_RECT frame = coslayout_view_frame(view);
+
+    coslayout_view_destroy(view);
+
+    return frame;
+}
+
+static double width(const char *rule) {
+    return solve(rule).w;
+}
+
+/* Context of a provider, which records the view it was last called with. */
+typedef struct PROVIDER {
+    double value;
+    void *view;
+    int calls;
+} PROVIDER;
+
+static double provide(void *info, void *view) {
+    PROVIDER *provider = (PROVIDER *)info;
+
+    provider->view = view;
+    provider->calls += 1;
+
+    return provider->value;
+}
+
+static void test_functions(void) {
+    CHECK(width("w = min(100, 50%, 300)") == 100);
+    CHECK(width("w = min(300, 50%)") == 200);
+    CHECK(width("w = max(10, 20, 5)") == 20);
+    CHECK(width("w = max(10, 10%)") == 40);
+
+    CHECK(width("w = clamp(50%, 100, 150)") == 150);
+    CHECK(width("w = clamp(10, 100, 150)") == 100);
+    CHECK(width("w = clamp(120, 100, 150)") == 120);
+
+    /* The upper bound wins over a lower bound above it. */
+    CHECK(width("w = clamp(120, 150, 100)") == 100);
+    CHECK(width("w = clamp(50, 150, 100)") == 100);
+}
+
+static void test_comparisons(void) {
+    CHECK(width("w = (10 < 20) * 100") == 100);
+    CHECK(width("w = (10 > 20) * 100 + 5") == 5);
+    CHECK(width("w = (2 <= 2) + (3 >= 4) * 10") == 1);
+    CHECK(width("w = (3 == 3) * 10 + (3 != 3) * 100") == 10);
+
+    /* Comparisons bind looser than arithmetic. */
+    CHECK(width("w = 1 + 1 == 2") == 1);
+    CHECK(width("w = 50% > 100") == 1);
+}
+
+static void test_conditionals(void) {
+    CHECK(width("w = 1 ? 10 : 20") == 10);
+    CHECK(width("w = 0 ? 10 : 20") == 20);
+
+    coslayout_view_set_param(container, "a", 1);
+    coslayout_view_set_param(container, "b", 0);
+
+    /* Conditionals nest to the right and in parentheses. */
+    CHECK(width("w = $a ? 10 : $b ? 20 : 30") == 10);
+    CHECK(width("w = $b ? 10 : $a ? 20 : 30") == 20);
+    CHECK(width("w = $a ? ($b ? 10 : 20) : 30") == 20);
+
+    /* Percentages in branches take the axis of the attribute assigned. */
+    COSLAYOUT_RECT frame = solve("w = $a ? 50% : 25%, h = $a ? 50% : 25%");
+
+    CHECK(frame.w == 200);
+    CHECK(frame.h == 100);
+
+    frame = solve("w = $b ? 50% : ($a ? 10% : 25%), h = clamp($a ? 50% : 0, 0, 80)");
+
+    CHECK(frame.w == 40);
+    CHECK(frame.h == 80);
+
+    frame = solve("ll = $a ? 10% : 0, tt = ($a > 0 ? 10% : 0) + 5, w = 10, h = 10");
+
+    CHECK(frame.x == 40);
+    CHECK(frame.y == 25);
+}
+
+static void test_providers(void) {
+    PROVIDER wide = { 120, NULL, 0 };
+    PROVIDER half = { 50, NULL, 0 };
+    COSLAYOUT_VIEW *view = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 33, 44 });
+
+    coslayout_view_add_subview(container, view);
+
+    /* Functions are called with their context and the view ruled. */
+    coslayout_view_add_rule(view, "w = %*f + 10, h = %*p", provide, &wide, provide, &half);
+    coslayout_view_layout(container, NULL);
+
+    CHECK(coslayout_view_frame(view).w == 130);
+    CHECK(coslayout_view_frame(view).h == 100);
+    CHECK(wide.view == view && wide.calls > 0);
+    CHECK(half.view == view && half.calls > 0);
+
+    /* Values are read again on every layout. */
+    wide.value = 60;
+    coslayout_view_layout(container, NULL);
+
+    CHECK(coslayout_view_frame(view).w == 70);
+
+    coslayout_view_destroy(view);
+
+    /* A NULL function drops the rule, the view keeps its size. */
+    view = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 33, 44 });
+    coslayout_view_add_subview(container, view);
+
+    coslayout_view_add_rule(view, "w = %*f, h = %*p", (COSLAYOUT_FUNC)NULL, &wide, (COSLAYOUT_FUNC)NULL, &half);
+    coslayout_view_layout(container, NULL);
+
+    CHECK(coslayout_view_frame(view).w == 33);
+    CHECK(coslayout_view_frame(view).h == 44);
+
+    /* Arrays of arguments call functions the same way. */
+    COSLAYOUT_VIEW_ARG args[] = { { 0, NULL, provide, &half } };
+
+    half.view = NULL;
+    coslayout_view_add_rule_args(view, "w = %*p", args, 1);
+    coslayout_view_layout(container, NULL);
+
+    CHECK(coslayout_view_frame(view).w == 200);
+    CHECK(half.view == view);
+
+    coslayout_view_destroy(view);
+}
+
+static void test_names(void) {
+    COSLAYOUT_VIEW *header = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 400, 40 });
+    COSLAYOUT_VIEW *banner = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 400, 90 });
+    COSLAYOUT_VIEW *body = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 33, 44 });
+
+    coslayout_view_add_subview(container, header);
+    coslayout_view_add_subview(container, banner);
+    coslayout_view_add_subview(container, body);
+
+    /* A name not set yet fails the whole rule, the view keeps its frame. */
+    CHECK(coslayout_view_add_rule(body, "w = 100, tt = header.bt + 8") == 3);
+    coslayout_view_layout(container, NULL);
+
+    CHECK(coslayout_view_frame(body).w == 33);
+    CHECK(coslayout_view_frame(body).y == 0);
+
+    coslayout_view_set_named(container, "header", header);
+
+    CHECK(coslayout_view_add_rule(body, "w = 100, tt = header.bt + 8") == 0);
+    coslayout_view_layout(container, NULL);
+
+    CHECK(coslayout_view_frame(body).w == 100);
+    CHECK(coslayout_view_frame(body).y == 48);
+
+    /* Names are resolved when rules are added. */
+    coslayout_view_set_named(container, "header", banner);
+    coslayout_view_layout(container, NULL);
+
+    CHECK(coslayout_view_frame(body).y == 48);
+
+    CHECK(coslayout_view_add_rule(body, "tt = header.bt + 8") == 0);
+    coslayout_view_layout(container, NULL);
+
+    CHECK(coslayout_view_frame(body).y == 98);
+
+    coslayout_view_set_named(container, "header", NULL);
+    coslayout_view_destroy(body);
+    coslayout_view_destroy(banner);
+    coslayout_view_destroy(header);
+}
+
+int main(void) {
+    container = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 400, 200 });
+
+    test_functions();
+    test_comparisons();
+    test_conditionals();
+    test_providers();
+    test_names();
+
+    coslayout_view_destroy(container);
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+
+    return failures;
+}
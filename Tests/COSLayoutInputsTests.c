@@ -0,0 +1,189 @@
+// COSLayoutInputsTests.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+// Inputs of incremental solves.
+//
+// Solves a container the way passes of COSLayout do: a snapshot of the
+// views is captured, diffed against the one kept from the last commit,
+// and only the axes whose inputs changed are solved again. A view below
+// a label is solved after a width-only change of the container, while
+// the label, which the pass does not solve, got taller meanwhile. Exits
+// with the number of failed checks. Runs on any POSIX system:
+//
+//   cc -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutInputsTests.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      -lpthread -lm -o inputs-tests
+//   ./inputs-tests
+
+#include "COSLayoutCore.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures += 1; \
+    } \
+} while (0)
+
+static char container, label, view;
+
+static void set_rule(COSLAYOUT_RULESET *set, int attr, COSLAYOUT_EXPR *expr) {
+    coslayout_ruleset_set(set, attr, expr);
+    coslayout_expr_release(expr);
+}
+
+/* Captures the container of width and a label of height, and the view
+ * at its frame. */
+static void capture(COSLAYOUT_SNAPSHOT *snapshot, COSLAYOUT_NODE *node, double width, double height) {
+    coslayout_snapshot_clear(snapshot);
+
+    COSLAYOUT_SNAPSHOT_ENTRY *entry = coslayout_snapshot_insert(snapshot, &container);
+
+    entry->rect = (COSLAYOUT_RECT){ 0, 0, width, 480 };
+    entry->width = 320;
+    entry->height = 480;
+
+    entry = coslayout_snapshot_insert(snapshot, &label);
+    entry->rect = (COSLAYOUT_RECT){ 0, 0, 100, height };
+    entry->width = width;
+    entry->height = 480;
+
+    entry = coslayout_snapshot_insert(snapshot, &view);
+    entry->rect = node->frame;
+    entry->width = width;
+    entry->height = 480;
+
+    node->start = node->frame;
+}
+
+/* Solves for the inputs changed by a resize, adding those of views which
+ * moved since before, and keeps the snapshot as before. */
+static void solve(COSLAYOUT_NODE *node, COSLAYOUT_SNAPSHOT *snapshot, COSLAYOUT_SNAPSHOT *before, int inputs, int diff) {
+    if (diff && inputs >= 0) {
+        int moved = coslayout_snapshot_changed_inputs(before, snapshot);
+
+        inputs = moved < 0 ? -1 : inputs | moved;
+    }
+
+    coslayout_nodes_solve(node, 1, snapshot, &container, inputs, NULL);
+    coslayout_snapshot_copy(before, snapshot);
+}
+
+static void test_label_resized_outside(int diff) {
+    COSLAYOUT_RULESET set;
+    COSLAYOUT_NODE node = { 0 };
+    COSLAYOUT_SNAPSHOT snapshot, before;
+
+    coslayout_ruleset_init(&set);
+    coslayout_snapshot_init(&snapshot);
+    coslayout_snapshot_init(&before);
+
+    /* tt = label.bt + 8, ll = 10, w = 50%, h = 20 */
+    COSLAYOUT_EXPR *bottom = coslayout_expr_create_attr(COSLAYOUT_ATTR_BT, &label);
+    COSLAYOUT_EXPR *space = coslayout_expr_create_const(8);
+
+    set_rule(&set, COSLAYOUT_ATTR_TT, coslayout_expr_create_binary(COSLAYOUT_EXPR_ADD, bottom, space));
+    coslayout_expr_release(bottom);
+    coslayout_expr_release(space);
+
+    set_rule(&set, COSLAYOUT_ATTR_LL, coslayout_expr_create_const(10));
+    set_rule(&set, COSLAYOUT_ATTR_W, coslayout_expr_create_percentage(50, COSLAYOUT_DIR_NONE));
+    set_rule(&set, COSLAYOUT_ATTR_H, coslayout_expr_create_const(20));
+
+    node.set = &set;
+    node.view = &view;
+    node.superview = &container;
+
+    capture(&snapshot, &node, 320, 20);
+    solve(&node, &snapshot, &before, -1, diff);
+
+    CHECK(node.frame.x == 10 && node.frame.w == 160);
+    CHECK(node.frame.y == 28);
+
+    /* Only the width of the container changed, but the label got taller
+     * in layoutSubviews before the solve. */
+    capture(&snapshot, &node, 200, 40);
+    solve(&node, &snapshot, &before, COSLAYOUT_READ_WIDTH | COSLAYOUT_READ_VIEW_H, diff);
+
+    CHECK(node.frame.w == 100);
+
+    if (diff) {
+        CHECK(node.frame.y == 48);
+    } else {
+        /* What passes did before they diffed snapshots. */
+        CHECK(node.frame.y == 28);
+    }
+
+    coslayout_snapshot_destroy(&snapshot);
+    coslayout_snapshot_destroy(&before);
+    coslayout_ruleset_destroy(&set);
+}
+
+static void test_changed_inputs(void) {
+    COSLAYOUT_NODE node = { 0 };
+    COSLAYOUT_SNAPSHOT snapshot, before;
+
+    coslayout_snapshot_init(&snapshot);
+    coslayout_snapshot_init(&before);
+
+    node.frame = (COSLAYOUT_RECT){ 10, 28, 160, 20 };
+
+    capture(&before, &node, 320, 20);
+    capture(&snapshot, &node, 320, 20);
+
+    CHECK(coslayout_snapshot_changed_inputs(&before, &snapshot) == 0);
+
+    coslayout_snapshot_find(&snapshot, &label)->rect.x = 4;
+
+    CHECK(coslayout_snapshot_changed_inputs(&before, &snapshot) == COSLAYOUT_READ_VIEW_H);
+
+    coslayout_snapshot_find(&snapshot, &label)->height = 500;
+
+    CHECK(coslayout_snapshot_changed_inputs(&before, &snapshot) == (COSLAYOUT_READ_VIEW_H | COSLAYOUT_READ_VIEW_V));
+
+    /* A view the last commit did not see may be anywhere. */
+    coslayout_snapshot_insert(&snapshot, &node);
+
+    CHECK(coslayout_snapshot_changed_inputs(&before, &snapshot) == -1);
+
+    coslayout_snapshot_destroy(&snapshot);
+    coslayout_snapshot_destroy(&before);
+}
+
+int main(void) {
+    test_label_resized_outside(0);
+    test_label_resized_outside(1);
+    test_changed_inputs();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+
+    return failures;
+}
@@ -0,0 +1,127 @@
+// COSLayoutParamsTests.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// Invalidation by parameters.
+//
+// Two containers side by side each hold a label, only the label of the
+// first reads $top. Setting the parameter must lay out again the
+// container whose rules read it and no other, which is counted by the
+// passes statistics record. Exits with the number of failed checks. Runs
+// on any POSIX system:
+//
+//   cc -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutParamsTests.c ../COSLayout/COSLayoutTree.c
+//      ../COSLayout/COSLayoutProgram.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      ../COSLayout/COSLayoutDump.c -lpthread -lm -o params-tests
+//   ./params-tests
+
+#include "COSLayoutTree.h"
+#include "COSLayoutStats.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures += 1; \
+    } \
+} while (0)
+
+/* Passes laid out by coslayout_view_layout_if_needed on root. */
+static uint64_t passes(COSLAYOUT_VIEW *root) {
+    coslayout_stats_reset();
+    coslayout_view_layout_if_needed(root, NULL);
+
+    return coslayout_stats_get().passes;
+}
+
+static void test_readers(void) {
+    COSLAYOUT_VIEW *root = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 400, 200 });
+    COSLAYOUT_VIEW *reading = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 200, 200 });
+    COSLAYOUT_VIEW *other = coslayout_view_create((COSLAYOUT_RECT){ 200, 0, 200, 200 });
+    COSLAYOUT_VIEW *label = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 0, 0 });
+    COSLAYOUT_VIEW *title = coslayout_view_create((COSLAYOUT_RECT){ 0, 0, 0, 0 });
+
+    coslayout_view_add_subview(root, reading);
+    coslayout_view_add_subview(root, other);
+    coslayout_view_add_subview(reading, label);
+    coslayout_view_add_subview(other, title);
+
+    coslayout_view_add_rule(label, "ll = 0, tt = $top + 8, w = 100, h = 20");
+    coslayout_view_add_rule(title, "ll = 0, tt = 8, w = 100, h = 20");
+
+    /* The root and both containers gained subviews. */
+    CHECK(passes(root) == 3);
+    CHECK(passes(root) == 0);
+
+    CHECK(coslayout_view_frame(label).y == 8);
+    CHECK(coslayout_view_frame(title).y == 8);
+
+    /* The title is moved without its container knowing, a layout of the
+     * container would move it back. */
+    coslayout_view_set_frame(title, (COSLAYOUT_RECT){ 0, 50, 100, 20 });
+
+    /* The container of the label reads the parameter through its scope. */
+    CHECK(coslayout_view_set_param(reading, "top", 20) == 1);
+    CHECK(passes(root) == 1);
+
+    CHECK(coslayout_view_frame(label).y == 28);
+    CHECK(coslayout_view_frame(title).y == 50);
+
+    /* Rules of the title do not read it. */
+    CHECK(coslayout_view_set_param(other, "top", 20) == 1);
+    CHECK(passes(root) == 0);
+
+    CHECK(coslayout_view_frame(title).y == 50);
+
+    /* Neither does an unchanged value. */
+    CHECK(coslayout_view_set_param(reading, "top", 20) == 0);
+    CHECK(passes(root) == 0);
+
+    /* Parameters of the label itself win over its scope. */
+    CHECK(coslayout_view_set_param(label, "top", 40) == 1);
+    CHECK(passes(root) == 1);
+
+    CHECK(coslayout_view_frame(label).y == 48);
+    CHECK(coslayout_view_frame(title).y == 50);
+
+    coslayout_view_destroy(root);
+}
+
+int main(void) {
+    coslayout_stats_set_enabled(1);
+
+    test_readers();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+
+    return failures;
+}
@@ -0,0 +1,189 @@
+// COSLayoutParserTests.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// Scanner and grammar of rules.
+//
+// Covers the inputs the hand written scanner and the grammar treat
+// differently from the flex scanner and grammar they replaced: V:%p is a
+// vertical percentage, %*p and %*f are specifiers, $name, name.attr,
+// commas and comparisons are tokens, and () is a syntax error instead of
+// an empty expression. Exits with the number of failed checks. Runs on
+// any POSIX system:
+//
+//   cc -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutParserTests.c ../COSLayout/COSLayoutCore.c
+//      ../COSLayout/COSLayoutParser.c ../COSLayout/COSLayoutLex.c
+//      ../COSLayout/COSLayoutPool.c ../COSLayout/COSLayoutStats.c
+//      ../COSLayout/COSLayoutProfile.c ../COSLayout/COSLayoutTrace.c
+//      -lpthread -lm -o parser-tests
+//   ./parser-tests
+
+#include "COSLayoutParser.h"
+#include "COSLayoutLex.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Declared for the parser by COSLayoutParser.y. */
+int coslayoutlex(YYSTYPE *lvalp, void *scanner, COSLAYOUT_AST **astpp);
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures += 1; \
+    } \
+} while (0)
+
+/* Scans text into at most count tokens, keeping the text of the first
+ * one, and returns the number of tokens. */
+static int scan(const char *text, int *tokens, int count, char *first, size_t size) {
+    yyscan_t scanner;
+    int length = 0;
+
+    coslayoutlex_init(&scanner);
+
+    YY_BUFFER_STATE state = coslayout_scan_string(text, scanner);
+
+    first[0] = '\0';
+
+    for (;;) {
+        COSLAYOUT_AST *ast = NULL;
+        int token = coslayoutlex(&ast, scanner, NULL);
+
+        if (token == 0) break;
+
+        if (length == 0 && ast != NULL) {
+            switch (token) {
+            case COSLAYOUT_TOKEN_NUMBER:
+                snprintf(first, size, "%g", ast->value.number);
+                break;
+            case COSLAYOUT_TOKEN_PERCENTAGE:
+            case COSLAYOUT_TOKEN_PERCENTAGE_H:
+            case COSLAYOUT_TOKEN_PERCENTAGE_V:
+                snprintf(first, size, "%g", ast->value.percentage);
+                break;
+            case COSLAYOUT_TOKEN_NIL:
+                break;
+            default:
+                snprintf(first, size, "%s", ast->value.coord);
+                break;
+            }
+        }
+
+        coslayout_destroy_ast(ast);
+
+        if (length < count) tokens[length] = token;
+
+        length += 1;
+    }
+
+    coslayout_delete_buffer(state, scanner);
+    coslayoutlex_destroy(scanner);
+
+    return length;
+}
+
+#define CHECK_TOKEN(text, token, value) do { \
+    int tokens[4]; \
+    char first[64]; \
+    CHECK(scan(text, tokens, 4, first, sizeof(first)) == 1); \
+    CHECK(tokens[0] == (token)); \
+    CHECK(strcmp(first, value) == 0); \
+} while (0)
+
+static void test_tokens(void) {
+    /* The flex scanner returned the horizontal token for V:%p. */
+    CHECK_TOKEN("V:%p", COSLAYOUT_TOKEN_COORD_PERCENTAGE_V, "p");
+    CHECK_TOKEN("H:%p", COSLAYOUT_TOKEN_COORD_PERCENTAGE_H, "p");
+    CHECK_TOKEN("%^p", COSLAYOUT_TOKEN_COORD_PERCENTAGE, "^p");
+    CHECK_TOKEN("%*p", COSLAYOUT_TOKEN_COORD_PERCENTAGE, "*p");
+    CHECK_TOKEN("%*f", COSLAYOUT_TOKEN_COORD, "*f");
+    CHECK_TOKEN("%tb", COSLAYOUT_TOKEN_COORD, "tb");
+    CHECK_TOKEN("V:50%", COSLAYOUT_TOKEN_PERCENTAGE_V, "50");
+    CHECK_TOKEN("-.5", COSLAYOUT_TOKEN_NUMBER, "-0.5");
+    CHECK_TOKEN("$top_1", COSLAYOUT_TOKEN_PARAM, "top_1");
+    CHECK_TOKEN("header.bt", COSLAYOUT_TOKEN_REFERENCE, "header.bt");
+    CHECK_TOKEN("a_b-c1", COSLAYOUT_TOKEN_ATTR, "a_b-c1");
+    CHECK_TOKEN("nil", COSLAYOUT_TOKEN_NIL, "");
+
+    int tokens[8];
+    char first[64];
+
+    CHECK(scan("w=10,h<=20", tokens, 8, first, sizeof(first)) == 7);
+    CHECK(tokens[3] == ',' && tokens[5] == COSLAYOUT_TOKEN_LE);
+
+    CHECK(scan("< > == != >= ? :", tokens, 8, first, sizeof(first)) == 7);
+    CHECK(tokens[2] == COSLAYOUT_TOKEN_EQ && tokens[3] == COSLAYOUT_TOKEN_NE && tokens[4] == COSLAYOUT_TOKEN_GE);
+
+    /* Parentheses are two tokens, unrecognized text is skipped. */
+    CHECK(scan("( ) # ~", tokens, 8, first, sizeof(first)) == 2);
+    CHECK(tokens[0] == '(' && tokens[1] == ')');
+}
+
+static int parse(const char *rule, int *type) {
+    char text[128];
+    COSLAYOUT_AST *ast = NULL;
+
+    snprintf(text, sizeof(text), "%s", rule);
+
+    int result = coslayout_parse_rule(text, &ast);
+
+    *type = ast && ast->r ? ast->r->node_type : 0;
+
+    coslayout_destroy_ast(ast);
+
+    return result;
+}
+
+static void test_rules(void) {
+    int type;
+
+    /* The flex grammar took () for an empty expression of no value. */
+    CHECK(parse("w = ()", &type) == 1);
+    CHECK(parse("tt = 10 + ()", &type) == 1);
+
+    CHECK(parse("w = (10)", &type) == 0 && type == COSLAYOUT_TOKEN_NUMBER);
+    CHECK(parse("w = nil", &type) == 0 && type == COSLAYOUT_TOKEN_NIL);
+    CHECK(parse("h = V:%p", &type) == 0 && type == COSLAYOUT_TOKEN_COORD_PERCENTAGE_V);
+    CHECK(parse("tt = $top + 8", &type) == 0 && type == '+');
+    CHECK(parse("tt = header.bt", &type) == 0 && type == COSLAYOUT_TOKEN_REFERENCE);
+    CHECK(parse("w = clamp(50%, 100, 300)", &type) == 0 && type == COSLAYOUT_TOKEN_CLAMP);
+    CHECK(parse("tt = %h > 500 ? 20 : 8", &type) == 0 && type == '?');
+
+    CHECK(parse("w = 10 +", &type) == 1);
+    CHECK(parse("w = min(10)", &type) == 1);
+}
+
+int main(void) {
+    test_tokens();
+    test_rules();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+
+    return failures;
+}
@@ -0,0 +1,124 @@
+// COSLayoutTemplateTests.c
+//
+// Copyright (c) 2014 Tianyong Tang
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+// AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+
+// Scratches of recompiled templates.
+//
+// A scratch keeps the nodes it prepared for a template across items.
+// Compiling the template again may reorder its slots without changing
+// their count, and a scratch solved before must then solve the same
+// frames as a fresh one. Exits with the number of failed checks. Runs on
+// any POSIX system:
+//
+//   cc -std=c99 -D_POSIX_C_SOURCE=200809L -I../COSLayout
+//      COSLayoutTemplateTests.c ../COSLayout/COSLayoutTemplate.c
+//      ../COSLayout/COSLayoutCore.c ../COSLayout/COSLayoutParser.c
+//      ../COSLayout/COSLayoutLex.c ../COSLayout/COSLayoutPool.c
+//      ../COSLayout/COSLayoutStats.c ../COSLayout/COSLayoutProfile.c
+//      ../COSLayout/COSLayoutTrace.c -lpthread -lm -o template-tests
+//   ./template-tests
+
+#include "COSLayoutTemplate.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures += 1; \
+    } \
+} while (0)
+
+static void test_recompile(void) {
+    COSLAYOUT_TEMPLATE *tmpl = coslayout_template_create();
+    COSLAYOUT_SCRATCH reused, fresh;
+    COSLAYOUT_SIZE contents[2] = { { 0, 0 }, { 0, 0 } };
+    COSLAYOUT_RECT frames[2], expected[2];
+
+    int a = coslayout_template_add_slot(tmpl, "a");
+    int b = coslayout_template_add_slot(tmpl, "b");
+
+    /* b follows a. */
+    coslayout_template_add_rule(tmpl, a, "ll = 0, tt = 0, w = 20, h = 10");
+    coslayout_template_add_rule(tmpl, b, "ll = %rl + 30, tt = 0, w = 20, h = 10", a);
+
+    CHECK(coslayout_template_compile(tmpl) == 0);
+
+    coslayout_scratch_init(&reused);
+    coslayout_template_solve(tmpl, &reused, 300, contents, frames);
+
+    CHECK(frames[a].x == 0);
+    CHECK(frames[b].x == 50);
+
+    /* a follows b now, slots are solved in the other order. */
+    coslayout_template_add_rule(tmpl, b, "ll = 50");
+    coslayout_template_add_rule(tmpl, a, "ll = %rl + 10", b);
+
+    CHECK(coslayout_template_compile(tmpl) == 0);
+
+    coslayout_template_solve(tmpl, &reused, 300, contents, frames);
+
+    coslayout_scratch_init(&fresh);
+    coslayout_template_solve(tmpl, &fresh, 300, contents, expected);
+
+    CHECK(expected[a].x == 80);
+    CHECK(expected[b].x == 50);
+    CHECK(frames[a].x == expected[a].x);
+    CHECK(frames[b].x == expected[b].x);
+
+    coslayout_scratch_destroy(&reused);
+    coslayout_scratch_destroy(&fresh);
+
+    /* A template created where a destroyed one was is not taken for it. */
+    coslayout_scratch_init(&reused);
+    coslayout_template_solve(tmpl, &reused, 300, contents, frames);
+    coslayout_template_destroy(tmpl);
+
+    tmpl = coslayout_template_create();
+    a = coslayout_template_add_slot(tmpl, "a");
+    b = coslayout_template_add_slot(tmpl, "b");
+    coslayout_template_add_rule(tmpl, a, "ll = 5, tt = 0, w = 20, h = 10");
+    coslayout_template_add_rule(tmpl, b, "ll = %rl, tt = 0, w = 20, h = 10", a);
+
+    CHECK(coslayout_template_compile(tmpl) == 0);
+
+    coslayout_template_solve(tmpl, &reused, 300, contents, frames);
+
+    CHECK(frames[a].x == 5);
+    CHECK(frames[b].x == 25);
+
+    coslayout_scratch_destroy(&reused);
+    coslayout_template_destroy(tmpl);
+}
+
+int main(void) {
+    test_recompile();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+
+    return failures;
+}